@@ -0,0 +1,132 @@
+#include "bench_common.h"
+#include "lite-obs/encoder/opus_encoder.h"
+
+#include <math.h>
+#include <string.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+}
+
+#define BENCH_ENCODER_CHANNELS 2
+#define BENCH_ENCODER_BITRATE 128
+/* a second of audio per iteration */
+#define BENCH_ENCODER_SAMPLES 48000
+
+/* a 440 Hz tone over a slow sweep, interleaved or planar float */
+static std::vector<float> bench_audio_tone(bool planar)
+{
+    std::vector<float> samples(BENCH_ENCODER_SAMPLES * BENCH_ENCODER_CHANNELS);
+    for (int i = 0; i < BENCH_ENCODER_SAMPLES; i++) {
+        double t = (double)i / BENCH_ENCODER_SAMPLES;
+        float v = (float)(0.3 * sin(2 * M_PI * 440 * t) + 0.2 * sin(2 * M_PI * (200 + 2000 * t) * t));
+        for (int c = 0; c < BENCH_ENCODER_CHANNELS; c++) {
+            size_t pos = planar ? (size_t)c * BENCH_ENCODER_SAMPLES + i : (size_t)i * BENCH_ENCODER_CHANNELS + c;
+            samples[pos] = c ? -v : v;
+        }
+    }
+    return samples;
+}
+
+/* encodes a second of stereo at 48 kHz per iteration with the aac encoder
+ * setup and with opus at the frame size in range(1). reports the cpu time
+ * per second of audio and the delay the encoder adds: its priming samples
+ * plus one frame. opus_encoder_test checks the frame durations and the
+ * pre-skip */
+static void BM_audio_encoder(benchmark::State &state)
+{
+    bool opus = state.range(0) != 0;
+    const char *name = opus ? "libopus" : "aac";
+    state.SetLabel(name);
+
+    const AVCodec *codec = avcodec_find_encoder_by_name(name);
+    if (!codec) {
+        state.SkipWithError("encoder not in this ffmpeg build");
+        return;
+    }
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    context->bit_rate = BENCH_ENCODER_BITRATE * 1000;
+    context->channels = BENCH_ENCODER_CHANNELS;
+    context->channel_layout = AV_CH_LAYOUT_STEREO;
+    context->flags = AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    if (opus) {
+        opus_encoder_settings settings;
+        settings.frame_ms = (int)state.range(1);
+        opus_apply_settings(context, settings);
+        context->sample_fmt = AV_SAMPLE_FMT_FLT;
+    } else {
+        context->sample_rate = BENCH_AUDIO_SAMPLE_RATE;
+        context->time_base = {1, BENCH_AUDIO_SAMPLE_RATE};
+        context->sample_fmt = AV_SAMPLE_FMT_FLTP;
+        av_opt_set(context->priv_data, "aac_coder", "fast", 0);
+    }
+
+    AVFrame *aframe = av_frame_alloc();
+    AVPacket *avpacket = av_packet_alloc();
+    if (avcodec_open2(context, codec, nullptr) < 0) {
+        state.SkipWithError("avcodec_open2 failed");
+        av_packet_free(&avpacket);
+        av_frame_free(&aframe);
+        avcodec_free_context(&context);
+        return;
+    }
+
+    const int frame_size = context->frame_size;
+    const bool planar = av_sample_fmt_is_planar(context->sample_fmt);
+    auto tone = bench_audio_tone(planar);
+    std::vector<float> frame_buf((size_t)frame_size * BENCH_ENCODER_CHANNELS);
+
+    aframe->format = context->sample_fmt;
+    aframe->channels = context->channels;
+    aframe->channel_layout = context->channel_layout;
+    aframe->sample_rate = context->sample_rate;
+    aframe->nb_samples = frame_size;
+
+    int64_t pts = 0;
+
+    auto receive = [&]() {
+        while (avcodec_receive_packet(context, avpacket) == 0)
+            av_packet_unref(avpacket);
+    };
+
+    for (auto _ : state) {
+        for (int done = 0; done + frame_size <= BENCH_ENCODER_SAMPLES; done += frame_size) {
+            for (int c = 0; c < (planar ? BENCH_ENCODER_CHANNELS : 1); c++) {
+                size_t count = planar ? (size_t)frame_size : (size_t)frame_size * BENCH_ENCODER_CHANNELS;
+                size_t src = planar ? (size_t)c * BENCH_ENCODER_SAMPLES + done : (size_t)done * BENCH_ENCODER_CHANNELS;
+                memcpy(frame_buf.data() + c * count, tone.data() + src, count * sizeof(float));
+            }
+
+            avcodec_fill_audio_frame(aframe, context->channels, context->sample_fmt, (const uint8_t *)frame_buf.data(),
+                                     (int)(frame_buf.size() * sizeof(float)), 1);
+            aframe->pts = pts;
+            pts += frame_size;
+
+            avcodec_send_frame(context, aframe);
+            receive();
+        }
+    }
+
+    avcodec_send_frame(context, nullptr);
+    receive();
+
+    const int priming = context->initial_padding;
+    av_packet_free(&avpacket);
+    av_frame_free(&aframe);
+    avcodec_free_context(&context);
+
+    double rate = opus ? OPUS_SAMPLE_RATE : BENCH_AUDIO_SAMPLE_RATE;
+    state.counters["frame_ms"] = frame_size * 1000.0 / rate;
+    state.counters["delay_ms"] = (priming + frame_size) * 1000.0 / rate;
+    state.counters["audio_s"] = benchmark::Counter((double)pts / rate, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_audio_encoder)
+    ->ArgNames({"opus", "frame_ms"})
+    ->Args({0, 0})
+    ->Args({1, 10})
+    ->Args({1, 20})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,108 @@
+#include "bench_common.h"
+#include "lite-obs/util/audio_ring.h"
+#include "lite-obs/util/circlebuf.h"
+
+#define BENCH_INPUT_SOURCES 16
+#define BENCH_INPUT_CHANNELS 2
+/* the sizes the source rings start at and may grow to */
+#define BENCH_INPUT_RING_SIZE (2 * BENCH_AUDIO_FRAME_SIZE * sizeof(float))
+#define BENCH_INPUT_RING_LIMIT (1000 * BENCH_AUDIO_FRAME_SIZE * sizeof(float))
+/* the encoder is restarted, and its buffer emptied, every this many ticks */
+#define BENCH_ENCODER_RESTART_TICKS 64
+
+/* the circlebuf and audio_ring calls the source and encoder audio paths make */
+struct bench_circlebuf {
+    circlebuf cb{};
+    uint64_t reallocs{};
+
+    ~bench_circlebuf() { circlebuf_free(&cb); }
+    size_t size() const { return cb.size; }
+    void push_back(const void *data, size_t bytes) {
+        size_t capacity = cb.capacity;
+        circlebuf_push_back(&cb, data, bytes);
+        reallocs += cb.capacity != capacity;
+    }
+    void pop_front(void *data, size_t bytes) { circlebuf_pop_front(&cb, data, bytes); }
+    /* what the encoder did on restart: give the memory back */
+    void reset() { circlebuf_free(&cb); }
+};
+
+struct bench_ring {
+    audio_ring ring;
+    uint64_t reallocs{};
+
+    bench_ring() { ring.init(BENCH_INPUT_RING_SIZE, BENCH_INPUT_RING_LIMIT); }
+    size_t size() const { return ring.size(); }
+    void push_back(const void *data, size_t bytes) {
+        size_t capacity = ring.capacity();
+        ring.push_back(data, bytes);
+        reallocs += ring.capacity() != capacity;
+    }
+    void pop_front(void *data, size_t bytes) { ring.pop_front(data, bytes); }
+    void reset() { ring.clear(); }
+};
+
+/* one audio tick per iteration: 16 stereo sources each deliver a tick worth
+ * of audio in uneven packets, the mixer reads and drops a tick from every
+ * one of them, and an encoder buffers the mix and hands out 1024 frame
+ * blocks. reports how often a buffer had to be reallocated */
+template<typename buffer>
+static void BM_audio_input(benchmark::State &state)
+{
+    static const size_t packet_frames[] = {441, 480, 103, 512, 1024, 64};
+    std::vector<float> in(BENCH_AUDIO_FRAME_SIZE, 0.5f), out(BENCH_AUDIO_FRAME_SIZE);
+
+    std::vector<std::unique_ptr<buffer>> sources;
+    for (size_t i = 0; i < BENCH_INPUT_SOURCES * BENCH_INPUT_CHANNELS; i++)
+        sources.push_back(std::make_unique<buffer>());
+    std::vector<std::unique_ptr<buffer>> encoder;
+    for (size_t i = 0; i < BENCH_INPUT_CHANNELS; i++)
+        encoder.push_back(std::make_unique<buffer>());
+
+    const size_t tick_bytes = BENCH_AUDIO_FRAME_SIZE * sizeof(float);
+    size_t packet = 0;
+    uint64_t ticks = 0;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        for (size_t s = 0; s < BENCH_INPUT_SOURCES; s++) {
+            size_t frames = 0;
+            while (frames < BENCH_AUDIO_FRAME_SIZE) {
+                size_t n = packet_frames[packet++ % (sizeof(packet_frames) / sizeof(packet_frames[0]))];
+                for (size_t ch = 0; ch < BENCH_INPUT_CHANNELS; ch++)
+                    sources[s * BENCH_INPUT_CHANNELS + ch]->push_back(in.data(), n * sizeof(float));
+                frames += n;
+            }
+
+            for (size_t ch = 0; ch < BENCH_INPUT_CHANNELS; ch++) {
+                auto &source = sources[s * BENCH_INPUT_CHANNELS + ch];
+                while (source->size() >= tick_bytes)
+                    source->pop_front(out.data(), tick_bytes);
+            }
+        }
+
+        if (++ticks % BENCH_ENCODER_RESTART_TICKS == 0) {
+            for (auto &plane : encoder)
+                plane->reset();
+        }
+
+        for (auto &plane : encoder)
+            plane->push_back(out.data(), tick_bytes);
+        while (encoder[0]->size() >= tick_bytes) {
+            for (auto &plane : encoder)
+                plane->pop_front(out.data(), tick_bytes);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    bench_report(state, allocs, BENCH_INPUT_SOURCES * BENCH_INPUT_CHANNELS * tick_bytes);
+
+    uint64_t reallocs = 0;
+    for (auto &source : sources)
+        reallocs += source->reallocs;
+    for (auto &plane : encoder)
+        reallocs += plane->reallocs;
+    state.counters["reallocs/s"] = benchmark::Counter((double)reallocs, benchmark::Counter::kIsRate);
+    state.counters["reallocs/op"] = benchmark::Counter((double)reallocs, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_TEMPLATE(BM_audio_input, bench_circlebuf);
+BENCHMARK_TEMPLATE(BM_audio_input, bench_ring);
@@ -0,0 +1,99 @@
+#include "bench_common.h"
+#include "lite-obs/media-io/audio_info.h"
+#include "lite-obs/media-io/audio_math.h"
+
+#include <cmath>
+#include <string.h>
+
+#define BENCH_MIXES 6
+#define BENCH_CHANNELS 2
+
+struct mix_buffers {
+    std::vector<float> mixes;
+    std::vector<float> source;
+    std::vector<float> input;
+
+    mix_buffers() : mixes(BENCH_MIXES * MAX_AUDIO_CHANNELS * AUDIO_OUTPUT_FRAMES), source(BENCH_MIXES * MAX_AUDIO_CHANNELS * AUDIO_OUTPUT_FRAMES), input(source.size()) {
+        for (size_t i = 0; i < source.size(); i++)
+            source[i] = 1.5f * sinf((float)i * 0.01f);
+    }
+
+    float *mix(size_t mix_idx, size_t ch) { return &mixes[(mix_idx * MAX_AUDIO_CHANNELS + ch) * AUDIO_OUTPUT_FRAMES]; }
+    float *src(size_t mix_idx, size_t ch) { return &source[(mix_idx * MAX_AUDIO_CHANNELS + ch) * AUDIO_OUTPUT_FRAMES]; }
+};
+
+struct mix_kernels {
+    void (*mix)(float *dst, const float *src, size_t count);
+    void (*multiply)(float *data, size_t count, float vol);
+    void (*clamp)(float *data, size_t count);
+};
+
+static const mix_kernels dispatched = {audio_mix_floats, audio_multiply_floats, audio_clamp_floats};
+static const mix_kernels reference = {audio_mix_floats_c, audio_multiply_floats_c, audio_clamp_floats_c};
+
+/* one 1024 frame tick at 48 kHz: every source copies its input, applies its
+ * volume and mixes into every active mix, then the active mixes are
+ * clamped, as audio_source_tick, lite_obs_source::mix_audio and
+ * audio_output::clamp_audio_output do it. "mixes" is how many of the
+ * outputs mixes are in use, idle ones are not touched */
+static void run_mix_tick(benchmark::State &state, const mix_kernels &k)
+{
+    size_t sources = (size_t)state.range(0);
+    size_t mixes = (size_t)state.range(1);
+    mix_buffers buf;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        for (size_t mix_idx = 0; mix_idx < mixes; mix_idx++)
+            memset(buf.mix(mix_idx, 0), 0, BENCH_CHANNELS * AUDIO_OUTPUT_FRAMES * sizeof(float));
+
+        for (size_t s = 0; s < sources; s++) {
+            for (size_t mix_idx = 0; mix_idx < mixes; mix_idx++) {
+                memcpy(buf.input.data(), buf.src(mix_idx, 0), AUDIO_OUTPUT_FRAMES * BENCH_CHANNELS * sizeof(float));
+                k.multiply(buf.input.data(), AUDIO_OUTPUT_FRAMES * BENCH_CHANNELS, 0.8f);
+                for (size_t ch = 0; ch < BENCH_CHANNELS; ch++)
+                    k.mix(buf.mix(mix_idx, ch), &buf.input[ch * AUDIO_OUTPUT_FRAMES], AUDIO_OUTPUT_FRAMES);
+            }
+        }
+
+        for (size_t mix_idx = 0; mix_idx < mixes; mix_idx++)
+            for (size_t ch = 0; ch < BENCH_CHANNELS; ch++)
+                k.clamp(buf.mix(mix_idx, ch), AUDIO_OUTPUT_FRAMES);
+
+        benchmark::DoNotOptimize(buf.mixes.data());
+        benchmark::ClobberMemory();
+    }
+    bench_report(state, allocs, sources * mixes * BENCH_CHANNELS * AUDIO_OUTPUT_FRAMES * sizeof(float));
+    state.SetLabel(&k == &dispatched ? audio_math_isa() : "c");
+}
+
+static void BM_audio_mix_tick(benchmark::State &state)
+{
+    run_mix_tick(state, dispatched);
+}
+BENCHMARK(BM_audio_mix_tick)->ArgNames({"sources", "mixes"})->Args({1, BENCH_MIXES})->Args({4, BENCH_MIXES})->Args({32, 1})->Args({32, BENCH_MIXES});
+
+static void BM_audio_mix_tick_c(benchmark::State &state)
+{
+    run_mix_tick(state, reference);
+}
+BENCHMARK(BM_audio_mix_tick_c)->ArgNames({"sources", "mixes"})->Args({32, 1})->Args({32, BENCH_MIXES});
+
+static void BM_audio_clamp(benchmark::State &state)
+{
+    mix_buffers buf;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        for (size_t mix_idx = 0; mix_idx < BENCH_MIXES; mix_idx++) {
+            for (size_t ch = 0; ch < BENCH_CHANNELS; ch++) {
+                memcpy(buf.mix(mix_idx, ch), buf.src(mix_idx, ch), AUDIO_OUTPUT_FRAMES * sizeof(float));
+                audio_clamp_floats(buf.mix(mix_idx, ch), AUDIO_OUTPUT_FRAMES);
+            }
+        }
+        benchmark::DoNotOptimize(buf.mixes.data());
+        benchmark::ClobberMemory();
+    }
+    bench_report(state, allocs, BENCH_MIXES * BENCH_CHANNELS * AUDIO_OUTPUT_FRAMES * sizeof(float));
+}
+BENCHMARK(BM_audio_clamp);
@@ -0,0 +1,68 @@
+#include "bench_common.h"
+#include "lite-obs/media-io/audio_output.h"
+#include "lite-obs/util/threading.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#define BENCH_TICK_SECONDS 10
+
+static bool tick_input_callback(void *param, uint64_t start_ts, uint64_t end_ts, uint64_t *new_ts, uint32_t active_mixers, audio_output_data *mixes)
+{
+    (void)param;
+    (void)start_ts;
+    (void)active_mixers;
+    (void)mixes;
+    *new_ts = end_ts;
+    return true;
+}
+
+/* runs the 48 kHz audio thread for ten seconds and reports how late it got
+ * to its ticks. "hogs" busy threads per cpu core compete with it, the way a
+ * loaded host would */
+static void BM_audio_output_tick_jitter(benchmark::State &state)
+{
+    size_t hogs = (size_t)state.range(0) * std::max(1u, std::thread::hardware_concurrency());
+
+    std::atomic_bool stop = false;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < hogs; i++) {
+        threads.emplace_back([&stop] {
+            uint64_t spin = 0;
+            while (!stop.load(std::memory_order_relaxed))
+                benchmark::DoNotOptimize(spin++);
+        });
+    }
+
+    audio_output_info info{};
+    info.name = "bench";
+    info.samples_per_sec = BENCH_AUDIO_SAMPLE_RATE;
+    info.format = audio_format::AUDIO_FORMAT_FLOAT_PLANAR;
+    info.speakers = speaker_layout::SPEAKERS_STEREO;
+    info.input_callback = tick_input_callback;
+
+    audio_tick_stats stats{};
+    for (auto _ : state) {
+        audio_output ao;
+        if (ao.audio_output_open(&info) != AUDIO_OUTPUT_SUCCESS) {
+            state.SkipWithError("failed to open audio output");
+            break;
+        }
+
+        os_sleep_ms(BENCH_TICK_SECONDS * 1000);
+        ao.audio_output_get_tick_stats(&stats);
+        ao.audio_output_close();
+    }
+
+    stop = true;
+    for (auto &thread : threads)
+        thread.join();
+
+    state.counters["ticks"] = (double)stats.ticks;
+    state.counters["avg_ms"] = (double)stats.avg_error_ns / 1000000.0;
+    state.counters["p99_ms"] = (double)stats.p99_error_ns / 1000000.0;
+    state.counters["max_ms"] = (double)stats.max_error_ns / 1000000.0;
+    state.counters["restarts"] = (double)stats.resyncs;
+}
+BENCHMARK(BM_audio_output_tick_jitter)->ArgName("hogs")->Arg(0)->Arg(2)->Iterations(1)->UseRealTime()->Unit(benchmark::kMillisecond);
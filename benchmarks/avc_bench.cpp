@@ -0,0 +1,34 @@
+#include "bench_common.h"
+#include "lite-obs/lite_obs_avc.h"
+#include "lite-obs/lite_encoder_info.h"
+
+static void BM_obs_parse_avc_packet(benchmark::State &state)
+{
+    bool keyframe = state.range(0) != 0;
+    size_t size = keyframe ? BENCH_VIDEO_KEYFRAME_SIZE : BENCH_VIDEO_FRAME_SIZE;
+
+    auto src = std::make_shared<encoder_packet>();
+    src->type = obs_encoder_type::OBS_ENCODER_VIDEO;
+    src->timebase_num = 1;
+    src->timebase_den = BENCH_VIDEO_FPS;
+    src->data = bench_packet_data(bench_h264_frame(size, keyframe, 1));
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        auto out = obs_parse_avc_packet(src);
+        benchmark::DoNotOptimize(out->data->data());
+    }
+    bench_report(state, allocs, src->data->size());
+}
+BENCHMARK(BM_obs_parse_avc_packet)->ArgName("keyframe")->Arg(0)->Arg(1);
+
+static void BM_obs_avc_keyframe(benchmark::State &state)
+{
+    auto data = bench_h264_frame(BENCH_VIDEO_FRAME_SIZE, false, 1);
+
+    auto allocs = bench_allocations();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(obs_avc_keyframe(data->data(), data->size()));
+    bench_report(state, allocs, data->size());
+}
+BENCHMARK(BM_obs_avc_keyframe);
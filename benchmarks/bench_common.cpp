@@ -0,0 +1,152 @@
+#include "bench_common.h"
+
+#include <atomic>
+#include <map>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <tuple>
+
+static std::atomic<uint64_t> allocations{};
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+uint64_t bench_allocations()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void bench_report(benchmark::State &state, uint64_t allocs_before, size_t bytes_per_op)
+{
+    auto allocs = bench_allocations() - allocs_before;
+    state.counters["allocs/op"] = benchmark::Counter((double)allocs, benchmark::Counter::kAvgIterations);
+    if (bytes_per_op)
+        state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)bytes_per_op);
+}
+
+static inline uint32_t xorshift32(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static void fill_nonzero(uint8_t *data, size_t size, uint32_t &state)
+{
+    for (size_t i = 0; i < size; i++)
+        data[i] = (uint8_t)(xorshift32(state) % 255 + 1);
+}
+
+static void push_nal(std::vector<uint8_t> &out, uint8_t header, size_t payload, uint32_t &state)
+{
+    static const uint8_t start_code[] = {0, 0, 0, 1};
+    out.insert(out.end(), start_code, start_code + sizeof(start_code));
+    out.push_back(header);
+
+    auto pos = out.size();
+    out.resize(pos + payload);
+    fill_nonzero(out.data() + pos, payload, state);
+}
+
+std::shared_ptr<std::vector<uint8_t>> bench_h264_frame(size_t size, bool keyframe, uint32_t seed)
+{
+    auto frame = std::make_shared<std::vector<uint8_t>>();
+    frame->reserve(size + 32);
+    uint32_t state = seed ? seed : 1;
+
+    if (keyframe) {
+        push_nal(*frame, 0x67, 24, state);
+        push_nal(*frame, 0x68, 4, state);
+        push_nal(*frame, 0x65, size > 64 ? size - 64 : 1, state);
+    } else {
+        push_nal(*frame, 0x41, size > 5 ? size - 5 : 1, state);
+    }
+
+    return frame;
+}
+
+std::shared_ptr<std::vector<uint8_t>> bench_random_bytes(size_t size, uint32_t seed)
+{
+    auto data = std::make_shared<std::vector<uint8_t>>(size);
+    uint32_t state = seed ? seed : 1;
+    fill_nonzero(data->data(), size, state);
+    return data;
+}
+
+packet_data bench_packet_data(const std::shared_ptr<std::vector<uint8_t>> &bytes)
+{
+    return packet_pool_copy(bytes->data(), bytes->size());
+}
+
+std::vector<std::vector<uint8_t>> &bench_video_clip(int width, int height, bool nv12)
+{
+    static std::map<std::tuple<int, int, bool>, std::vector<std::vector<uint8_t>>> clips;
+    auto &clip = clips[{width, height, nv12}];
+    if (!clip.empty())
+        return clip;
+
+    const size_t luma = (size_t)width * height;
+    auto noise = bench_random_bytes(256 * 256, 7);
+
+    for (int f = 0; f < BENCH_CLIP_FRAMES; f++) {
+        std::vector<uint8_t> frame(luma * 3 / 2);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++)
+                frame[y * width + x] = (uint8_t)((x + y / 2 + f * 8) & 0xff);
+        }
+
+        int top = (f * 12) % (height - 256);
+        for (int y = 0; y < 256; y++)
+            memcpy(frame.data() + (top + y) * width + width / 2 - 128, noise->data() + y * 256, 256);
+
+        for (size_t i = 0; i < luma / 2; i += 2) {
+            uint8_t u = (uint8_t)(128 + (i / 64 + f) % 32);
+            uint8_t v = (uint8_t)(128 - (i / 128) % 32);
+            if (nv12) {
+                frame[luma + i] = u;
+                frame[luma + i + 1] = v;
+            } else {
+                frame[luma + i / 2] = u;
+                frame[luma + luma / 4 + i / 2] = v;
+            }
+        }
+        clip.push_back(std::move(frame));
+    }
+
+    return clip;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "lite-obs/util/packet_pool.h"
+
+/* 1080p60 at 6 Mbps with a 2 second keyframe interval, 48 kHz stereo aac */
+#define BENCH_VIDEO_FPS 60
+#define BENCH_VIDEO_FRAME_SIZE (6000000 / 8 / BENCH_VIDEO_FPS)
+#define BENCH_VIDEO_KEYFRAME_SIZE (BENCH_VIDEO_FRAME_SIZE * 12)
+#define BENCH_VIDEO_KEYINT (BENCH_VIDEO_FPS * 2)
+#define BENCH_AUDIO_SAMPLE_RATE 48000
+#define BENCH_AUDIO_FRAME_SIZE 1024
+#define BENCH_AUDIO_PACKET_SIZE 342
+
+/* number of operator new calls made by this process so far */
+uint64_t bench_allocations();
+
+/* adds the "allocs/op" and "bytes_per_second" counters to a finished run */
+void bench_report(benchmark::State &state, uint64_t allocs_before, size_t bytes_per_op);
+
+/* annex-b h264 access unit: sps + pps + idr slice for keyframes, a single
+ * non-idr slice otherwise. payload bytes are never zero so the only start
+ * codes are the ones we put in. */
+std::shared_ptr<std::vector<uint8_t>> bench_h264_frame(size_t size, bool keyframe, uint32_t seed);
+
+std::shared_ptr<std::vector<uint8_t>> bench_random_bytes(size_t size, uint32_t seed);
+
+/* half a second at 60 fps of synthetic video */
+#define BENCH_CLIP_FRAMES 30
+
+/* a gradient panning right under a block of noise moving down, the same for
+ * every run. frames are nv12, or i420 with nv12 false */
+std::vector<std::vector<uint8_t>> &bench_video_clip(int width, int height, bool nv12);
+
+/* copies bytes into a pooled packet payload */
+packet_data bench_packet_data(const std::shared_ptr<std::vector<uint8_t>> &bytes);
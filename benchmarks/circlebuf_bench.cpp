@@ -0,0 +1,49 @@
+#include "bench_common.h"
+#include "lite-obs/util/circlebuf.h"
+
+/* steady state of a source audio buffer: one 1024 frame float block in, one
+ * out, so the buffer never has to grow after the first iterations */
+static void BM_circlebuf_push_back_steady(benchmark::State &state)
+{
+    size_t size = (size_t)state.range(0);
+    std::vector<uint8_t> in(size, 1), out(size);
+    circlebuf cb{};
+
+    circlebuf_push_back(&cb, in.data(), size);
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        circlebuf_push_back(&cb, in.data(), size);
+        circlebuf_pop_front(&cb, out.data(), size);
+        benchmark::DoNotOptimize(out.data());
+    }
+    bench_report(state, allocs, size);
+
+    circlebuf_free(&cb);
+}
+BENCHMARK(BM_circlebuf_push_back_steady)->Arg(BENCH_AUDIO_FRAME_SIZE * sizeof(float))->Arg(BENCH_VIDEO_FRAME_SIZE);
+
+/* buffering without draining, as happens while waiting for the first video
+ * frame. reports how often the buffer has to be reallocated. */
+static void BM_circlebuf_push_back_growing(benchmark::State &state)
+{
+    size_t size = (size_t)state.range(0);
+    size_t blocks = 256;
+    std::vector<uint8_t> in(size, 1);
+    uint64_t reallocs = 0;
+
+    for (auto _ : state) {
+        circlebuf cb{};
+        for (size_t i = 0; i < blocks; i++) {
+            size_t capacity = cb.capacity;
+            circlebuf_push_back(&cb, in.data(), size);
+            reallocs += cb.capacity != capacity;
+        }
+        benchmark::DoNotOptimize(cb.data);
+        circlebuf_free(&cb);
+    }
+
+    state.counters["reallocs/op"] = benchmark::Counter((double)reallocs, benchmark::Counter::kAvgIterations);
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)(size * blocks));
+}
+BENCHMARK(BM_circlebuf_push_back_growing)->Arg(BENCH_AUDIO_FRAME_SIZE * sizeof(float));
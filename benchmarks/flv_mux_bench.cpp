@@ -0,0 +1,54 @@
+#include "bench_common.h"
+#include "lite-obs/output/flv_mux.h"
+
+static std::shared_ptr<encoder_packet> make_packet(obs_encoder_type type)
+{
+    auto packet = std::make_shared<encoder_packet>();
+    packet->type = type;
+    packet->timebase_num = 1;
+    if (type == obs_encoder_type::OBS_ENCODER_VIDEO) {
+        packet->timebase_den = BENCH_VIDEO_FPS;
+        packet->data = bench_packet_data(bench_random_bytes(BENCH_VIDEO_FRAME_SIZE, 1));
+    } else {
+        packet->timebase_den = BENCH_AUDIO_SAMPLE_RATE;
+        packet->data = bench_packet_data(bench_random_bytes(BENCH_AUDIO_PACKET_SIZE, 1));
+    }
+
+    return packet;
+}
+
+/* the rtmp output muxes every packet into a fresh vector */
+static void BM_flv_packet_mux(benchmark::State &state)
+{
+    auto type = state.range(0) ? obs_encoder_type::OBS_ENCODER_VIDEO : obs_encoder_type::OBS_ENCODER_AUDIO;
+    auto packet = make_packet(type);
+    int64_t step = type == obs_encoder_type::OBS_ENCODER_VIDEO ? 1 : BENCH_AUDIO_FRAME_SIZE;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        std::vector<uint8_t> output;
+        flv_packet_mux(packet, 0, output, false);
+        benchmark::DoNotOptimize(output.data());
+        packet->dts += step;
+        packet->pts += step;
+    }
+    bench_report(state, allocs, packet->data->size());
+}
+BENCHMARK(BM_flv_packet_mux)->ArgName("video")->Arg(0)->Arg(1);
+
+/* same, reusing the output buffer to show the cost of the allocation */
+static void BM_flv_packet_mux_reuse(benchmark::State &state)
+{
+    auto type = state.range(0) ? obs_encoder_type::OBS_ENCODER_VIDEO : obs_encoder_type::OBS_ENCODER_AUDIO;
+    auto packet = make_packet(type);
+    std::vector<uint8_t> output;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        output.clear();
+        flv_packet_mux(packet, 0, output, false);
+        benchmark::DoNotOptimize(output.data());
+    }
+    bench_report(state, allocs, packet->data->size());
+}
+BENCHMARK(BM_flv_packet_mux_reuse)->ArgName("video")->Arg(0)->Arg(1);
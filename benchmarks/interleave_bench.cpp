@@ -0,0 +1,107 @@
+#include "bench_common.h"
+#include "lite-obs/lite_obs_output.h"
+#include "lite-obs/lite_encoder.h"
+
+class bench_output : public lite_obs_output
+{
+public:
+    bool i_output_valid() override { return true; }
+    bool i_has_video() override { return true; }
+    bool i_has_audio() override { return true; }
+    bool i_encoded() override { return true; }
+    bool i_create() override { return true; }
+    void i_destroy() override {}
+    bool i_start() override { return true; }
+    void i_stop(uint64_t) override {}
+    void i_raw_video(struct video_data *) override {}
+    void i_raw_audio(struct audio_data *) override {}
+    void i_encoded_packet(std::shared_ptr<struct encoder_packet> packet) override {
+        bytes += packet->data->size();
+    }
+    uint64_t i_get_total_bytes() override { return bytes; }
+    int i_get_dropped_frames() override { return 0; }
+    bool i_multi_track() override { return true; }
+
+    uint64_t bytes{};
+};
+
+class lite_obs_output_benchmark
+{
+public:
+    static void interleave(lite_obs_output *output, const std::shared_ptr<encoder_packet> &packet) {
+        lite_obs_output::interleave_packets(output, packet);
+    }
+};
+
+/* feeds a 1080p60 video track and "tracks" 48 kHz aac tracks in dts
+ * order through the interleaver of an active output, one video packet or
+ * one packet for every audio track per iteration */
+static void BM_interleave_packets(benchmark::State &state)
+{
+    auto tracks = (size_t)state.range(0);
+
+    auto output = std::make_shared<bench_output>();
+    auto video_encoder = std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::X264, 6000, 0);
+    std::vector<std::shared_ptr<lite_obs_encoder>> audio_encoders;
+    output->lite_obs_output_set_video_encoder(video_encoder);
+    for (size_t i = 0; i < tracks; i++) {
+        audio_encoders.push_back(std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::AAC, 128, i));
+        output->lite_obs_output_set_audio_encoder(audio_encoders.back(), i);
+    }
+    if (!output->lite_obs_output_begin_data_capture()) {
+        state.SkipWithError("failed to begin data capture");
+        return;
+    }
+
+    auto keyframe_data = bench_packet_data(bench_h264_frame(BENCH_VIDEO_KEYFRAME_SIZE, true, 1));
+    auto frame_data = bench_packet_data(bench_h264_frame(BENCH_VIDEO_FRAME_SIZE, false, 2));
+    auto audio_data = bench_packet_data(bench_random_bytes(BENCH_AUDIO_PACKET_SIZE, 3));
+
+    auto video = std::make_shared<encoder_packet>();
+    video->type = obs_encoder_type::OBS_ENCODER_VIDEO;
+    video->timebase_num = 1;
+    video->timebase_den = BENCH_VIDEO_FPS;
+
+    std::vector<std::shared_ptr<encoder_packet>> audio;
+    for (size_t i = 0; i < tracks; i++) {
+        auto packet = std::make_shared<encoder_packet>();
+        packet->type = obs_encoder_type::OBS_ENCODER_AUDIO;
+        packet->timebase_num = 1;
+        packet->timebase_den = BENCH_AUDIO_SAMPLE_RATE;
+        packet->data = audio_data;
+        packet->encoder = audio_encoders[i];
+        audio.push_back(packet);
+    }
+
+    int64_t video_frames = 0;
+    int64_t audio_samples = 0;
+    size_t bytes = 0;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        int64_t video_usec = video_frames * 1000000 / BENCH_VIDEO_FPS;
+        int64_t audio_usec = audio_samples * 1000000 / BENCH_AUDIO_SAMPLE_RATE;
+
+        if (video_usec <= audio_usec) {
+            video->dts = video->pts = video_frames;
+            video->dts_usec = video->sys_dts_usec = video_usec;
+            video->keyframe = video_frames % BENCH_VIDEO_KEYINT == 0;
+            video->data = video->keyframe ? keyframe_data : frame_data;
+            bytes += video->data->size();
+            lite_obs_output_benchmark::interleave(output.get(), video);
+            video_frames++;
+        } else {
+            for (auto &packet : audio) {
+                packet->dts = packet->pts = audio_samples;
+                packet->dts_usec = packet->sys_dts_usec = audio_usec;
+                bytes += packet->data->size();
+                lite_obs_output_benchmark::interleave(output.get(), packet);
+            }
+            audio_samples += BENCH_AUDIO_FRAME_SIZE;
+        }
+    }
+    bench_report(state, allocs, 0);
+    state.SetBytesProcessed((int64_t)bytes);
+    state.counters["sent_bytes"] = (double)output->bytes;
+}
+BENCHMARK(BM_interleave_packets)->ArgName("tracks")->Arg(1)->Arg(2)->Arg(6);
@@ -0,0 +1,77 @@
+#include "bench_common.h"
+#include "lite-obs/lite_encoder_info.h"
+
+#include <deque>
+#include <string.h>
+
+#define BENCH_PACKET_OUTPUTS 3
+/* packets an output keeps queued before it gets to send them */
+#define BENCH_PACKET_QUEUE 8
+
+/* what the encoders did before: a new packet per frame written through one
+ * payload vector shared by every packet, so the interleaver copied it */
+struct bench_vector_packet {
+    std::shared_ptr<std::vector<uint8_t>> data;
+    int64_t pts{};
+};
+
+struct bench_shared_vector {
+    typedef std::shared_ptr<bench_vector_packet> packet_ptr;
+    std::shared_ptr<std::vector<uint8_t>> buffer = std::make_shared<std::vector<uint8_t>>();
+
+    packet_ptr make(const uint8_t *payload, size_t size) {
+        auto packet = std::make_shared<bench_vector_packet>();
+        buffer->resize(size);
+        memcpy(buffer->data(), payload, size);
+        packet->data = buffer;
+        return packet;
+    }
+
+    packet_ptr share(const packet_ptr &packet) {
+        auto out = std::make_shared<bench_vector_packet>(*packet);
+        out->data = std::make_shared<std::vector<uint8_t>>(*packet->data);
+        return out;
+    }
+};
+
+struct bench_pooled {
+    typedef std::shared_ptr<encoder_packet> packet_ptr;
+
+    packet_ptr make(const uint8_t *payload, size_t size) {
+        auto packet = encoder_packet_create();
+        packet->data = packet_pool_copy(payload, size);
+        return packet;
+    }
+
+    packet_ptr share(const packet_ptr &packet) {
+        return encoder_packet_create(*packet);
+    }
+};
+
+/* one video frame per iteration: the encoder writes a packet and three
+ * outputs each queue their own reference to it. packet_pool_test checks the
+ * payloads stay intact while the outputs hold them */
+template<typename packets>
+static void BM_packet_fanout(benchmark::State &state)
+{
+    auto frame = bench_h264_frame(BENCH_VIDEO_FRAME_SIZE, false, 1);
+    packets source;
+    std::deque<typename packets::packet_ptr> queues[BENCH_PACKET_OUTPUTS];
+    int64_t pts = 0;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        auto packet = source.make(frame->data(), frame->size());
+        packet->pts = pts++;
+
+        for (auto &queue : queues) {
+            queue.push_back(source.share(packet));
+            if (queue.size() > BENCH_PACKET_QUEUE)
+                queue.pop_front();
+        }
+    }
+    bench_report(state, allocs, frame->size());
+    state.counters["blocks_in_use"] = (double)packet_pool_blocks_in_use();
+}
+BENCHMARK_TEMPLATE(BM_packet_fanout, bench_shared_vector);
+BENCHMARK_TEMPLATE(BM_packet_fanout, bench_pooled);
@@ -0,0 +1,202 @@
+#include "bench_common.h"
+#include "lite-obs/output/rtmp_dbr.h"
+#include "lite-obs/util/log.h"
+
+#include <deque>
+
+#define BENCH_DBR_VIDEO_BITRATE 6000
+#define BENCH_DBR_AUDIO_BITRATE 128
+#define BENCH_DBR_FAST_LINK 10000
+#define BENCH_DBR_SNDBUF (256 * 1024)
+/* token bucket depth, in milliseconds of the link rate */
+#define BENCH_DBR_BURST_MS 20
+
+/* link drops at 10 s, recovers at 40 s, the run ends at 60 s */
+#define BENCH_DBR_DROP_MS 10000
+#define BENCH_DBR_RECOVER_MS 40000
+#define BENCH_DBR_END_MS 60000
+
+#define BENCH_DBR_CONVERGE_MS 10000
+#define BENCH_DBR_MAX_LATENCY_MS 500
+#define BENCH_DBR_PFRAME_DROP_USEC 900000
+
+struct bench_dbr_packet {
+    uint64_t enqueue_ms;
+    int64_t dts_usec;
+    size_t size;
+    bool video;
+    bool keyframe;
+    uint64_t end_offset;
+};
+
+/* a sender and a token bucket shaped link, stepped a millisecond at a time.
+ * the encoder puts frames at the controller's bitrate in the packet queue,
+ * the send thread writes them while the socket buffer has room and reports
+ * the acked and unacked bytes, the link acks at its rate. the queue drops
+ * p-frames over the output's threshold as the backstop it is in the output */
+struct bench_dbr_link {
+    rtmp_dbr dbr;
+    std::deque<bench_dbr_packet> queue;
+    std::deque<bench_dbr_packet> in_flight;
+
+    uint64_t written{};
+    uint64_t acked{};
+    double tokens{};
+    int64_t last_dts_usec{};
+    int dropped{};
+
+    uint64_t max_latency_ms{};
+    uint64_t last_late_ms{};
+
+    int64_t queue_usec() const {
+        for (auto &packet : queue) {
+            if (packet.video && !packet.keyframe)
+                return last_dts_usec - packet.dts_usec;
+        }
+        return 0;
+    }
+
+    void push(uint64_t now_ms, int64_t dts_usec, size_t size, bool video, bool keyframe) {
+        queue.push_back({now_ms, dts_usec, size, video, keyframe, 0});
+        last_dts_usec = dts_usec;
+        if (!video)
+            return;
+
+        dbr.update(now_ms * 1000000ULL, queue_usec());
+
+        if (queue.size() >= 5 && queue_usec() > BENCH_DBR_PFRAME_DROP_USEC) {
+            std::deque<bench_dbr_packet> kept;
+            for (auto &packet : queue) {
+                if (!packet.video || packet.keyframe)
+                    kept.push_back(packet);
+                else
+                    dropped++;
+            }
+            queue.swap(kept);
+        }
+    }
+
+    void step(uint64_t now_ms, long link_kbps) {
+        double rate = (double)link_kbps * 1000 / 8 / 1000;
+        tokens += rate;
+        if (tokens > rate * BENCH_DBR_BURST_MS)
+            tokens = rate * BENCH_DBR_BURST_MS;
+
+        uint64_t unacked = written - acked;
+        uint64_t sent = (uint64_t)tokens < unacked ? (uint64_t)tokens : unacked;
+        tokens -= (double)sent;
+        acked += sent;
+
+        while (!in_flight.empty() && in_flight.front().end_offset <= acked) {
+            uint64_t latency = now_ms - in_flight.front().enqueue_ms;
+            if (latency > max_latency_ms)
+                max_latency_ms = latency;
+            if (latency > BENCH_DBR_MAX_LATENCY_MS)
+                last_late_ms = now_ms;
+            in_flight.pop_front();
+        }
+
+        while (!queue.empty() && BENCH_DBR_SNDBUF - (written - acked) >= queue.front().size) {
+            auto packet = queue.front();
+            queue.pop_front();
+            written += packet.size;
+            packet.end_offset = written;
+            in_flight.push_back(packet);
+            dbr.add_sample(now_ms * 1000000ULL, acked, written - acked);
+        }
+    }
+};
+
+/* every bitrate change logs, keep the warnings only */
+static void bench_dbr_quiet_log(int level, const char *msg)
+{
+    if (level <= LOG_WARNING)
+        fprintf(stderr, "%s\n", msg);
+}
+
+/* runs a minute of a 6 Mbps stream through a link that drops from 10 Mbps
+ * to range(0) kbps at 10 s and comes back at 40 s. reports how long after
+ * the drop frames last took over 500 ms to get acked, how much of the
+ * slow link the video used once settled, the worst latency after that and
+ * how long the bitrate took to get back after the recovery. fails unless it
+ * settles and recovers within 10 s each */
+static void BM_rtmp_dbr(benchmark::State &state)
+{
+    long slow_link = (long)state.range(0);
+    const uint64_t frame_ms_x1000 = 1000000 / BENCH_VIDEO_FPS;
+    const uint64_t audio_ms = 20;
+
+    uint64_t settle_ms = 0;
+    uint64_t recover_ms = 0;
+    uint64_t settled_latency_ms = 0;
+    double utilization = 0;
+    int dropped = 0;
+
+    base_set_log_handler(bench_dbr_quiet_log);
+
+    for (auto _ : state) {
+        bench_dbr_link link;
+        link.dbr.reset(BENCH_DBR_VIDEO_BITRATE, BENCH_DBR_AUDIO_BITRATE, 0);
+
+        uint64_t next_frame_x1000 = 0;
+        uint64_t frame_index = 0;
+        uint64_t slow_bits = 0;
+        uint64_t settled_frames = 0;
+        recover_ms = 0;
+        settled_latency_ms = 0;
+
+        for (uint64_t now = 0; now < BENCH_DBR_END_MS; now++) {
+            bool slow = now >= BENCH_DBR_DROP_MS && now < BENCH_DBR_RECOVER_MS;
+
+            if (now * 1000 >= next_frame_x1000) {
+                /* keyframes four times a p-frame, the gop at the bitrate */
+                long bitrate = link.dbr.bitrate();
+                uint64_t gop_bytes = (uint64_t)bitrate * 1000 / 8 * BENCH_VIDEO_KEYINT / BENCH_VIDEO_FPS;
+                uint64_t pframe = gop_bytes / (BENCH_VIDEO_KEYINT + 3);
+                bool keyframe = frame_index % BENCH_VIDEO_KEYINT == 0;
+                link.push(now, (int64_t)next_frame_x1000, keyframe ? pframe * 4 : pframe, true, keyframe);
+
+                if (slow && now >= BENCH_DBR_DROP_MS + BENCH_DBR_CONVERGE_MS) {
+                    slow_bits += (uint64_t)bitrate;
+                    settled_frames++;
+                }
+                next_frame_x1000 += frame_ms_x1000;
+                frame_index++;
+            }
+            if (now % audio_ms == 0)
+                link.push(now, (int64_t)now * 1000, BENCH_DBR_AUDIO_BITRATE * 1000 / 8 * audio_ms / 1000, false, false);
+
+            if (now == BENCH_DBR_DROP_MS + BENCH_DBR_CONVERGE_MS)
+                link.max_latency_ms = 0;
+            if (now == BENCH_DBR_RECOVER_MS)
+                settled_latency_ms = link.max_latency_ms;
+            if (now >= BENCH_DBR_RECOVER_MS && !recover_ms && link.dbr.bitrate() >= BENCH_DBR_VIDEO_BITRATE)
+                recover_ms = now - BENCH_DBR_RECOVER_MS;
+
+            link.step(now, slow ? slow_link : BENCH_DBR_FAST_LINK);
+
+            if (slow && link.last_late_ms == now)
+                settle_ms = now - BENCH_DBR_DROP_MS;
+        }
+
+        /* mean video bitrate of the settled frames against the link */
+        utilization = settled_frames ? (double)slow_bits / settled_frames / (slow_link - BENCH_DBR_AUDIO_BITRATE) : 0;
+        dropped = link.dropped;
+    }
+
+    base_set_log_handler(nullptr);
+
+    state.counters["settle_s"] = (double)settle_ms / 1000;
+    state.counters["utilization"] = utilization;
+    state.counters["latency_ms"] = (double)settled_latency_ms;
+    state.counters["recover_s"] = recover_ms ? (double)recover_ms / 1000 : -1;
+    state.counters["dropped"] = dropped;
+
+    if (settle_ms > BENCH_DBR_CONVERGE_MS)
+        state.SkipWithError("latency did not settle within 10 s of the link drop");
+    else if (utilization > 1.0 || utilization < 0.5)
+        state.SkipWithError("settled bitrate does not fit the link");
+    else if (!recover_ms || recover_ms > BENCH_DBR_CONVERGE_MS)
+        state.SkipWithError("bitrate did not recover within 10 s of the link recovery");
+}
+BENCHMARK(BM_rtmp_dbr)->ArgName("link_kbps")->Arg(1500)->Arg(3000)->Arg(4500)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,54 @@
+#include "bench_common.h"
+#include "lite-obs/lite_obs_source.h"
+#include "lite-obs/lite_obs_source_graph.h"
+
+#include <atomic>
+#include <thread>
+
+#define BENCH_GRAPH_SOURCES 64
+
+/* what render_all_sources does every tick: grab the source list and walk
+ * it. "writer" runs a second thread that keeps calling set_pos and
+ * reordering sources the way an app animating its layout would, without it
+ * the readers never contend with anything */
+static void BM_source_graph_render_walk(benchmark::State &state)
+{
+    bool writer = state.range(0) != 0;
+
+    auto graph = std::make_shared<lite_obs_source_graph>();
+    std::vector<std::shared_ptr<lite_obs_source>> sources;
+    for (int i = 0; i < BENCH_GRAPH_SOURCES; i++) {
+        auto source = std::make_shared<lite_obs_source>(source_type::SOURCE_VIDEO, nullptr, nullptr);
+        sources.push_back(source);
+        graph->add(source);
+    }
+
+    std::atomic_bool stop = false;
+    std::thread hammer;
+    if (writer) {
+        hammer = std::thread([&] {
+            size_t i = 0;
+            while (!stop) {
+                auto &source = sources[i++ % sources.size()];
+                source->lite_source_set_pos((float)i, (float)i);
+                graph->move(source, (i & 1) ? MOVE_UP : MOVE_DOWN);
+            }
+        });
+    }
+
+    for (auto _ : state) {
+        auto snapshot = graph->snapshot();
+        size_t video = 0;
+        for (auto &source : *snapshot) {
+            if (source->lite_source_type() & source_type::SOURCE_VIDEO)
+                video++;
+        }
+        benchmark::DoNotOptimize(video);
+    }
+    state.SetItemsProcessed(state.iterations() * BENCH_GRAPH_SOURCES);
+
+    stop = true;
+    if (hammer.joinable())
+        hammer.join();
+}
+BENCHMARK(BM_source_graph_render_walk)->ArgName("writer")->Arg(0)->Arg(1)->UseRealTime();
@@ -0,0 +1,40 @@
+#include "bench_common.h"
+#include "lite-obs/graphics/gs_subsystem.h"
+#include "lite-obs/graphics/gs_texture.h"
+
+#define BENCH_UPLOAD_WIDTH 1920
+#define BENCH_UPLOAD_HEIGHT 1080
+
+/* one rgba image per iteration the way output_video3 hands them in: take
+ * the graphics context, upload, release it. "recreate" allocates a new
+ * texture for every image, which is what the source used to do, "reuse"
+ * keeps uploading into the same one through its unpack buffer ring */
+static void BM_gs_texture_upload(benchmark::State &state)
+{
+    bool recreate = state.range(0) != 0;
+
+    auto graphics = graphics_subsystem::gs_create_graphics_system(nullptr);
+    if (!graphics) {
+        state.SkipWithError("no graphics context");
+        return;
+    }
+
+    auto image = bench_random_bytes(BENCH_UPLOAD_WIDTH * BENCH_UPLOAD_HEIGHT * 4, 1);
+    std::shared_ptr<gs_texture> tex;
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        graphics_subsystem::make_current(graphics);
+        if (recreate || !tex)
+            tex = gs_texture_create(BENCH_UPLOAD_WIDTH, BENCH_UPLOAD_HEIGHT, gs_color_format::GS_RGBA, GS_DYNAMIC);
+        tex->gs_texture_set_image(image->data(), BENCH_UPLOAD_WIDTH * 4, false);
+        graphics_subsystem::done_current(true);
+    }
+    bench_report(state, allocs, BENCH_UPLOAD_WIDTH * BENCH_UPLOAD_HEIGHT * 4);
+    state.SetItemsProcessed(state.iterations());
+
+    graphics_subsystem::make_current(graphics);
+    tex.reset();
+    graphics_subsystem::done_current();
+}
+BENCHMARK(BM_gs_texture_upload)->ArgName("recreate")->Arg(0)->Arg(1)->UseRealTime();
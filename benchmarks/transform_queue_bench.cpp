@@ -0,0 +1,42 @@
+#include "bench_common.h"
+#include "lite-obs/lite_obs_source_transform.h"
+
+#include <atomic>
+#include <thread>
+
+/* set_pos calls per second from one or more api threads while a fake
+ * render thread drains the queue the way render_texture does once per
+ * frame. items/s is the total number of calls across all threads */
+static void BM_source_transform_set_pos(benchmark::State &state)
+{
+    static source_transform_queue queue;
+    static std::atomic_bool stop;
+    static std::thread render;
+
+    if (state.thread_index() == 0) {
+        stop = false;
+        render = std::thread([] {
+            while (!stop) {
+                auto pending = queue.drain();
+                benchmark::DoNotOptimize(pending);
+                std::this_thread::sleep_for(std::chrono::microseconds(1000000 / BENCH_VIDEO_FPS));
+            }
+        });
+    }
+
+    float i = 0;
+    for (auto _ : state) {
+        source_transform_command cmd{source_transform_type::pos, {}};
+        cmd.vec = {i, i};
+        queue.push(cmd);
+        i += 1.0f;
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        stop = true;
+        render.join();
+        queue.drain();
+    }
+}
+BENCHMARK(BM_source_transform_set_pos)->Threads(1)->Threads(4)->UseRealTime();
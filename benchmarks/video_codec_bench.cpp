@@ -0,0 +1,168 @@
+#include "bench_common.h"
+#include "lite-obs/encoder/x264_encoder.h"
+#include "lite-obs/encoder/ffmpeg_video_encoder.h"
+
+#include <string.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+#define BENCH_CODEC_WIDTH 1280
+#define BENCH_CODEC_HEIGHT 720
+#define BENCH_CODEC_BITRATE 3000
+
+/* encodes the clip with x264 and, at the same bitrate and preset, with the
+ * hevc and av1 encoders the way lite_obs_encoder sets them up. reports
+ * encoded frames per second and the resulting bitrate, so the speed each
+ * codec costs can be weighed against the size it saves. skipped when the
+ * ffmpeg build lacks the encoder */
+static void BM_video_codec_x264(benchmark::State &state)
+{
+    auto &clip = bench_video_clip(BENCH_CODEC_WIDTH, BENCH_CODEC_HEIGHT, false);
+
+    x264_encoder_settings settings;
+    x264_param_t params;
+    memset(&params, 0, sizeof(params));
+    if (!x264_apply_settings(&params, settings, BENCH_CODEC_BITRATE, BENCH_VIDEO_FPS, 1, false)) {
+        state.SkipWithError("x264_apply_settings failed");
+        return;
+    }
+
+    params.i_width = BENCH_CODEC_WIDTH;
+    params.i_height = BENCH_CODEC_HEIGHT;
+    params.i_fps_num = BENCH_VIDEO_FPS;
+    params.i_fps_den = 1;
+    params.i_csp = X264_CSP_I420;
+    params.b_vfr_input = false;
+    params.i_log_level = X264_LOG_NONE;
+
+    x264_t *context = x264_encoder_open(&params);
+    if (!context) {
+        state.SkipWithError("x264_encoder_open failed");
+        return;
+    }
+
+    x264_picture_t pic, pic_out;
+    x264_picture_init(&pic);
+    pic.img.i_csp = X264_CSP_I420;
+    pic.img.i_plane = 3;
+    pic.img.i_stride[0] = BENCH_CODEC_WIDTH;
+    pic.img.i_stride[1] = BENCH_CODEC_WIDTH / 2;
+    pic.img.i_stride[2] = BENCH_CODEC_WIDTH / 2;
+
+    const size_t luma = (size_t)BENCH_CODEC_WIDTH * BENCH_CODEC_HEIGHT;
+    int64_t pts = 0;
+    size_t bytes = 0;
+    x264_nal_t *nals = nullptr;
+    int nal_count = 0;
+
+    for (auto _ : state) {
+        for (auto &frame : clip) {
+            pic.i_pts = pts++;
+            pic.img.plane[0] = frame.data();
+            pic.img.plane[1] = frame.data() + luma;
+            pic.img.plane[2] = frame.data() + luma + luma / 4;
+
+            int size = x264_encoder_encode(context, &nals, &nal_count, &pic, &pic_out);
+            if (size > 0)
+                bytes += (size_t)size;
+        }
+    }
+
+    while (x264_encoder_delayed_frames(context) > 0) {
+        int size = x264_encoder_encode(context, &nals, &nal_count, nullptr, &pic_out);
+        if (size < 0)
+            break;
+        bytes += (size_t)size;
+    }
+    x264_encoder_close(context);
+
+    double frames = (double)pts;
+    state.counters["fps"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+    state.counters["kbps"] = frames ? (double)bytes * 8 * BENCH_VIDEO_FPS / frames / 1000 : 0;
+    state.SetLabel("x264");
+}
+BENCHMARK(BM_video_codec_x264)->Unit(benchmark::kMillisecond);
+
+static void BM_video_codec_ffmpeg(benchmark::State &state)
+{
+    auto codec = state.range(0) ? ffmpeg_video_codec::AV1 : ffmpeg_video_codec::HEVC;
+    const char *name = ffmpeg_video_encoder_name(codec);
+    state.SetLabel(name);
+
+    auto &clip = bench_video_clip(BENCH_CODEC_WIDTH, BENCH_CODEC_HEIGHT, false);
+
+    const AVCodec *av_codec = avcodec_find_encoder_by_name(name);
+    if (!av_codec) {
+        state.SkipWithError("encoder not in this ffmpeg build");
+        return;
+    }
+
+    AVCodecContext *context = avcodec_alloc_context3(av_codec);
+    x264_encoder_settings settings;
+    ffmpeg_video_apply_settings(context, codec, settings, BENCH_CODEC_BITRATE, BENCH_VIDEO_FPS, 1);
+    context->width = BENCH_CODEC_WIDTH;
+    context->height = BENCH_CODEC_HEIGHT;
+    context->pix_fmt = AV_PIX_FMT_YUV420P;
+
+    AVFrame *vframe = av_frame_alloc();
+    AVPacket *av_pkt = av_packet_alloc();
+    if (avcodec_open2(context, av_codec, nullptr) < 0) {
+        state.SkipWithError("avcodec_open2 failed");
+        av_packet_free(&av_pkt);
+        av_frame_free(&vframe);
+        avcodec_free_context(&context);
+        return;
+    }
+
+    const size_t luma = (size_t)BENCH_CODEC_WIDTH * BENCH_CODEC_HEIGHT;
+    vframe->format = AV_PIX_FMT_YUV420P;
+    vframe->width = BENCH_CODEC_WIDTH;
+    vframe->height = BENCH_CODEC_HEIGHT;
+    vframe->linesize[0] = BENCH_CODEC_WIDTH;
+    vframe->linesize[1] = BENCH_CODEC_WIDTH / 2;
+    vframe->linesize[2] = BENCH_CODEC_WIDTH / 2;
+
+    int64_t pts = 0;
+    size_t bytes = 0;
+    bool failed = false;
+
+    auto receive = [&]() {
+        int ret;
+        while ((ret = avcodec_receive_packet(context, av_pkt)) == 0) {
+            bytes += (size_t)av_pkt->size;
+            av_packet_unref(av_pkt);
+        }
+        failed |= ret != AVERROR(EAGAIN) && ret != AVERROR_EOF;
+    };
+
+    for (auto _ : state) {
+        for (auto &frame : clip) {
+            /* the frame has no buffers, so avcodec_send_frame copies it */
+            vframe->data[0] = frame.data();
+            vframe->data[1] = frame.data() + luma;
+            vframe->data[2] = frame.data() + luma + luma / 4;
+            vframe->pts = pts++;
+
+            failed |= avcodec_send_frame(context, vframe) < 0;
+            receive();
+        }
+    }
+
+    avcodec_send_frame(context, nullptr);
+    receive();
+
+    av_packet_free(&av_pkt);
+    av_frame_free(&vframe);
+    avcodec_free_context(&context);
+
+    if (failed)
+        state.SkipWithError("encoding failed");
+
+    double frames = (double)pts;
+    state.counters["fps"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+    state.counters["kbps"] = frames ? (double)bytes * 8 * BENCH_VIDEO_FPS / frames / 1000 : 0;
+}
+BENCHMARK(BM_video_codec_ffmpeg)->ArgName("av1")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,69 @@
+#include "bench_common.h"
+#include "lite-obs/media-io/video_scaler.h"
+#include "lite-obs/media-io/video_frame.h"
+
+#include <string.h>
+
+#define BENCH_CONVERT_WIDTH 1920
+#define BENCH_CONVERT_HEIGHT 1080
+
+/* one 1080p frame through video_scaler for the conversions video_output
+ * inputs ask for most. these go through the video_convert kernels, the
+ * "swscale" variant uses point sampling for the downscale which keeps it on
+ * the swscale path for comparison */
+static void run_scaler(benchmark::State &state, video_format src_format, video_format dst_format, uint32_t dst_width, uint32_t dst_height, video_scale_type type)
+{
+    video_scale_info src{src_format, BENCH_CONVERT_WIDTH, BENCH_CONVERT_HEIGHT, video_range_type::VIDEO_RANGE_PARTIAL, video_colorspace::VIDEO_CS_709};
+    video_scale_info dst{dst_format, dst_width, dst_height, video_range_type::VIDEO_RANGE_PARTIAL, video_colorspace::VIDEO_CS_709};
+
+    video_scaler scaler;
+    if (scaler.create(&dst, &src, type) != VIDEO_SCALER_SUCCESS) {
+        state.SkipWithError("failed to create scaler");
+        return;
+    }
+
+    video_frame in, out;
+    in.frame_init(src_format, BENCH_CONVERT_WIDTH, BENCH_CONVERT_HEIGHT);
+    out.frame_init(dst_format, dst_width, dst_height);
+    for (size_t i = 0; i < in.data.size(); i++) {
+        if (in.data[i])
+            memset(in.data[i], (int)(0x40 + i * 0x20), in.linesize[i] * 16);
+    }
+
+    auto allocs = bench_allocations();
+    for (auto _ : state) {
+        scaler.video_scaler_scale(out.data.data(), out.linesize.data(), in.data.data(), in.linesize.data());
+        benchmark::DoNotOptimize(out.data[0]);
+    }
+    bench_report(state, allocs, BENCH_CONVERT_WIDTH * BENCH_CONVERT_HEIGHT);
+}
+
+static void BM_video_convert_nv12_to_i420(benchmark::State &state)
+{
+    run_scaler(state, video_format::VIDEO_FORMAT_NV12, video_format::VIDEO_FORMAT_I420, BENCH_CONVERT_WIDTH, BENCH_CONVERT_HEIGHT, video_scale_type::VIDEO_SCALE_DEFAULT);
+}
+BENCHMARK(BM_video_convert_nv12_to_i420);
+
+static void BM_video_convert_bgra_to_nv12(benchmark::State &state)
+{
+    run_scaler(state, video_format::VIDEO_FORMAT_BGRA, video_format::VIDEO_FORMAT_NV12, BENCH_CONVERT_WIDTH, BENCH_CONVERT_HEIGHT, video_scale_type::VIDEO_SCALE_DEFAULT);
+}
+BENCHMARK(BM_video_convert_bgra_to_nv12);
+
+static void BM_video_convert_rgba_to_i420(benchmark::State &state)
+{
+    run_scaler(state, video_format::VIDEO_FORMAT_RGBA, video_format::VIDEO_FORMAT_I420, BENCH_CONVERT_WIDTH, BENCH_CONVERT_HEIGHT, video_scale_type::VIDEO_SCALE_DEFAULT);
+}
+BENCHMARK(BM_video_convert_rgba_to_i420);
+
+static void BM_video_convert_nv12_half(benchmark::State &state)
+{
+    run_scaler(state, video_format::VIDEO_FORMAT_NV12, video_format::VIDEO_FORMAT_NV12, BENCH_CONVERT_WIDTH / 2, BENCH_CONVERT_HEIGHT / 2, video_scale_type::VIDEO_SCALE_DEFAULT);
+}
+BENCHMARK(BM_video_convert_nv12_half);
+
+static void BM_video_convert_nv12_half_swscale(benchmark::State &state)
+{
+    run_scaler(state, video_format::VIDEO_FORMAT_NV12, video_format::VIDEO_FORMAT_NV12, BENCH_CONVERT_WIDTH / 2, BENCH_CONVERT_HEIGHT / 2, video_scale_type::VIDEO_SCALE_POINT);
+}
+BENCHMARK(BM_video_convert_nv12_half_swscale);
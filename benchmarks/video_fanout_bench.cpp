@@ -0,0 +1,204 @@
+#include "bench_common.h"
+#include "lite-obs/media-io/video_output.h"
+#include "lite-obs/util/threading.h"
+
+#include <algorithm>
+#include <string.h>
+#include <string>
+
+#define BENCH_FANOUT_WIDTH 1920
+#define BENCH_FANOUT_HEIGHT 1080
+#define BENCH_FANOUT_FRAMES 600
+
+struct fanout_input {
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<uint64_t> latency_ns{};
+
+    static void callback(void *param, struct video_data *frame) {
+        auto input = (fanout_input *)param;
+        input->latency_ns.push_back(os_gettime_ns() - frame->timestamp);
+    }
+};
+
+static uint64_t percentile(std::vector<uint64_t> &values, double p)
+{
+    if (values.empty())
+        return 0;
+
+    size_t idx = (size_t)(p * (double)(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + idx, values.end());
+    return values[idx];
+}
+
+/* 1080p60 nv12 output with three raw inputs: one at full size and two that
+ * scale to 720p and 360p. frames are paced at the output rate, every frame
+ * is stamped when it is handed to video_output, and each input records how
+ * long it took to reach its callback. */
+static void BM_video_output_fanout(benchmark::State &state)
+{
+    video_output_info info{};
+    info.name = "bench";
+    info.format = video_format::VIDEO_FORMAT_NV12;
+    info.fps_num = BENCH_VIDEO_FPS;
+    info.fps_den = 1;
+    info.width = BENCH_FANOUT_WIDTH;
+    info.height = BENCH_FANOUT_HEIGHT;
+    info.cache_size = 6;
+
+    auto vo = std::make_shared<video_output>();
+    if (vo->video_output_open(&info) != VIDEO_OUTPUT_SUCCESS) {
+        state.SkipWithError("failed to open video output");
+        return;
+    }
+
+    fanout_input inputs[3];
+    inputs[0].width = BENCH_FANOUT_WIDTH;
+    inputs[0].height = BENCH_FANOUT_HEIGHT;
+    inputs[1].width = 1280;
+    inputs[1].height = 720;
+    inputs[2].width = 640;
+    inputs[2].height = 360;
+
+    for (auto &input : inputs) {
+        video_scale_info conversion{};
+        conversion.format = video_format::VIDEO_FORMAT_I420;
+        conversion.width = input.width;
+        conversion.height = input.height;
+        input.latency_ns.reserve(BENCH_FANOUT_FRAMES);
+        vo->video_output_connect(&conversion, fanout_input::callback, &input);
+    }
+
+    uint64_t frame_time = vo->video_output_get_frame_time();
+    uint64_t next = os_gettime_ns();
+
+    for (auto _ : state) {
+        os_sleepto_ns(next);
+        next += frame_time;
+
+        video_frame frame;
+        uint64_t now = os_gettime_ns();
+        if (vo->video_output_lock_frame(&frame, 1, now)) {
+            memset(frame.data[0], 0x80, frame.linesize[0] * BENCH_FANOUT_HEIGHT);
+            vo->video_output_unlock_frame();
+        }
+    }
+
+    for (auto &input : inputs)
+        vo->video_output_disconnect(fanout_input::callback, &input);
+    vo->video_output_close();
+
+    for (auto &input : inputs) {
+        std::string name = std::to_string(input.height) + "p";
+        state.counters[name + "_p50_us"] = (double)percentile(input.latency_ns, 0.50) / 1000.0;
+        state.counters[name + "_p99_us"] = (double)percentile(input.latency_ns, 0.99) / 1000.0;
+        state.counters[name + "_max_us"] = (double)percentile(input.latency_ns, 1.0) / 1000.0;
+        state.counters[name + "_frames"] = (double)input.latency_ns.size();
+    }
+}
+BENCHMARK(BM_video_output_fanout)->Iterations(BENCH_FANOUT_FRAMES)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+#define BENCH_SLOW_WIDTH 640
+#define BENCH_SLOW_HEIGHT 360
+/* the slow input needs this many frame times per frame */
+#define BENCH_SLOW_FACTOR 3
+
+struct slow_input {
+    uint64_t delay_ns{};
+    uint64_t last_timestamp{};
+    bool in_order = true;
+    std::vector<uint64_t> latency_ns{};
+
+    static void callback(void *param, struct video_data *frame) {
+        auto input = (slow_input *)param;
+        input->in_order &= frame->timestamp > input->last_timestamp;
+        input->last_timestamp = frame->timestamp;
+        input->latency_ns.push_back(os_gettime_ns() - frame->timestamp);
+        if (input->delay_ns)
+            os_sleepto_ns(os_gettime_ns() + input->delay_ns);
+    }
+};
+
+/* two inputs that keep up and a mock encoder that takes three frame times
+ * per frame, all without scaling. the fast inputs have to get every frame,
+ * the slow one has to stay on recent frames by dropping the oldest waiting
+ * ones rather than working through a growing backlog */
+static void BM_video_output_slow_input(benchmark::State &state)
+{
+    video_output_info info{};
+    info.name = "bench";
+    info.format = video_format::VIDEO_FORMAT_NV12;
+    info.fps_num = BENCH_VIDEO_FPS;
+    info.fps_den = 1;
+    info.width = BENCH_SLOW_WIDTH;
+    info.height = BENCH_SLOW_HEIGHT;
+    info.cache_size = 6;
+
+    auto vo = std::make_shared<video_output>();
+    if (vo->video_output_open(&info) != VIDEO_OUTPUT_SUCCESS) {
+        state.SkipWithError("failed to open video output");
+        return;
+    }
+
+    uint64_t frame_time = vo->video_output_get_frame_time();
+    slow_input inputs[3];
+    inputs[2].delay_ns = frame_time * BENCH_SLOW_FACTOR;
+    for (auto &input : inputs) {
+        input.latency_ns.reserve(BENCH_FANOUT_FRAMES);
+        vo->video_output_connect(nullptr, slow_input::callback, &input);
+    }
+
+    uint64_t next = os_gettime_ns();
+    int64_t frames = 0;
+
+    for (auto _ : state) {
+        os_sleepto_ns(next);
+        next += frame_time;
+
+        video_frame frame;
+        if (vo->video_output_lock_frame(&frame, 1, os_gettime_ns())) {
+            memset(frame.data[0], 0x80, frame.linesize[0] * BENCH_SLOW_HEIGHT);
+            vo->video_output_unlock_frame();
+        }
+        frames++;
+    }
+
+    /* let the fast inputs drain what is still queued */
+    os_sleepto_ns(os_gettime_ns() + frame_time * 2);
+
+    video_input_stats stats[3];
+    for (int i = 0; i < 3; i++)
+        vo->video_output_get_input_stats(slow_input::callback, &inputs[i], &stats[i]);
+
+    for (auto &input : inputs)
+        vo->video_output_disconnect(slow_input::callback, &input);
+    vo->video_output_close();
+
+    bool fast_complete = true;
+    for (int i = 0; i < 2; i++)
+        fast_complete &= inputs[i].latency_ns.size() + (size_t)frames / 100 >= (size_t)frames;
+
+    bool in_order = true;
+    for (auto &input : inputs)
+        in_order &= input.in_order;
+
+    /* one frame being encoded and queue_limit waiting, nothing older */
+    uint64_t slow_max = percentile(inputs[2].latency_ns, 1.0);
+    uint64_t slow_bound = (stats[2].queue_limit + 2) * frame_time * BENCH_SLOW_FACTOR;
+
+    state.counters["fast_frames"] = (double)inputs[0].latency_ns.size();
+    state.counters["fast_p99_us"] = (double)percentile(inputs[0].latency_ns, 0.99) / 1000.0;
+    state.counters["slow_frames"] = (double)inputs[2].latency_ns.size();
+    state.counters["slow_dropped"] = (double)stats[2].dropped_frames;
+    state.counters["slow_max_depth"] = (double)stats[2].max_queue_depth;
+    state.counters["slow_avg_ms"] = (double)stats[2].avg_callback_ns / 1000000.0;
+    state.counters["slow_max_lag_ms"] = (double)slow_max / 1000000.0;
+
+    if (!fast_complete)
+        state.SkipWithError("a fast input lost frames to the slow one");
+    else if (!in_order)
+        state.SkipWithError("an input got frames out of order");
+    else if (slow_max > slow_bound)
+        state.SkipWithError("the slow input fell behind instead of dropping old frames");
+}
+BENCHMARK(BM_video_output_slow_input)->Iterations(BENCH_FANOUT_FRAMES)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,104 @@
+#include "bench_common.h"
+#include "lite-obs/encoder/x264_encoder.h"
+
+#include <string.h>
+
+#define BENCH_X264_WIDTH 1280
+#define BENCH_X264_HEIGHT 720
+#define BENCH_X264_BITRATE 6000
+
+static const char *const bench_x264_presets[] = {
+    "ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow",
+};
+
+static x264_t *bench_x264_open(const x264_encoder_settings &settings, int width, int height, int bitrate)
+{
+    x264_param_t params;
+    memset(&params, 0, sizeof(params));
+    if (!x264_apply_settings(&params, settings, bitrate, BENCH_VIDEO_FPS, 1, false))
+        return nullptr;
+
+    params.i_width = width;
+    params.i_height = height;
+    params.i_fps_num = BENCH_VIDEO_FPS;
+    params.i_fps_den = 1;
+    params.i_csp = X264_CSP_NV12;
+    params.b_vfr_input = false;
+    params.b_repeat_headers = false;
+    params.i_log_level = X264_LOG_NONE;
+    return x264_encoder_open(&params);
+}
+
+static void bench_x264_set_frame(x264_picture_t *pic, std::vector<uint8_t> &frame, int width, int height)
+{
+    pic->img.i_csp = X264_CSP_NV12;
+    pic->img.i_plane = 2;
+    pic->img.i_stride[0] = width;
+    pic->img.i_stride[1] = width;
+    pic->img.plane[0] = frame.data();
+    pic->img.plane[1] = frame.data() + width * height;
+}
+
+/* encodes the clip with the cbr setup the x264 encoder uses under each
+ * preset, frame threaded and in low latency mode. reports encoded frames
+ * per second, the resulting bitrate and the most frames the encoder held
+ * back. x264_latency_test checks low latency frames come out in order */
+static void BM_x264_preset(benchmark::State &state)
+{
+    auto &clip = bench_video_clip(BENCH_X264_WIDTH, BENCH_X264_HEIGHT, true);
+
+    x264_encoder_settings settings;
+    settings.preset = bench_x264_presets[state.range(0)];
+    settings.low_latency = state.range(1) != 0;
+
+    x264_t *context = bench_x264_open(settings, BENCH_X264_WIDTH, BENCH_X264_HEIGHT, BENCH_X264_BITRATE);
+    if (!context) {
+        state.SkipWithError("x264_encoder_open failed");
+        return;
+    }
+
+    x264_picture_t pic, pic_out;
+    x264_picture_init(&pic);
+
+    int64_t pts = 0;
+    int64_t frames_out = 0;
+    int64_t max_delay = 0;
+    size_t bytes = 0;
+    x264_nal_t *nals = nullptr;
+    int nal_count = 0;
+
+    for (auto _ : state) {
+        for (auto &frame : clip) {
+            pic.i_pts = pts++;
+            bench_x264_set_frame(&pic, frame, BENCH_X264_WIDTH, BENCH_X264_HEIGHT);
+
+            int size = x264_encoder_encode(context, &nals, &nal_count, &pic, &pic_out);
+            if (size > 0) {
+                bytes += (size_t)size;
+                frames_out++;
+            }
+
+            if (pts - frames_out > max_delay)
+                max_delay = pts - frames_out;
+        }
+    }
+
+    /* lookahead and b-frames hold frames back, count what is still queued */
+    while (x264_encoder_delayed_frames(context) > 0) {
+        int size = x264_encoder_encode(context, &nals, &nal_count, nullptr, &pic_out);
+        if (size < 0)
+            break;
+        bytes += (size_t)size;
+    }
+    x264_encoder_close(context);
+
+    double frames = (double)pts;
+    state.counters["fps"] = benchmark::Counter(frames, benchmark::Counter::kIsRate);
+    state.counters["kbps"] = frames ? (double)bytes * 8 * BENCH_VIDEO_FPS / frames / 1000 : 0;
+    state.counters["delay_frames"] = (double)max_delay;
+    state.SetLabel(settings.preset);
+}
+BENCHMARK(BM_x264_preset)
+    ->ArgNames({"preset", "low_latency"})
+    ->ArgsProduct({benchmark::CreateDenseRange(0, sizeof(bench_x264_presets) / sizeof(bench_x264_presets[0]) - 1, 1), {0, 1}})
+    ->Unit(benchmark::kMillisecond);
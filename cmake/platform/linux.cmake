@@ -0,0 +1,34 @@
+set(TARGET_OS linux)
+
+option(LITEOBS_LINUX_OSMESA "Use OSMesa instead of EGL for offscreen rendering on Linux" OFF)
+
+target_compile_definitions(
+    ${PROJECT_NAME}
+    PUBLIC LINUX
+)
+
+if(LITEOBS_LINUX_OSMESA)
+    find_path(OSMESA_INCLUDE_DIR NAMES GL/osmesa.h)
+    find_library(OSMESA_LIB NAMES OSMesa)
+    if (NOT OSMESA_INCLUDE_DIR OR NOT OSMESA_LIB)
+        message(FATAL_ERROR "Could not find OSMesa library")
+    endif()
+
+    target_compile_definitions(${PROJECT_NAME} PRIVATE LITEOBS_USE_OSMESA)
+    target_include_directories(${PROJECT_NAME} PRIVATE ${OSMESA_INCLUDE_DIR})
+    target_link_libraries(${PROJECT_NAME} PRIVATE ${OSMESA_LIB})
+else()
+    set(OpenGL_GL_PREFERENCE GLVND)
+    find_package(OpenGL REQUIRED COMPONENTS OpenGL EGL)
+    target_link_libraries(${PROJECT_NAME} PRIVATE OpenGL::OpenGL OpenGL::EGL)
+endif()
+
+find_package(Threads REQUIRED)
+
+target_link_libraries(
+    ${PROJECT_NAME}
+    PRIVATE
+    Threads::Threads
+    dl
+    z
+)
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lite-obs/lite_encoder.h"
+
+struct AVCodecContext;
+
+/* software encoders libavcodec wraps for codecs x264 can't produce */
+enum class ffmpeg_video_codec {
+    HEVC,
+    AV1,
+};
+
+/* "libx265" or "libsvtav1" */
+const char *ffmpeg_video_encoder_name(ffmpeg_video_codec codec);
+
+/* cbr setup of the codec's encoder on an allocated but not yet opened
+ * context, bitrate in kbps. the x264 preset, threads, b-frames, keyframe
+ * interval and low latency mode are mapped to the closest equivalents,
+ * x264_opts and crf are ignored. pixel format, size and colors are up to
+ * the caller */
+void ffmpeg_video_apply_settings(AVCodecContext *context, ffmpeg_video_codec codec, const x264_encoder_settings &settings,
+                                 int bitrate, uint32_t fps_num, uint32_t fps_den);
+
+struct ffmpeg_video_encoder_private;
+class ffmpeg_video_encoder : public lite_obs_encoder_interface
+{
+public:
+    ffmpeg_video_encoder(lite_obs_encoder *encoder, ffmpeg_video_codec codec);
+    virtual ~ffmpeg_video_encoder();
+    virtual const char *i_encoder_codec();
+    virtual obs_encoder_type i_encoder_type();
+    virtual bool i_create();
+    virtual void i_destroy();
+    virtual bool i_encoder_valid();
+    virtual bool i_encode(encoder_frame *frame, std::shared_ptr<encoder_packet> packet, std::function<void(std::shared_ptr<encoder_packet>)> send_off);
+    virtual bool i_get_extra_data(uint8_t **extra_data, size_t *size);
+    virtual void i_get_video_info(struct video_scale_info *info);
+    virtual bool i_gpu_encode_available();
+    virtual void i_update_encode_bitrate(int bitrate);
+
+private:
+    bool update_settings();
+    bool init_codec();
+
+private:
+    std::unique_ptr<ffmpeg_video_encoder_private> d_ptr{};
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "lite-obs/lite_encoder.h"
+
+struct AVCodecContext;
+
+/* opus runs at 48 kHz internally, the audio is resampled to it */
+#define OPUS_SAMPLE_RATE 48000
+
+/* frame duration, complexity, application and sample rate on an allocated
+ * but not yet opened libopus context. unsupported frame durations fall back
+ * to 20 ms, which is returned */
+int opus_apply_settings(AVCodecContext *context, const opus_encoder_settings &settings);
+
+struct lite_opus_encoder_private;
+class lite_opus_encoder : public lite_obs_encoder_interface
+{
+public:
+    lite_opus_encoder(lite_obs_encoder *encoder);
+    virtual ~lite_opus_encoder();
+
+    virtual const char *i_encoder_codec();
+    virtual obs_encoder_type i_encoder_type();
+    virtual bool i_create();
+    virtual void i_destroy();
+    virtual bool i_encoder_valid();
+    virtual bool i_encode(encoder_frame *frame, std::shared_ptr<encoder_packet> packet, std::function<void(std::shared_ptr<encoder_packet>)> send_off);
+    virtual size_t i_get_frame_size();
+    virtual bool i_get_extra_data(uint8_t **extra_data, size_t *size);
+    virtual void i_get_audio_info(struct audio_convert_info *info);
+
+private:
+    bool initialize_codec();
+
+private:
+    std::unique_ptr<lite_opus_encoder_private> d_ptr{};
+};
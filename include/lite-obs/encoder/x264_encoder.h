@@ -3,6 +3,13 @@
 #include "lite-obs/lite_encoder.h"
 #include <x264.h>
 
+/* applies settings to params, bitrates in kbps. the preset and tune are
+ * loaded first and x264_opts parsed last, unless reconfig is set in which
+ * case only what x264_encoder_reconfig can change is touched. returns false
+ * if x264 rejects the preset, the tune or one of the options */
+bool x264_apply_settings(x264_param_t *params, const x264_encoder_settings &settings,
+                         int bitrate, uint32_t fps_num, uint32_t fps_den, bool reconfig);
+
 struct x264_encoder_private;
 class x264_encoder : public lite_obs_encoder_interface
 {
@@ -23,7 +30,7 @@ public:
 
 private:
     bool update_settings(bool update);
-    void update_params(bool update);
+    bool update_params(const x264_encoder_settings &settings, bool update);
     void load_headers();
 
     void init_pic_data(x264_picture_t *pic, encoder_frame *frame);
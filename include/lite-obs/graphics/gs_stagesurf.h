@@ -14,6 +14,7 @@ public:
     bool gs_stagesurface_create(uint32_t width, uint32_t height, gs_color_format color_format);
 
     void gs_stagesurface_stage_texture(const std::shared_ptr<gs_texture> &src);
+    bool gs_stagesurface_ready();
 
     uint32_t gs_stagesurface_get_width();
     uint32_t gs_stagesurface_get_height();
@@ -24,6 +25,8 @@ public:
 private:
     bool create_pixel_pack_buffer();
     bool can_stage(std::shared_ptr<gs_texture> src);
+    void insert_fence();
+    void release_fence();
 
 private:
     std::unique_ptr<gs_stagesurface_private> d_ptr{};
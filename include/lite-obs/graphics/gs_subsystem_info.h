@@ -25,6 +25,12 @@
 #include <windows.h>
 #include <glad/glad_wgl.h>
 
+#elif TARGET_PLATFORM == PLATFORM_LINUX
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
 #endif
 
 #include <stdint.h>
@@ -41,6 +41,7 @@ public:
 
     bool gs_texture_is_rect();
     bool gs_texture_is_render_target();
+    bool gs_texture_is_dynamic();
 
     std::shared_ptr<fbo_info> get_fbo();
     GLuint gs_texture_obj();
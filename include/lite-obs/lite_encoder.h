@@ -12,6 +12,7 @@ class lite_obs_core_video;
 class lite_obs_core_audio;
 class video_output;
 class audio_output;
+struct video_input_stats;
 class lite_obs_output;
 class lite_obs_encoder;
 
@@ -49,13 +50,17 @@ public:
         X264,
         MEDIACODEC,
         VIDEOTOOLBOX,
+        X265,
+        SVT_AV1,
+        OPUS,
     };
 
     lite_obs_encoder(encoder_id id, int bitrate, size_t mixer_idx);
     ~lite_obs_encoder();
 
     obs_encoder_type lite_obs_encoder_type();
-    bool lite_obs_encoder_reset_encoder_impl(encoder_id id);
+    /* force recreates the implementation even if it already is id */
+    bool lite_obs_encoder_reset_encoder_impl(encoder_id id, bool force = false);
 
     void lite_obs_encoder_update_bitrate(int bitrate);
     int lite_obs_encoder_bitrate();
@@ -70,12 +75,29 @@ public:
     uint32_t lite_obs_encoder_get_sample_rate();
     size_t lite_obs_encoder_get_frame_size();
 
+    /* frames the implementation held back after the last encode call, 0
+     * when every frame comes out of the call it went into */
+    uint32_t lite_obs_encoder_get_delay_frames();
+
+    /* queue and timing of the raw frames video_output delivers to this
+     * encoder, false for audio and gpu encoders */
+    bool lite_obs_encoder_get_input_stats(video_input_stats *stats);
+
+    void lite_obs_encoder_set_x264_settings(const x264_encoder_settings &settings);
+    x264_encoder_settings lite_obs_encoder_get_x264_settings();
+
+    /* read when the opus encoder is created */
+    void lite_obs_encoder_set_opus_settings(const opus_encoder_settings &settings);
+    opus_encoder_settings lite_obs_encoder_get_opus_settings();
+
     void lite_obs_encoder_set_preferred_video_format(video_format format);
     video_format lite_obs_encoder_get_preferred_video_format();
 
     bool lite_obs_encoder_get_extra_data(uint8_t **extra_data, size_t *size);
 
     void lite_obs_encoder_set_core_video(std::shared_ptr<lite_obs_core_video> c_v);
+    /* feeds the encoder from video, a rendition of the core video set before */
+    void lite_obs_encoder_set_video(std::shared_ptr<video_output> video);
     void lite_obs_encoder_set_core_audio(std::shared_ptr<lite_obs_core_audio> c_a);
 
     std::shared_ptr<video_output> lite_obs_encoder_video();
@@ -89,7 +111,8 @@ public:
 
     void lite_obs_encoder_set_sei(char *sei, int len);
     void lite_obs_encoder_clear_sei();
-    bool lite_obs_encoder_get_sei(uint8_t *sei, int *sei_len);
+    /* sei points at data owned by the encoder, valid until the next set or clear */
+    bool lite_obs_encoder_get_sei(const uint8_t **sei, size_t *sei_len);
     void lite_obs_encoder_set_sei_rate(uint32_t rate);
     uint32_t lite_obs_encoder_get_sei_rate();
 
@@ -99,6 +122,8 @@ public:
     void obs_encoder_stop(new_packet cb, void *param);
     void obs_encoder_add_output(std::shared_ptr<lite_obs_output> output);
     void obs_encoder_remove_output(std::shared_ptr<lite_obs_output> output);
+    /* the outputs the encoder feeds, a bitrate change affects all of them */
+    size_t obs_encoder_output_count();
     bool start_gpu_encode();
     void stop_gpu_encode();
     void obs_encoder_destroy();
@@ -116,6 +141,7 @@ private:
     void receive_video_internal(struct video_data *frame);
     static void receive_video(void *param, struct video_data *frame);
     void receive_video_texture(uint64_t timestamp, int tex_id);
+    bool keyframe_due(uint64_t timestamp);
 
     bool encode_send(encoder_frame *frame, std::shared_ptr<encoder_packet> pkt);
     bool do_encode(encoder_frame *frame);
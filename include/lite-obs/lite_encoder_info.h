@@ -4,7 +4,9 @@
 #include <memory>
 #include <atomic>
 #include <vector>
+#include <string>
 #include "lite-obs/lite_obs_defines.h"
+#include "lite-obs/util/packet_pool.h"
 
 #define OBS_ENCODER_CAP_DEPRECATED (1 << 0)
 #define OBS_ENCODER_CAP_PASS_TEXTURE (1 << 1)
@@ -16,7 +18,7 @@ enum class obs_encoder_type {
 
 class lite_obs_encoder;
 struct encoder_packet {
-    std::shared_ptr<std::vector<uint8_t>> data;
+    packet_data data;
 
     bool encoder_first_packet{}; /** true encoder's first output packet */
 
@@ -62,12 +64,50 @@ struct encoder_packet {
     std::weak_ptr<lite_obs_encoder> encoder{};
 };
 
+/* packets and their control blocks come from the packet pool, so sending a
+ * frame does not go through the general purpose allocator */
+static inline std::shared_ptr<encoder_packet> encoder_packet_create()
+{
+    return std::allocate_shared<encoder_packet>(packet_pool_allocator<encoder_packet>());
+}
+
+/* copies the packet fields, the payload is shared with src */
+static inline std::shared_ptr<encoder_packet> encoder_packet_create(const encoder_packet &src)
+{
+    return std::allocate_shared<encoder_packet>(packet_pool_allocator<encoder_packet>(), src);
+}
+
 #define MICROSECOND_DEN 1000000
 static inline int64_t packet_dts_usec(std::shared_ptr<encoder_packet> packet)
 {
     return packet->dts * MICROSECOND_DEN / packet->timebase_den;
 }
 
+/* lite_obs_x264_settings with the strings copied and defaults filled in */
+struct x264_encoder_settings {
+    std::string preset = "veryfast";
+    std::string tune;
+    int threads{};
+    int lookahead{};
+    int bframes{};
+    int keyint_sec = 2;
+    int crf{};
+    int vbv_buffer_kbit{};
+    bool low_latency{};
+    /* keyframes only every keyint_sec on the shared video clock, so every
+     * encoder of a rendition ladder switches at the same frames */
+    bool aligned_keyframes{};
+    std::string x264_opts;
+};
+
+/* lite_obs_opus_settings with defaults filled in */
+struct opus_encoder_settings {
+    int frame_ms = 20;
+    int complexity = 10;
+    /* celt only with 2.5 ms of lookahead instead of 6.5 ms */
+    bool low_delay{};
+};
+
 /** Encoder input frame */
 struct encoder_frame {
     /** Data for the frame/audio */
@@ -81,4 +121,7 @@ struct encoder_frame {
 
     /** Presentation timestamp */
     int64_t pts{};
+
+    /** Force a keyframe (video only) */
+    bool keyframe{};
 };
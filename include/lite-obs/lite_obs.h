@@ -19,6 +19,13 @@ typedef struct lite_obs_media_source_api {
                           video_format format, video_range_type range,
                           video_colorspace color_space, uint32_t width,
                           uint32_t height);
+    /* like output_video2 but without copying the planes. the source reads them in place until the frame is uploaded
+     * (or dropped) and then calls release_cb(opaque), exactly once per call and in the order the frames came in.
+     * release_cb normally runs on the graphics thread and must not call back into the source */
+    void (*output_video2_borrowed)(struct lite_obs_media_source_api *source_api, const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES],
+                                   video_format format, video_range_type range,
+                                   video_colorspace color_space, uint32_t width,
+                                   uint32_t height, void (*release_cb)(void *opaque), void *opaque);
     //only support RGBA format
     void (*output_video3)(struct lite_obs_media_source_api *source_api, const uint8_t *img_data, uint32_t img_width, uint32_t img_height);
     void (*clear_video)(struct lite_obs_media_source_api *source_api);
@@ -30,6 +37,11 @@ typedef struct lite_obs_media_source_api {
     void (*set_order)(struct lite_obs_media_source_api *source_api, order_movement movement);
     void (*set_flip)(struct lite_obs_media_source_api *source_api, bool flip_h, bool flip_v);
     void (*reset_transform)(struct lite_obs_media_source_api *source_api);
+
+    /* how long async frames are held back to even out bursty input, frames arriving within it keep the source's cadence. 0 (default) shows each frame as soon as it is due */
+    void (*set_jitter_window)(struct lite_obs_media_source_api *source_api, uint32_t ms);
+    /* bit n routes the source's audio into audio track n, all tracks (default) when every bit is set */
+    void (*set_audio_mixers)(struct lite_obs_media_source_api *source_api, uint32_t mixers);
 } lite_obs_media_source_api;
 
 struct lite_obs;
@@ -41,8 +53,45 @@ typedef struct lite_obs_api {
 
     bool (*lite_obs_start_output)(struct lite_obs_api *core_api, output_type type, void *output_info, int vb, int ab, struct lite_obs_output_callbak callback);
     void (*lite_obs_stop_output)(struct lite_obs_api *core_api);
+    /* starts one more output next to the one above, e.g. a recording while streaming. all outputs share a single
+     * video encoder and the audio encoders, vb and ab only apply if no output has created them yet.
+     * returns an id for lite_obs_stop_output2 or -1 on failure */
+    int (*lite_obs_start_output2)(struct lite_obs_api *core_api, output_type type, void *output_info, int vb, int ab, struct lite_obs_output_callbak callback);
+    /* stops and destroys the output, blocks until it has finished */
+    void (*lite_obs_stop_output2)(struct lite_obs_api *core_api, int output_id);
+    /* like lite_obs_start_output2 with a video encoder of its own at width x height and vb. the composite is
+     * scaled down on the gpu and read back with the main frame, width is rounded down to a multiple of 4 and
+     * height to an even one. from the first rendition on every video encoder puts its keyframes on the shared
+     * video clock every keyint_sec, so the ladder switches at the same frames, running encoders are recreated for
+     * that. scaling needs an encoder that takes raw frames (x264, the ffmpeg h264 encoder or a hevc / av1 one).
+     * stop it with lite_obs_stop_output2 */
+    int (*lite_obs_start_rendition)(struct lite_obs_api *core_api, output_type type, void *output_info, uint32_t width, uint32_t height, int vb, int ab, struct lite_obs_output_callbak callback);
 
     void (*lite_obs_reset_encoder)(struct lite_obs_api *core_api, bool sw);
+    /* like lite_obs_reset_encoder, x264 (null for the defaults) also applies to x264 encoders created later.
+     * a running x264 encoder is recreated with the new settings */
+    void (*lite_obs_reset_encoder2)(struct lite_obs_api *core_api, bool sw, const struct lite_obs_x264_settings *x264);
+    /* like lite_obs_reset_encoder2 for codec (h264 by default). preset, threads, b-frames, keyint_sec and low_latency
+     * carry over to the hevc and av1 encoders. rtmp only takes h264, start hevc or av1 on the srt or file output */
+    void (*lite_obs_reset_encoder3)(struct lite_obs_api *core_api, bool sw, video_codec codec, const struct lite_obs_x264_settings *x264);
+
+    /* number of frames the gpu readback may run behind (2 - 8), applied on the next lite_obs_reset_video */
+    void (*lite_obs_set_video_readback_depth)(struct lite_obs_api *core_api, uint32_t depth);
+    /* frames between staging and downloading the last raw video frame */
+    uint32_t (*lite_obs_get_video_readback_latency)(struct lite_obs_api *core_api);
+    /* convert raw video to yuv on the gpu (default) or on the cpu from the rgba readback, applied on the next lite_obs_reset_video */
+    void (*lite_obs_set_video_gpu_conversion)(struct lite_obs_api *core_api, bool enabled);
+    /* number of audio tracks (1 - 6) recorded by outputs that can hold several, currently the file output.
+     * track n is encoded from the sources routed to mix n, applied on the next lite_obs_start_output */
+    void (*lite_obs_set_audio_tracks)(struct lite_obs_api *core_api, uint32_t tracks);
+    /* audio codec of all tracks (aac by default), opus (null for the defaults) is resampled to 48 kHz. applied on
+     * the next lite_obs_start_output, set it while no output is running. srt and file outputs carry opus, rtmp
+     * refuses to start with it */
+    void (*lite_obs_set_audio_codec)(struct lite_obs_api *core_api, audio_codec codec, const struct lite_obs_opus_settings *opus);
+    /* frames the video encoder currently holds between input and output, 0 for a low latency x264 encoder */
+    uint32_t (*lite_obs_get_video_encoder_delay)(struct lite_obs_api *core_api);
+    /* false when no cpu video encoder is running, gpu encoders take frames straight from the render thread */
+    bool (*lite_obs_get_video_encoder_stats)(struct lite_obs_api *core_api, struct lite_obs_video_encoder_stats *stats);
 
 } lite_obs_api;
 
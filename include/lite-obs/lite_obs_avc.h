@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <vector>
 #include <memory>
+#include "lite-obs/util/packet_pool.h"
 
 enum { OBS_NAL_UNKNOWN = 0,
        OBS_NAL_SLICE = 1,
@@ -30,6 +31,6 @@ const uint8_t *obs_avc_find_startcode(const uint8_t *p, const uint8_t *end);
 std::shared_ptr<struct encoder_packet> obs_parse_avc_packet(std::shared_ptr<struct encoder_packet> src);
 void obs_parse_avc_header(std::vector<uint8_t> &header, const uint8_t *data, size_t size);
 void obs_extract_avc_headers(const uint8_t *packet, size_t size,
-                    std::shared_ptr<std::vector<uint8_t>> new_packet_data,
+                    packet_data &new_packet_data,
                     std::vector<uint8_t> &header_data,
                     std::vector<uint8_t> &sei_data);
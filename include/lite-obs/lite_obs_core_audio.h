@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "lite_obs_defines.h"
 
 #define MAX_BUFFERING_TICKS 45
@@ -12,15 +13,19 @@ struct ts_info {
 
 struct lite_obs_core_audio_private;
 class audio_output;
+class lite_obs_source;
+class lite_obs_source_graph;
 class lite_obs_core_audio
 {
 public:
+    typedef std::vector<std::shared_ptr<lite_obs_source>> source_list;
+
     struct output_audio_info {
         uint32_t samples_per_sec{};
         speaker_layout speakers{};
     };
 
-    lite_obs_core_audio(uintptr_t core_ptr);
+    lite_obs_core_audio(std::shared_ptr<lite_obs_source_graph> graph);
     ~lite_obs_core_audio();
 
     std::shared_ptr<audio_output> core_audio();
@@ -32,9 +37,9 @@ private:
     bool audio_callback_internal(uint64_t start_ts_in, uint64_t end_ts_in, uint64_t *out_ts, uint32_t mixers, struct audio_output_data *mixes);
     static bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint64_t *out_ts, uint32_t mixers, struct audio_output_data *mixes);
 
-    void find_min_ts(uint64_t *min_ts);
-    bool mark_invalid_sources(size_t sample_rate, uint64_t min_ts);
-    void calc_min_ts(size_t sample_rate, uint64_t *min_ts);
+    void find_min_ts(const source_list &sources, uint64_t *min_ts);
+    bool mark_invalid_sources(const source_list &sources, size_t sample_rate, uint64_t min_ts);
+    void calc_min_ts(const source_list &sources, size_t sample_rate, uint64_t *min_ts);
     void add_audio_buffering(size_t sample_rate, struct ts_info *ts, uint64_t min_ts);
 
 private:
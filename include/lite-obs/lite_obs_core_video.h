@@ -9,12 +9,14 @@
 #define LITE_OBS_VIDEO_CURRENTLY_ACTIVE -3
 
 struct lite_obs_core_video_private;
+class lite_obs_source_graph;
 struct lite_obs_graphics_context;
 class gs_texture;
 class gs_program;
 class graphics_subsystem;
 class video_output;
 class lite_obs_encoder;
+struct lite_obs_rendition;
 class lite_obs_core_video
 {
     friend class lite_obs_encoder;
@@ -32,11 +34,16 @@ public:
         video_format output_format{};
     };
 
-    lite_obs_core_video(uintptr_t core_ptr);
+    lite_obs_core_video(std::shared_ptr<lite_obs_source_graph> graph);
     ~lite_obs_core_video();
 
     void lite_obs_core_video_change_raw_active(bool add);
 
+    void lite_obs_set_stage_depth(uint32_t depth);
+    void lite_obs_set_gpu_conversion(bool enabled);
+    /* how many bands the cpu conversion is split into with gpu conversion
+     * off, up to four. 0 leaves it to the output size */
+    void lite_obs_set_rgbx_convert_bands(uint32_t bands);
     int lite_obs_start_video(uint32_t width, uint32_t height, uint32_t fps);
 
     bool lite_obs_video_active();
@@ -44,11 +51,18 @@ public:
 
     std::shared_ptr<video_output> core_video();
 
+    /* a video output at width x height scaled from the same composite on
+     * the gpu, with conversion and staging of its own. its frames are read
+     * back with those of core_video and carry the same timestamps */
+    std::shared_ptr<video_output> lite_obs_add_rendition(uint32_t width, uint32_t height);
+    void lite_obs_remove_rendition(const std::shared_ptr<video_output> &video);
+
     static void graphics_thread(void *param);
     std::unique_ptr<graphics_subsystem> &graphics();
 
     uint32_t total_frames();
     uint32_t lagged_frames();
+    uint32_t readback_latency();
 
 private:
     void set_video_matrix(output_video_info *ovi);
@@ -71,15 +85,21 @@ private:
     std::shared_ptr<gs_program> get_scale_effect_internal();
     std::shared_ptr<gs_program> get_scale_effect(uint32_t width, uint32_t height);
     void stage_output_texture(const std::shared_ptr<gs_texture> &tex, int cur_texture);
-    void render_convert_texture(std::shared_ptr<gs_texture> texture);
+    void render_convert_texture(std::shared_ptr<gs_texture> texture, std::shared_ptr<gs_texture> *convert_textures, float width_i);
     void render_all_sources();
     void render_main_texture();
     std::shared_ptr<gs_texture> render_output_texture();
     void render_video(bool raw_active, const bool gpu_active, int cur_texture);
-    bool download_frame(int prev_texture, struct video_data *frame);
+    bool download_frame(struct video_data *frame);
+    bool init_rendition(lite_obs_rendition *rendition);
+    void clear_rendition(lite_obs_rendition *rendition);
+    void render_renditions(int cur_texture);
+    void download_renditions(int texture);
+    void output_renditions(uint64_t timestamp, int count);
     void set_gpu_converted_data_internal(bool using_nv12_tex, class video_frame *output, const struct video_data *input, video_format format, uint32_t width, uint32_t height);
     void set_gpu_converted_data(class video_frame *output, const struct video_data *input, const struct video_output_info *info);
-    void output_video_data(video_data *input_frame, int count);
+    void copy_rgbx_frame(class video_frame *output, const struct video_data *input, const struct video_output_info *info);
+    void output_video_data(const std::shared_ptr<video_output> &video, video_data *input_frame, int count);
     void output_frame(bool raw_active, const bool gpu_active);
     bool graphics_loop(lite_obs_graphics_context *context);
     void graphics_thread_internal();
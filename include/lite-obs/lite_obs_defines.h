@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 #define MAX_AV_PLANES 8
 
 enum audio_format {
@@ -108,3 +110,51 @@ enum output_type {
     android_aoa,
     iOS_usb
 };
+
+/* hevc and av1 are always encoded in software, by libx265 and svt-av1
+ * through libavcodec. sw only chooses between x264 and the hardware encoder
+ * for h264 */
+enum video_codec {
+    VIDEO_CODEC_H264,
+    VIDEO_CODEC_HEVC,
+    VIDEO_CODEC_AV1,
+};
+
+/* x264 tuning, a zeroed struct gives the built-in veryfast cbr setup */
+struct lite_obs_x264_settings {
+    const char *preset;     /* ultrafast ... placebo, null for veryfast */
+    const char *tune;       /* zerolatency, film, animation ... null for none */
+    int threads;            /* encoder threads, 0 lets x264 pick */
+    int lookahead;          /* rc_lookahead in frames, 0 keeps the preset/tune value */
+    int bframes;            /* max consecutive b-frames, 0 disables them */
+    int keyint_sec;         /* keyframe interval, 0 for 2 seconds */
+    int crf;                /* > 0 uses crf with the bitrate as vbv cap instead of cbr */
+    int vbv_buffer_kbit;    /* vbv buffer size, 0 for one second of bitrate */
+    int low_latency;        /* non zero: sliced threads, no lookahead or b-frames and intra refresh
+                               instead of periodic idr frames, so each frame leaves the encoder it went into */
+    const char *x264_opts;  /* "key=value:key=value" passed to x264_param_parse last */
+};
+
+enum audio_codec {
+    AUDIO_CODEC_AAC,
+    AUDIO_CODEC_OPUS,
+};
+
+/* opus tuning, a zeroed struct gives 20 ms frames at full complexity */
+struct lite_obs_opus_settings {
+    int frame_ms;           /* 5, 10, 20, 40 or 60, 0 for 20 */
+    int complexity;         /* 1 - 10, lower costs less cpu. 0 for 10 */
+    int low_delay;          /* non zero: celt only with 2.5 ms lookahead instead of 6.5 ms, worse for speech */
+};
+
+/* raw frame queue of a cpu video encoder, times are per frame and include scaling */
+struct lite_obs_video_encoder_stats {
+    uint32_t queue_depth;       /* frames waiting for the encoder right now */
+    uint32_t max_queue_depth;
+    uint32_t queue_limit;       /* beyond this the oldest waiting frame is dropped */
+    uint64_t encoded_frames;
+    uint64_t dropped_frames;
+    uint64_t last_encode_ns;
+    uint64_t avg_encode_ns;
+    uint64_t max_encode_ns;
+};
@@ -17,13 +17,25 @@ public:
 
     int obs_reset_video(uint32_t width, uint32_t height, uint32_t fps);
     bool obs_reset_audio(uint32_t sample_rate);
+    void obs_set_video_readback_depth(uint32_t depth);
+    uint32_t obs_get_video_readback_latency();
+    void obs_set_video_gpu_conversion(bool enabled);
+    void obs_set_audio_tracks(uint32_t tracks);
+    void obs_set_audio_codec(audio_codec codec, const lite_obs_opus_settings *opus);
+    uint32_t obs_get_video_encoder_delay();
+    bool obs_get_video_encoder_stats(lite_obs_video_encoder_stats *stats);
 
     lite_obs_media_source_internal *lite_obs_create_source(source_type type);
     void lite_obs_destroy_source(lite_obs_media_source_internal *source);
 
     bool lite_obs_start_output(output_type type, void *output_info, int vb, int ab, const lite_obs_output_callbak &callback);
     void lite_obs_stop_output();
+    int lite_obs_start_output2(output_type type, void *output_info, int vb, int ab, const lite_obs_output_callbak &callback);
+    void lite_obs_stop_output2(int output_id);
+    int lite_obs_start_rendition(output_type type, void *output_info, uint32_t width, uint32_t height, int vb, int ab, const lite_obs_output_callbak &callback);
 
+    void lite_obs_reset_encoder(bool sw, video_codec codec, const lite_obs_x264_settings *x264);
+    void lite_obs_reset_encoder(bool sw, const lite_obs_x264_settings *x264);
     void lite_obs_reset_encoder(bool sw);
 
 private:
@@ -43,6 +55,10 @@ public:
                       video_format format, video_range_type range,
                       video_colorspace color_space, uint32_t width,
                       uint32_t height);
+    void output_video_borrowed(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES],
+                               video_format format, video_range_type range,
+                               video_colorspace color_space, uint32_t width,
+                               uint32_t height, void (*release_cb)(void *opaque), void *opaque);
     void output_video(const uint8_t *img_data, uint32_t img_width, uint32_t img_height);
     void clear_video();
 
@@ -54,6 +70,9 @@ public:
     void set_flip(bool flip_h, bool flip_v);
     void reset_transform();
 
+    void set_jitter_window(uint32_t ms);
+    void set_audio_mixers(uint32_t mixers);
+
 private:
     ~lite_obs_media_source_internal();
 
@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>
 #include "lite_encoder_info.h"
+#include "media-io/audio_info.h"
 #include "lite_obs_callback.h"
 
 class video_output;
@@ -24,6 +25,7 @@ struct lite_obs_output_private;
 class lite_obs_output : public std::enable_shared_from_this<lite_obs_output>
 {
     friend class lite_obs_encoder;
+    friend class lite_obs_output_benchmark;
 public:
     lite_obs_output();
     ~lite_obs_output();
@@ -43,6 +45,9 @@ public:
     virtual uint64_t i_get_total_bytes() = 0;
     virtual int i_get_dropped_frames() = 0;
     virtual std::string i_cdn_ip() { return std::string(); }
+    /* outputs that can carry more than one audio track, one per audio
+     * encoder slot, override this. everything else only uses slot 0 */
+    virtual bool i_multi_track() { return false; }
 
     void set_output_signal_callback(lite_obs_output_callbak callback);
     const lite_obs_output_callbak &output_signal_callback();
@@ -60,6 +65,7 @@ public:
     void lite_obs_output_set_audio_encoder(std::shared_ptr<lite_obs_encoder> encoder, size_t idx);
     std::shared_ptr<lite_obs_encoder> lite_obs_output_get_video_encoder();
     std::shared_ptr<lite_obs_encoder> lite_obs_output_get_audio_encoder(size_t idx);
+    size_t lite_obs_output_audio_tracks();
 
     uint64_t lite_obs_output_get_total_bytes();
     int lite_obs_output_get_frames_dropped();
@@ -109,6 +115,7 @@ private:
     void check_received(std::shared_ptr<encoder_packet> out);
     void insert_interleaved_packet(std::shared_ptr<encoder_packet> out);
     void set_higher_ts(std::shared_ptr<encoder_packet> packet);
+    size_t get_track_index(const std::shared_ptr<encoder_packet> &packet);
 
     std::shared_ptr<encoder_packet> find_first_packet_type(obs_encoder_type type, size_t audio_idx);
     std::shared_ptr<encoder_packet> find_last_packet_type(obs_encoder_type type, size_t audio_idx);
@@ -118,7 +125,7 @@ private:
     auto get_interleaved_start_idx();
     auto prune_premature_packets();
     bool prune_interleaved_packets();
-    bool get_audio_and_video_packets(std::shared_ptr<encoder_packet> &video, std::shared_ptr<encoder_packet> &audio);
+    bool get_audio_and_video_packets(std::shared_ptr<encoder_packet> &video, std::shared_ptr<encoder_packet> audio[MAX_AUDIO_MIXES]);
     bool initialize_interleaved_packets();
     void resort_interleaved_packets();
     bool has_higher_opposing_ts(std::shared_ptr<encoder_packet> packet);
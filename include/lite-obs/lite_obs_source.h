@@ -1,10 +1,10 @@
 #pragma once
 
+#include <string.h>
 #include <memory>
 #include <string>
 #include <mutex>
-#include <map>
-#include <list>
+#include <functional>
 #include "lite_obs_internal.h"
 #include "media-io/video_frame.h"
 #include "media-io/video_info.h"
@@ -18,6 +18,7 @@ class lite_obs_source : public std::enable_shared_from_this<lite_obs_source>
 {
     friend class lite_obs_core_audio;
     friend class lite_obs_core_video;
+    friend class lite_obs_source_test;
 public:
     struct lite_obs_source_audio_frame {
         const uint8_t *data[MAX_AV_PLANES];
@@ -46,11 +47,23 @@ public:
         bool flip{};
         bool flip_h{};
 
+        /* set on frames that point at the caller's planes instead of
+         * data_internal, runs once when the last reference goes away */
+        std::function<void()> release{};
+
         lite_obs_source_video_frame() {
             data.resize(MAX_AV_PLANES);
             linesize.resize(MAX_AV_PLANES);
         }
 
+        ~lite_obs_source_video_frame() {
+            if (release)
+                release();
+        }
+
+        lite_obs_source_video_frame(const lite_obs_source_video_frame &) = delete;
+        lite_obs_source_video_frame &operator=(const lite_obs_source_video_frame &) = delete;
+
         void lite_obs_source_video_frame_init(video_format f, uint32_t w, uint32_t h) {
             video_frame_init(data_internal, data, linesize, f, w, h);
             format = f;
@@ -169,6 +182,10 @@ public:
                                   video_format format, video_range_type range,
                                   video_colorspace color_space, uint32_t width,
                                   uint32_t height);
+    void lite_source_output_video_borrowed(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES],
+                                           video_format format, video_range_type range,
+                                           video_colorspace color_space, uint32_t width,
+                                           uint32_t height, void (*release_cb)(void *opaque), void *opaque);
     void lite_source_output_video(int texture_id, uint32_t texture_width, uint32_t texture_height);
     void lite_source_output_video(const uint8_t *img_data, uint32_t img_width, uint32_t img_height);
     void lite_source_clear_video();
@@ -181,9 +198,9 @@ public:
     void lite_source_set_flip(bool flip_h, bool flip_v);
     void lite_source_reset_transform();
 
-public:
-    static std::recursive_mutex sources_mutex;
-    static std::map<uintptr_t, std::list<std::shared_ptr<lite_obs_source>>> sources;
+    void lite_source_set_jitter_window(uint32_t ms);
+    // bit n sends the source's audio to mix n, all mixes by default
+    void lite_source_set_audio_mixers(uint32_t mixers);
 
 private:
     bool audio_pending();
@@ -202,7 +219,7 @@ private:
 
     float get_source_volume();
     void multiply_output_audio(size_t mix, size_t channels, float vol);
-    void apply_audio_volume(uint32_t mixers, size_t channels, size_t sample_rate);
+    uint32_t apply_audio_volume(uint32_t mixers, size_t channels, size_t sample_rate);
     void audio_source_tick(uint32_t mixers, size_t channels, size_t sample_rate, size_t size);
     void audio_render(uint32_t mixers, size_t channels, size_t sample_rate, size_t size);
 
@@ -217,10 +234,18 @@ private:
     void free_async_cache();
     bool async_texture_changed(const lite_obs_source_video_frame *frame);
     void output_video_internal(const lite_obs_source_video_frame *frame);
+    bool prepare_video_frame(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES],
+                             video_format format, video_range_type range,
+                             video_colorspace color_space, uint32_t width, uint32_t height);
+    void push_async_frame(const std::shared_ptr<lite_obs_source_video_frame> &frame);
 
     void remove_async_frame(const std::shared_ptr<lite_obs_source_video_frame> &frame);
+    uint64_t async_frame_timestamp(uint64_t arrival);
+    uint64_t async_frame_due(uint64_t timestamp);
+    bool async_frame_superseded(uint64_t timestamp);
     bool ready_async_frame(uint64_t sys_time);
     std::shared_ptr<lite_obs_source_video_frame> get_closest_frame(uint64_t sys_time);
+    std::shared_ptr<lite_obs_source_video_frame> select_async_frame(uint64_t sys_time);
     bool set_packed422_sizes(const std::shared_ptr<lite_obs_source_video_frame> &frame);
     bool set_packed444_alpha_sizes(const std::shared_ptr<lite_obs_source_video_frame> &frame);
     bool set_planar444_sizes(const std::shared_ptr<lite_obs_source_video_frame> &frame);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "lite_obs_defines.h"
+
+class lite_obs_source;
+
+/* the ordered source list of one lite_obs instance, bottom first.
+ * every change builds a new list and publishes it, the render and audio
+ * threads grab the current one once per tick without taking any lock and
+ * keep it alive for as long as they hold it */
+class lite_obs_source_graph
+{
+public:
+    typedef std::vector<std::shared_ptr<lite_obs_source>> source_list;
+
+    lite_obs_source_graph();
+    ~lite_obs_source_graph();
+
+    std::shared_ptr<const source_list> snapshot() const;
+
+    void add(const std::shared_ptr<lite_obs_source> &source);
+    void remove(const std::shared_ptr<lite_obs_source> &source);
+    void move(const std::shared_ptr<lite_obs_source> &source, order_movement movement);
+    void clear();
+
+private:
+    void publish(std::shared_ptr<const source_list> list);
+
+private:
+    std::mutex write_mutex;
+    std::shared_ptr<const source_list> current{};
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include "lite_obs_defines.h"
+#include "util/mpsc_ring.h"
+
+#define SOURCE_TRANSFORM_QUEUE_SIZE 64
+
+enum class source_transform_type {
+    pos,
+    scale,
+    flip,
+    rotate,
+    box,
+    reset,
+};
+
+struct source_render_box {
+    int x;
+    int y;
+    int width;
+    int height;
+    source_aspect_ratio_mode mode;
+};
+
+struct source_transform_command {
+    source_transform_type type;
+    union {
+        struct {
+            float x;
+            float y;
+        } vec;
+        source_render_box box;
+    };
+};
+
+/* what a run of transform commands adds up to. a render box or a reset
+ * throws away everything queued before it, the last pos and scale win,
+ * flips multiply and rotations add up. pos is applied last, which gives the
+ * same result as applying it in order since scale, flip and rotate all keep
+ * the top left corner where it was */
+struct source_transform_pending {
+    bool reset{};
+    bool reset_crop{};
+    bool has_box{};
+    source_render_box box{};
+
+    bool has_scale{};
+    float scale_x{};
+    float scale_y{};
+
+    float flip_x{1.0f};
+    float flip_y{1.0f};
+
+    bool has_rotate{};
+    float rot{};
+
+    bool has_pos{};
+    float pos_x{};
+    float pos_y{};
+
+    void merge(const source_transform_command &cmd);
+    void merge(const source_transform_pending &other);
+    bool empty() const;
+};
+
+/* transform commands from any thread to the render thread. pushing never
+ * allocates and never blocks on the render thread. if the ring fills up
+ * because nothing is rendering, commands are folded into a spare pending
+ * state instead, and keep going there until the render thread has picked
+ * it up so that one thread's commands stay in order */
+class source_transform_queue
+{
+public:
+    source_transform_queue();
+
+    void push(const source_transform_command &cmd);
+
+    /* render thread only */
+    source_transform_pending drain();
+
+private:
+    mpsc_ring<source_transform_command> ring{};
+
+    std::atomic_bool overflowed{};
+    std::mutex overflow_mutex{};
+    source_transform_pending overflow{};
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+/* inner loops of the audio pipeline, shared by the sources (volume, mixing)
+ * and audio_output (clamping). the exported versions are picked at runtime
+ * for the cpu (sse/avx2 on x86, neon on arm) and give exactly the same
+ * results as the plain c++ ones below */
+
+static inline void audio_mix_floats_c(float *dst, const float *src, size_t count)
+{
+    const float *end = src + count;
+
+    while (src < end)
+        *(dst++) += *(src++);
+}
+
+static inline void audio_multiply_floats_c(float *data, size_t count, float vol)
+{
+    float *end = data + count;
+
+    while (data < end)
+        *(data++) *= vol;
+}
+
+static inline void audio_clamp_floats_c(float *data, size_t count)
+{
+    float *end = data + count;
+
+    while (data < end) {
+        float val = *data;
+        val = (val > 1.0f) ? 1.0f : val;
+        val = (val < -1.0f) ? -1.0f : val;
+        *(data++) = val;
+    }
+}
+
+void audio_mix_floats(float *dst, const float *src, size_t count);
+void audio_multiply_floats(float *data, size_t count, float vol);
+void audio_clamp_floats(float *data, size_t count);
+
+/* name of the instruction set the kernels run with, for logging */
+const char *audio_math_isa();
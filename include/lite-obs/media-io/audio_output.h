@@ -38,6 +38,18 @@ struct audio_convert_info {
     speaker_layout speakers = speaker_layout::SPEAKERS_UNKNOWN;
 };
 
+/* how late the audio thread got to its ticks, measured from when each tick
+ * was due to when it was mixed */
+struct audio_tick_stats {
+    uint64_t ticks{};
+    uint64_t avg_error_ns{};
+    uint64_t p99_error_ns{};
+    uint64_t max_error_ns{};
+    /* times the schedule was restarted because the clock jumped or the
+     * thread fell too far behind */
+    uint64_t resyncs{};
+};
+
 #define AUDIO_OUTPUT_SUCCESS 0
 #define AUDIO_OUTPUT_INVALIDPARAM -1
 #define AUDIO_OUTPUT_FAIL -2
@@ -70,12 +82,14 @@ public:
     size_t audio_output_get_channels();
     uint32_t audio_output_get_sample_rate();
     const audio_output_info *audio_output_get_info();
+    void audio_output_get_tick_stats(audio_tick_stats *stats);
 
 private:
     int get_input_index(size_t mix_idx, audio_output_callback_t callback, void *param);
     void input_and_output(uint64_t audio_time, uint64_t prev_time);
-    void clamp_audio_output(size_t bytes);
-    void do_audio_output(size_t mix_idx, uint64_t timestamp, uint32_t frames);
+    void clamp_audio_output(size_t bytes, uint32_t active_mixes);
+    void do_audio_output(size_t mix_idx, uint32_t active_mixes, uint64_t timestamp, uint32_t frames);
+    void record_tick_error(uint64_t error_ns);
     bool resample_audio_output(std::shared_ptr<audio_input> input, audio_data *data);
 
 private:
@@ -89,6 +89,55 @@ static inline video_format ffmpeg_to_lite_obs_video_format(AVPixelFormat format)
     }
 }
 
+static inline uint64_t convert_speaker_layout(speaker_layout layout)
+{
+    switch (layout) {
+    case speaker_layout::SPEAKERS_UNKNOWN:
+        return 0;
+    case speaker_layout::SPEAKERS_MONO:
+        return AV_CH_LAYOUT_MONO;
+    case speaker_layout::SPEAKERS_STEREO:
+        return AV_CH_LAYOUT_STEREO;
+    case speaker_layout::SPEAKERS_2POINT1:
+        return AV_CH_LAYOUT_SURROUND;
+    case speaker_layout::SPEAKERS_4POINT0:
+        return AV_CH_LAYOUT_4POINT0;
+    case speaker_layout::SPEAKERS_4POINT1:
+        return AV_CH_LAYOUT_4POINT1;
+    case speaker_layout::SPEAKERS_5POINT1:
+        return AV_CH_LAYOUT_5POINT1_BACK;
+    case speaker_layout::SPEAKERS_7POINT1:
+        return AV_CH_LAYOUT_7POINT1;
+    }
+
+    /* shouldn't get here */
+    return 0;
+}
+
+static inline speaker_layout
+convert_ff_channel_layout(uint64_t channel_layout)
+{
+    switch (channel_layout) {
+    case AV_CH_LAYOUT_MONO:
+        return speaker_layout::SPEAKERS_MONO;
+    case AV_CH_LAYOUT_STEREO:
+        return speaker_layout::SPEAKERS_STEREO;
+    case AV_CH_LAYOUT_SURROUND:
+        return speaker_layout::SPEAKERS_2POINT1;
+    case AV_CH_LAYOUT_4POINT0:
+        return speaker_layout::SPEAKERS_4POINT0;
+    case AV_CH_LAYOUT_4POINT1:
+        return speaker_layout::SPEAKERS_4POINT1;
+    case AV_CH_LAYOUT_5POINT1_BACK:
+        return speaker_layout::SPEAKERS_5POINT1;
+    case AV_CH_LAYOUT_7POINT1:
+        return speaker_layout::SPEAKERS_7POINT1;
+    }
+
+    /* shouldn't get here */
+    return speaker_layout::SPEAKERS_UNKNOWN;
+}
+
 static inline audio_format convert_ffmpeg_sample_format(AVSampleFormat format)
 {
     switch ((uint32_t)format) {
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include "video_info.h"
+
+/* hand written conversions for the cases video_scaler sees most, picked at
+ * runtime for the cpu (sse4.1/avx2 on x86, neon on arm) with a plain c++
+ * fallback. all of them need even dimensions, the 420 downscale needs the
+ * source to be a multiple of 4. */
+
+/* Q15 rgb -> yuv coefficients, in the byte order of the source pixels */
+struct video_convert_coeffs {
+    int16_t y[4]{};
+    int16_t u[4]{};
+    int16_t v[4]{};
+    int32_t y_offset{};
+    int32_t uv_offset{};
+    /* chroma sited on the left pixel of each pair as the gpu conversion
+     * samples it, instead of the 2x2 box. left alone by coeffs_init */
+    bool chroma_left{};
+};
+
+void video_convert_coeffs_init(video_convert_coeffs *coeffs, video_format src_format, video_colorspace colorspace, video_range_type range);
+
+void video_convert_nv12_to_i420(const uint8_t *const src[], const uint32_t src_linesize[], uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height);
+void video_convert_i420_to_nv12(const uint8_t *const src[], const uint32_t src_linesize[], uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height);
+
+/* rgba/bgra/bgrx source, chroma is the 2x2 box average unless
+ * coeffs->chroma_left is set */
+void video_convert_rgb_to_nv12(const uint8_t *src, uint32_t src_linesize, uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height, const video_convert_coeffs *coeffs);
+void video_convert_rgb_to_i420(const uint8_t *src, uint32_t src_linesize, uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height, const video_convert_coeffs *coeffs);
+
+/* 2:1 box downscale in both directions, format stays the same. supports
+ * I420, NV12, Y800, RGBA, BGRA and BGRX */
+bool video_convert_downscale_supported(video_format format);
+void video_convert_downscale_2x(video_format format, const uint8_t *const src[], const uint32_t src_linesize[], uint8_t *dst[], const uint32_t dst_linesize[], uint32_t src_width, uint32_t src_height);
+
+/* name of the instruction set the kernels run with, for logging */
+const char *video_convert_isa();
+
+/* a few worker threads that split one conversion into horizontal bands.
+ * run() hands every worker and the calling thread one band index and
+ * returns when all of them are done */
+struct video_convert_pool_private;
+class video_convert_pool
+{
+public:
+    video_convert_pool();
+    ~video_convert_pool();
+
+    bool start(size_t threads);
+    void stop();
+
+    /* number of bands run() splits into, the calling thread included */
+    size_t band_count();
+    void run(void (*job)(void *param, size_t band, size_t band_count), void *param);
+
+private:
+    void worker_thread(size_t band);
+
+    std::unique_ptr<video_convert_pool_private> d_ptr{};
+};
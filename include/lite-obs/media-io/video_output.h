@@ -12,8 +12,25 @@
 struct video_data {
     video_frame frame;
     uint64_t timestamp{};
+    /* the first frame of a gop on the keyframe grid of the input */
+    bool keyframe{};
 };
 
+#define VIDEO_GOP_NONE UINT64_MAX
+/* true for the first frame at or after the next multiple of interval_ns on
+ * the video clock. every input of one video output, and of the renditions
+ * read back with it, sees the same timestamps, so their keyframes land on
+ * the same frames */
+static inline bool video_keyframe_due(uint64_t timestamp, uint64_t interval_ns, uint64_t *last_gop)
+{
+    uint64_t gop = timestamp / interval_ns;
+    if (gop == *last_gop)
+        return false;
+
+    *last_gop = gop;
+    return true;
+}
+
 struct video_output_info {
     const char *name{};
 
@@ -28,8 +45,21 @@ struct video_output_info {
     video_range_type range = video_range_type::VIDEO_RANGE_DEFAULT;
 };
 
+/* one connected input, the callback times cover scaling plus the callback */
+struct video_input_stats {
+    uint32_t queue_depth{};      /* frames waiting, not counting the one being delivered */
+    uint32_t max_queue_depth{};
+    uint32_t queue_limit{};      /* the oldest waiting frame is dropped beyond this */
+    uint64_t delivered_frames{};
+    uint64_t dropped_frames{};
+    uint64_t last_callback_ns{};
+    uint64_t avg_callback_ns{};
+    uint64_t max_callback_ns{};
+};
+
 struct video_output_private;
 struct video_input;
+struct cached_frame_info;
 class video_output
 {
 public:
@@ -50,6 +80,11 @@ public:
 
     bool video_output_connect(const video_scale_info *conversion, void (*callback)(void *param, struct video_data *frame), void *param);
     void video_output_disconnect(void (*callback)(void *param, video_data *frame), void *param);
+    bool video_output_get_input_stats(void (*callback)(void *param, video_data *frame), void *param, video_input_stats *stats);
+    /* marks the frames starting a gop every interval_ns for the input, 0 for
+     * none. those are never dropped for a slow input, so an encoder that
+     * forces its keyframes on them stays aligned with the others */
+    void video_output_set_keyframe_interval(void (*callback)(void *param, video_data *frame), void *param, uint64_t interval_ns);
 
     void video_output_stop();
     bool video_output_stopped();
@@ -72,9 +107,15 @@ private:
     void init_cache();
     int video_get_input_idx(void (*callback)(void *param, video_data *frame), void *param);
     bool video_input_init(std::shared_ptr<video_input> input);
+    void video_input_thread(video_input *input);
+    void video_input_stop(video_input *input);
+    bool video_input_drop_oldest(video_input *input);
+    void release_cached_frame(cached_frame_info *cfi);
+    void recycle_cached_frames();
     void reset_frames();
     void log_skipped();
-    bool scale_video_output(std::shared_ptr<video_input> input, video_data *data);
+    bool scale_video_output(video_input *input, video_data *data);
+    void copy_video_input_frame(video_input *input, video_data *data);
 
 private:
     std::unique_ptr<video_output_private> d_ptr{};
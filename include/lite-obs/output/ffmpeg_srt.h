@@ -19,6 +19,7 @@
 #include "ffmpeg_url.h"
 #include "lite-obs/util/log.h"
 #include "lite-obs/lite_obs_output.h"
+#include <string.h>
 #include <srt/srt.h>
 
 extern "C"
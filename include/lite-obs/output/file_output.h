@@ -29,12 +29,13 @@ public:
     virtual void i_encoded_packet(std::shared_ptr<struct encoder_packet> packet) override;
     virtual uint64_t i_get_total_bytes() override;
     virtual int i_get_dropped_frames() override;
+    virtual bool i_multi_track() override;
 
 private:
     void init_params();
     bool new_stream(AVStream **stream, const char *name);
     void create_video_stream();
-    void create_audio_stream();
+    void create_audio_stream(size_t idx);
     bool init_streams();
     void free_avformat();
     bool open_output_file();
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DBR_MAX_SAMPLES 256
+
+/* Dynamic bitrate controller of the rtmp output, bitrates in kbps.
+ *
+ * The send thread reports how many bytes the peer has acknowledged and how
+ * many still sit unacknowledged in the socket, the throughput estimate is
+ * the acked byte rate over the last one to two seconds. The packet queue
+ * calls update() with the duration of the packets waiting to be sent, and
+ * the delay they and the socket backlog add decides the bitrate: congestion
+ * cuts it multiplicatively, down to what actually got through, a clear
+ * queue adds a step every second, and after a quiet spell a probe jumps by
+ * half and returns to where it came from if the queue builds up again. */
+class rtmp_dbr
+{
+public:
+    void reset(long video_bitrate, long audio_bitrate, uint64_t time_ns);
+
+    /* send thread side, called after each write */
+    void add_sample(uint64_t time_ns, uint64_t acked_bytes, uint64_t unacked_bytes);
+
+    /* returns the new video bitrate, or 0 when it stays */
+    long update(uint64_t time_ns, int64_t queue_usec);
+
+    long bitrate() const { return cur_bitrate; }
+    long orig_bitrate() const { return orig; }
+    long estimate() const { return est_bitrate; }
+    int64_t delay_usec(int64_t queue_usec) const;
+
+private:
+    struct sample {
+        uint64_t time_ns;
+        uint64_t acked;
+    };
+
+    void update_estimate();
+    long set_bitrate(long bitrate, uint64_t time_ns);
+
+    sample samples[DBR_MAX_SAMPLES]{};
+    size_t first{};
+    size_t count{};
+    uint64_t unacked{};
+
+    long orig{};
+    long audio{};
+    long cur_bitrate{};
+    long prev_bitrate{};
+    long est_bitrate{};
+    long total_est{};
+    long step{};
+
+    uint64_t last_change_ns{};
+    uint64_t last_dec_ns{};
+    int64_t dec_delay_usec{};
+    uint64_t clear_since_ns{};
+    uint64_t probe_until_ns{};
+};
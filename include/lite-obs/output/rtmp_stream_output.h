@@ -30,10 +30,11 @@ private:
     bool send_audio_header();
     bool send_video_header();
 
-    void dbr_add_frame(std::shared_ptr<struct dbr_frame> frame);
-    void dbr_set_bitrate();
-    void dbr_inc_bitrate();
-    bool dbr_bitrate_lowered();
+    uint64_t socket_unacked_bytes();
+    void dbr_add_sample();
+    void dbr_update(int64_t buffer_duration_usec);
+    void dbr_set_bitrate(long bitrate);
+    void dbr_restore_bitrate();
 
     std::shared_ptr<encoder_packet> find_first_video_packet();
     void check_to_drop_frames(bool pframes);
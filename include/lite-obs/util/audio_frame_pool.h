@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include "lite-obs/lite_obs_defines.h"
+
+/* one encoder input frame. the planes of a frame sit back to back, plane n
+ * starts n * plane_bytes after plane 0, so encoders that want every plane in
+ * a single buffer can use data[0] as is */
+struct audio_frame_buffer {
+    uint8_t *data[MAX_AV_PLANES]{};
+    size_t planes{};
+    size_t plane_bytes{};
+};
+
+/* Fixed set of page aligned frame buffers handed from the encoder's audio
+ * buffering to the encoder implementation. Everything is allocated by init(),
+ * acquire() returns nullptr once every frame is in use instead of
+ * allocating more. */
+class audio_frame_pool
+{
+public:
+    audio_frame_pool() = default;
+    ~audio_frame_pool();
+
+    audio_frame_pool(const audio_frame_pool &) = delete;
+    audio_frame_pool &operator=(const audio_frame_pool &) = delete;
+
+    bool init(size_t planes, size_t plane_bytes, size_t count);
+    void free();
+
+    audio_frame_buffer *acquire();
+    void release(audio_frame_buffer *frame);
+
+    size_t frame_count() const { return frames.size(); }
+
+private:
+    std::mutex mutex;
+    uint8_t *block{};
+    std::vector<audio_frame_buffer> frames;
+    std::vector<audio_frame_buffer *> free_frames;
+};
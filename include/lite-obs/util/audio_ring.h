@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+/* what ring capacities are rounded to */
+size_t os_page_size();
+
+/* Byte ring for one plane of audio, bounded by a limit.
+ *
+ * init() allocates a small ring that doubles when a push doesn't fit, up to
+ * the limit, and never shrinks. Once a source's latency has settled pushing
+ * is at most two memcpy calls into memory that stays in cache, never a
+ * realloc or a memmove. Operations that would go past the limit fail and
+ * leave the ring untouched, callers treat that as the buffer limit being
+ * hit. The calls mirror the circlebuf ones the audio paths used before.
+ *
+ * The storage is ordinary heap memory. Page aligned rings all start on the
+ * same cache sets, which made mixing dozens of them measurably slower. */
+class audio_ring
+{
+public:
+    audio_ring() = default;
+    ~audio_ring();
+
+    audio_ring(const audio_ring &) = delete;
+    audio_ring &operator=(const audio_ring &) = delete;
+
+    /* capacity is rounded up to whole pages and limit, 0 for the same as
+     * capacity, is how far it may grow. the previous contents are dropped,
+     * calling it again with a capacity that already fits keeps the
+     * allocation */
+    bool init(size_t capacity, size_t limit = 0);
+    void free();
+
+    size_t size() const { return count; }
+    size_t capacity() const { return cap; }
+    size_t limit() const { return max; }
+    size_t space() const { return max - count; }
+
+    bool push_back(const void *data, size_t bytes);
+    bool push_back_zero(size_t bytes);
+
+    /* writes at position bytes from the front, zero filling any gap after
+     * the current end */
+    bool place(size_t position, const void *data, size_t bytes);
+
+    /* data may be null to only drop the bytes */
+    void peek_front(void *data, size_t bytes) const;
+    void pop_front(void *data, size_t bytes);
+    void pop_back(size_t bytes);
+
+    void clear();
+
+private:
+    void write_at(size_t position, const void *data, size_t bytes);
+    bool grow(size_t needed);
+
+private:
+    uint8_t *buf{};
+    size_t cap{};
+    size_t max{};
+    size_t start{};
+    size_t count{};
+};
+
+/* the per packet calls are inline like the circlebuf ones they replace */
+inline void audio_ring::write_at(size_t position, const void *data, size_t bytes)
+{
+    size_t pos = start + position;
+    if (pos >= cap)
+        pos -= cap;
+
+    size_t first = cap - pos;
+    if (first >= bytes) {
+        if (data)
+            memcpy(buf + pos, data, bytes);
+        else
+            memset(buf + pos, 0, bytes);
+        return;
+    }
+
+    if (data) {
+        memcpy(buf + pos, data, first);
+        memcpy(buf, (const uint8_t *)data + first, bytes - first);
+    } else {
+        memset(buf + pos, 0, first);
+        memset(buf, 0, bytes - first);
+    }
+}
+
+inline bool audio_ring::push_back(const void *data, size_t bytes)
+{
+    if (count + bytes > cap && !grow(count + bytes))
+        return false;
+
+    write_at(count, data, bytes);
+    count += bytes;
+    return true;
+}
+
+inline void audio_ring::peek_front(void *data, size_t bytes) const
+{
+    assert(bytes <= count);
+    if (!data)
+        return;
+
+    size_t first = cap - start;
+    if (first >= bytes) {
+        memcpy(data, buf + start, bytes);
+    } else {
+        memcpy(data, buf + start, first);
+        memcpy((uint8_t *)data + first, buf, bytes - first);
+    }
+}
+
+inline void audio_ring::pop_front(void *data, size_t bytes)
+{
+    peek_front(data, bytes);
+
+    count -= bytes;
+    if (!count) {
+        start = 0;
+        return;
+    }
+
+    start += bytes;
+    if (start >= cap)
+        start -= cap;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+/* runtime instruction set checks for the simd kernels, these always return
+ * false when built for a different architecture */
+bool cpu_has_sse2();
+bool cpu_has_sse41();
+bool cpu_has_avx2();
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MPSC_CACHE_LINE_SIZE 64
+
+/* Bounded multi producer / single consumer ring.
+ *
+ * All slots are allocated up front by init(). Every slot carries a sequence
+ * number that tells whose turn it is: a producer claims the tail with a CAS
+ * once the slot's sequence says the consumer is done with it, writes the
+ * value and then publishes the slot by bumping the sequence. The consumer
+ * only ever looks at the sequence of the slot at its own head, so it never
+ * touches the shared tail. push() fails instead of waiting when the ring is
+ * full. */
+template<typename T>
+class mpsc_ring
+{
+public:
+    bool init(size_t capacity) {
+        if (!capacity)
+            return false;
+
+        cells.reset(new cell[capacity]);
+        size = capacity;
+        for (size_t i = 0; i < size; i++)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+
+        tail.store(0, std::memory_order_relaxed);
+        head = 0;
+        return true;
+    }
+
+    size_t capacity() const { return size; }
+
+    /* ---- producer side, any thread ---- */
+
+    bool push(const T &val) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            auto &c = cells[pos % size];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto &c = cells[pos % size];
+        c.val = val;
+        c.seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* ---- consumer side, one thread ---- */
+
+    bool pop(T &val) {
+        auto &c = cells[head % size];
+        size_t seq = c.seq.load(std::memory_order_acquire);
+        if (seq != head + 1)
+            return false;
+
+        val = c.val;
+        c.seq.store(head + size, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+private:
+    struct cell {
+        std::atomic_size_t seq{};
+        T val{};
+    };
+
+    alignas(MPSC_CACHE_LINE_SIZE) std::atomic_size_t tail{};
+    alignas(MPSC_CACHE_LINE_SIZE) size_t head{};
+
+    std::unique_ptr<cell[]> cells{};
+    size_t size{};
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <new>
+
+/* Payload of one encoded packet.
+ *
+ * Buffers come from a size classed pool shared by every encoder and output,
+ * the payload sits right after this header in the same block. The reference
+ * count lives in the buffer itself, so a packet handed to several outputs
+ * never copies its bytes and dropping the last reference puts the block back
+ * on the free list of its class. Encoders get a new buffer for every packet
+ * and must not write to it once the packet has been sent. */
+class alignas(16) packet_buffer
+{
+public:
+    uint8_t *data() { return (uint8_t *)(this + 1); }
+    const uint8_t *data() const { return (const uint8_t *)(this + 1); }
+    size_t size() const { return bytes; }
+    size_t capacity() const { return cap; }
+
+private:
+    friend class packet_data;
+    friend class packet_pool;
+
+    std::atomic_uint32_t refs{};
+    uint32_t size_class{};
+    size_t bytes{};
+    size_t cap{};
+    packet_buffer *next{};
+};
+
+/* reference to a packet_buffer, copying it only bumps the count */
+class packet_data
+{
+public:
+    packet_data() = default;
+    packet_data(std::nullptr_t) {}
+    ~packet_data() { reset(); }
+
+    packet_data(const packet_data &other) : buf(other.buf) {
+        if (buf)
+            buf->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    packet_data(packet_data &&other) noexcept : buf(other.buf) { other.buf = nullptr; }
+
+    packet_data &operator=(const packet_data &other) {
+        packet_data(other).swap(*this);
+        return *this;
+    }
+    packet_data &operator=(packet_data &&other) noexcept {
+        packet_data(static_cast<packet_data &&>(other)).swap(*this);
+        return *this;
+    }
+
+    packet_buffer *operator->() const { return buf; }
+    packet_buffer *get() const { return buf; }
+    explicit operator bool() const { return buf != nullptr; }
+
+    uint32_t use_count() const { return buf ? buf->refs.load(std::memory_order_relaxed) : 0; }
+    void swap(packet_data &other) noexcept {
+        auto tmp = buf;
+        buf = other.buf;
+        other.buf = tmp;
+    }
+
+    void reset();
+
+    /* these change the payload, they are only meant for the one reference
+     * that is filling a new buffer. growing past the capacity moves the
+     * contents to a block of a larger class */
+    bool resize(size_t size);
+    bool append(const void *data, size_t size);
+
+private:
+    friend class packet_pool;
+    explicit packet_data(packet_buffer *b) : buf(b) {}
+
+    packet_buffer *buf{};
+};
+
+/* a new buffer of size bytes, the contents are not initialized */
+packet_data packet_pool_alloc(size_t size);
+packet_data packet_pool_copy(const void *data, size_t size);
+
+/* raw blocks from the same size classes, used for the packet headers */
+void *packet_pool_alloc_raw(size_t size);
+void packet_pool_free_raw(void *ptr);
+
+/* blocks and bytes currently handed out, for diagnostics */
+size_t packet_pool_blocks_in_use();
+size_t packet_pool_bytes_in_use();
+
+template<typename T>
+struct packet_pool_allocator
+{
+    typedef T value_type;
+
+    packet_pool_allocator() = default;
+    template<typename U>
+    packet_pool_allocator(const packet_pool_allocator<U> &) {}
+
+    T *allocate(size_t n) {
+        void *ptr = packet_pool_alloc_raw(n * sizeof(T));
+        if (!ptr)
+            throw std::bad_alloc();
+        return (T *)ptr;
+    }
+    void deallocate(T *ptr, size_t) { packet_pool_free_raw(ptr); }
+
+    template<typename U>
+    bool operator==(const packet_pool_allocator<U> &) const { return true; }
+    template<typename U>
+    bool operator!=(const packet_pool_allocator<U> &) const { return false; }
+};
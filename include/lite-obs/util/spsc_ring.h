@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+
+#define SPSC_CACHE_LINE_SIZE 64
+
+/* Bounded single producer / single consumer ring.
+ *
+ * All slots are allocated up front by init(). The producer fills the slot
+ * returned by write_slot() and publishes it with push(), the consumer reads
+ * front() in place and hands the slot back with pop(). The two indices live
+ * on separate cache lines, and each side keeps a private copy of the other
+ * side's index so the shared line is only read when the ring looks full or
+ * empty. */
+template<typename T>
+class spsc_ring
+{
+public:
+    bool init(size_t capacity) {
+        if (!capacity)
+            return false;
+
+        slots.reset(new T[capacity]);
+        size = capacity;
+        clear();
+        return true;
+    }
+
+    /* only safe while neither side is running */
+    void clear() {
+        consumer.index.store(0, std::memory_order_relaxed);
+        consumer.cached = 0;
+        producer.index.store(0, std::memory_order_relaxed);
+        producer.cached = 0;
+    }
+
+    size_t capacity() const { return size; }
+
+    T &slot(size_t i) { return slots[i]; }
+
+    size_t count() const {
+        return producer.index.load(std::memory_order_acquire) - consumer.index.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return count() == 0; }
+
+    /* sequence numbers of the oldest slot not popped yet and of the next
+     * slot to be pushed, the slots between them are queued. the producer
+     * may look at queued slots, but the consumer can pop them at any time so
+     * T has to arbitrate that access itself */
+    size_t read_index() const { return consumer.index.load(std::memory_order_acquire); }
+    size_t write_index() const { return producer.index.load(std::memory_order_acquire); }
+
+    /* ---- producer side ---- */
+
+    T *write_slot() {
+        size_t tail = producer.index.load(std::memory_order_relaxed);
+        if (tail - producer.cached == size) {
+            producer.cached = consumer.index.load(std::memory_order_acquire);
+            if (tail - producer.cached == size)
+                return nullptr;
+        }
+
+        return &slots[tail % size];
+    }
+
+    void push() {
+        producer.index.store(producer.index.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool push(const T &val) {
+        auto dst = write_slot();
+        if (!dst)
+            return false;
+
+        *dst = val;
+        push();
+        return true;
+    }
+
+    /* the most recently pushed slot, it may already have been consumed */
+    T *last_pushed() {
+        size_t tail = producer.index.load(std::memory_order_relaxed);
+        return tail ? &slots[(tail - 1) % size] : nullptr;
+    }
+
+    /* ---- consumer side ---- */
+
+    T *front() {
+        size_t head = consumer.index.load(std::memory_order_relaxed);
+        if (head == consumer.cached) {
+            consumer.cached = producer.index.load(std::memory_order_acquire);
+            if (head == consumer.cached)
+                return nullptr;
+        }
+
+        return &slots[head % size];
+    }
+
+    void pop() {
+        consumer.index.store(consumer.index.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /* slot number seq (counted from the last clear()) if it has been pushed.
+     * lets the consumer read ahead of front() when it hands slots on to
+     * other threads and only pops them once they are done with them */
+    T *read_slot(size_t seq) {
+        if (seq >= producer.index.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &slots[seq % size];
+    }
+
+    bool pop(T &val) {
+        auto src = front();
+        if (!src)
+            return false;
+
+        val = *src;
+        pop();
+        return true;
+    }
+
+private:
+    struct alignas(SPSC_CACHE_LINE_SIZE) ring_index {
+        std::atomic_size_t index{};
+        size_t cached{};
+    };
+
+    ring_index consumer{};
+    ring_index producer{};
+
+    std::unique_ptr<T[]> slots{};
+    size_t size{};
+};
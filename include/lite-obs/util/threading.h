@@ -10,8 +10,10 @@ enum os_event_type {
 
 struct os_event_data;
 struct os_sem_data;
+struct os_wakeup_data;
 typedef struct os_event_data os_event_t;
 typedef struct os_sem_data os_sem_t;
+typedef struct os_wakeup_data os_wakeup_t;
 
 int os_event_init(os_event_t **event, enum os_event_type type);
 void os_event_destroy(os_event_t *event);
@@ -26,9 +28,18 @@ void os_sem_destroy(os_sem_t *sem);
 int os_sem_post(os_sem_t *sem);
 int os_sem_wait(os_sem_t *sem);
 
+/* auto reset wakeup for a single waiting thread, signalling while nobody is
+ * waiting doesn't enter the kernel (futex on linux/android). */
+int os_wakeup_init(os_wakeup_t **wakeup);
+void os_wakeup_destroy(os_wakeup_t *wakeup);
+int os_wakeup_signal(os_wakeup_t *wakeup);
+int os_wakeup_wait(os_wakeup_t *wakeup);
+
 int64_t os_gettime_ns();
 void os_sleep_ms(uint32_t duration);
 bool os_sleepto_ns(uint64_t time_target);
+/* asks the scheduler to run the calling thread as soon as it wakes */
+bool os_set_thread_time_critical();
 void os_breakpoint(void);
 
 #endif // PLATFORM_H
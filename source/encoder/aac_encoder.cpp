@@ -2,6 +2,7 @@
 #include "lite-obs/util/log.h"
 #include "lite-obs/media-io/audio_output.h"
 #include "lite-obs/media-io/ffmpeg_formats.h"
+#include <string.h>
 
 extern "C"
 {
@@ -23,55 +24,6 @@ extern "C"
 #define CODEC_FLAG_GLOBAL_H CODEC_FLAG_GLOBAL_HEADER
 #endif
 
-static inline uint64_t convert_speaker_layout(speaker_layout layout)
-{
-    switch (layout) {
-    case speaker_layout::SPEAKERS_UNKNOWN:
-        return 0;
-    case speaker_layout::SPEAKERS_MONO:
-        return AV_CH_LAYOUT_MONO;
-    case speaker_layout::SPEAKERS_STEREO:
-        return AV_CH_LAYOUT_STEREO;
-    case speaker_layout::SPEAKERS_2POINT1:
-        return AV_CH_LAYOUT_SURROUND;
-    case speaker_layout::SPEAKERS_4POINT0:
-        return AV_CH_LAYOUT_4POINT0;
-    case speaker_layout::SPEAKERS_4POINT1:
-        return AV_CH_LAYOUT_4POINT1;
-    case speaker_layout::SPEAKERS_5POINT1:
-        return AV_CH_LAYOUT_5POINT1_BACK;
-    case speaker_layout::SPEAKERS_7POINT1:
-        return AV_CH_LAYOUT_7POINT1;
-    }
-
-    /* shouldn't get here */
-    return 0;
-}
-
-static inline speaker_layout
-convert_ff_channel_layout(uint64_t channel_layout)
-{
-    switch (channel_layout) {
-    case AV_CH_LAYOUT_MONO:
-        return speaker_layout::SPEAKERS_MONO;
-    case AV_CH_LAYOUT_STEREO:
-        return speaker_layout::SPEAKERS_STEREO;
-    case AV_CH_LAYOUT_SURROUND:
-        return speaker_layout::SPEAKERS_2POINT1;
-    case AV_CH_LAYOUT_4POINT0:
-        return speaker_layout::SPEAKERS_4POINT0;
-    case AV_CH_LAYOUT_4POINT1:
-        return speaker_layout::SPEAKERS_4POINT1;
-    case AV_CH_LAYOUT_5POINT1_BACK:
-        return speaker_layout::SPEAKERS_5POINT1;
-    case AV_CH_LAYOUT_7POINT1:
-        return speaker_layout::SPEAKERS_7POINT1;
-    }
-
-    /* shouldn't get here */
-    return speaker_layout::SPEAKERS_UNKNOWN;
-}
-
 struct lite_aac_encoder_private
 {
     const char *type{};
@@ -85,8 +37,6 @@ struct lite_aac_encoder_private
     AVFrame *aframe{};
     int64_t total_samples{};
 
-    std::shared_ptr<std::vector<uint8_t>> packet_buffer{};
-
     size_t audio_planes{};
     size_t audio_size{};
 
@@ -127,7 +77,6 @@ void lite_aac_encoder::init_sizes(std::shared_ptr<audio_output> audio)
 
 bool lite_aac_encoder::initialize_codec()
 {
-    d_ptr->packet_buffer = std::make_shared<std::vector<uint8_t>>();
     d_ptr->aframe = av_frame_alloc();
     if (!d_ptr->aframe) {
         blog(LOG_WARNING, "Failed to allocate audio frame");
@@ -253,8 +202,6 @@ void lite_aac_encoder::i_destroy()
     if (d_ptr->aframe)
         av_frame_free(&d_ptr->aframe);
 
-    d_ptr->packet_buffer.reset();
-
     d_ptr->initilized = false;
 }
 
@@ -305,12 +252,10 @@ bool lite_aac_encoder::i_encode_internal(std::shared_ptr<encoder_packet> packet,
     if (!got_packet)
         return true;
 
-    d_ptr->packet_buffer->resize(avpacket.size);
-    memcpy(d_ptr->packet_buffer->data(), avpacket.data, avpacket.size);
 
     packet->pts = rescale_ts(avpacket.pts, d_ptr->context, time_base);
     packet->dts = rescale_ts(avpacket.dts, d_ptr->context, time_base);
-    packet->data = d_ptr->packet_buffer;
+    packet->data = packet_pool_copy(avpacket.data, avpacket.size);
     packet->type = obs_encoder_type::OBS_ENCODER_AUDIO;
     packet->timebase_num = 1;
     packet->timebase_den = (int32_t)d_ptr->context->sample_rate;
@@ -320,8 +265,22 @@ bool lite_aac_encoder::i_encode_internal(std::shared_ptr<encoder_packet> packet,
 
 bool lite_aac_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encoder_packet> packet, std::function<void(std::shared_ptr<encoder_packet>)> send_off)
 {
-    for (size_t i = 0; i < d_ptr->audio_planes; i++)
-        memcpy(d_ptr->samples[i], frame->data[i], d_ptr->frame_size_bytes);
+    /* frames from the encoder's frame pool already hold their planes back
+     * to back the way avcodec_fill_audio_frame wants them, only copy when
+     * they come from somewhere else */
+    uint8_t *samples = frame->data[0];
+    for (size_t i = 0; i < d_ptr->audio_planes; i++) {
+        if (frame->data[i] != frame->data[0] + i * d_ptr->frame_size_bytes ||
+                frame->linesize[i] != (uint32_t)d_ptr->frame_size_bytes) {
+            samples = d_ptr->samples[0];
+            break;
+        }
+    }
+
+    if (samples == d_ptr->samples[0]) {
+        for (size_t i = 0; i < d_ptr->audio_planes; i++)
+            memcpy(d_ptr->samples[i], frame->data[i], d_ptr->frame_size_bytes);
+    }
 
     AVRational time_base = {1, d_ptr->context->sample_rate};
     AVPacket avpacket{};
@@ -333,7 +292,7 @@ bool lite_aac_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encoder_pa
 
     auto ret = avcodec_fill_audio_frame(
                 d_ptr->aframe, d_ptr->context->channels, d_ptr->context->sample_fmt,
-                d_ptr->samples[0], d_ptr->frame_size_bytes * d_ptr->context->channels, 1);
+                samples, d_ptr->frame_size_bytes * d_ptr->context->channels, 1);
     if (ret < 0) {
         blog(LOG_WARNING, "avcodec_fill_audio_frame failed: %d", ret);
         return false;
@@ -362,12 +321,10 @@ bool lite_aac_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encoder_pa
     if (!got_packet)
         return true;
 
-    d_ptr->packet_buffer->resize(avpacket.size);
-    memcpy(d_ptr->packet_buffer->data(), avpacket.data, avpacket.size);
 
     packet->pts = rescale_ts(avpacket.pts, d_ptr->context, time_base);
     packet->dts = rescale_ts(avpacket.dts, d_ptr->context, time_base);
-    packet->data = d_ptr->packet_buffer;
+    packet->data = packet_pool_copy(avpacket.data, avpacket.size);
     packet->type = obs_encoder_type::OBS_ENCODER_AUDIO;
     packet->timebase_num = 1;
     packet->timebase_den = (int32_t)d_ptr->context->sample_rate;
@@ -0,0 +1,413 @@
+#include "lite-obs/encoder/ffmpeg_video_encoder.h"
+#include "lite-obs/media-io/ffmpeg_formats.h"
+
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include "lite-obs/media-io/video_output.h"
+#include "lite-obs/util/log.h"
+
+/* svt-av1 numbers its presets 0 (slowest) - 13, pick the one closest in
+ * speed to the x264 preset of the same name */
+static const struct {
+    const char *x264;
+    int svt;
+} svt_presets[] = {
+    {"ultrafast", 12}, {"superfast", 11}, {"veryfast", 10}, {"faster", 9}, {"fast", 8},
+    {"medium", 7}, {"slow", 5}, {"slower", 4}, {"veryslow", 2}, {"placebo", 0},
+};
+
+static inline bool valid_format(video_format format)
+{
+    return format == video_format::VIDEO_FORMAT_I420 || format == video_format::VIDEO_FORMAT_I444;
+}
+
+const char *ffmpeg_video_encoder_name(ffmpeg_video_codec codec)
+{
+    return codec == ffmpeg_video_codec::HEVC ? "libx265" : "libsvtav1";
+}
+
+void ffmpeg_video_apply_settings(AVCodecContext *context, ffmpeg_video_codec codec, const x264_encoder_settings &settings,
+                                 int bitrate, uint32_t fps_num, uint32_t fps_den)
+{
+    context->bit_rate = (int64_t)bitrate * 1000;
+    context->rc_buffer_size = (settings.vbv_buffer_kbit > 0 ? settings.vbv_buffer_kbit : bitrate) * 1000;
+    context->time_base = {(int)fps_den, (int)fps_num};
+    context->framerate = {(int)fps_num, (int)fps_den};
+    context->thread_count = settings.threads;
+    context->max_b_frames = settings.low_latency ? 0 : settings.bframes;
+    context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    if (settings.keyint_sec > 0 && fps_den)
+        context->gop_size = settings.keyint_sec * (int)fps_num / (int)fps_den;
+    else
+        context->gop_size = 250;
+
+    /* aligned keyframes are all forced by the encoder, keyint -1 turns off
+     * the periodic ones in both libraries */
+    if (codec == ffmpeg_video_codec::HEVC) {
+        /* a max rate equal to the bitrate is what makes x265 run cbr */
+        context->rc_max_rate = (int64_t)bitrate * 1000;
+
+        std::string params = "strict-cbr=1";
+        if (settings.low_latency)
+            params += ":rc-lookahead=0:frame-threads=1";
+        if (settings.aligned_keyframes)
+            params += ":keyint=-1:scenecut=0:open-gop=0";
+
+        av_opt_set(context->priv_data, "preset", settings.preset.c_str(), 0);
+        if (!settings.tune.empty())
+            av_opt_set(context->priv_data, "tune", settings.tune.c_str(), 0);
+        /* a forced frame becomes an idr, not just an i frame */
+        av_opt_set_int(context->priv_data, "forced-idr", 1, 0);
+        av_opt_set(context->priv_data, "x265-params", params.c_str(), 0);
+    } else {
+        int preset = 10;
+        for (auto &p : svt_presets) {
+            if (settings.preset == p.x264)
+                preset = p.svt;
+        }
+
+        /* svt-av1 refuses a max rate outside crf mode, which the wrapper
+         * passes on whenever it is set. cbr is picked through the params
+         * instead, svt-av1 only runs it with the low delay structure */
+        std::string params = "rc=2:pred-struct=1";
+        if (settings.aligned_keyframes)
+            params += ":keyint=-1:scd=0";
+
+        av_opt_set_int(context->priv_data, "preset", preset, 0);
+        av_opt_set(context->priv_data, "svtav1-params", params.c_str(), 0);
+    }
+}
+
+struct ffmpeg_video_encoder_private
+{
+    ffmpeg_video_codec codec{};
+    const AVCodec *av_codec{};
+    AVCodecContext *context{};
+
+    AVFrame *vframe{};
+    AVPacket *av_pkt{};
+
+    std::vector<uint8_t> header{};
+    /* the headers the stream runs with, those of a context reopened with a
+     * new bitrate differ from the extra data when the library puts rate
+     * control into them. changed ones go out ahead of the keyframe the new
+     * context starts with */
+    std::vector<uint8_t> stream_header{};
+    std::vector<uint8_t> inband_header{};
+
+    int height{};
+    /* kbps the next frame is encoded with, the context is reopened when it
+     * differs from what it was opened with */
+    std::atomic_int bitrate{};
+    int open_bitrate{};
+    bool first_packet{};
+    bool initialized{};
+};
+
+ffmpeg_video_encoder::ffmpeg_video_encoder(lite_obs_encoder *encoder, ffmpeg_video_codec codec)
+    : lite_obs_encoder_interface(encoder)
+{
+    d_ptr = std::make_unique<ffmpeg_video_encoder_private>();
+    d_ptr->codec = codec;
+}
+
+ffmpeg_video_encoder::~ffmpeg_video_encoder()
+{
+    if (ffmpeg_video_encoder::i_encoder_valid())
+        ffmpeg_video_encoder::i_destroy();
+}
+
+const char *ffmpeg_video_encoder::i_encoder_codec()
+{
+    return d_ptr->codec == ffmpeg_video_codec::HEVC ? "hevc" : "av1";
+}
+
+obs_encoder_type ffmpeg_video_encoder::i_encoder_type()
+{
+    return obs_encoder_type::OBS_ENCODER_VIDEO;
+}
+
+bool ffmpeg_video_encoder::i_encoder_valid()
+{
+    return d_ptr->initialized;
+}
+
+bool ffmpeg_video_encoder::i_create()
+{
+    const char *name = ffmpeg_video_encoder_name(d_ptr->codec);
+
+    blog(LOG_INFO, "---------------------------------");
+
+    d_ptr->av_codec = avcodec_find_encoder_by_name(name);
+    if (!d_ptr->av_codec) {
+        blog(LOG_WARNING, "Couldn't find encoder %s", name);
+        return false;
+    }
+
+    d_ptr->first_packet = true;
+    d_ptr->bitrate = encoder->lite_obs_encoder_bitrate();
+    if (!update_settings()) {
+        i_destroy();
+        return false;
+    }
+
+    d_ptr->stream_header = d_ptr->header;
+    return true;
+}
+
+void ffmpeg_video_encoder::i_destroy()
+{
+    avcodec_free_context(&d_ptr->context);
+    av_frame_free(&d_ptr->vframe);
+    av_packet_free(&d_ptr->av_pkt);
+    d_ptr->header.clear();
+    d_ptr->stream_header.clear();
+    d_ptr->inband_header.clear();
+
+    d_ptr->initialized = false;
+}
+
+static inline void copy_data(AVFrame *pic, const struct encoder_frame *frame, int height, AVPixelFormat format)
+{
+    int h_chroma_shift, v_chroma_shift;
+    av_pix_fmt_get_chroma_sub_sample(format, &h_chroma_shift, &v_chroma_shift);
+    for (int plane = 0; plane < MAX_AV_PLANES; plane++) {
+        if (!frame->data[plane] || !pic->data[plane])
+            continue;
+
+        int frame_rowsize = (int)frame->linesize[plane];
+        int pic_rowsize = pic->linesize[plane];
+        int bytes = frame_rowsize < pic_rowsize ? frame_rowsize : pic_rowsize;
+        int plane_height = height >> (plane ? v_chroma_shift : 0);
+
+        for (int y = 0; y < plane_height; y++)
+            memcpy(pic->data[plane] + y * pic_rowsize, frame->data[plane] + y * frame_rowsize, bytes);
+    }
+}
+
+/* where headers sent in-band go: hevc takes them ahead of the access unit,
+ * av1 after the temporal delimiter a temporal unit has to start with (obu
+ * type 2 with a size field, of size 0) */
+static size_t inband_header_offset(ffmpeg_video_codec codec, const uint8_t *data, size_t size)
+{
+    if (codec == ffmpeg_video_codec::AV1 && size >= 2 && data[0] == 0x12 && data[1] == 0)
+        return 2;
+    return 0;
+}
+
+/* sends off every packet the context has ready. false on an encoder error */
+static bool receive_packets(ffmpeg_video_encoder_private *d, std::shared_ptr<encoder_packet> &packet,
+                            const std::function<void(std::shared_ptr<encoder_packet>)> &send_off)
+{
+    while (true) {
+        int ret = avcodec_receive_packet(d->context, d->av_pkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            return true;
+        if (ret < 0) {
+            blog(LOG_WARNING, "encode: Error encoding: %d", ret);
+            return false;
+        }
+
+        if (d->first_packet) {
+            packet->encoder_first_packet = true;
+            d->first_packet = false;
+        }
+
+        /* a new buffer for every packet, outputs may still hold earlier ones */
+        if (d->inband_header.empty()) {
+            packet->data = packet_pool_copy(d->av_pkt->data, d->av_pkt->size);
+        } else {
+            size_t size = (size_t)d->av_pkt->size;
+            size_t offset = inband_header_offset(d->codec, d->av_pkt->data, size);
+            packet->data = packet_pool_alloc(size + d->inband_header.size());
+            if (packet->data) {
+                uint8_t *dst = packet->data->data();
+                memcpy(dst, d->av_pkt->data, offset);
+                memcpy(dst + offset, d->inband_header.data(), d->inband_header.size());
+                memcpy(dst + offset + d->inband_header.size(), d->av_pkt->data + offset, size - offset);
+            }
+            d->inband_header.clear();
+        }
+        packet->pts = d->av_pkt->pts;
+        packet->dts = d->av_pkt->dts;
+        packet->type = obs_encoder_type::OBS_ENCODER_VIDEO;
+        packet->keyframe = (d->av_pkt->flags & AV_PKT_FLAG_KEY) != 0;
+        av_packet_unref(d->av_pkt);
+        send_off(packet);
+
+        /* outputs may still hold the packet just sent */
+        packet = encoder_packet_create(*packet);
+        packet->encoder_first_packet = false;
+    }
+}
+
+bool ffmpeg_video_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encoder_packet> packet, std::function<void(std::shared_ptr<encoder_packet>)> send_off)
+{
+    /* neither wrapper passes a new bitrate on to an open encoder. drain it
+     * and open a new one, which starts with a keyframe */
+    if (d_ptr->bitrate != d_ptr->open_bitrate) {
+        avcodec_send_frame(d_ptr->context, nullptr);
+        if (!receive_packets(d_ptr.get(), packet, send_off))
+            return false;
+
+        std::vector<uint8_t> header = std::move(d_ptr->header);
+        avcodec_free_context(&d_ptr->context);
+        av_frame_free(&d_ptr->vframe);
+        if (!update_settings()) {
+            i_destroy();
+            return false;
+        }
+
+        /* outputs took the first headers as extra data, they stay that */
+        if (d_ptr->header != d_ptr->stream_header) {
+            blog(LOG_INFO, "%s: stream headers changed with the bitrate, sending them in-band",
+                 ffmpeg_video_encoder_name(d_ptr->codec));
+            d_ptr->stream_header = d_ptr->header;
+            d_ptr->inband_header = d_ptr->header;
+        }
+        d_ptr->header = std::move(header);
+    }
+
+    int ret = av_frame_make_writable(d_ptr->vframe);
+    if (ret < 0) {
+        blog(LOG_WARNING, "encode: Failed to make frame writable: %d", ret);
+        return false;
+    }
+
+    copy_data(d_ptr->vframe, frame, d_ptr->height, d_ptr->context->pix_fmt);
+    d_ptr->vframe->pts = frame->pts;
+    d_ptr->vframe->pict_type = frame->keyframe ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+
+    ret = avcodec_send_frame(d_ptr->context, d_ptr->vframe);
+    if (ret < 0) {
+        blog(LOG_WARNING, "encode: Error sending frame: %d", ret);
+        return false;
+    }
+
+    return receive_packets(d_ptr.get(), packet, send_off);
+}
+
+bool ffmpeg_video_encoder::i_get_extra_data(uint8_t **extra_data, size_t *size)
+{
+    *extra_data = d_ptr->header.data();
+    *size = d_ptr->header.size();
+    return true;
+}
+
+void ffmpeg_video_encoder::i_get_video_info(video_scale_info *info)
+{
+    /* both libraries take planar yuv only */
+    video_format pref_format = encoder->lite_obs_encoder_get_preferred_video_format();
+    if (!valid_format(pref_format))
+        pref_format = valid_format(info->format) ? info->format : video_format::VIDEO_FORMAT_I420;
+
+    /* svt-av1 only does 4:2:0 */
+    if (d_ptr->codec == ffmpeg_video_codec::AV1)
+        pref_format = video_format::VIDEO_FORMAT_I420;
+
+    info->format = pref_format;
+}
+
+bool ffmpeg_video_encoder::i_gpu_encode_available()
+{
+    return false;
+}
+
+void ffmpeg_video_encoder::i_update_encode_bitrate(int bitrate)
+{
+    d_ptr->bitrate = bitrate;
+}
+
+bool ffmpeg_video_encoder::update_settings()
+{
+    d_ptr->context = avcodec_alloc_context3(d_ptr->av_codec);
+    if (!d_ptr->context) {
+        blog(LOG_WARNING, "Failed to create codec context");
+        return false;
+    }
+
+    auto video = encoder->lite_obs_encoder_video();
+    const struct video_output_info *voi = video->video_output_get_info();
+    auto settings = encoder->lite_obs_encoder_get_x264_settings();
+    int bitrate = d_ptr->bitrate;
+
+    video_scale_info info{};
+    info.format = voi->format;
+    info.colorspace = voi->colorspace;
+    info.range = voi->range;
+    i_get_video_info(&info);
+
+    ffmpeg_video_apply_settings(d_ptr->context, d_ptr->codec, settings, bitrate, voi->fps_num, voi->fps_den);
+    d_ptr->context->width = encoder->lite_obs_encoder_get_width();
+    d_ptr->context->height = encoder->lite_obs_encoder_get_height();
+    d_ptr->context->pix_fmt = lite_obs_to_ffmpeg_video_format(info.format);
+    d_ptr->context->colorspace = info.colorspace == video_colorspace::VIDEO_CS_709
+                                     ? AVCOL_SPC_BT709
+                                     : AVCOL_SPC_BT470BG;
+    d_ptr->context->color_range = info.range == video_range_type::VIDEO_RANGE_FULL
+                                      ? AVCOL_RANGE_JPEG
+                                      : AVCOL_RANGE_MPEG;
+
+    d_ptr->height = d_ptr->context->height;
+    d_ptr->open_bitrate = bitrate;
+
+    blog(LOG_INFO, "%s settings:\n"
+                   "\tbitrate:      %d\n"
+                   "\tkeyint:       %d\n"
+                   "\tpreset:       %s\n"
+                   "\twidth:        %d\n"
+                   "\theight:       %d\n"
+                   "\tb-frames:     %d\n",
+         ffmpeg_video_encoder_name(d_ptr->codec), bitrate, d_ptr->context->gop_size, settings.preset.c_str(),
+         d_ptr->context->width, d_ptr->context->height, d_ptr->context->max_b_frames);
+
+    return init_codec();
+}
+
+bool ffmpeg_video_encoder::init_codec()
+{
+    auto ret = avcodec_open2(d_ptr->context, d_ptr->av_codec, NULL);
+    if (ret < 0) {
+        blog(LOG_WARNING, "Failed to open %s: %d", ffmpeg_video_encoder_name(d_ptr->codec), ret);
+        return false;
+    }
+
+    /* global headers: vps/sps/pps or the av1 sequence header */
+    if (d_ptr->context->extradata_size > 0)
+        d_ptr->header.assign(d_ptr->context->extradata, d_ptr->context->extradata + d_ptr->context->extradata_size);
+
+    if (!d_ptr->av_pkt)
+        d_ptr->av_pkt = av_packet_alloc();
+
+    d_ptr->vframe = av_frame_alloc();
+    if (!d_ptr->vframe || !d_ptr->av_pkt) {
+        blog(LOG_WARNING, "Failed to allocate video frame");
+        return false;
+    }
+
+    d_ptr->vframe->format = d_ptr->context->pix_fmt;
+    d_ptr->vframe->width = d_ptr->context->width;
+    d_ptr->vframe->height = d_ptr->context->height;
+    d_ptr->vframe->colorspace = d_ptr->context->colorspace;
+    d_ptr->vframe->color_range = d_ptr->context->color_range;
+
+    ret = av_frame_get_buffer(d_ptr->vframe, 32);
+    if (ret < 0) {
+        blog(LOG_WARNING, "Failed to allocate vframe: %d", ret);
+        return false;
+    }
+
+    d_ptr->initialized = true;
+    return true;
+}
@@ -2,6 +2,7 @@
 #include "lite-obs/media-io/ffmpeg_formats.h"
 #include "lite-obs/lite_obs_avc.h"
 
+#include <string.h>
 #include <vector>
 
 extern "C"
@@ -28,7 +29,6 @@ struct lite_ffmpeg_video_encoder_private
 
     AVFrame *vframe{};
 
-    std::shared_ptr<std::vector<uint8_t>> buffer{};
     std::vector<uint8_t> header{};
     std::vector<uint8_t> sei{};
 
@@ -36,10 +36,6 @@ struct lite_ffmpeg_video_encoder_private
     bool first_packet{};
     bool initialized{};
     bool new_create = true;
-
-    lite_ffmpeg_video_encoder_private() {
-        buffer = std::make_shared<std::vector<uint8_t>>();
-    }
 };
 
 h264_hw_video_encoder::h264_hw_video_encoder(lite_obs_encoder *encoder)
@@ -83,6 +79,8 @@ bool h264_hw_video_encoder::i_create()
     d_ptr->codec = avcodec_find_encoder_by_name("h264_mediacodec");
 #elif TARGET_PLATFORM == PLATFORM_MAC || TARGET_PLATFORM == PLATFORM_IOS
     d_ptr->codec = avcodec_find_encoder_by_name("h264_videotoolbox");
+#elif TARGET_PLATFORM == PLATFORM_LINUX
+    d_ptr->codec = avcodec_find_encoder_by_name("h264_nvenc");
 #endif
     d_ptr->first_packet = true;
 
@@ -132,7 +130,6 @@ void h264_hw_video_encoder::i_destroy()
     avcodec_close(d_ptr->context);
     av_frame_unref(d_ptr->vframe);
     av_frame_free(&d_ptr->vframe);
-    d_ptr->buffer->clear();
     d_ptr->header.clear();
     d_ptr->sei.clear();
 
@@ -172,6 +169,7 @@ bool h264_hw_video_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encod
     copy_data(d_ptr->vframe, frame, d_ptr->height, d_ptr->context->pix_fmt);
 
     d_ptr->vframe->pts = frame->pts;
+    d_ptr->vframe->pict_type = frame->keyframe ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
 #if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
     auto ret = avcodec_send_frame(d_ptr->context, d_ptr->vframe);
     if (ret == 0)
@@ -191,31 +189,34 @@ bool h264_hw_video_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encod
     }
 
     if (got_packet && av_pkt.size) {
+        const uint8_t *sei = nullptr;
+        size_t sei_len = 0;
+        bool got_sei = encoder->lite_obs_encoder_get_sei(&sei, &sei_len);
+
+        /* a new buffer for every packet, outputs may still hold earlier ones */
+        packet_data data;
         if (d_ptr->first_packet) {
             packet->encoder_first_packet = true;
             d_ptr->first_packet = false;
-            obs_extract_avc_headers(av_pkt.data, av_pkt.size, d_ptr->buffer, d_ptr->header, d_ptr->sei);
+            data = packet_pool_alloc(av_pkt.size);
+            data.resize(0);
+            obs_extract_avc_headers(av_pkt.data, av_pkt.size, data, d_ptr->header, d_ptr->sei);
         } else {
-            d_ptr->buffer->resize(av_pkt.size);
-            memcpy(d_ptr->buffer->data(), av_pkt.data, av_pkt.size);
+            data = packet_pool_copy(av_pkt.data, av_pkt.size);
         }
 
-        uint8_t sei_buf[102400] = {0};
-        int sei_len = 0;
-        bool got_sei = encoder->lite_obs_encoder_get_sei(sei_buf, &sei_len);
-        if (got_sei) {
-            auto old_num = d_ptr->buffer->size();
-            d_ptr->buffer->resize(old_num + sei_len);
-            memcpy(d_ptr->buffer->data() + old_num, sei_buf, sei_len);
-        }
+        if (got_sei)
+            data.append(sei, sei_len);
 
         packet->pts = av_pkt.pts;
         packet->dts = av_pkt.dts;
-        packet->data = d_ptr->buffer;
+        packet->data = std::move(data);
         packet->type = obs_encoder_type::OBS_ENCODER_VIDEO;
         packet->keyframe = obs_avc_keyframe(packet->data->data(), packet->data->size());
         send_off(packet);
 
+        /* outputs may still hold the packet just sent */
+        packet = encoder_packet_create(*packet);
         goto again;
     }
 
@@ -324,6 +325,14 @@ bool h264_hw_video_encoder::update_settings()
     else
         d_ptr->context->gop_size = 250;
 
+    /* aligned keyframes are all forced by lite_obs_encoder, a periodic gop
+     * would add keyframes of its own. forced frames have to be idr frames,
+     * not just i frames, for an output to start on them */
+    if (encoder->lite_obs_encoder_get_x264_settings().aligned_keyframes) {
+        d_ptr->context->gop_size = 1 << 30;
+        av_opt_set_int(d_ptr->context->priv_data, "forced-idr", 1, 0);
+    }
+
     d_ptr->height = d_ptr->context->height;
 
     blog(LOG_INFO, "settings:\n"
@@ -157,7 +157,6 @@ struct mediacodec_encoder_private
     bool initialized = false;
     std::vector<uint8_t> sei;
     std::vector<uint8_t> header;
-    std::shared_ptr<std::vector<uint8_t>> buffer;
     AMediaCodec*    mediacodec = nullptr;
     std::shared_ptr<surface_encode_rc> rc = nullptr;
     video_format format{};
@@ -167,7 +166,6 @@ mediacodec_encoder::mediacodec_encoder(lite_obs_encoder *encoder)
     :lite_obs_encoder_interface(encoder)
 {
     d_ptr = std::make_unique<mediacodec_encoder_private>();
-    d_ptr->buffer = std::make_shared<std::vector<uint8_t>>();
     d_ptr->rc = std::make_shared<surface_encode_rc>();
 }
 
@@ -377,31 +375,31 @@ bool mediacodec_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encoder_
                     d_ptr->header.resize(info.size);
                     memcpy(d_ptr->header.data(), output_buf, info.size);
                 } else {
-                    int bytes = info.size;
-                    uint8_t sei_buf[102400] = {0};
-                    int sei_len = 0;
-                    bool got_sei = encoder->lite_obs_encoder_get_sei(sei_buf, &sei_len);
-                    if (got_sei) {
+                    size_t bytes = info.size;
+                    const uint8_t *sei = nullptr;
+                    size_t sei_len = 0;
+                    bool got_sei = encoder->lite_obs_encoder_get_sei(&sei, &sei_len);
+                    if (got_sei)
                         bytes += sei_len;
-                    }
-
-                    d_ptr->buffer->clear();
-                    d_ptr->buffer->resize(bytes);
 
-                    int copy_index = 0;
-                    if (got_sei) {
-                        memcpy(d_ptr->buffer->data(), sei_buf, sei_len);
-                        copy_index += sei_len;
+                    /* a new buffer for every packet, outputs may still hold earlier ones */
+                    auto data = packet_pool_alloc(bytes);
+                    if (data) {
+                        size_t copy_index = 0;
+                        if (got_sei) {
+                            memcpy(data->data(), sei, sei_len);
+                            copy_index += sei_len;
+                        }
+
+                        memcpy(data->data() + copy_index, output_buf, info.size);
+                        packet->data = std::move(data);
+                        packet->type = obs_encoder_type::OBS_ENCODER_VIDEO;
+
+                        packet->pts = info.presentationTimeUs / (d_ptr->fps_den * 1000000 / d_ptr->fps_num);
+                        packet->dts = packet->pts;
+                        packet->keyframe = !(info.flags & AMEDIACODEC_BUFFER_FLAG_KEY_FRAME);
+                        send_off(packet);
                     }
-
-                    memcpy(d_ptr->buffer->data() + copy_index, output_buf, info.size);
-                    packet->data = d_ptr->buffer;
-                    packet->type = obs_encoder_type::OBS_ENCODER_VIDEO;
-
-                    packet->pts = info.presentationTimeUs / (d_ptr->fps_den * 1000000 / d_ptr->fps_num);
-                    packet->dts = packet->pts;
-                    packet->keyframe = !(info.flags & AMEDIACODEC_BUFFER_FLAG_KEY_FRAME);
-                    send_off(packet);
                 }
                 AMediaCodec_releaseOutputBuffer(d_ptr->mediacodec, status, false);
             }
@@ -0,0 +1,261 @@
+#include "lite-obs/encoder/opus_encoder.h"
+#include "lite-obs/util/log.h"
+#include "lite-obs/media-io/audio_output.h"
+#include "lite-obs/media-io/ffmpeg_formats.h"
+#include <string.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/opt.h>
+}
+
+static inline bool valid_frame_ms(int ms)
+{
+    return ms == 5 || ms == 10 || ms == 20 || ms == 40 || ms == 60;
+}
+
+int opus_apply_settings(AVCodecContext *context, const opus_encoder_settings &settings)
+{
+    int frame_ms = valid_frame_ms(settings.frame_ms) ? settings.frame_ms : 20;
+
+    context->sample_rate = OPUS_SAMPLE_RATE;
+    context->time_base = {1, OPUS_SAMPLE_RATE};
+    context->compression_level = settings.complexity;
+    av_opt_set_double(context->priv_data, "frame_duration", frame_ms, 0);
+    av_opt_set(context->priv_data, "application", settings.low_delay ? "lowdelay" : "audio", 0);
+    return frame_ms;
+}
+
+struct lite_opus_encoder_private
+{
+    bool initilized{};
+
+    const AVCodec *codec{};
+    AVCodecContext *context{};
+
+    AVFrame *aframe{};
+    AVPacket *avpacket{};
+    uint8_t *samples[MAX_AV_PLANES]{};
+    int64_t total_samples{};
+
+    size_t audio_size{};
+
+    int frame_size{};
+    int frame_size_bytes{};
+};
+
+lite_opus_encoder::lite_opus_encoder(lite_obs_encoder *encoder)
+    : lite_obs_encoder_interface(encoder)
+{
+    d_ptr = std::make_unique<lite_opus_encoder_private>();
+}
+
+lite_opus_encoder::~lite_opus_encoder()
+{
+    if (lite_opus_encoder::i_encoder_valid())
+        lite_opus_encoder::i_destroy();
+}
+
+const char *lite_opus_encoder::i_encoder_codec()
+{
+    return "opus";
+}
+
+obs_encoder_type lite_opus_encoder::i_encoder_type()
+{
+    return obs_encoder_type::OBS_ENCODER_AUDIO;
+}
+
+bool lite_opus_encoder::initialize_codec()
+{
+    d_ptr->aframe = av_frame_alloc();
+    d_ptr->avpacket = av_packet_alloc();
+    if (!d_ptr->aframe || !d_ptr->avpacket) {
+        blog(LOG_WARNING, "Failed to allocate audio frame");
+        return false;
+    }
+
+    auto ret = avcodec_open2(d_ptr->context, d_ptr->codec, NULL);
+    if (ret < 0) {
+        blog(LOG_WARNING, "Failed to open Opus codec: %d", ret);
+        return false;
+    }
+    d_ptr->aframe->format = d_ptr->context->sample_fmt;
+    d_ptr->aframe->channels = d_ptr->context->channels;
+    d_ptr->aframe->channel_layout = d_ptr->context->channel_layout;
+    d_ptr->aframe->sample_rate = d_ptr->context->sample_rate;
+
+    /* set from frame_duration when the codec opens */
+    d_ptr->frame_size = d_ptr->context->frame_size;
+    d_ptr->frame_size_bytes = d_ptr->frame_size * (int)d_ptr->audio_size;
+
+    /* unaligned, so planes sit back to back like in the frame pool */
+    ret = av_samples_alloc(d_ptr->samples, NULL, d_ptr->context->channels,
+                           d_ptr->frame_size, d_ptr->context->sample_fmt, 1);
+    if (ret < 0) {
+        blog(LOG_WARNING, "Failed to create audio buffer: %d", ret);
+        return false;
+    }
+
+    return true;
+}
+
+bool lite_opus_encoder::i_create()
+{
+    int bitrate = encoder->lite_obs_encoder_bitrate();
+    auto audio = encoder->lite_obs_encoder_audio();
+    auto settings = encoder->lite_obs_encoder_get_opus_settings();
+
+    /* prefer libopus, ffmpeg's own encoder is experimental */
+    d_ptr->codec = avcodec_find_encoder_by_name("libopus");
+    if (!d_ptr->codec)
+        d_ptr->codec = avcodec_find_encoder_by_name("opus");
+
+    blog(LOG_INFO, "---------------------------------");
+
+    do {
+        if (!d_ptr->codec) {
+            blog(LOG_WARNING, "Couldn't find encoder");
+            break;
+        }
+
+        if (!bitrate) {
+            blog(LOG_WARNING, "Invalid bitrate specified");
+            return false;
+        }
+
+        d_ptr->context = avcodec_alloc_context3(d_ptr->codec);
+        if (!d_ptr->context) {
+            blog(LOG_WARNING, "Failed to create codec context");
+            break;
+        }
+
+        auto aoi = audio->audio_output_get_info();
+        d_ptr->context->bit_rate = bitrate * 1000;
+        d_ptr->context->channels = (int)audio->audio_output_get_channels();
+        d_ptr->context->channel_layout = convert_speaker_layout(aoi->speakers);
+
+        /* interleaved float when offered, saves the planar split */
+        d_ptr->context->sample_fmt = d_ptr->codec->sample_fmts ? d_ptr->codec->sample_fmts[0] : AV_SAMPLE_FMT_FLT;
+        for (auto fmt = d_ptr->codec->sample_fmts; fmt && *fmt != AV_SAMPLE_FMT_NONE; fmt++) {
+            if (*fmt == AV_SAMPLE_FMT_FLT)
+                d_ptr->context->sample_fmt = AV_SAMPLE_FMT_FLT;
+        }
+
+        int frame_ms = opus_apply_settings(d_ptr->context, settings);
+
+        blog(LOG_INFO, "opus bitrate: %" PRId64 ", channels: %d, frame: %d ms, complexity: %d, low delay: %d\n",
+             (int64_t)d_ptr->context->bit_rate / 1000, (int)d_ptr->context->channels,
+             frame_ms, settings.complexity, (int)settings.low_delay);
+
+        auto format = convert_ffmpeg_sample_format(d_ptr->context->sample_fmt);
+        d_ptr->audio_size = get_audio_size(format, aoi->speakers, 1);
+
+        d_ptr->context->strict_std_compliance = -2;
+        d_ptr->context->flags = AV_CODEC_FLAG_GLOBAL_HEADER;
+
+        if (initialize_codec()) {
+            d_ptr->initilized = true;
+            return true;
+        }
+
+    } while (0);
+
+    i_destroy();
+    return false;
+}
+
+void lite_opus_encoder::i_destroy()
+{
+    if (d_ptr->samples[0])
+        av_freep(&d_ptr->samples[0]);
+    avcodec_free_context(&d_ptr->context);
+    av_frame_free(&d_ptr->aframe);
+    av_packet_free(&d_ptr->avpacket);
+
+    d_ptr->initilized = false;
+}
+
+bool lite_opus_encoder::i_encoder_valid()
+{
+    return d_ptr->initilized;
+}
+
+bool lite_opus_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encoder_packet> packet, std::function<void(std::shared_ptr<encoder_packet>)> send_off)
+{
+    /* interleaved or planar, pool frames hold their planes back to back */
+    int planes = av_sample_fmt_is_planar(d_ptr->context->sample_fmt) ? d_ptr->context->channels : 1;
+    int plane_bytes = d_ptr->frame_size_bytes;
+    uint8_t *samples = frame->data[0];
+    for (int i = 0; i < planes; i++) {
+        if (frame->data[i] != frame->data[0] + i * plane_bytes || frame->linesize[i] != (uint32_t)plane_bytes) {
+            samples = d_ptr->samples[0];
+            break;
+        }
+    }
+
+    if (samples == d_ptr->samples[0]) {
+        for (int i = 0; i < planes; i++)
+            memcpy(d_ptr->samples[0] + i * plane_bytes, frame->data[i], plane_bytes);
+    }
+
+    d_ptr->aframe->nb_samples = d_ptr->frame_size;
+    d_ptr->aframe->pts = d_ptr->total_samples;
+
+    auto ret = avcodec_fill_audio_frame(d_ptr->aframe, d_ptr->context->channels, d_ptr->context->sample_fmt,
+                                        samples, plane_bytes * planes, 1);
+    if (ret < 0) {
+        blog(LOG_WARNING, "avcodec_fill_audio_frame failed: %d", ret);
+        return false;
+    }
+
+    d_ptr->total_samples += d_ptr->frame_size;
+
+    ret = avcodec_send_frame(d_ptr->context, d_ptr->aframe);
+    while (ret >= 0) {
+        ret = avcodec_receive_packet(d_ptr->context, d_ptr->avpacket);
+        if (ret < 0)
+            break;
+
+        /* pts start at minus the encoder delay, the pre-skip in the header */
+        packet->pts = d_ptr->avpacket->pts;
+        packet->dts = d_ptr->avpacket->dts;
+        packet->data = packet_pool_copy(d_ptr->avpacket->data, d_ptr->avpacket->size);
+        packet->type = obs_encoder_type::OBS_ENCODER_AUDIO;
+        packet->timebase_num = 1;
+        packet->timebase_den = OPUS_SAMPLE_RATE;
+        av_packet_unref(d_ptr->avpacket);
+        send_off(packet);
+
+        packet = encoder_packet_create(*packet);
+    }
+
+    if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+        blog(LOG_WARNING, "opus encode failed: %d", ret);
+        return false;
+    }
+
+    return true;
+}
+
+size_t lite_opus_encoder::i_get_frame_size()
+{
+    return d_ptr->frame_size;
+}
+
+bool lite_opus_encoder::i_get_extra_data(uint8_t **extra_data, size_t *size)
+{
+    /* the OpusHead mpeg-ts and matroska need */
+    *extra_data = d_ptr->context->extradata;
+    *size = d_ptr->context->extradata_size;
+    return true;
+}
+
+void lite_opus_encoder::i_get_audio_info(audio_convert_info *info)
+{
+    info->format = convert_ffmpeg_sample_format(d_ptr->context->sample_fmt);
+    info->samples_per_sec = (uint32_t)d_ptr->context->sample_rate;
+    info->speakers = convert_ff_channel_layout(d_ptr->context->channel_layout);
+}
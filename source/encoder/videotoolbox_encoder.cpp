@@ -79,13 +79,9 @@ struct videotoolbox_encoder_private
     CMSimpleQueueRef queue{};
     bool hw_enc{};
 
-    std::shared_ptr<std::vector<uint8_t>> packet_data;
+    packet_data data;
     std::vector<uint8_t> extra_data;
     std::vector<uint8_t> sei;
-
-    videotoolbox_encoder_private() {
-        packet_data = std::make_shared<std::vector<uint8_t>>();
-    }
 };
 
 videotoolbox_encoder::videotoolbox_encoder(lite_obs_encoder *encoder)
@@ -616,7 +612,7 @@ static bool is_sample_keyframe(CMSampleBufferRef buffer)
 static const uint8_t annexb_startcode[4] = {0, 0, 0, 1};
 
 static bool handle_keyframe(CMFormatDescriptionRef format_desc,
-                            size_t param_count, const std::shared_ptr<std::vector<uint8_t>> &packet,
+                            size_t param_count, packet_data &packet,
                             std::vector<uint8_t> &extra_data)
 {
     for (size_t i = 0; i < param_count; i++) {
@@ -629,8 +625,8 @@ static bool handle_keyframe(CMFormatDescriptionRef format_desc,
             return false;
         }
 
-        packet->insert(packet->end(), annexb_startcode, annexb_startcode + 4);
-        packet->insert(packet->end(), param, param + param_size);
+        packet.append(annexb_startcode, 4);
+        packet.append(param, param_size);
     }
 
     // if we were passed an extra_data array, fill it with
@@ -643,7 +639,7 @@ static bool handle_keyframe(CMFormatDescriptionRef format_desc,
     return true;
 }
 
-static void convert_block_nals_to_annexb(const std::shared_ptr<std::vector<uint8_t>> &packet,
+static void convert_block_nals_to_annexb(packet_data &packet,
                                          CMBlockBufferRef block,
                                          int nal_length_bytes)
 {
@@ -673,8 +669,8 @@ static void convert_block_nals_to_annexb(const std::shared_ptr<std::vector<uint8
             return;
         }
 
-        packet->insert(packet->end(), annexb_startcode + 1, annexb_startcode + 4);
-        packet->insert(packet->end(), block_buf, block_buf + nal_size);
+        packet.append(annexb_startcode + 1, 3);
+        packet.append(block_buf, nal_size);
 
         bytes_remaining -= nal_size;
         block_buf += nal_size;
@@ -703,11 +699,17 @@ bool videotoolbox_encoder::convert_sample_to_annexb(void *buf, bool keyframe)
         return false;
     }
 
-    if (keyframe && !handle_keyframe(format_desc, param_count, d_ptr->packet_data, d_ptr->extra_data))
+    /* a new buffer for every packet, outputs may still hold earlier ones.
+     * sized for the usual 4 byte length fields plus the parameter sets,
+     * append moves it to a larger block if that is short */
+    CMBlockBufferRef block = CMSampleBufferGetDataBuffer(buffer);
+    d_ptr->data = packet_pool_alloc(CMBlockBufferGetDataLength(block) + 256);
+    d_ptr->data.resize(0);
+
+    if (keyframe && !handle_keyframe(format_desc, param_count, d_ptr->data, d_ptr->extra_data))
         return false;
 
-    CMBlockBufferRef block = CMSampleBufferGetDataBuffer(buffer);
-    convert_block_nals_to_annexb(d_ptr->packet_data, block, nal_length_bytes);
+    convert_block_nals_to_annexb(d_ptr->data, block, nal_length_bytes);
 
     return true;
 }
@@ -736,14 +738,14 @@ bool videotoolbox_encoder::parse_sample(void *buf, const std::shared_ptr<encoder
     packet->type = obs_encoder_type::OBS_ENCODER_VIDEO;
     packet->pts = (int64_t)(CMTimeGetSeconds(pts));
     packet->dts = (int64_t)(CMTimeGetSeconds(dts));
-    packet->data = d_ptr->packet_data;
+    packet->data = std::move(d_ptr->data);
     packet->keyframe = keyframe;
 
     // VideoToolbox produces packets with priority lower than the RTMP code
     // expects, which causes it to be unable to recover from frame drops.
     // Fix this by manually adjusting the priority.
-    uint8_t *start = d_ptr->packet_data->data();
-    uint8_t *end = start + d_ptr->packet_data->size();
+    uint8_t *start = packet->data->data();
+    uint8_t *end = start + packet->data->size();
 
     start = (uint8_t *)obs_avc_find_startcode(start, end);
     while (true) {
@@ -903,7 +905,7 @@ bool videotoolbox_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encode
     draw_video_frame_texture(*((int *)frame->data[0]));
 #endif
 
-    d_ptr->packet_data->clear();
+    d_ptr->data.reset();
 
     CMTime dur = CMTimeMake(d_ptr->fps_den, d_ptr->fps_num);
     CMTime off = CMTimeMultiply(dur, 2);
@@ -1,6 +1,7 @@
 #include "lite-obs/encoder/x264_encoder.h"
 #include "lite-obs/util/log.h"
 #include "lite-obs/media-io/video_output.h"
+#include <string.h>
 #include <x264.h>
 #include <vector>
 #include <cstdint>
@@ -37,8 +38,6 @@ struct x264_encoder_private
     std::vector<uint8_t> sei;
     std::vector<uint8_t> extra_data;
 
-    std::shared_ptr<std::vector<uint8_t>> buffer;
-
     bool initialized{};
     bool first_packet = true;
 };
@@ -47,7 +46,6 @@ x264_encoder::x264_encoder(lite_obs_encoder *encoder)
     : lite_obs_encoder_interface(encoder)
 {
     d_ptr = std::make_unique<x264_encoder_private>();
-    d_ptr->buffer = std::make_shared<std::vector<uint8_t>>();
 }
 
 x264_encoder::~x264_encoder()
@@ -112,6 +110,8 @@ void x264_encoder::init_pic_data(x264_picture_t *pic, encoder_frame *frame)
     x264_picture_init(pic);
 
     pic->i_pts = frame->pts;
+    if (frame->keyframe)
+        pic->i_type = X264_TYPE_IDR;
     pic->img.i_csp = d_ptr->params.i_csp;
 
     if (d_ptr->params.i_csp == X264_CSP_NV12)
@@ -132,35 +132,36 @@ void x264_encoder::parse_packet(const std::shared_ptr<encoder_packet> &packet, x
     if (!nal_count)
         return;
 
-    int bytes = 0;
+    size_t bytes = 0;
     for (int i = 0; i < nal_count; i++) {
         x264_nal_t *nal = nals + i;
         bytes += nal->i_payload;
     }
 
-    uint8_t sei_buf[102400] = {0};
-    int sei_len = 0;
-    bool got_sei = encoder->lite_obs_encoder_get_sei(sei_buf, &sei_len);
-    if (got_sei) {
+    const uint8_t *sei = nullptr;
+    size_t sei_len = 0;
+    bool got_sei = encoder->lite_obs_encoder_get_sei(&sei, &sei_len);
+    if (got_sei)
         bytes += sei_len;
-    }
 
-    d_ptr->buffer->clear();
-    d_ptr->buffer->resize(bytes);
+    /* a new buffer for every packet, outputs may still hold earlier ones */
+    auto data = packet_pool_alloc(bytes);
+    if (!data)
+        return;
 
-    int copy_index = 0;
+    size_t copy_index = 0;
     if (got_sei) {
-        memcpy(d_ptr->buffer->data(), sei_buf, sei_len);
+        memcpy(data->data(), sei, sei_len);
         copy_index += sei_len;
     }
 
     for (int i = 0; i < nal_count; i++) {
         x264_nal_t *nal = nals + i;
-        memcpy(d_ptr->buffer->data() + copy_index, nal->p_payload, nal->i_payload);
+        memcpy(data->data() + copy_index, nal->p_payload, nal->i_payload);
         copy_index += nal->i_payload;
     }
 
-    packet->data = d_ptr->buffer;
+    packet->data = std::move(data);
     packet->type = obs_encoder_type::OBS_ENCODER_VIDEO;
     packet->pts = pic_out->i_pts;
     packet->dts = pic_out->i_dts;
@@ -245,24 +246,128 @@ void x264_encoder::i_update_encode_bitrate(int bitrate)
     }
 }
 
-bool x264_encoder::update_settings(bool update)
+static bool parse_x264_opts(x264_param_t *params, const std::string &opts)
 {
-    const char *preset = "veryfast";
+    bool success = true;
+    size_t pos = 0;
+    while (pos < opts.size()) {
+        size_t next = opts.find_first_of(": ", pos);
+        if (next == std::string::npos)
+            next = opts.size();
+
+        std::string opt = opts.substr(pos, next - pos);
+        pos = next + 1;
+        if (opt.empty())
+            continue;
+
+        std::string name = opt;
+        std::string value = "true";
+        size_t eq = opt.find('=');
+        if (eq != std::string::npos) {
+            name = opt.substr(0, eq);
+            value = opt.substr(eq + 1);
+        }
 
-    if (!update)
-        blog(LOG_INFO, "---------------------------------");
+        int ret = x264_param_parse(params, name.c_str(), value.c_str());
+        if (ret == X264_PARAM_BAD_NAME) {
+            blog(LOG_WARNING, "x264 option: unknown name %s", name.c_str());
+            success = false;
+        } else if (ret == X264_PARAM_BAD_VALUE) {
+            blog(LOG_WARNING, "x264 option: bad value %s for %s", value.c_str(), name.c_str());
+            success = false;
+        }
+    }
 
-    bool success = false;
-    if (!d_ptr->context) {
-        if (preset && *preset)
-            blog(LOG_INFO, "preset: %s", preset);
+    return success;
+}
+
+bool x264_apply_settings(x264_param_t *params, const x264_encoder_settings &settings,
+                         int bitrate, uint32_t fps_num, uint32_t fps_den, bool reconfig)
+{
+    if (!reconfig) {
+        const char *tune = settings.tune.empty() ? nullptr : settings.tune.c_str();
+        if (x264_param_default_preset(params, settings.preset.c_str(), tune) != 0) {
+            blog(LOG_WARNING, "x264: bad preset %s or tune %s", settings.preset.c_str(), tune ? tune : "none");
+            return false;
+        }
+
+        params->i_threads = settings.threads;
+        if (settings.lookahead > 0)
+            params->rc.i_lookahead = settings.lookahead;
+        params->i_bframe = settings.bframes;
+        if (settings.keyint_sec > 0 && fps_den)
+            params->i_keyint_max = settings.keyint_sec * (int)fps_num / (int)fps_den;
+
+        /* frame threads and the lookahead each hold frames back, slices
+         * split every frame across the threads instead. intra refresh
+         * spreads the keyframe over keyint frames so no single frame
+         * spikes the bitrate */
+        if (settings.low_latency) {
+            params->b_sliced_threads = 1;
+            params->rc.i_lookahead = 0;
+            params->i_sync_lookahead = 0;
+            params->rc.b_mb_tree = 0;
+            params->i_bframe = 0;
+            params->b_intra_refresh = 1;
+        }
+
+        /* the encoder forces the keyframes, scene cuts or an intra refresh
+         * cycle would put them somewhere else in each rendition */
+        if (settings.aligned_keyframes) {
+            params->i_keyint_max = X264_KEYINT_MAX_INFINITE;
+            params->i_scenecut_threshold = 0;
+            params->b_intra_refresh = 0;
+        }
+    }
+
+    int buffer_size = settings.vbv_buffer_kbit > 0 ? settings.vbv_buffer_kbit : bitrate;
+    params->rc.i_vbv_max_bitrate = bitrate;
+    params->rc.i_vbv_buffer_size = buffer_size;
+
+    if (settings.crf > 0) {
+        params->rc.i_rc_method = X264_RC_CRF;
+        params->rc.f_rf_constant = (float)settings.crf;
+        params->rc.i_bitrate = 0;
+#if X264_BUILD >= 139
+        params->rc.b_filler = false;
+#endif
+    } else {
+        /* use the new filler method for CBR to allow real-time adjusting of
+         * the bitrate */
+        params->rc.i_rc_method = X264_RC_ABR;
+        params->rc.i_bitrate = bitrate;
+        params->rc.f_rf_constant = (float)0;
+#if X264_BUILD >= 139
+        params->rc.b_filler = true;
+#else
+        params->i_nal_hrd = X264_NAL_HRD_CBR;
+#endif
+    }
 
-        int ret = x264_param_default_preset(&d_ptr->params, preset, "");
-        success = ret == 0;
+    if (!reconfig && !settings.x264_opts.empty())
+        return parse_x264_opts(params, settings.x264_opts);
+
+    return true;
+}
+
+bool x264_encoder::update_settings(bool update)
+{
+    auto settings = encoder->lite_obs_encoder_get_x264_settings();
+
+    if (!update) {
+        blog(LOG_INFO, "---------------------------------");
+        blog(LOG_INFO, "preset: %s", settings.preset.c_str());
+        if (!settings.tune.empty())
+            blog(LOG_INFO, "tune: %s", settings.tune.c_str());
+        if (settings.low_latency)
+            blog(LOG_INFO, "low latency: sliced threads%s", settings.aligned_keyframes ? "" : ", intra refresh");
+        if (settings.aligned_keyframes)
+            blog(LOG_INFO, "keyframes aligned every %d s", settings.keyint_sec);
+        if (!settings.x264_opts.empty())
+            blog(LOG_INFO, "x264 opts: %s", settings.x264_opts.c_str());
     }
 
-    if (success)
-        update_params(update);
+    bool success = update_params(settings, update);
 
     d_ptr->params.b_repeat_headers = false;
     return success;
@@ -278,11 +383,11 @@ static void log_x264(void *param, int level, const char *format, va_list args)
     (void)level;
 }
 
-void x264_encoder::update_params(bool update)
+bool x264_encoder::update_params(const x264_encoder_settings &settings, bool update)
 {
     auto video = encoder->lite_obs_encoder_video();
     if (!video)
-        return;
+        return false;
 
     auto voi = video->video_output_get_info();
     video_scale_info info;
@@ -293,20 +398,18 @@ void x264_encoder::update_params(bool update)
 
     i_get_video_info(&info);
 
-
     int bitrate = encoder->lite_obs_encoder_bitrate();
-    int buffer_size = bitrate;
-    int keyint_sec = 2;
     int width = (int)encoder->lite_obs_encoder_get_width();
     int height = (int)encoder->lite_obs_encoder_get_height();
 
-    if (keyint_sec)
-        d_ptr->params.i_keyint_max = keyint_sec * voi->fps_num / voi->fps_den;
+    /* a running encoder only takes the new bitrate */
+    bool reconfig = update && d_ptr->context;
+    if (!x264_apply_settings(&d_ptr->params, settings, bitrate, voi->fps_num, voi->fps_den, reconfig))
+        return false;
+    if (reconfig)
+        return true;
 
     d_ptr->params.b_vfr_input = false;
-    d_ptr->params.rc.i_vbv_max_bitrate = bitrate;
-    d_ptr->params.rc.i_vbv_buffer_size = buffer_size;
-    d_ptr->params.rc.i_bitrate = bitrate;
     d_ptr->params.i_width = width;
     d_ptr->params.i_height = height;
     d_ptr->params.i_fps_num = voi->fps_num;
@@ -314,25 +417,12 @@ void x264_encoder::update_params(bool update)
     d_ptr->params.pf_log = log_x264;
     d_ptr->params.p_log_private = this;
     d_ptr->params.i_log_level = X264_LOG_WARNING;
-    d_ptr->params.i_bframe = 0;
 
     d_ptr->params.vui.i_transfer = get_x264_cs_val(info.colorspace, x264_transfer_names);
     d_ptr->params.vui.i_colmatrix = get_x264_cs_val(info.colorspace, x264_colmatrix_names);
     d_ptr->params.vui.i_colorprim = get_x264_cs_val(info.colorspace, x264_colorprim_names);
     d_ptr->params.vui.b_fullrange = info.range == video_range_type::VIDEO_RANGE_FULL;
 
-    /* use the new filler method for CBR to allow real-time adjusting of
-     * the bitrate */
-    d_ptr->params.rc.i_rc_method = X264_RC_ABR;
-
-#if X264_BUILD >= 139
-    d_ptr->params.rc.b_filler = true;
-#else
-    d_ptr->params.i_nal_hrd = X264_NAL_HRD_CBR;
-#endif
-
-    d_ptr->params.rc.f_rf_constant = (float)0;
-
     if (info.format == video_format::VIDEO_FORMAT_NV12)
         d_ptr->params.i_csp = X264_CSP_NV12;
     else if (info.format == video_format::VIDEO_FORMAT_I420)
@@ -344,7 +434,7 @@ void x264_encoder::update_params(bool update)
 
     if (!update) {
         blog(LOG_INFO, "settings:\n"
-                       "\trate_control: CBR\n"
+                       "\trate_control: %s\n"
                        "\tbitrate:      %d\n"
                        "\tbuffer size:  %d\n"
                        "\tcrf:          %d\n"
@@ -352,12 +442,20 @@ void x264_encoder::update_params(bool update)
                        "\tfps_den:      %d\n"
                        "\twidth:        %d\n"
                        "\theight:       %d\n"
-                       "\tkeyint:       %d\n",
+                       "\tkeyint:       %d\n"
+                       "\tthreads:      %d\n"
+                       "\tlookahead:    %d\n"
+                       "\tbframes:      %d\n",
+             settings.crf > 0 ? "CRF" : "CBR",
              d_ptr->params.rc.i_vbv_max_bitrate,
              d_ptr->params.rc.i_vbv_buffer_size,
              (int)d_ptr->params.rc.f_rf_constant, voi->fps_num,
-             voi->fps_den, width, height, d_ptr->params.i_keyint_max);
+             voi->fps_den, width, height, d_ptr->params.i_keyint_max,
+             d_ptr->params.i_threads, d_ptr->params.rc.i_lookahead,
+             d_ptr->params.i_bframe);
     }
+
+    return true;
 }
 
 void x264_encoder::load_headers()
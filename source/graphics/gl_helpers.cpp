@@ -1,5 +1,6 @@
 #include "lite-obs/graphics/gl_helpers.h"
 #include <memory>
+#include <string.h>
 
 bool gl_create_buffer(GLenum target, GLuint *buffer, GLsizeiptr size,
                       const GLvoid *data, GLenum usage)
@@ -8,6 +8,7 @@
 #include "lite-obs/graphics/gs_shader.h"
 #include "lite-obs/graphics/gs_vertexbuffer.h"
 
+#include <string.h>
 #include <glm/mat4x4.hpp>
 
 #include <list>
@@ -0,0 +1,344 @@
+#include "lite-obs/graphics/gs_context_gl.h"
+#include "lite-obs/graphics/gs_subsystem_info.h"
+#include "lite-obs/util/log.h"
+
+#if TARGET_PLATFORM == PLATFORM_LINUX
+
+#include <string.h>
+#include <vector>
+
+#ifdef LITEOBS_USE_OSMESA
+
+#include <GL/osmesa.h>
+
+/* OSMesa always renders into client memory, all of our drawing goes to fbos
+ * so a 1x1 color buffer is enough to make the context current. */
+struct gl_platform
+{
+    OSMesaContext context{};
+    void *buffer{};
+    GLsizei width = 1;
+    GLsizei height = 1;
+    std::vector<uint8_t> storage{};
+    bool release_on_destroy = true;
+
+    ~gl_platform() {
+        if (release_on_destroy && context) {
+            OSMesaMakeCurrent(nullptr, nullptr, 0, 0, 0);
+            OSMesaDestroyContext(context);
+        }
+    }
+};
+
+void *gs_context_gl::gs_create_platform_rc()
+{
+    return nullptr;
+}
+
+void gs_context_gl::gs_destroy_platform_rc(void *plat)
+{
+    (void)plat;
+}
+
+void *gs_context_gl::gl_platform_create(void *)
+{
+    const int attribs[] = {
+        OSMESA_FORMAT, OSMESA_RGBA,
+        OSMESA_DEPTH_BITS, 0,
+        OSMESA_STENCIL_BITS, 0,
+        OSMESA_ACCUM_BITS, 0,
+        OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, 3,
+        OSMESA_CONTEXT_MINOR_VERSION, 3,
+        0
+    };
+
+    blog(LOG_DEBUG, "Initializing osmesa context");
+
+    auto share = OSMesaGetCurrentContext();
+    auto context = OSMesaCreateContextAttribs(attribs, share);
+    if (context && share)
+        set_texture_share_enabled(true);
+
+    if (!context && share)
+        context = OSMesaCreateContextAttribs(attribs, nullptr);
+
+    if (!context) {
+        blog(LOG_ERROR, "OSMesaCreateContextAttribs() failed");
+        return nullptr;
+    }
+
+    auto plat = std::make_unique<gl_platform>();
+    plat->context = context;
+    plat->storage.resize(plat->width * plat->height * 4);
+    plat->buffer = plat->storage.data();
+
+    if (!OSMesaMakeCurrent(plat->context, plat->buffer, GL_UNSIGNED_BYTE, plat->width, plat->height)) {
+        blog(LOG_ERROR, "OSMesaMakeCurrent() failed");
+        return nullptr;
+    }
+
+    blog(LOG_DEBUG, "osmesa create opengl context success, renderer: %s", (const char *)glGetString(GL_RENDERER));
+
+    return plat.release();
+}
+
+gl_context_helper::gl_context_helper()
+{
+    platform = std::make_shared<gl_platform>();
+    platform->release_on_destroy = false;
+    platform->context = OSMesaGetCurrentContext();
+    if (platform->context) {
+        GLint width = 0, height = 0, format = 0;
+        OSMesaGetColorBuffer(platform->context, &width, &height, &format, &platform->buffer);
+        platform->width = width;
+        platform->height = height;
+    }
+}
+
+gl_context_helper::~gl_context_helper()
+{
+    if (platform->context && platform->buffer) {
+        if (!OSMesaMakeCurrent(platform->context, platform->buffer, GL_UNSIGNED_BYTE, platform->width, platform->height))
+            blog(LOG_DEBUG, "gl_context_helper restore osmesa context failed");
+    }
+}
+
+void gs_context_gl::device_enter_context_internal(void *param)
+{
+    gl_platform *plat = (gl_platform *)param;
+    if (!OSMesaMakeCurrent(plat->context, plat->buffer, GL_UNSIGNED_BYTE, plat->width, plat->height))
+        blog(LOG_DEBUG, "OSMesaMakeCurrent() failed");
+}
+
+void gs_context_gl::device_leave_context_internal(void *param)
+{
+    (void)param;
+    OSMesaMakeCurrent(nullptr, nullptr, 0, 0, 0);
+}
+
+#else
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+struct gl_platform
+{
+    EGLDisplay display{};
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context{};
+    bool terminate_display{};
+    bool release_on_destroy = true;
+
+    ~gl_platform() {
+        if (release_on_destroy) {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(display, context);
+            if (surface != EGL_NO_SURFACE)
+                eglDestroySurface(display, surface);
+            if (terminate_display)
+                eglTerminate(display);
+        }
+    }
+};
+
+static bool egl_has_extension(EGLDisplay display, const char *ext)
+{
+    const char *exts = eglQueryString(display, EGL_EXTENSIONS);
+    if (!exts)
+        return false;
+
+    size_t len = strlen(ext);
+    for (const char *p = strstr(exts, ext); p; p = strstr(p + len, ext)) {
+        if ((p == exts || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+            return true;
+    }
+
+    return false;
+}
+
+/* prefer the mesa surfaceless platform, it needs neither a window system nor
+ * a gpu (llvmpipe is picked when no render node is available). */
+static EGLDisplay egl_get_headless_display()
+{
+    if (egl_has_extension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display) {
+            auto display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+
+    blog(LOG_DEBUG, "EGL_MESA_platform_surfaceless not available, use default display");
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+void *gs_context_gl::gs_create_platform_rc()
+{
+    return nullptr;
+}
+
+void gs_context_gl::gs_destroy_platform_rc(void *plat)
+{
+    (void)plat;
+}
+
+void *gs_context_gl::gl_platform_create(void *)
+{
+    EGLint attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 0,
+        EGL_STENCIL_SIZE, 0,
+        EGL_NONE
+    };
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLConfig config{};
+    EGLint numConfigs = 0;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+
+    blog(LOG_DEBUG, "Initializing egl context");
+
+    /* share with the caller's context when there is one, which means we
+     * have to live on the same display */
+    auto share = eglGetCurrentContext();
+    EGLDisplay display = share != EGL_NO_CONTEXT ? eglGetCurrentDisplay() : egl_get_headless_display();
+    bool terminate_display = share == EGL_NO_CONTEXT;
+    if (display == EGL_NO_DISPLAY) {
+        blog(LOG_ERROR, "eglGetDisplay() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    EGLint major = 0, minor = 0;
+    if (!eglInitialize(display, &major, &minor)) {
+        blog(LOG_ERROR, "eglInitialize() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    blog(LOG_DEBUG, "egl version %d.%d, vendor: %s", major, minor, eglQueryString(display, EGL_VENDOR));
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        blog(LOG_ERROR, "eglBindAPI() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    bool surfaceless = egl_has_extension(display, "EGL_KHR_surfaceless_context");
+    if (!eglChooseConfig(display, attribs, &config, 1, &numConfigs) || !numConfigs) {
+        if (!surfaceless) {
+            blog(LOG_ERROR, "eglChooseConfig() returned error %d", eglGetError());
+            return nullptr;
+        }
+
+        /* surfaceless displays may not expose any pbuffer config */
+        attribs[1] = 0;
+        if (!eglChooseConfig(display, attribs, &config, 1, &numConfigs) || !numConfigs) {
+            blog(LOG_ERROR, "eglChooseConfig() returned error %d", eglGetError());
+            return nullptr;
+        }
+    }
+
+    if (!surfaceless) {
+        const EGLint pbufferAttribs[] = {
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+        };
+        if ((surface = eglCreatePbufferSurface(display, config, pbufferAttribs)) == EGL_NO_SURFACE) {
+            blog(LOG_ERROR, "eglCreatePbufferSurface() returned error %d", eglGetError());
+            return nullptr;
+        }
+    }
+
+    if (share != EGL_NO_CONTEXT) {
+        if ((context = eglCreateContext(display, config, share, contextAttribs)) != EGL_NO_CONTEXT)
+            set_texture_share_enabled(true);
+    }
+
+    if (context == EGL_NO_CONTEXT) {
+        if ((context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs)) == EGL_NO_CONTEXT) {
+            blog(LOG_ERROR, "eglCreateContext() returned error %d", eglGetError());
+            if (surface != EGL_NO_SURFACE)
+                eglDestroySurface(display, surface);
+            return nullptr;
+        }
+    }
+
+    auto plat = std::make_unique<gl_platform>();
+    plat->context = context;
+    plat->display = display;
+    plat->surface = surface;
+    plat->terminate_display = terminate_display;
+
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        blog(LOG_ERROR, "eglMakeCurrent() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    blog(LOG_DEBUG, "egl create opengl context success, surfaceless: %d, renderer: %s", surfaceless, (const char *)glGetString(GL_RENDERER));
+
+    return plat.release();
+}
+
+gl_context_helper::gl_context_helper()
+{
+    platform = std::make_shared<gl_platform>();
+    platform->release_on_destroy = false;
+    platform->context = eglGetCurrentContext();
+    platform->display = eglGetCurrentDisplay();
+    platform->surface = eglGetCurrentSurface(EGL_DRAW);
+}
+
+gl_context_helper::~gl_context_helper()
+{
+    if (platform->context != EGL_NO_CONTEXT && platform->display != EGL_NO_DISPLAY) {
+        if (!eglMakeCurrent(platform->display, platform->surface, platform->surface, platform->context)) {
+            blog(LOG_DEBUG, "gl_context_helper restore gl context-> %d", eglGetError());
+        }
+    }
+}
+
+void gs_context_gl::device_enter_context_internal(void *param)
+{
+    gl_platform *plat = (gl_platform *)param;
+    if (!eglMakeCurrent(plat->display, plat->surface, plat->surface, plat->context)) {
+        blog(LOG_DEBUG, "eglMakeCurrent() returned error %d", eglGetError());
+    }
+}
+
+void gs_context_gl::device_leave_context_internal(void *param)
+{
+    gl_platform *plat = (gl_platform *)param;
+    eglMakeCurrent(plat->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+#endif
+
+void gs_context_gl::gl_platform_destroy(void *plat)
+{
+    gl_platform *p = (gl_platform *)plat;
+    delete p;
+}
+
+void *gs_context_gl::get_device_context_internal(void *param)
+{
+    gl_platform *plat = (gl_platform *)param;
+    return plat->context;
+}
+
+#endif
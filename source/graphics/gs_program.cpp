@@ -5,6 +5,7 @@
 #include "lite-obs/graphics/gs_shader.h"
 #include "lite-obs/graphics/gs_subsystem.h"
 
+#include <string.h>
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
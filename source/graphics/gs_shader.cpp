@@ -2,6 +2,7 @@
 #include "lite-obs/graphics/shaders.h"
 #include "lite-obs/graphics/gl_helpers.h"
 #include "lite-obs/lite_obs_platform_config.h"
+#include <string.h>
 
 struct gs_sampler_info {
     gs_sample_filter filter;
@@ -14,8 +14,11 @@ struct gs_stagesurface_private
     GLenum gl_format{};
     GLenum gl_type{};
     GLuint pack_buffer{};
+    GLsync fence{};
 
     ~gs_stagesurface_private() {
+        if (fence)
+            glDeleteSync(fence);
         if (pack_buffer)
             gl_delete_buffers(1, &pack_buffer);
     }
@@ -94,6 +97,24 @@ bool gs_stagesurface::can_stage(std::shared_ptr<gs_texture> src)
 
     return true;
 }
+
+void gs_stagesurface::insert_fence()
+{
+    release_fence();
+
+    d_ptr->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl_success("glFenceSync");
+}
+
+void gs_stagesurface::release_fence()
+{
+    if (!d_ptr->fence)
+        return;
+
+    glDeleteSync(d_ptr->fence);
+    d_ptr->fence = nullptr;
+}
+
 #ifdef PLATFORM_MOBILE
 
 /* Apparently for mac, PBOs won't do an asynchronous transfer unless you use
@@ -125,6 +146,7 @@ void gs_stagesurface::gs_stagesurface_stage_texture(const std::shared_ptr<gs_tex
     if (!gl_success("glReadPixels"))
         goto failed_unbind_all;
 
+    insert_fence();
     success = true;
 
 failed_unbind_all:
@@ -153,6 +175,8 @@ void gs_stagesurface::gs_stagesurface_stage_texture(const std::shared_ptr<gs_tex
     if (!gl_success("glGetTexImage"))
         goto failed;
 
+    insert_fence();
+
     gl_bind_texture(GL_TEXTURE_2D, 0);
     gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
     return;
@@ -179,8 +203,29 @@ gs_color_format gs_stagesurface::gs_stagesurface_get_color_format()
     return d_ptr->format;
 }
 
+/* polls the fence placed after the last readback without waiting, mapping a
+ * surface that is not ready yet stalls the calling thread until the gpu has
+ * finished the transfer. */
+bool gs_stagesurface::gs_stagesurface_ready()
+{
+    if (!d_ptr->fence)
+        return true;
+
+    GLenum ret = glClientWaitSync(d_ptr->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (ret == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    if (ret == GL_WAIT_FAILED)
+        gl_success("glClientWaitSync");
+
+    release_fence();
+    return true;
+}
+
 bool gs_stagesurface::gs_stagesurface_map(uint8_t **data, uint32_t *linesize)
 {
+    release_fence();
+
     if (!gl_bind_buffer(GL_PIXEL_PACK_BUFFER, d_ptr->pack_buffer))
         goto fail;
 
@@ -1,6 +1,11 @@
 #include "lite-obs/graphics/gs_texture.h"
 #include "lite-obs/graphics/gs_subsystem.h"
 #include "lite-obs/graphics/gs_shader.h"
+#include <string.h>
+
+/* dynamic textures upload through a small ring of unpack buffers so a new
+ * image never has to wait for the previous transfer to finish */
+#define NUM_UNPACK_BUFFERS 3
 
 bool fbo_info::attach_rendertarget(std::shared_ptr<gs_texture> tex) {
     if (cur_render_target.lock() == tex)
@@ -38,7 +43,8 @@ struct gs_texture_private
     uint32_t width{};
     uint32_t height{};
     bool gen_mipmaps{};
-    GLuint unpack_buffer{};
+    GLuint unpack_buffers[NUM_UNPACK_BUFFERS]{};
+    int cur_unpack_buffer{};
     GLsizeiptr size{};
 
     bool external_texture{};
@@ -52,8 +58,8 @@ gs_texture::gs_texture()
 gs_texture::~gs_texture()
 {
     if (!d_ptr->external_texture) {
-        if (d_ptr->base.is_dynamic && d_ptr->unpack_buffer)
-            gl_delete_buffers(1, &d_ptr->unpack_buffer);
+        if (d_ptr->base.is_dynamic && d_ptr->unpack_buffers[0])
+            gl_delete_buffers(NUM_UNPACK_BUFFERS, d_ptr->unpack_buffers);
 
         if (d_ptr->base.texture)
             gl_delete_textures(1, &d_ptr->base.texture);
@@ -155,15 +161,13 @@ bool gs_texture::gs_texture_map(uint8_t **ptr, uint32_t *linesize)
         goto fail;
     }
 
-    if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffer))
+    if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffers[d_ptr->cur_unpack_buffer]))
         goto fail;
 
-#ifdef PLATFORM_MOBILE
-    *ptr = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, d_ptr->size, GL_MAP_WRITE_BIT);
-#else
-    *ptr = (uint8_t *)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-#endif
-    if (!gl_success("glMapBuffer"))
+    /* the whole buffer is rewritten, let the driver drop its old contents
+     * instead of syncing with a transfer that may still read from it */
+    *ptr = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, d_ptr->size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!gl_success("glMapBufferRange") || !*ptr)
         goto fail;
 
     gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
@@ -173,15 +177,19 @@ bool gs_texture::gs_texture_map(uint8_t **ptr, uint32_t *linesize)
     return true;
 
 fail:
+    gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
     blog(LOG_ERROR, "gs_texture_map (GL) failed");
     return false;
 }
 
 void gs_texture::gs_texture_unmap()
 {
-    if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffer))
+    if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffers[d_ptr->cur_unpack_buffer]))
         goto failed;
 
+    if (++d_ptr->cur_unpack_buffer == NUM_UNPACK_BUFFERS)
+        d_ptr->cur_unpack_buffer = 0;
+
     glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
     if (!gl_success("glUnmapBuffer"))
         goto failed;
@@ -189,9 +197,10 @@ void gs_texture::gs_texture_unmap()
     if (!gl_bind_texture(GL_TEXTURE_2D, d_ptr->base.texture))
         goto failed;
 
-    glTexImage2D(GL_TEXTURE_2D, 0, d_ptr->base.gl_internal_format, d_ptr->width,
-                 d_ptr->height, 0, d_ptr->base.gl_format, d_ptr->base.gl_type, 0);
-    if (!gl_success("glTexImage2D"))
+    /* the storage was allocated by create(), only the contents change */
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, d_ptr->width, d_ptr->height,
+                    d_ptr->base.gl_format, d_ptr->base.gl_type, 0);
+    if (!gl_success("glTexSubImage2D"))
         goto failed;
 
     gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
@@ -214,6 +223,11 @@ bool gs_texture::gs_texture_is_render_target()
     return d_ptr->base.is_render_target;
 }
 
+bool gs_texture::gs_texture_is_dynamic()
+{
+    return d_ptr->base.is_dynamic && !d_ptr->external_texture;
+}
+
 std::shared_ptr<fbo_info> gs_texture::get_fbo()
 {
     uint32_t width, height;
@@ -351,10 +365,7 @@ bool gs_texture::create_pixel_unpack_buffer()
     GLsizeiptr size;
     bool success = true;
 
-    if (!gl_gen_buffers(1, &d_ptr->unpack_buffer))
-        return false;
-
-    if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffer))
+    if (!gl_gen_buffers(NUM_UNPACK_BUFFERS, d_ptr->unpack_buffers))
         return false;
 
     size = d_ptr->width * gs_get_format_bpp(d_ptr->base.format);
@@ -362,9 +373,14 @@ bool gs_texture::create_pixel_unpack_buffer()
     size = (size + 3) & 0xFFFFFFFC;
     size *= d_ptr->height;
 
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_DYNAMIC_DRAW);
-    if (!gl_success("glBufferData"))
-        success = false;
+    for (int i = 0; i < NUM_UNPACK_BUFFERS; i++) {
+        if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffers[i]))
+            return false;
+
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_STREAM_DRAW);
+        if (!gl_success("glBufferData"))
+            success = false;
+    }
 
     if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0))
         success = false;
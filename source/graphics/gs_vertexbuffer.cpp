@@ -1,5 +1,6 @@
 #include "lite-obs/graphics/gs_vertexbuffer.h"
 #include "lite-obs/graphics/gl_helpers.h"
+#include <string.h>
 #include <stdint.h>
 
 struct gs_vertexbuffer_private
@@ -2785,6 +2785,150 @@ float undistort_factor null 3 0 18446744073709551615
 textureSampler
 )";
 
+std::string area_shader = R"(
+Area_Draw
+---------------------------------------
+const bool obs_glsl_compile = true;
+
+uniform mat4x4 ViewProj;
+
+in vec4 _input_attrib0;
+in vec2 _input_attrib1;
+
+out vec2 _vertex_shader_attrib0;
+
+struct VertInOut {
+    vec4 pos;
+    vec2 uv;
+};
+
+VertInOut VSDefault(VertInOut vert_in)
+{
+    VertInOut vert_out;
+    vert_out.pos = ((vec4(vert_in.pos.xyz, 1.0)) * (ViewProj));
+    vert_out.uv  = vert_in.uv;
+    return vert_out;
+}
+
+VertInOut _main_wrap(VertInOut vert_in)
+{
+    return VSDefault(vert_in);
+}
+
+void main(void)
+{
+    VertInOut vert_in;
+    VertInOut outputval;
+
+    vert_in.pos = _input_attrib0;
+    vert_in.uv = _input_attrib1;
+
+    outputval = _main_wrap(vert_in);
+
+    gl_Position = outputval.pos;
+    _vertex_shader_attrib0 = outputval.uv;
+}
+
+---------------------------------------
+float4x4 ViewProj null 3 0 18446744073709551615
+---------------------------------------
+_input_attrib0 POSITION 1
++++++++++++++++++++++++++++++++++++++++
+_input_attrib1 TEXCOORD0 1
++++++++++++++++++++++++++++++++++++++++
+_vertex_shader_attrib0 TEXCOORD0 0
+---------------------------------------
+=======================================
+Area_Draw
+---------------------------------------
+const bool obs_glsl_compile = true;
+
+uniform highp vec2 base_dimension;
+uniform highp vec2 base_dimension_i;
+uniform sampler2D image;
+
+in highp vec2 _vertex_shader_attrib0;
+
+out vec4 _pixel_shader_attrib0;
+
+struct VertInOut {
+    vec4 pos;
+    vec2 uv;
+};
+
+vec4 PSDrawAreaRGBA(VertInOut vert_in)
+{
+    highp vec2 uv = vert_in.uv;
+    highp vec2 uv_delta = vec2(dFdx(uv.x), abs(dFdy(uv.y)));
+
+    highp vec2 uv_min = uv - 0.5 * uv_delta;
+    highp vec2 uv_max = uv_min + uv_delta;
+
+    highp vec2 load_index_min = max(floor(uv_min * base_dimension), vec2(0.0, 0.0));
+    highp vec2 load_index_max = min(ceil(uv_max * base_dimension), base_dimension);
+
+    highp vec2 target_dimension = 1.0 / uv_delta;
+    highp vec2 target_pos = uv * target_dimension;
+    highp vec2 target_pos_min = target_pos - 0.5;
+    highp vec2 target_pos_max = target_pos + 0.5;
+
+    highp vec2 scale = base_dimension_i * target_dimension;
+
+    vec4 total_color = vec4(0.0, 0.0, 0.0, 0.0);
+
+    highp float load_index_y = load_index_min.y;
+    do {
+        highp float source_y_min = load_index_y * scale.y;
+        highp float source_y_max = source_y_min + scale.y;
+        highp float y_min = max(source_y_min, target_pos_min.y);
+        highp float y_max = min(source_y_max, target_pos_max.y);
+        highp float height = y_max - y_min;
+
+        highp float load_index_x = load_index_min.x;
+        do {
+            highp float source_x_min = load_index_x * scale.x;
+            highp float source_x_max = source_x_min + scale.x;
+            highp float x_min = max(source_x_min, target_pos_min.x);
+            highp float x_max = min(source_x_max, target_pos_max.x);
+            highp float width = x_max - x_min;
+            highp float area = width * height;
+
+            vec4 color = texelFetch(image, ivec2(int(load_index_x), int(load_index_y)), 0);
+            total_color += area * color;
+
+            ++load_index_x;
+        } while (load_index_x < load_index_max.x);
+
+        ++load_index_y;
+    } while (load_index_y < load_index_max.y);
+
+    return total_color;
+}
+
+vec4 _main_wrap(VertInOut vert_in)
+{
+    return PSDrawAreaRGBA(vert_in);
+}
+
+void main(void)
+{
+    VertInOut vert_in;
+    vert_in.pos = gl_FragCoord;
+    vert_in.uv = _vertex_shader_attrib0;
+
+    _pixel_shader_attrib0 = _main_wrap(vert_in);
+}
+
+---------------------------------------
+float2 base_dimension null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float2 base_dimension_i null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+texture2d image null 3 0 18446744073709551615
+---------------------------------------
+---------------------------------------
+)";
+
 std::string conversion_shaders_total =
         conversion_shaders + "=======================================" +
         conversion_shaders2 + "=======================================" +
@@ -2792,6 +2936,7 @@ std::string conversion_shaders_total =
         conversion_shaders4 + "=======================================" +
         conversion_shaders5 + "=======================================" +
         scale_shader + "=======================================" +
+        area_shader + "=======================================" +
         draw_shader;
 
 
@@ -5,15 +5,19 @@
 #include "lite-obs/lite_obs_output.h"
 #include "lite-obs/media-io/video_output.h"
 #include "lite-obs/media-io/audio_output.h"
-#include "lite-obs/util/circlebuf.h"
+#include "lite-obs/util/audio_ring.h"
+#include "lite-obs/util/audio_frame_pool.h"
 #include "lite-obs/util/log.h"
 #include "lite-obs/encoder/h264_encoder.h"
 #include "lite-obs/encoder/aac_encoder.h"
+#include "lite-obs/encoder/opus_encoder.h"
 #include "lite-obs/encoder/x264_encoder.h"
+#include "lite-obs/encoder/ffmpeg_video_encoder.h"
 #include "lite-obs/encoder/mediacodec_encoder.h"
 #include "lite-obs/encoder/videotoolbox_encoder.h"
 #include "lite-obs/graphics/gs_subsystem.h"
 #include "lite-obs/lite_obs_platform_config.h"
+#include <string.h>
 #include <mutex>
 #include <atomic>
 #include <list>
@@ -21,6 +25,14 @@
 
 class lite_obs_output;
 
+/* audio held back while waiting for video or for a full encoder frame. the
+ * buffer starts at two ticks and grows to about 5 seconds at 48khz, the
+ * oldest audio is dropped past that */
+#define ENCODER_AUDIO_BUFFER_MIN_FRAMES (2 * AUDIO_OUTPUT_FRAMES)
+#define ENCODER_AUDIO_BUFFER_FRAMES (256 * AUDIO_OUTPUT_FRAMES)
+/* frames that can be in flight to the encoder implementation at once */
+#define ENCODER_AUDIO_POOL_FRAMES 4
+
 struct encoder_callback {
     bool sent_first_packet{};
     new_packet cb;
@@ -48,6 +60,10 @@ struct lite_obs_encoder_private
     uint32_t scaled_width{};
     uint32_t scaled_height{};
     video_format preferred_format{};
+    std::mutex x264_settings_mutex;
+    x264_encoder_settings x264_settings{};
+    std::mutex opus_settings_mutex;
+    opus_encoder_settings opus_settings{};
 
     std::atomic_bool active{};
     bool initialized{};
@@ -56,9 +72,20 @@ struct lite_obs_encoder_private
     uint32_t timebase_den{};
 
     int64_t cur_pts{};
+    uint64_t frame_time_ns{};
+
+    /* non zero when keyframes are aligned to the video clock */
+    std::atomic_uint64_t keyframe_interval_ns{};
+    uint64_t last_gop = VIDEO_GOP_NONE;
+
+    /* frames handed to the encoder implementation and packets it gave back
+     * since it was connected, the difference is how many frames it holds */
+    uint64_t frames_in{};
+    uint64_t packets_out{};
+    std::atomic_uint32_t delay_frames{};
 
-    circlebuf audio_input_buffer[MAX_AV_PLANES]{};
-    uint8_t *audio_output_buffer[MAX_AV_PLANES]{};
+    audio_ring audio_input_buffer[MAX_AV_PLANES]{};
+    audio_frame_pool audio_frames;
 
     /* if a video encoder is paired with an audio encoder, make it start
          * up at the specific timestamp.  if this is the audio encoder,
@@ -136,12 +163,21 @@ std::shared_ptr<lite_obs_encoder_interface> lite_obs_encoder::create_encoder(enc
     case encoder_id::AAC:
         ec = std::make_shared<lite_aac_encoder>(this);
         break;
+    case encoder_id::OPUS:
+        ec = std::make_shared<lite_opus_encoder>(this);
+        break;
     case encoder_id::FFMPEG_H264_HW:
         ec = std::make_shared<h264_hw_video_encoder>(this);
         break;
     case encoder_id::X264:
         ec = std::make_shared<x264_encoder>(this);
         break;
+    case encoder_id::X265:
+        ec = std::make_shared<ffmpeg_video_encoder>(this, ffmpeg_video_codec::HEVC);
+        break;
+    case encoder_id::SVT_AV1:
+        ec = std::make_shared<ffmpeg_video_encoder>(this, ffmpeg_video_codec::AV1);
+        break;
 #if TARGET_PLATFORM == PLATFORM_ANDROID
     case encoder_id::MEDIACODEC:
         ec = std::make_shared<mediacodec_encoder>(this);
@@ -159,12 +195,15 @@ std::shared_ptr<lite_obs_encoder_interface> lite_obs_encoder::create_encoder(enc
     return ec;
 }
 
-bool lite_obs_encoder::lite_obs_encoder_reset_encoder_impl(encoder_id id)
+bool lite_obs_encoder::lite_obs_encoder_reset_encoder_impl(encoder_id id, bool force)
 {
-    if (d_ptr->id == id)
+    if (d_ptr->id == id && !force)
         return true;
 
-    remove_connection(false);
+    /* an encoder no output is using stays disconnected */
+    bool active = d_ptr->active;
+    if (active)
+        remove_connection(false);
 
     auto ec = create_encoder(id);
     if (!ec)
@@ -178,7 +217,8 @@ bool lite_obs_encoder::lite_obs_encoder_reset_encoder_impl(encoder_id id)
         d_ptr->encoder_impl = ec;
     }
 
-    add_connection();
+    if (active)
+        add_connection();
 
     return true;
 }
@@ -208,16 +248,16 @@ void lite_obs_encoder::reset_audio_buffers()
     free_audio_buffers();
 
     for (size_t i = 0; i < d_ptr->planes; i++)
-        d_ptr->audio_output_buffer[i] = (uint8_t *)malloc(d_ptr->framesize_bytes);
+        d_ptr->audio_input_buffer[i].init(ENCODER_AUDIO_BUFFER_MIN_FRAMES * d_ptr->blocksize,
+                                            ENCODER_AUDIO_BUFFER_FRAMES * d_ptr->blocksize);
+    d_ptr->audio_frames.init(d_ptr->planes, d_ptr->framesize_bytes, ENCODER_AUDIO_POOL_FRAMES);
 }
 
 void lite_obs_encoder::free_audio_buffers()
 {
-    for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-        circlebuf_free(&d_ptr->audio_input_buffer[i]);
-        free(d_ptr->audio_output_buffer[i]);
-        d_ptr->audio_output_buffer[i] = NULL;
-    }
+    for (size_t i = 0; i < MAX_AV_PLANES; i++)
+        d_ptr->audio_input_buffer[i].free();
+    d_ptr->audio_frames.free();
 }
 
 void lite_obs_encoder::intitialize_audio_encoder()
@@ -297,7 +337,7 @@ auto lite_obs_encoder::get_callback_idx(new_packet cb, void *param)
 void lite_obs_encoder::clear_audio()
 {
     for (size_t i = 0; i < d_ptr->planes; i++)
-        circlebuf_free(&d_ptr->audio_input_buffer[i]);
+        d_ptr->audio_input_buffer[i].clear();
 }
 
 size_t lite_obs_encoder::calc_offset_size(uint64_t v_start_ts, uint64_t a_start_ts)
@@ -307,35 +347,47 @@ size_t lite_obs_encoder::calc_offset_size(uint64_t v_start_ts, uint64_t a_start_
     return (size_t)offset * d_ptr->blocksize;
 }
 
+/* drops the buffered audio that comes before the video start in place */
 void lite_obs_encoder::start_from_buffer(uint64_t v_start_ts)
 {
-    size_t size = d_ptr->audio_input_buffer[0].size;
-    struct audio_data audio{};
+    size_t size = d_ptr->audio_input_buffer[0].size();
     size_t offset_size = 0;
 
-    for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-        audio.data[i] = (uint8_t *)(d_ptr->audio_input_buffer[i].data);
-        memset(&d_ptr->audio_input_buffer[i], 0,
-               sizeof(struct circlebuf));
-    }
-
     if (d_ptr->first_raw_ts < v_start_ts)
         offset_size = calc_offset_size(v_start_ts, d_ptr->first_raw_ts);
 
-    push_back_audio(&audio, size, offset_size);
+    if (offset_size >= size) {
+        clear_audio();
+        return;
+    }
 
-    for (size_t i = 0; i < MAX_AV_PLANES; i++)
-        free(audio.data[i]);
+    for (size_t i = 0; i < d_ptr->planes; i++)
+        d_ptr->audio_input_buffer[i].pop_front(nullptr, offset_size);
 }
 
 void lite_obs_encoder::push_back_audio(struct audio_data *data, size_t size, size_t offset_size)
 {
+    if (offset_size >= size)
+        return;
+
     size -= offset_size;
 
-    /* push in to the circular buffer */
-    if (size)
+    /* make room by dropping the oldest audio, keeping first_raw_ts in step
+     * with what is left in the buffer */
+    auto &front = d_ptr->audio_input_buffer[0];
+    if (size > front.space()) {
+        size_t drop = (size - front.space() + d_ptr->blocksize - 1) / d_ptr->blocksize * d_ptr->blocksize;
+        if (drop > front.size())
+            return;
+
         for (size_t i = 0; i < d_ptr->planes; i++)
-            circlebuf_push_back(&d_ptr->audio_input_buffer[i], data->data[i] + offset_size, size);
+            d_ptr->audio_input_buffer[i].pop_front(nullptr, drop);
+        d_ptr->first_raw_ts += (uint64_t)(drop / d_ptr->blocksize) * 1000000000ULL / (uint64_t)d_ptr->samplerate;
+    }
+
+    /* push in to the circular buffer */
+    for (size_t i = 0; i < d_ptr->planes; i++)
+        d_ptr->audio_input_buffer[i].push_back(data->data[i] + offset_size, size);
 }
 
 bool lite_obs_encoder::buffer_audio(struct audio_data *data)
@@ -392,19 +444,23 @@ bool lite_obs_encoder::send_audio_data()
 
     memset(&enc_frame, 0, sizeof(struct encoder_frame));
 
+    auto frame = d_ptr->audio_frames.acquire();
+    if (!frame)
+        return false;
+
     for (size_t i = 0; i < d_ptr->planes; i++) {
-        circlebuf_pop_front(&d_ptr->audio_input_buffer[i],
-                            d_ptr->audio_output_buffer[i],
-                            d_ptr->framesize_bytes);
+        d_ptr->audio_input_buffer[i].pop_front(frame->data[i], d_ptr->framesize_bytes);
 
-        enc_frame.data[i] = d_ptr->audio_output_buffer[i];
+        enc_frame.data[i] = frame->data[i];
         enc_frame.linesize[i] = (uint32_t)d_ptr->framesize_bytes;
     }
 
     enc_frame.frames = (uint32_t)d_ptr->framesize;
     enc_frame.pts = d_ptr->cur_pts;
 
-    if (!do_encode(&enc_frame))
+    auto success = do_encode(&enc_frame);
+    d_ptr->audio_frames.release(frame);
+    if (!success)
         return false;
 
     d_ptr->cur_pts += d_ptr->framesize;
@@ -424,7 +480,7 @@ void lite_obs_encoder::receive_audio_internal(size_t mix_idx, struct audio_data
     if (!buffer_audio(&audio))
         return;
 
-    while (d_ptr->audio_input_buffer[0].size >= d_ptr->framesize_bytes) {
+    while (d_ptr->audio_input_buffer[0].size() >= d_ptr->framesize_bytes) {
         if (!send_audio_data()) {
             break;
         }
@@ -465,11 +521,24 @@ void lite_obs_encoder::receive_video_internal(struct video_data *frame)
         enc_frame.linesize[i] = frame->frame.linesize[i];
     }
 
+    /* video_output drops frames for an encoder that falls behind, count
+     * the pts from the timestamp so a drop leaves a gap instead of pulling
+     * the video ahead of the audio */
+    int64_t pts = d_ptr->cur_pts;
+    if (d_ptr->frame_time_ns) {
+        uint64_t elapsed = frame->timestamp - d_ptr->start_ts;
+        int64_t frame_idx = (int64_t)((elapsed + d_ptr->frame_time_ns / 2) / d_ptr->frame_time_ns);
+        if (frame_idx * (int64_t)d_ptr->timebase_num > pts)
+            pts = frame_idx * (int64_t)d_ptr->timebase_num;
+    }
+
     enc_frame.frames = 1;
-    enc_frame.pts = d_ptr->cur_pts;
+    enc_frame.pts = pts;
+    /* video_output marks the gop starts, it knows which frames it may drop */
+    enc_frame.keyframe = frame->keyframe;
 
     if (do_encode(&enc_frame))
-        d_ptr->cur_pts += d_ptr->timebase_num;
+        d_ptr->cur_pts = pts + d_ptr->timebase_num;
 }
 
 void lite_obs_encoder::receive_video(void *param, struct video_data *frame)
@@ -487,8 +556,9 @@ void lite_obs_encoder::receive_video_texture(uint64_t timestamp, int tex_id)
     frame.pts = d_ptr->cur_pts;
     frame.data[0] = (uint8_t *)&tex_id;
     frame.frames = 1;
+    frame.keyframe = keyframe_due(timestamp);
 
-    std::shared_ptr<encoder_packet> pkt = std::make_shared<encoder_packet>();
+    std::shared_ptr<encoder_packet> pkt = encoder_packet_create();
     pkt->timebase_num = d_ptr->timebase_num;
     pkt->timebase_den = d_ptr->timebase_den;
     pkt->encoder = shared_from_this();
@@ -497,8 +567,23 @@ void lite_obs_encoder::receive_video_texture(uint64_t timestamp, int tex_id)
         d_ptr->cur_pts += d_ptr->timebase_num;
 }
 
+bool lite_obs_encoder::keyframe_due(uint64_t timestamp)
+{
+    uint64_t interval = d_ptr->keyframe_interval_ns;
+    if (!interval)
+        return false;
+
+    return video_keyframe_due(timestamp, interval, &d_ptr->last_gop);
+}
+
 void lite_obs_encoder::add_connection()
 {
+    d_ptr->frames_in = 0;
+    d_ptr->packets_out = 0;
+    d_ptr->delay_frames = 0;
+    d_ptr->frame_time_ns = 0;
+    d_ptr->last_gop = VIDEO_GOP_NONE;
+
     auto ec = d_ptr->get_encoder_impl();
     if (ec->i_encoder_type() == obs_encoder_type::OBS_ENCODER_AUDIO) {
         struct audio_convert_info audio_info = {0};
@@ -529,7 +614,9 @@ void lite_obs_encoder::add_connection()
                 if (info.width != voi->width || info.height != voi->height)
                     lite_obs_encoder_set_scaled_size(info.width, info.height);
 
+                d_ptr->frame_time_ns = vo->video_output_get_frame_time();
                 vo->video_output_connect(&info, lite_obs_encoder::receive_video, this);
+                vo->video_output_set_keyframe_interval(lite_obs_encoder::receive_video, this, d_ptr->keyframe_interval_ns);
             }
         }
     }
@@ -683,6 +770,18 @@ void lite_obs_encoder::obs_encoder_remove_output(std::shared_ptr<lite_obs_output
     d_ptr->outputs_mutex.unlock();
 }
 
+size_t lite_obs_encoder::obs_encoder_output_count()
+{
+    size_t count = 0;
+    d_ptr->outputs_mutex.lock();
+    for (auto iter = d_ptr->outputs.begin(); iter != d_ptr->outputs.end(); iter++) {
+        if (!(*iter).expired())
+            count++;
+    }
+    d_ptr->outputs_mutex.unlock();
+    return count;
+}
+
 bool lite_obs_encoder::start_gpu_encode()
 {
     auto cv = d_ptr->core_video.lock();
@@ -704,6 +803,7 @@ void lite_obs_encoder::stop_gpu_encode()
 bool lite_obs_encoder::encode_send(encoder_frame *frame, std::shared_ptr<encoder_packet> pkt)
 {
     auto send = [this](std::shared_ptr<encoder_packet> pkt){
+        d_ptr->packets_out++;
         if (!d_ptr->first_received) {
             d_ptr->offset_usec = packet_dts_usec(pkt);
             d_ptr->first_received = true;
@@ -724,18 +824,22 @@ bool lite_obs_encoder::encode_send(encoder_frame *frame, std::shared_ptr<encoder
     };
 
     auto ec = d_ptr->get_encoder_impl();
+    d_ptr->frames_in++;
     bool success = ec->i_encode(frame, pkt, send);
     if (!success) {
         blog(LOG_ERROR, "Error encoding with encoder");
         full_stop();
     }
 
+    uint64_t held = d_ptr->frames_in > d_ptr->packets_out ? d_ptr->frames_in - d_ptr->packets_out : 0;
+    d_ptr->delay_frames = (uint32_t)held;
+
     return success;
 }
 
 bool lite_obs_encoder::do_encode(encoder_frame *frame)
 {
-    auto pkt = std::make_shared<encoder_packet>();
+    auto pkt = encoder_packet_create();
     pkt->timebase_num = d_ptr->timebase_num;
     pkt->timebase_den = d_ptr->timebase_den;
     pkt->encoder = shared_from_this();
@@ -780,13 +884,12 @@ void lite_obs_encoder::send_first_video_packet(encoder_callback *cb, std::shared
         return;
     }
 
-    auto data = std::make_shared<std::vector<uint8_t>>();
-    data->resize(size + packet->data->size());
-    memcpy(data->data(), sei, size);
-    memcpy(data->data() + size, packet->data->data(), packet->data->size());
-
-    auto first_packet = packet;
-    first_packet->data = data;
+    /* other callbacks may get the same packet without the sei, prefix a
+     * copy of it */
+    auto first_packet = encoder_packet_create(*packet);
+    first_packet->data = packet_pool_alloc(size + packet->data->size());
+    memcpy(first_packet->data->data(), sei, size);
+    memcpy(first_packet->data->data() + size, packet->data->data(), packet->data->size());
 
     cb->cb(cb->param, first_packet);
     cb->sent_first_packet = true;
@@ -909,6 +1012,53 @@ size_t lite_obs_encoder::lite_obs_encoder_get_frame_size()
     return d_ptr->framesize;
 }
 
+void lite_obs_encoder::lite_obs_encoder_set_x264_settings(const x264_encoder_settings &settings)
+{
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->x264_settings_mutex);
+        d_ptr->x264_settings = settings;
+    }
+
+    bool aligned = settings.aligned_keyframes && settings.keyint_sec > 0;
+    d_ptr->keyframe_interval_ns = aligned ? (uint64_t)settings.keyint_sec * 1000000000ULL : 0;
+
+    auto vo = d_ptr->v_media.lock();
+    if (vo)
+        vo->video_output_set_keyframe_interval(lite_obs_encoder::receive_video, this, d_ptr->keyframe_interval_ns);
+}
+
+uint32_t lite_obs_encoder::lite_obs_encoder_get_delay_frames()
+{
+    return d_ptr->delay_frames;
+}
+
+bool lite_obs_encoder::lite_obs_encoder_get_input_stats(video_input_stats *stats)
+{
+    auto vo = d_ptr->v_media.lock();
+    if (!vo)
+        return false;
+
+    return vo->video_output_get_input_stats(lite_obs_encoder::receive_video, this, stats);
+}
+
+x264_encoder_settings lite_obs_encoder::lite_obs_encoder_get_x264_settings()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->x264_settings_mutex);
+    return d_ptr->x264_settings;
+}
+
+void lite_obs_encoder::lite_obs_encoder_set_opus_settings(const opus_encoder_settings &settings)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->opus_settings_mutex);
+    d_ptr->opus_settings = settings;
+}
+
+opus_encoder_settings lite_obs_encoder::lite_obs_encoder_get_opus_settings()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->opus_settings_mutex);
+    return d_ptr->opus_settings;
+}
+
 void lite_obs_encoder::lite_obs_encoder_set_preferred_video_format(video_format format)
 {
     auto ec = d_ptr->get_encoder_impl();
@@ -970,6 +1120,23 @@ void lite_obs_encoder::lite_obs_encoder_set_core_audio(std::shared_ptr<lite_obs_
     d_ptr->timebase_den = d_ptr->a_media.lock()->audio_output_get_sample_rate();
 }
 
+void lite_obs_encoder::lite_obs_encoder_set_video(std::shared_ptr<video_output> video)
+{
+    auto ec = d_ptr->get_encoder_impl();
+    if (ec->i_encoder_type() != obs_encoder_type::OBS_ENCODER_VIDEO) {
+        blog(LOG_WARNING, "lite_obs_encoder_set_video: encoder is not a video encoder");
+        return;
+    }
+
+    if (d_ptr->active) {
+        blog(LOG_WARNING, "encoder Cannot change the video output while the encoder is active");
+        return;
+    }
+
+    if (video)
+        d_ptr->v_media = video;
+}
+
 std::shared_ptr<video_output> lite_obs_encoder::lite_obs_encoder_video()
 {
     auto ec = d_ptr->get_encoder_impl();
@@ -1033,7 +1200,7 @@ void lite_obs_encoder::lite_obs_encoder_clear_sei()
 
 }
 
-bool lite_obs_encoder::lite_obs_encoder_get_sei(uint8_t *sei, int *sei_len)
+bool lite_obs_encoder::lite_obs_encoder_get_sei(const uint8_t **sei, size_t *sei_len)
 {
     return false;
 }
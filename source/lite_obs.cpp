@@ -40,6 +40,12 @@ lite_obs_media_source_api *lite_obs_media_source_new(const lite_obs_api *api, so
                                          uint32_t height){
         source_api->obj->source_internal->output_video(video_data, line_size, format, range, color_space, width, height);
     };
+    media_source_api->output_video2_borrowed = [](struct lite_obs_media_source_api *source_api, const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES],
+                                                  video_format format, video_range_type range,
+                                                  video_colorspace color_space, uint32_t width,
+                                                  uint32_t height, void (*release_cb)(void *opaque), void *opaque){
+        source_api->obj->source_internal->output_video_borrowed(video_data, line_size, format, range, color_space, width, height, release_cb, opaque);
+    };
     media_source_api->output_video3 = [](struct lite_obs_media_source_api *source_api, const uint8_t *img_data, uint32_t img_width, uint32_t img_height){
         source_api->obj->source_internal->output_video(img_data, img_width, img_height);
     };
@@ -67,6 +73,12 @@ lite_obs_media_source_api *lite_obs_media_source_new(const lite_obs_api *api, so
     media_source_api->reset_transform = [](struct lite_obs_media_source_api *source_api){
         source_api->obj->source_internal->reset_transform();
     };
+    media_source_api->set_jitter_window = [](struct lite_obs_media_source_api *source_api, uint32_t ms){
+        source_api->obj->source_internal->set_jitter_window(ms);
+    };
+    media_source_api->set_audio_mixers = [](struct lite_obs_media_source_api *source_api, uint32_t mixers){
+        source_api->obj->source_internal->set_audio_mixers(mixers);
+    };
 
     return media_source_api;
 }
@@ -103,10 +115,58 @@ lite_obs_api *lite_obs_api_new()
         core_api->object->api_internal->lite_obs_stop_output();
     };
 
+    api->lite_obs_start_output2 = [](struct lite_obs_api *core_api, output_type type, void *output_info, int vb, int ab, struct lite_obs_output_callbak callback){
+        return core_api->object->api_internal->lite_obs_start_output2(type, output_info, vb, ab, callback);
+    };
+
+    api->lite_obs_stop_output2 = [](struct lite_obs_api *core_api, int output_id){
+        core_api->object->api_internal->lite_obs_stop_output2(output_id);
+    };
+
+    api->lite_obs_start_rendition = [](struct lite_obs_api *core_api, output_type type, void *output_info, uint32_t width, uint32_t height, int vb, int ab, struct lite_obs_output_callbak callback){
+        return core_api->object->api_internal->lite_obs_start_rendition(type, output_info, width, height, vb, ab, callback);
+    };
+
     api->lite_obs_reset_encoder = [](struct lite_obs_api *core_api, bool sw){
         core_api->object->api_internal->lite_obs_reset_encoder(sw);
     };
 
+    api->lite_obs_reset_encoder2 = [](struct lite_obs_api *core_api, bool sw, const struct lite_obs_x264_settings *x264){
+        core_api->object->api_internal->lite_obs_reset_encoder(sw, x264);
+    };
+
+    api->lite_obs_reset_encoder3 = [](struct lite_obs_api *core_api, bool sw, video_codec codec, const struct lite_obs_x264_settings *x264){
+        core_api->object->api_internal->lite_obs_reset_encoder(sw, codec, x264);
+    };
+
+    api->lite_obs_set_video_readback_depth = [](struct lite_obs_api *core_api, uint32_t depth){
+        core_api->object->api_internal->obs_set_video_readback_depth(depth);
+    };
+
+    api->lite_obs_get_video_readback_latency = [](struct lite_obs_api *core_api){
+        return core_api->object->api_internal->obs_get_video_readback_latency();
+    };
+
+    api->lite_obs_set_video_gpu_conversion = [](struct lite_obs_api *core_api, bool enabled){
+        core_api->object->api_internal->obs_set_video_gpu_conversion(enabled);
+    };
+
+    api->lite_obs_set_audio_tracks = [](struct lite_obs_api *core_api, uint32_t tracks){
+        core_api->object->api_internal->obs_set_audio_tracks(tracks);
+    };
+
+    api->lite_obs_set_audio_codec = [](struct lite_obs_api *core_api, audio_codec codec, const struct lite_obs_opus_settings *opus){
+        core_api->object->api_internal->obs_set_audio_codec(codec, opus);
+    };
+
+    api->lite_obs_get_video_encoder_delay = [](struct lite_obs_api *core_api){
+        return core_api->object->api_internal->obs_get_video_encoder_delay();
+    };
+
+    api->lite_obs_get_video_encoder_stats = [](struct lite_obs_api *core_api, struct lite_obs_video_encoder_stats *stats){
+        return core_api->object->api_internal->obs_get_video_encoder_stats(stats);
+    };
+
     return api;
 }
 
@@ -82,7 +82,7 @@ static inline int get_drop_priority(int priority)
 	return priority;
 }
 
-static void serialize_avc_data(serialize_op &op, const uint8_t *data, size_t size, bool *is_keyframe, int *priority)
+static void serialize_avc_data(packet_data &out, const uint8_t *data, size_t size, bool *is_keyframe, int *priority)
 {
 	const uint8_t *nal_start, *nal_end;
 	const uint8_t *end = data + size;
@@ -106,20 +106,25 @@ static void serialize_avc_data(serialize_op &op, const uint8_t *data, size_t siz
 		}
 
 		nal_end = obs_avc_find_startcode(nal_start, end);
-        op.s_wb32((uint32_t)(nal_end - nal_start));
-        op.s_write(nal_start, nal_end - nal_start);
+        uint32_t nal_size = (uint32_t)(nal_end - nal_start);
+        uint8_t nal_size_be[4] = {(uint8_t)(nal_size >> 24), (uint8_t)(nal_size >> 16),
+                                  (uint8_t)(nal_size >> 8), (uint8_t)nal_size};
+        out.append(nal_size_be, sizeof(nal_size_be));
+        out.append(nal_start, nal_size);
 		nal_start = nal_end;
 	}
 }
 
 std::shared_ptr<struct encoder_packet> obs_parse_avc_packet(std::shared_ptr<encoder_packet> src)
 {
-    std::shared_ptr<encoder_packet> avc_packet = std::make_shared<encoder_packet>();
-	*avc_packet = *src;
-    avc_packet->data = std::make_shared<std::vector<uint8_t>>();
-
-    serialize_op op(*avc_packet->data.get());
-    serialize_avc_data(op, src->data->data(), src->data->size(), &avc_packet->keyframe,
+    auto avc_packet = encoder_packet_create(*src);
+
+    /* every start code is at least 3 bytes and becomes a 4 byte size in
+     * front of a nal of at least 1 byte, so this never has to grow */
+    size_t size = src->data->size();
+    avc_packet->data = packet_pool_alloc(size + size / 4 + 4);
+    avc_packet->data.resize(0);
+    serialize_avc_data(avc_packet->data, src->data->data(), size, &avc_packet->keyframe,
 			   &avc_packet->priority);
 
 	avc_packet->drop_priority = get_drop_priority(avc_packet->priority);
@@ -195,7 +200,7 @@ void obs_parse_avc_header(std::vector<uint8_t> &header, const uint8_t *data, siz
 }
 
 void obs_extract_avc_headers(const uint8_t *packet, size_t size,
-                 std::shared_ptr<std::vector<uint8_t> > new_packet_data,
+                 packet_data &new_packet_data,
                  std::vector<uint8_t> &header_data,
                  std::vector<uint8_t> &sei_data)
 {
@@ -227,8 +232,7 @@ void obs_extract_avc_headers(const uint8_t *packet, size_t size,
             serialize_op op(sei_data);
             op.s_write(nal_codestart, nal_end - nal_codestart);
 		} else {
-            serialize_op op(*new_packet_data.get());
-            op.s_write(nal_codestart, nal_end - nal_codestart);
+            new_packet_data.append(nal_codestart, nal_end - nal_codestart);
         }
 
 		nal_start = nal_end;
@@ -2,11 +2,12 @@
 #include "lite-obs/util/circlebuf.h"
 #include "lite-obs/util/log.h"
 #include "lite-obs/lite_obs_source.h"
+#include "lite-obs/lite_obs_source_graph.h"
 #include "lite-obs/media-io/audio_output.h"
 
 struct lite_obs_core_audio_private
 {
-    uintptr_t core_ptr;
+    std::shared_ptr<lite_obs_source_graph> graph{};
 
     std::shared_ptr<audio_output> audio{};
 
@@ -16,10 +17,10 @@ struct lite_obs_core_audio_private
     int total_buffering_ticks{};
 };
 
-lite_obs_core_audio::lite_obs_core_audio(uintptr_t core_ptr)
+lite_obs_core_audio::lite_obs_core_audio(std::shared_ptr<lite_obs_source_graph> graph)
 {
     d_ptr = std::make_unique<lite_obs_core_audio_private>();
-    d_ptr->core_ptr = core_ptr;
+    d_ptr->graph = graph;
 }
 
 lite_obs_core_audio::~lite_obs_core_audio()
@@ -32,9 +33,8 @@ std::shared_ptr<audio_output> lite_obs_core_audio::core_audio()
     return d_ptr->audio;
 }
 
-void lite_obs_core_audio::find_min_ts(uint64_t *min_ts)
+void lite_obs_core_audio::find_min_ts(const source_list &sources, uint64_t *min_ts)
 {
-    auto &sources = lite_obs_source::sources[d_ptr->core_ptr];
     for (auto iter = sources.begin(); iter != sources.end(); iter++) {
         auto &source = *iter;
         if(!(source->lite_source_type() & source_type::SOURCE_AUDIO))
@@ -46,11 +46,10 @@ void lite_obs_core_audio::find_min_ts(uint64_t *min_ts)
     }
 }
 
-bool lite_obs_core_audio::mark_invalid_sources(size_t sample_rate, uint64_t min_ts)
+bool lite_obs_core_audio::mark_invalid_sources(const source_list &sources, size_t sample_rate, uint64_t min_ts)
 {
     bool recalculate = false;
 
-    auto &sources = lite_obs_source::sources[d_ptr->core_ptr];
     for (auto iter = sources.begin(); iter != sources.end(); iter++) {
         auto &source = *iter;
         if(!(source->lite_source_type() & source_type::SOURCE_AUDIO))
@@ -62,11 +61,11 @@ bool lite_obs_core_audio::mark_invalid_sources(size_t sample_rate, uint64_t min_
     return recalculate;
 }
 
-void lite_obs_core_audio::calc_min_ts(size_t sample_rate, uint64_t *min_ts)
+void lite_obs_core_audio::calc_min_ts(const source_list &sources, size_t sample_rate, uint64_t *min_ts)
 {
-    find_min_ts(min_ts);
-    if (mark_invalid_sources(sample_rate, *min_ts))
-        find_min_ts(min_ts);
+    find_min_ts(sources, min_ts);
+    if (mark_invalid_sources(sources, sample_rate, *min_ts))
+        find_min_ts(sources, min_ts);
 }
 
 void lite_obs_core_audio::add_audio_buffering(size_t sample_rate, struct ts_info *ts, uint64_t min_ts)
@@ -133,31 +132,21 @@ bool lite_obs_core_audio::audio_callback_internal(uint64_t start_ts_in, uint64_t
 
     audio_size = AUDIO_OUTPUT_FRAMES * sizeof(float);
 
-    std::list<std::shared_ptr<lite_obs_source>> audio_sources;
-    lite_obs_source::sources_mutex.lock();
-    {
-        auto &sources = lite_obs_source::sources[d_ptr->core_ptr];
-        for (auto iter = sources.begin(); iter != sources.end(); iter++) {
-            auto &source = *iter;
-            if (source->lite_source_type() & source_type::SOURCE_AUDIO) {
-                audio_sources.push_back(source);
-            }
-        }
-    }
-    lite_obs_source::sources_mutex.unlock();
+    /* the snapshot keeps every source in it alive until the end of the tick */
+    auto snapshot = d_ptr->graph->snapshot();
+    const auto &sources = *snapshot;
 
     /* ------------------------------------------------ */
     /* render audio data */
-    for (auto iter = audio_sources.begin(); iter != audio_sources.end(); iter++) {
+    for (auto iter = sources.begin(); iter != sources.end(); iter++) {
         auto &source = *iter;
-        source->audio_render(mixers, channels, sample_rate, audio_size);
+        if (source->lite_source_type() & source_type::SOURCE_AUDIO)
+            source->audio_render(mixers, channels, sample_rate, audio_size);
     }
 
     /* ------------------------------------------------ */
     /* get minimum audio timestamp */
-    lite_obs_source::sources_mutex.lock();
-    calc_min_ts(sample_rate, &min_ts);
-    lite_obs_source::sources_mutex.unlock();
+    calc_min_ts(sources, sample_rate, &min_ts);
 
     /* ------------------------------------------------ */
     /* if a source has gone backward in time, buffer */
@@ -168,10 +157,10 @@ bool lite_obs_core_audio::audio_callback_internal(uint64_t start_ts_in, uint64_t
     /* mix audio */
     if (!d_ptr->buffering_wait_ticks) {
 
-        for (auto iter = audio_sources.begin(); iter != audio_sources.end(); iter++) {
+        for (auto iter = sources.begin(); iter != sources.end(); iter++) {
 
             auto &source = *iter;
-            if (source->audio_pending())
+            if (!(source->lite_source_type() & source_type::SOURCE_AUDIO) || source->audio_pending())
                 continue;
 
             source->mix_audio(mixes, channels, sample_rate, &ts);
@@ -180,14 +169,11 @@ bool lite_obs_core_audio::audio_callback_internal(uint64_t start_ts_in, uint64_t
 
     /* ------------------------------------------------ */
     /* discard audio */
-    for (auto source : audio_sources) {
-        source->discard_audio(d_ptr->total_buffering_ticks, channels, sample_rate, &ts);
+    for (auto &source : sources) {
+        if (source->lite_source_type() & source_type::SOURCE_AUDIO)
+            source->discard_audio(d_ptr->total_buffering_ticks, channels, sample_rate, &ts);
     }
 
-    /* ------------------------------------------------ */
-    /* release audio sources */
-    audio_sources.clear();
-
     circlebuf_pop_front(&d_ptr->buffered_timestamps, NULL, sizeof(ts));
 
     *out_ts = ts.start;
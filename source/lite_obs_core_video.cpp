@@ -1,5 +1,6 @@
 #include "lite-obs/lite_obs_core_video.h"
 #include "lite-obs/lite_obs_source.h"
+#include "lite-obs/lite_obs_source_graph.h"
 #include "lite-obs/lite_encoder.h"
 #include "lite-obs/graphics/gs_subsystem.h"
 #include "lite-obs/graphics/gs_texture.h"
@@ -8,16 +9,26 @@
 #include "lite-obs/graphics/gs_context_gl.h"
 #include "lite-obs/media-io/video_output.h"
 #include "lite-obs/media-io/video_matrices.h"
+#include "lite-obs/media-io/video_convert.h"
 #include "lite-obs/util/log.h"
 #include "lite-obs/util/threading.h"
 #include "lite-obs/util/circlebuf.h"
+#include "lite-obs/util/spsc_ring.h"
+#include <string.h>
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
+#include <algorithm>
 #include <atomic>
+#include <list>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #define NUM_TEXTURES 2
+#define MAX_STAGE_TEXTURES 8
 #define NUM_CHANNELS 3
+#define RGBX_CONVERT_MT_HEIGHT 1080
+#define RGBX_CONVERT_MAX_BANDS 4
 
 struct obs_vframe_info {
     uint64_t timestamp{};
@@ -35,33 +46,68 @@ struct lite_obs_graphics_context {
     bool was_active{};
 };
 
+/* count is the number of queued entries still referring to the texture, the
+ * frame goes back to the avail queue once the last of them is encoded */
 struct lite_obs_tex_frame {
     std::shared_ptr<gs_texture> tex{};
+    std::atomic_int count{};
+};
+
+struct lite_obs_tex_entry {
+    lite_obs_tex_frame *tf{};
     uint64_t timestamp{};
-    int count{};
+    bool duplicate{};
+};
+
+/* a scaled copy of the composite for encoders of its own. it is drawn,
+ * converted and staged into the same ring slot as the main output and read
+ * back with it, so its frames go out with the same timestamps. the gpu
+ * objects are created and freed on the graphics thread */
+struct lite_obs_rendition {
+    uint32_t width{};
+    uint32_t height{};
+    std::shared_ptr<video_output> video{};
+
+    bool initialized{};
+    bool valid{};
+    std::shared_ptr<gs_texture> output_texture{};
+    std::shared_ptr<gs_texture> convert_textures[NUM_CHANNELS]{};
+    std::shared_ptr<gs_stagesurface> copy_surfaces[MAX_STAGE_TEXTURES][NUM_CHANNELS]{};
+    bool textures_copied[MAX_STAGE_TEXTURES]{};
+    std::weak_ptr<gs_stagesurface> mapped_surfaces[NUM_CHANNELS];
+
+    video_data frame{};
+    bool frame_ready{};
 };
 
 struct lite_obs_core_video_private
 {
-    uintptr_t core_ptr;
+    std::shared_ptr<lite_obs_source_graph> graph{};
 
     void *plat{};
     std::unique_ptr<graphics_subsystem> graphics{};
 
-    std::shared_ptr<gs_stagesurface> copy_surfaces[NUM_TEXTURES][NUM_CHANNELS]{};
+    std::shared_ptr<gs_stagesurface> copy_surfaces[MAX_STAGE_TEXTURES][NUM_CHANNELS]{};
     bool output_scaled{};
     std::shared_ptr<gs_texture> render_texture{};
     std::shared_ptr<gs_texture> output_texture{};
     std::shared_ptr<gs_texture> convert_textures[NUM_CHANNELS]{};
 
     bool texture_rendered{};
-    bool textures_copied[NUM_TEXTURES]{};
+    bool textures_copied[MAX_STAGE_TEXTURES]{};
     bool texture_converted{};
     bool using_nv12_tex{};
     circlebuf vframe_info_buffer{};
     circlebuf vframe_info_buffer_gpu{};
 
+    /* staging ring, cur_texture is the next slot to stage into and
+     * staged_texture the oldest slot that has not been downloaded yet */
+    int stage_depth = NUM_TEXTURES;
+    std::atomic_int requested_stage_depth = NUM_TEXTURES;
     int cur_texture{};
+    int staged_texture{};
+    int staged_count{};
+    std::atomic_uint32_t readback_latency{};
 
     std::weak_ptr<gs_stagesurface> mapped_surfaces[NUM_CHANNELS];
 
@@ -75,10 +121,18 @@ struct lite_obs_core_video_private
     uint32_t lagged_frames{};
 
     bool gpu_conversion{};
+    std::atomic_bool requested_gpu_conversion = true;
     const char *conversion_techs[NUM_CHANNELS]{};
     bool conversion_needed{};
     float conversion_width_i{};
 
+    /* cpu conversion of the rgba readback when gpu_conversion is off */
+    video_convert_coeffs rgbx_coeffs{};
+    video_convert_pool rgbx_convert_pool{};
+    /* 0 splits only frames of RGBX_CONVERT_MT_HEIGHT rows or more, by core
+     * count */
+    std::atomic_uint32_t requested_rgbx_bands{};
+
     video_format output_format{};
     uint32_t output_width{};
     uint32_t output_height{};
@@ -90,22 +144,30 @@ struct lite_obs_core_video_private
     std::atomic_long gpu_encoder_active{};
 
     std::mutex gpu_encoder_mutex;
-    std::list<std::shared_ptr<lite_obs_tex_frame>> gpu_encoder_queue{};
-    std::list<std::shared_ptr<lite_obs_tex_frame>> gpu_encoder_avail_queue{};
+    std::vector<std::unique_ptr<lite_obs_tex_frame>> gpu_encoder_frames{};
+    spsc_ring<lite_obs_tex_entry> gpu_encoder_queue{};
+    spsc_ring<lite_obs_tex_frame *> gpu_encoder_avail_queue{};
+    lite_obs_tex_frame *gpu_encoder_last_queued{};
     std::list<std::shared_ptr<lite_obs_encoder>> gpu_encoders;
-    os_sem_t *gpu_encode_semaphore{};
+    os_wakeup_t *gpu_encode_wakeup{};
     os_event_t *gpu_encode_inactive{};
     std::thread gpu_encode_thread;
     bool gpu_encode_thread_initialized{};
     std::atomic_bool gpu_encode_stop{};
 
+    /* held by the graphics thread for a whole frame. removed renditions
+     * wait in retired_renditions for it to free their gpu objects */
+    std::mutex rendition_mutex;
+    std::vector<std::shared_ptr<lite_obs_rendition>> renditions{};
+    std::vector<std::shared_ptr<lite_obs_rendition>> retired_renditions{};
+
     lite_obs_core_video::output_video_info ovi{};
 };
 
-lite_obs_core_video::lite_obs_core_video(uintptr_t core_ptr)
+lite_obs_core_video::lite_obs_core_video(std::shared_ptr<lite_obs_source_graph> graph)
 {
     d_ptr = std::make_unique<lite_obs_core_video_private>();
-    d_ptr->core_ptr = core_ptr;
+    d_ptr->graph = graph;
     d_ptr->plat = gs_context_gl::gs_create_platform_rc();
 }
 
@@ -128,12 +190,21 @@ void lite_obs_core_video::clear_base_frame_data(void)
     d_ptr->texture_converted = false;
     circlebuf_free(&d_ptr->vframe_info_buffer);
     d_ptr->cur_texture = 0;
+    d_ptr->staged_texture = 0;
+    d_ptr->staged_count = 0;
 }
 
 void lite_obs_core_video::clear_raw_frame_data(void)
 {
     memset(d_ptr->textures_copied, 0, sizeof(d_ptr->textures_copied));
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->rendition_mutex);
+        for (auto &rendition : d_ptr->renditions)
+            memset(rendition->textures_copied, 0, sizeof(rendition->textures_copied));
+    }
     circlebuf_free(&d_ptr->vframe_info_buffer);
+    d_ptr->staged_texture = d_ptr->cur_texture;
+    d_ptr->staged_count = 0;
 }
 
 void lite_obs_core_video::clear_gpu_frame_data(void)
@@ -171,18 +242,12 @@ void lite_obs_core_video::video_sleep(bool raw_active, const bool gpu_active, ui
 
 void lite_obs_core_video::render_all_sources()
 {
-    std::list<std::shared_ptr<lite_obs_source>> sources;
-    lite_obs_source::sources_mutex.lock();
-    auto &s = lite_obs_source::sources[d_ptr->core_ptr];
-    for (auto iter = s.begin(); iter != s.end(); iter++) {
+    auto sources = d_ptr->graph->snapshot();
+    for (auto iter = sources->begin(); iter != sources->end(); iter++) {
         auto &source = *iter;
-        if (source->lite_source_type() & source_type::SOURCE_VIDEO)
-            sources.push_back(source);
-    }
-    lite_obs_source::sources_mutex.unlock();
+        if (!(source->lite_source_type() & source_type::SOURCE_VIDEO))
+            continue;
 
-    for (auto iter = sources.begin(); iter != sources.end(); iter++) {
-        auto &source = *iter;
         if(source->lite_source_type() & source_type::SOURCE_ASYNC)
             source->update_async_video(d_ptr->video_time);
 
@@ -213,6 +278,21 @@ std::shared_ptr<gs_program> lite_obs_core_video::get_scale_effect(uint32_t width
     }
 }
 
+static void draw_scaled_texture(const std::shared_ptr<gs_program> &program, const std::shared_ptr<gs_texture> &texture,
+                                const std::shared_ptr<gs_texture> &target, uint32_t base_width, uint32_t base_height)
+{
+    glm::vec2 base = {(float)base_width, (float)base_height};
+    program->gs_effect_set_param("base_dimension", base);
+    program->gs_effect_set_param("base_dimension_f", base);
+
+    glm::vec2 base_i = {1.0f / (float)base_width, 1.0f / (float)base_height};
+    program->gs_effect_set_param("base_dimension_i", base_i);
+
+    program->gs_effect_set_texture("image", texture);
+
+    graphics_subsystem::draw_sprite(program, texture, target, 0, target->gs_texture_get_width(), target->gs_texture_get_height(), false, nullptr);
+}
+
 std::shared_ptr<gs_texture> lite_obs_core_video::render_output_texture()
 {
     //here we remove RGBA output format support.
@@ -226,53 +306,42 @@ std::shared_ptr<gs_texture> lite_obs_core_video::render_output_texture()
     if (!program || ((program->gs_program_name() == "Default_Draw") && (width == d_ptr->base_width) && (height == d_ptr->base_height)))
         return texture;
 
-    glm::vec2 base = {(float)d_ptr->base_width, (float)d_ptr->base_height};
-    program->gs_effect_set_param("base_dimension", base);
-    program->gs_effect_set_param("base_dimension_f", base);
-
-    glm::vec2 base_i = {1.0f / (float)d_ptr->base_width, 1.0f / (float)d_ptr->base_height};
-    program->gs_effect_set_param("base_dimension_i", base_i);
-
-    program->gs_effect_set_texture("image", texture);
-
-    graphics_subsystem::draw_sprite(program, texture, target, 0, width, height, false, nullptr);
+    draw_scaled_texture(program, texture, target, d_ptr->base_width, d_ptr->base_height);
 
     return target;
 }
 
-void lite_obs_core_video::render_convert_texture(std::shared_ptr<gs_texture> texture)
+void lite_obs_core_video::render_convert_texture(std::shared_ptr<gs_texture> texture, std::shared_ptr<gs_texture> *convert_textures, float width_i)
 {
     glm::vec4 vec0 = {d_ptr->color_matrix[4], d_ptr->color_matrix[5], d_ptr->color_matrix[6], d_ptr->color_matrix[7]};
     glm::vec4 vec1 = {d_ptr->color_matrix[0], d_ptr->color_matrix[1], d_ptr->color_matrix[2], d_ptr->color_matrix[3]};
     glm::vec4 vec2 = {d_ptr->color_matrix[8], d_ptr->color_matrix[9], d_ptr->color_matrix[10], d_ptr->color_matrix[11]};
 
-    if (d_ptr->convert_textures[0]) {
+    if (convert_textures[0]) {
         auto program = graphics_subsystem::get_effect_by_name(d_ptr->conversion_techs[0]);
         program->gs_effect_set_param("color_vec0", vec0);
         program->gs_effect_set_texture("image", texture);
-        graphics_subsystem::draw_convert(d_ptr->convert_textures[0], program);
+        graphics_subsystem::draw_convert(convert_textures[0], program);
 
-        if (d_ptr->convert_textures[1]) {
+        if (convert_textures[1]) {
             auto program1 = graphics_subsystem::get_effect_by_name(d_ptr->conversion_techs[1]);
             program1->gs_effect_set_param("color_vec1", vec1);
             program1->gs_effect_set_texture("image", texture);
-            if (!d_ptr->convert_textures[2])
+            if (!convert_textures[2])
                 program1->gs_effect_set_param("color_vec2", vec2);
-            program1->gs_effect_set_param("width_i", d_ptr->conversion_width_i);
-            graphics_subsystem::draw_convert(d_ptr->convert_textures[1], program1);
+            program1->gs_effect_set_param("width_i", width_i);
+            graphics_subsystem::draw_convert(convert_textures[1], program1);
 
-            if (d_ptr->convert_textures[2]) {
+            if (convert_textures[2]) {
                 auto program2 = graphics_subsystem::get_effect_by_name(d_ptr->conversion_techs[2]);
                 program2->gs_effect_set_param("color_vec1", vec1);
                 program2->gs_effect_set_texture("image", texture);
                 program2->gs_effect_set_param("color_vec2", vec2);
-                program2->gs_effect_set_param("width_i", d_ptr->conversion_width_i);
-                graphics_subsystem::draw_convert(d_ptr->convert_textures[2], program2);
+                program2->gs_effect_set_param("width_i", width_i);
+                graphics_subsystem::draw_convert(convert_textures[2], program2);
             }
         }
     }
-
-    d_ptr->texture_converted = true;
 }
 
 void lite_obs_core_video::stage_output_texture(const std::shared_ptr<gs_texture> &tex, int cur_texture)
@@ -300,6 +369,12 @@ void lite_obs_core_video::stage_output_texture(const std::shared_ptr<gs_texture>
 
         d_ptr->textures_copied[cur_texture] = true;
     }
+
+    if (d_ptr->textures_copied[cur_texture]) {
+        d_ptr->staged_count++;
+        if (++d_ptr->cur_texture == d_ptr->stage_depth)
+            d_ptr->cur_texture = 0;
+    }
 }
 
 void lite_obs_core_video::render_video(bool raw_active, const bool gpu_active, int cur_texture)
@@ -307,33 +382,77 @@ void lite_obs_core_video::render_video(bool raw_active, const bool gpu_active, i
     if (raw_active || gpu_active) {
         auto texture = render_output_texture();
 
-        if (raw_active && d_ptr->gpu_conversion)
-            render_convert_texture(texture);
+        if (raw_active && d_ptr->gpu_conversion) {
+            render_convert_texture(texture, d_ptr->convert_textures, d_ptr->conversion_width_i);
+            d_ptr->texture_converted = true;
+        }
 
         if (gpu_active) {
             output_gpu_encoders();
         }
 
-        if (raw_active)
+        if (raw_active) {
+            render_renditions(cur_texture);
             stage_output_texture(texture, cur_texture);
+        }
     }
 }
 
-bool lite_obs_core_video::download_frame(int prev_texture, video_data *frame)
+bool lite_obs_core_video::download_frame(video_data *frame)
 {
-    if (!d_ptr->textures_copied[prev_texture])
+    if (!d_ptr->staged_count)
+        return false;
+
+    int texture = d_ptr->staged_texture;
+    if (!d_ptr->textures_copied[texture])
         return false;
 
+    /* frames have to come out in the order they were staged, so only the
+     * oldest slot is a candidate. while there is still a free slot for the
+     * next frame, skip it until its readback has finished instead of
+     * stalling, once the ring is full we have to wait for it. */
+    if (d_ptr->staged_count < d_ptr->stage_depth) {
+        for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+            auto surface = d_ptr->copy_surfaces[texture][channel];
+            if (surface && !surface->gs_stagesurface_ready())
+                return false;
+        }
+
+        for (auto &rendition : d_ptr->renditions) {
+            if (!rendition->textures_copied[texture])
+                continue;
+
+            for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+                auto surface = rendition->copy_surfaces[texture][channel];
+                if (surface && !surface->gs_stagesurface_ready())
+                    return false;
+            }
+        }
+    }
+
+    bool success = true;
     for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
-        auto surface = d_ptr->copy_surfaces[prev_texture][channel];
+        auto surface = d_ptr->copy_surfaces[texture][channel];
         if (surface) {
-            if (!surface->gs_stagesurface_map(&frame->frame.data[channel], &frame->frame.linesize[channel]))
-                return false;
+            if (!surface->gs_stagesurface_map(&frame->frame.data[channel], &frame->frame.linesize[channel])) {
+                success = false;
+                break;
+            }
 
             d_ptr->mapped_surfaces[channel] = surface;
         }
     }
-    return true;
+
+    download_renditions(texture);
+
+    /* release the slot even if mapping failed so the ring can't overflow */
+    d_ptr->readback_latency = (uint32_t)(d_ptr->staged_count - 1);
+    d_ptr->textures_copied[texture] = false;
+    d_ptr->staged_count--;
+    if (++d_ptr->staged_texture == d_ptr->stage_depth)
+        d_ptr->staged_texture = 0;
+
+    return success;
 }
 
 static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
@@ -460,44 +579,112 @@ void lite_obs_core_video::set_gpu_converted_data(video_frame *output,
                                     info->height);
 }
 
-void lite_obs_core_video::output_video_data(video_data *input_frame, int count)
+struct rgbx_convert_job {
+    const video_data *input{};
+    video_frame *output{};
+    const video_output_info *info{};
+    const video_convert_coeffs *coeffs{};
+};
+
+/* converts the rows of one band, bands are split on chroma rows so every
+ * band starts on an even luma row */
+static void convert_rgbx_band(void *param, size_t band, size_t band_count)
+{
+    auto job = (rgbx_convert_job *)param;
+    const uint32_t chroma_rows = job->info->height / 2;
+    const uint32_t y0 = (uint32_t)(chroma_rows * band / band_count) * 2;
+    const uint32_t y1 = (uint32_t)(chroma_rows * (band + 1) / band_count) * 2;
+    if (y0 == y1)
+        return;
+
+    const uint8_t *src = job->input->frame.data[0] + y0 * job->input->frame.linesize[0];
+    uint8_t *dst[MAX_AV_PLANES]{};
+    dst[0] = job->output->data[0] + y0 * job->output->linesize[0];
+    dst[1] = job->output->data[1] + (y0 / 2) * job->output->linesize[1];
+
+    if (job->info->format == video_format::VIDEO_FORMAT_NV12) {
+        video_convert_rgb_to_nv12(src, job->input->frame.linesize[0], dst, job->output->linesize.data(),
+                                  job->info->width, y1 - y0, job->coeffs);
+    } else {
+        dst[2] = job->output->data[2] + (y0 / 2) * job->output->linesize[2];
+        video_convert_rgb_to_i420(src, job->input->frame.linesize[0], dst, job->output->linesize.data(),
+                                  job->info->width, y1 - y0, job->coeffs);
+    }
+}
+
+void lite_obs_core_video::copy_rgbx_frame(video_frame *output, const video_data *input, const video_output_info *info)
+{
+    switch (info->format) {
+    case video_format::VIDEO_FORMAT_NV12:
+    case video_format::VIDEO_FORMAT_I420: {
+        /* reads straight from the mapped staging surface, it stays mapped
+         * until the next frame is staged */
+        rgbx_convert_job job;
+        job.input = input;
+        job.output = output;
+        job.info = info;
+        job.coeffs = &d_ptr->rgbx_coeffs;
+        d_ptr->rgbx_convert_pool.run(convert_rgbx_band, &job);
+        break;
+    }
+    case video_format::VIDEO_FORMAT_RGBA:
+    case video_format::VIDEO_FORMAT_BGRX:
+    case video_format::VIDEO_FORMAT_BGRA:
+        set_gpu_converted_plane(info->width * 4, info->height,
+                                input->frame.linesize[0],
+                                output->linesize[0],
+                                input->frame.data[0],
+                                output->data[0]);
+        break;
+    default:
+        /* unimplemented */
+        break;
+    }
+}
+
+void lite_obs_core_video::output_video_data(const std::shared_ptr<video_output> &video, video_data *input_frame, int count)
 {
     video_frame output_frame;
     bool locked;
 
-    const auto info = d_ptr->video->video_output_get_info();
+    const auto info = video->video_output_get_info();
 
-    locked = d_ptr->video->video_output_lock_frame(&output_frame, count, input_frame->timestamp);
+    locked = video->video_output_lock_frame(&output_frame, count, input_frame->timestamp);
     if (locked) {
         if (d_ptr->gpu_conversion) {
             set_gpu_converted_data(&output_frame, input_frame, info);
         } else {
-            //todo
-            //copy_rgbx_frame(&output_frame, input_frame, info);
+            copy_rgbx_frame(&output_frame, input_frame, info);
         }
 
-        d_ptr->video->video_output_unlock_frame();
+        video->video_output_unlock_frame();
     }
 }
 
 void lite_obs_core_video::output_frame(bool raw_active, const bool gpu_active)
 {
-    int cur_texture = d_ptr->cur_texture;
-    int prev_texture = cur_texture == 0 ? NUM_TEXTURES - 1 : cur_texture - 1;
-
     video_data frame;
     bool frame_ready = 0;
 
+    std::lock_guard<std::mutex> lock(d_ptr->rendition_mutex);
+
     graphics_subsystem::make_current(d_ptr->graphics);
 
+    for (auto &rendition : d_ptr->retired_renditions)
+        clear_rendition(rendition.get());
+    d_ptr->retired_renditions.clear();
+
     graphics_subsystem::process_main_render_task([this](){
         render_main_texture();
     }, d_ptr->render_texture);
 
-    render_video(raw_active, gpu_active, cur_texture);
+    render_video(raw_active, gpu_active, d_ptr->cur_texture);
 
-    if (raw_active) {
-        frame_ready = download_frame(prev_texture, &frame);
+    /* the timing of the frame staged just now is queued in video_sleep, only
+     * frames staged on an earlier pass can go out. with a ready readback the
+     * one just staged would otherwise be taken before it has any */
+    if (raw_active && d_ptr->vframe_info_buffer.size) {
+        frame_ready = download_frame(&frame);
     }
 
     graphics_subsystem::done_current(true);
@@ -507,11 +694,9 @@ void lite_obs_core_video::output_frame(bool raw_active, const bool gpu_active)
         circlebuf_pop_front(&d_ptr->vframe_info_buffer, &vframe_info, sizeof(vframe_info));
 
         frame.timestamp = vframe_info.timestamp;
-        output_video_data(&frame, vframe_info.count);
+        output_video_data(d_ptr->video, &frame, vframe_info.count);
+        output_renditions(vframe_info.timestamp, vframe_info.count);
     }
-
-    if (++d_ptr->cur_texture == NUM_TEXTURES)
-        d_ptr->cur_texture = 0;
 }
 
 bool lite_obs_core_video::graphics_loop(lite_obs_graphics_context *context)
@@ -595,6 +780,11 @@ uint32_t lite_obs_core_video::lagged_frames()
     return d_ptr->lagged_frames;
 }
 
+uint32_t lite_obs_core_video::readback_latency()
+{
+    return d_ptr->readback_latency;
+}
+
 void lite_obs_core_video::set_video_matrix(output_video_info *ovi)
 {
     glm::mat4x4 mat{0};
@@ -656,43 +846,50 @@ void lite_obs_core_video::clear_gpu_conversion_textures()
     }
 }
 
-bool lite_obs_core_video::init_gpu_conversion()
+/* the planes the conversion shaders draw for format, the last one that
+ * format has must exist */
+static bool create_convert_textures(video_format format, uint32_t width, uint32_t height, std::shared_ptr<gs_texture> *textures)
 {
-    calc_gpu_conversion_sizes();
-
-    d_ptr->convert_textures[0] = gs_texture_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8, GS_RENDER_TARGET);
+    textures[0] = gs_texture_create(width, height, gs_color_format::GS_R8, GS_RENDER_TARGET);
 
-    switch (d_ptr->output_format) {
+    switch (format) {
     case video_format::VIDEO_FORMAT_I420:
-        d_ptr->convert_textures[1] = gs_texture_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_R8, GS_RENDER_TARGET);
-        d_ptr->convert_textures[2] = gs_texture_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_R8, GS_RENDER_TARGET);
-        if (!d_ptr->convert_textures[2])
+        textures[1] = gs_texture_create(width / 2, height / 2, gs_color_format::GS_R8, GS_RENDER_TARGET);
+        textures[2] = gs_texture_create(width / 2, height / 2, gs_color_format::GS_R8, GS_RENDER_TARGET);
+        if (!textures[2])
             return false;
         break;
     case video_format::VIDEO_FORMAT_NV12:
-        d_ptr->convert_textures[1] = gs_texture_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_R8G8, GS_RENDER_TARGET);
+        textures[1] = gs_texture_create(width / 2, height / 2, gs_color_format::GS_R8G8, GS_RENDER_TARGET);
         break;
     case video_format::VIDEO_FORMAT_I444:
-        d_ptr->convert_textures[1] = gs_texture_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8, GS_RENDER_TARGET);
-        d_ptr->convert_textures[2] = gs_texture_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8, GS_RENDER_TARGET);
-        if (!d_ptr->convert_textures[2])
+        textures[1] = gs_texture_create(width, height, gs_color_format::GS_R8, GS_RENDER_TARGET);
+        textures[2] = gs_texture_create(width, height, gs_color_format::GS_R8, GS_RENDER_TARGET);
+        if (!textures[2])
             return false;
         break;
     default:
         break;
     }
 
-    if (!d_ptr->convert_textures[0])
+    if (!textures[0])
         return false;
-    if (!d_ptr->convert_textures[1])
+    if (!textures[1])
         return false;
 
     return true;
 }
 
+bool lite_obs_core_video::init_gpu_conversion()
+{
+    calc_gpu_conversion_sizes();
+
+    return create_convert_textures(d_ptr->output_format, d_ptr->output_width, d_ptr->output_height, d_ptr->convert_textures);
+}
+
 void lite_obs_core_video::clear_gpu_copy_surface()
 {
-    for (size_t i = 0; i < NUM_TEXTURES; i++) {
+    for (size_t i = 0; i < MAX_STAGE_TEXTURES; i++) {
         for (size_t c = 0; c < NUM_CHANNELS; c++) {
             if (d_ptr->copy_surfaces[i][c]) {
                 d_ptr->copy_surfaces[i][c].reset();
@@ -701,32 +898,33 @@ void lite_obs_core_video::clear_gpu_copy_surface()
     }
 }
 
-bool lite_obs_core_video::init_gpu_copy_surface(size_t i)
+/* one staging surface per plane of format */
+static bool create_copy_surfaces(video_format format, uint32_t width, uint32_t height, std::shared_ptr<gs_stagesurface> *surfaces)
 {
-    d_ptr->copy_surfaces[i][0] = gs_stagesurface_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8);
-    if (!d_ptr->copy_surfaces[i][0])
+    surfaces[0] = gs_stagesurface_create(width, height, gs_color_format::GS_R8);
+    if (!surfaces[0])
         return false;
 
-    switch (d_ptr->output_format) {
+    switch (format) {
     case video_format::VIDEO_FORMAT_I420:
-        d_ptr->copy_surfaces[i][1] = gs_stagesurface_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_R8);
-        if (!d_ptr->copy_surfaces[i][1])
+        surfaces[1] = gs_stagesurface_create(width / 2, height / 2, gs_color_format::GS_R8);
+        if (!surfaces[1])
             return false;
-        d_ptr->copy_surfaces[i][2] = gs_stagesurface_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_R8);
-        if (!d_ptr->copy_surfaces[i][2])
+        surfaces[2] = gs_stagesurface_create(width / 2, height / 2, gs_color_format::GS_R8);
+        if (!surfaces[2])
             return false;
         break;
     case video_format::VIDEO_FORMAT_NV12:
-        d_ptr->copy_surfaces[i][1] = gs_stagesurface_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_R8G8);
-        if (!d_ptr->copy_surfaces[i][1])
+        surfaces[1] = gs_stagesurface_create(width / 2, height / 2, gs_color_format::GS_R8G8);
+        if (!surfaces[1])
             return false;
         break;
     case video_format::VIDEO_FORMAT_I444:
-        d_ptr->copy_surfaces[i][1] = gs_stagesurface_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8);
-        if (!d_ptr->copy_surfaces[i][1])
+        surfaces[1] = gs_stagesurface_create(width, height, gs_color_format::GS_R8);
+        if (!surfaces[1])
             return false;
-        d_ptr->copy_surfaces[i][2] = gs_stagesurface_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8);
-        if (!d_ptr->copy_surfaces[i][2])
+        surfaces[2] = gs_stagesurface_create(width, height, gs_color_format::GS_R8);
+        if (!surfaces[2])
             return false;
         break;
     default:
@@ -736,9 +934,14 @@ bool lite_obs_core_video::init_gpu_copy_surface(size_t i)
     return true;
 }
 
+bool lite_obs_core_video::init_gpu_copy_surface(size_t i)
+{
+    return create_copy_surfaces(d_ptr->output_format, d_ptr->output_width, d_ptr->output_height, d_ptr->copy_surfaces[i]);
+}
+
 bool lite_obs_core_video::init_textures()
 {
-    for (size_t i = 0; i < NUM_TEXTURES; i++) {
+    for (size_t i = 0; i < (size_t)d_ptr->stage_depth; i++) {
         if (d_ptr->gpu_conversion) {
             if (!init_gpu_copy_surface(i)) {
                 clear_gpu_copy_surface();
@@ -767,11 +970,145 @@ bool lite_obs_core_video::init_textures()
     return true;
 }
 
+bool lite_obs_core_video::init_rendition(lite_obs_rendition *rendition)
+{
+    if (d_ptr->gpu_conversion &&
+        !create_convert_textures(d_ptr->output_format, rendition->width, rendition->height, rendition->convert_textures))
+        return false;
+
+    for (int i = 0; i < d_ptr->stage_depth; i++) {
+        if (d_ptr->gpu_conversion) {
+            if (!create_copy_surfaces(d_ptr->output_format, rendition->width, rendition->height, rendition->copy_surfaces[i]))
+                return false;
+        } else {
+            rendition->copy_surfaces[i][0] = gs_stagesurface_create(rendition->width, rendition->height, gs_color_format::GS_RGBA);
+            if (!rendition->copy_surfaces[i][0])
+                return false;
+        }
+    }
+
+    rendition->output_texture = gs_texture_create(rendition->width, rendition->height, gs_color_format::GS_RGBA, GS_RENDER_TARGET);
+    return rendition->output_texture != nullptr;
+}
+
+void lite_obs_core_video::clear_rendition(lite_obs_rendition *rendition)
+{
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+        auto surface = rendition->mapped_surfaces[c].lock();
+        if (surface)
+            surface->gs_stagesurface_unmap();
+        rendition->mapped_surfaces[c].reset();
+    }
+
+    for (int i = 0; i < MAX_STAGE_TEXTURES; i++) {
+        for (int c = 0; c < NUM_CHANNELS; c++)
+            rendition->copy_surfaces[i][c].reset();
+    }
+    for (int c = 0; c < NUM_CHANNELS; c++)
+        rendition->convert_textures[c].reset();
+    rendition->output_texture.reset();
+
+    memset(rendition->textures_copied, 0, sizeof(rendition->textures_copied));
+    rendition->frame_ready = false;
+    rendition->valid = false;
+    rendition->initialized = false;
+}
+
+/* scales the composite into every rendition and stages it into the ring
+ * slot the main output is staged into. bicubic takes four taps per axis,
+ * which skips source pixels below half size, so smaller renditions average
+ * every pixel they cover instead */
+void lite_obs_core_video::render_renditions(int cur_texture)
+{
+    for (auto &rendition : d_ptr->renditions) {
+        if (!rendition->initialized) {
+            rendition->initialized = true;
+            rendition->valid = init_rendition(rendition.get());
+            if (!rendition->valid) {
+                blog(LOG_WARNING, "could not create the textures of a %ux%u rendition", rendition->width, rendition->height);
+                clear_rendition(rendition.get());
+                rendition->initialized = true;
+            }
+        }
+
+        if (!rendition->valid)
+            continue;
+
+        for (int c = 0; c < NUM_CHANNELS; c++) {
+            auto surface = rendition->mapped_surfaces[c].lock();
+            if (surface) {
+                surface->gs_stagesurface_unmap();
+                rendition->mapped_surfaces[c].reset();
+            }
+        }
+
+        std::shared_ptr<gs_program> program;
+        if (rendition->width * 2 <= d_ptr->base_width || rendition->height * 2 <= d_ptr->base_height)
+            program = graphics_subsystem::get_effect_by_name("Area_Draw");
+        else
+            program = get_scale_effect(rendition->width, rendition->height);
+        if (!program)
+            continue;
+
+        draw_scaled_texture(program, d_ptr->render_texture, rendition->output_texture, d_ptr->base_width, d_ptr->base_height);
+
+        if (d_ptr->gpu_conversion) {
+            render_convert_texture(rendition->output_texture, rendition->convert_textures, 1.f / (float)rendition->width);
+            for (int c = 0; c < NUM_CHANNELS; c++) {
+                auto copy = rendition->copy_surfaces[cur_texture][c];
+                if (copy)
+                    copy->gs_stagesurface_stage_texture(rendition->convert_textures[c]);
+            }
+        } else {
+            rendition->copy_surfaces[cur_texture][0]->gs_stagesurface_stage_texture(rendition->output_texture);
+        }
+
+        rendition->textures_copied[cur_texture] = true;
+    }
+}
+
+/* renditions added after the slot was staged have nothing in it */
+void lite_obs_core_video::download_renditions(int texture)
+{
+    for (auto &rendition : d_ptr->renditions) {
+        rendition->frame_ready = false;
+        if (!rendition->textures_copied[texture])
+            continue;
+
+        rendition->textures_copied[texture] = false;
+        rendition->frame_ready = true;
+        for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+            auto surface = rendition->copy_surfaces[texture][channel];
+            if (!surface)
+                continue;
+
+            if (!surface->gs_stagesurface_map(&rendition->frame.frame.data[channel], &rendition->frame.frame.linesize[channel])) {
+                rendition->frame_ready = false;
+                break;
+            }
+
+            rendition->mapped_surfaces[channel] = surface;
+        }
+    }
+}
+
+void lite_obs_core_video::output_renditions(uint64_t timestamp, int count)
+{
+    for (auto &rendition : d_ptr->renditions) {
+        if (!rendition->frame_ready)
+            continue;
+
+        rendition->frame_ready = false;
+        rendition->frame.timestamp = timestamp;
+        output_video_data(rendition->video, &rendition->frame, count);
+    }
+}
+
 void lite_obs_core_video::graphics_thread_internal()
 {
     do {
         graphics_subsystem::make_current(d_ptr->graphics);
-        if (!init_gpu_conversion()) {
+        if (d_ptr->gpu_conversion && !init_gpu_conversion()) {
             clear_gpu_conversion_textures();
             graphics_subsystem::done_current();
             break;
@@ -783,11 +1120,30 @@ void lite_obs_core_video::graphics_thread_internal()
         }
         graphics_subsystem::done_current();
 
+        if (!d_ptr->gpu_conversion) {
+            size_t bands = std::min<size_t>(d_ptr->requested_rgbx_bands, RGBX_CONVERT_MAX_BANDS);
+            if (!bands && d_ptr->output_height >= RGBX_CONVERT_MT_HEIGHT)
+                bands = std::min<size_t>(std::thread::hardware_concurrency() / 2, RGBX_CONVERT_MAX_BANDS);
+            if (bands > 1)
+                d_ptr->rgbx_convert_pool.start(bands - 1);
+        }
+
         graphics_task_func();
     } while(false);
 
+    d_ptr->rgbx_convert_pool.stop();
+
     graphics_subsystem::make_current(d_ptr->graphics);
 
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->rendition_mutex);
+        for (auto &rendition : d_ptr->renditions)
+            clear_rendition(rendition.get());
+        for (auto &rendition : d_ptr->retired_renditions)
+            clear_rendition(rendition.get());
+        d_ptr->retired_renditions.clear();
+    }
+
     for (size_t c = 0; c < NUM_CHANNELS; c++) {
         auto surface = d_ptr->mapped_surfaces[c].lock();
         if (surface) {
@@ -827,6 +1183,29 @@ static inline void make_video_info(video_output_info *vi, lite_obs_core_video::o
     vi->cache_size = 6;
 }
 
+void lite_obs_core_video::lite_obs_set_stage_depth(uint32_t depth)
+{
+    if (depth < NUM_TEXTURES)
+        depth = NUM_TEXTURES;
+    else if (depth > MAX_STAGE_TEXTURES)
+        depth = MAX_STAGE_TEXTURES;
+
+    /* the staging surfaces are created when the graphics thread starts,
+     * so the new depth is picked up by the next lite_obs_start_video */
+    d_ptr->requested_stage_depth = (int)depth;
+}
+
+void lite_obs_core_video::lite_obs_set_gpu_conversion(bool enabled)
+{
+    /* picked up by the next lite_obs_start_video, like the stage depth */
+    d_ptr->requested_gpu_conversion = enabled;
+}
+
+void lite_obs_core_video::lite_obs_set_rgbx_convert_bands(uint32_t bands)
+{
+    d_ptr->requested_rgbx_bands = bands;
+}
+
 int lite_obs_core_video::lite_obs_start_video(uint32_t width, uint32_t height, uint32_t fps)
 {
 #if TARGET_PLATFORM == PLATFORM_WIN32
@@ -863,7 +1242,13 @@ int lite_obs_core_video::lite_obs_start_video(uint32_t width, uint32_t height, u
     d_ptr->base_height = ovi.base_height;
     d_ptr->output_width = ovi.output_width;
     d_ptr->output_height = ovi.output_height;
-    d_ptr->gpu_conversion = true;
+    d_ptr->gpu_conversion = d_ptr->requested_gpu_conversion;
+    video_convert_coeffs_init(&d_ptr->rgbx_coeffs, video_format::VIDEO_FORMAT_RGBA, vi.colorspace, vi.range);
+    /* same chroma as Convert_NV12_UV, switching gpu conversion off must not
+     * move it */
+    d_ptr->rgbx_coeffs.chroma_left = true;
+    d_ptr->stage_depth = d_ptr->requested_stage_depth;
+    d_ptr->readback_latency = 0;
 
     set_video_matrix(&ovi);
     d_ptr->ovi = ovi;
@@ -894,6 +1279,17 @@ void lite_obs_core_video::lite_obs_stop_video()
         blog(LOG_DEBUG, "video thread stopped");
     }
 
+    /* the graphics thread has freed their gpu objects on the way out */
+    std::vector<std::shared_ptr<lite_obs_rendition>> renditions;
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->rendition_mutex);
+        renditions = std::move(d_ptr->renditions);
+        d_ptr->renditions.clear();
+        d_ptr->retired_renditions.clear();
+    }
+    for (auto &rendition : renditions)
+        rendition->video->video_output_close();
+
     if (d_ptr->video) {
         d_ptr->video->video_output_close();
         d_ptr->video.reset();
@@ -906,11 +1302,63 @@ std::shared_ptr<video_output> lite_obs_core_video::core_video()
     return d_ptr->video;
 }
 
+std::shared_ptr<video_output> lite_obs_core_video::lite_obs_add_rendition(uint32_t width, uint32_t height)
+{
+    if (!d_ptr->video)
+        return nullptr;
+
+    width &= 0xFFFFFFFC;
+    height &= 0xFFFFFFFE;
+    if (!width || !height)
+        return nullptr;
+
+    video_output_info vi = *d_ptr->video->video_output_get_info();
+    vi.name = "rendition";
+    vi.width = width;
+    vi.height = height;
+
+    auto video = std::make_shared<video_output>();
+    if (video->video_output_open(&vi) != VIDEO_OUTPUT_SUCCESS) {
+        blog(LOG_ERROR, "Could not open the video output of a %ux%u rendition", width, height);
+        return nullptr;
+    }
+
+    auto rendition = std::make_shared<lite_obs_rendition>();
+    rendition->width = width;
+    rendition->height = height;
+    rendition->video = video;
+
+    std::lock_guard<std::mutex> lock(d_ptr->rendition_mutex);
+    d_ptr->renditions.push_back(std::move(rendition));
+    return video;
+}
+
+void lite_obs_core_video::lite_obs_remove_rendition(const std::shared_ptr<video_output> &video)
+{
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->rendition_mutex);
+        auto iter = std::find_if(d_ptr->renditions.begin(), d_ptr->renditions.end(),
+                                 [&](const std::shared_ptr<lite_obs_rendition> &rendition) { return rendition->video == video; });
+        if (iter == d_ptr->renditions.end())
+            return;
+
+        d_ptr->retired_renditions.push_back(std::move(*iter));
+        d_ptr->renditions.erase(iter);
+    }
+
+    video->video_output_close();
+}
+
 #define NUM_ENCODE_TEXTURES 5
+#define NUM_ENCODE_QUEUE_ENTRIES 16
 bool lite_obs_core_video::init_gpu_encoding()
 {
     d_ptr->gpu_encode_stop = false;
 
+    d_ptr->gpu_encoder_queue.init(NUM_ENCODE_QUEUE_ENTRIES);
+    d_ptr->gpu_encoder_avail_queue.init(NUM_ENCODE_TEXTURES);
+    d_ptr->gpu_encoder_last_queued = nullptr;
+
     auto ovi = d_ptr->video->video_output_get_info();
     for (size_t i = 0; i < NUM_ENCODE_TEXTURES; i++) {
         auto tex = gs_texture_create(ovi->width, ovi->height, gs_color_format::GS_RGBA, GS_RENDER_TARGET);
@@ -918,12 +1366,13 @@ bool lite_obs_core_video::init_gpu_encoding()
             return false;
         }
 
-        auto frame = std::make_shared<lite_obs_tex_frame>();
+        auto frame = std::make_unique<lite_obs_tex_frame>();
         frame->tex = tex;
-        d_ptr->gpu_encoder_avail_queue.push_back(frame);
+        d_ptr->gpu_encoder_avail_queue.push(frame.get());
+        d_ptr->gpu_encoder_frames.push_back(std::move(frame));
     }
 
-    if (os_sem_init(&d_ptr->gpu_encode_semaphore, 0) != 0)
+    if (os_wakeup_init(&d_ptr->gpu_encode_wakeup) != 0)
         return false;
     if (os_event_init(&d_ptr->gpu_encode_inactive, OS_EVENT_TYPE_MANUAL) != 0)
         return false;
@@ -936,63 +1385,48 @@ bool lite_obs_core_video::init_gpu_encoding()
     return true;
 }
 
+/* the encode thread stays this many queue entries behind the graphics thread
+ * so the texture it hands to the encoders has finished rendering */
 #define NUM_ENCODE_TEXTURE_FRAMES_TO_WAIT 1
 void lite_obs_core_video::gpu_encode_thread_internal()
 {
-    int wait_frames = NUM_ENCODE_TEXTURE_FRAMES_TO_WAIT;
-    while (os_sem_wait(d_ptr->gpu_encode_semaphore) == 0) {
+    while (os_wakeup_wait(d_ptr->gpu_encode_wakeup) == 0) {
         if (d_ptr->gpu_encode_stop)
             break;
 
-        if (wait_frames) {
-            wait_frames--;
-            continue;
-        }
-
-        os_event_reset(d_ptr->gpu_encode_inactive);
+        while (!d_ptr->gpu_encode_stop && d_ptr->gpu_encoder_queue.count() > NUM_ENCODE_TEXTURE_FRAMES_TO_WAIT) {
+            os_event_reset(d_ptr->gpu_encode_inactive);
 
-        /* -------------- */
+            /* -------------- */
 
-        std::list<std::shared_ptr<lite_obs_encoder>> encoders;
+            lite_obs_tex_entry entry;
+            d_ptr->gpu_encoder_queue.pop(entry);
+            auto tf = entry.tf;
+            auto tex_id = tf->tex->gs_texture_obj();
 
-        d_ptr->gpu_encoder_mutex.lock();
+            std::list<std::shared_ptr<lite_obs_encoder>> encoders;
 
-        auto tf = d_ptr->gpu_encoder_queue.front();
-        d_ptr->gpu_encoder_queue.pop_front();
-        auto timestamp = tf->timestamp;
-        auto tex_id = tf->tex->gs_texture_obj();
+            d_ptr->gpu_encoder_mutex.lock();
+            d_ptr->video->video_output_inc_texture_frames();
+            if (entry.duplicate)
+                d_ptr->video->video_output_inc_texture_skipped_frames();
+            encoders = d_ptr->gpu_encoders;
+            d_ptr->gpu_encoder_mutex.unlock();
 
-        d_ptr->video->video_output_inc_texture_frames();
-        encoders = d_ptr->gpu_encoders;
+            /* -------------- */
 
-        d_ptr->gpu_encoder_mutex.unlock();
-        /* -------------- */
-
-        for (auto iter = encoders.begin(); iter != encoders.end(); iter++) {
-            auto &encoder = *iter;
-            encoder->receive_video_texture(timestamp, tex_id);
-        }
-
-        /* -------------- */
+            for (auto iter = encoders.begin(); iter != encoders.end(); iter++) {
+                auto &encoder = *iter;
+                encoder->receive_video_texture(entry.timestamp, tex_id);
+            }
 
-        d_ptr->gpu_encoder_mutex.lock();
+            /* -------------- */
 
-        if (--tf->count) {
-            tf->timestamp += d_ptr->video->video_output_get_frame_time();
-            d_ptr->gpu_encoder_queue.push_front(tf);
+            if (tf->count.fetch_sub(1) == 1)
+                d_ptr->gpu_encoder_avail_queue.push(tf);
 
-            d_ptr->video->video_output_inc_texture_skipped_frames();
-        } else {
-            d_ptr->gpu_encoder_avail_queue.push_back(tf);
+            os_event_signal(d_ptr->gpu_encode_inactive);
         }
-
-        d_ptr->gpu_encoder_mutex.unlock();
-
-        /* -------------- */
-
-        os_event_signal(d_ptr->gpu_encode_inactive);
-
-        encoders.clear();
     }
 }
 
@@ -1004,9 +1438,9 @@ void lite_obs_core_video::gpu_encode_thread(void *param)
 
 void lite_obs_core_video::free_gpu_encoding()
 {
-    if (d_ptr->gpu_encode_semaphore) {
-        os_sem_destroy(d_ptr->gpu_encode_semaphore);
-        d_ptr->gpu_encode_semaphore = NULL;
+    if (d_ptr->gpu_encode_wakeup) {
+        os_wakeup_destroy(d_ptr->gpu_encode_wakeup);
+        d_ptr->gpu_encode_wakeup = NULL;
     }
     if (d_ptr->gpu_encode_inactive) {
         os_event_destroy(d_ptr->gpu_encode_inactive);
@@ -1015,13 +1449,15 @@ void lite_obs_core_video::free_gpu_encoding()
 
     d_ptr->gpu_encoder_queue.clear();
     d_ptr->gpu_encoder_avail_queue.clear();
+    d_ptr->gpu_encoder_last_queued = nullptr;
+    d_ptr->gpu_encoder_frames.clear();
 }
 
 void lite_obs_core_video::stop_gpu_encoding_thread()
 {
     if (d_ptr->gpu_encode_thread_initialized) {
         d_ptr->gpu_encode_stop = true;
-        os_sem_post(d_ptr->gpu_encode_semaphore);
+        os_wakeup_signal(d_ptr->gpu_encode_wakeup);
         if (d_ptr->gpu_encode_thread.joinable())
             d_ptr->gpu_encode_thread.join();
         d_ptr->gpu_encode_thread_initialized = false;
@@ -1086,20 +1522,40 @@ void lite_obs_core_video::output_gpu_encoders()
     obs_vframe_info vframe_info;
     circlebuf_pop_front(&d_ptr->vframe_info_buffer_gpu, &vframe_info, sizeof(vframe_info));
 
+    /* the graphics thread is the only producer of gpu_encoder_queue and the
+     * only consumer of gpu_encoder_avail_queue, the encode thread the other
+     * way around */
     auto queue_frame = [this](obs_vframe_info *info) -> bool {
+        auto entry = d_ptr->gpu_encoder_queue.write_slot();
+        if (!entry)
+            return false;
+
         bool duplicate = d_ptr->gpu_encoder_avail_queue.empty() || (!d_ptr->gpu_encoder_queue.empty() && info->count > 1);
         if (duplicate) {
-            if (d_ptr->gpu_encoder_queue.empty())
-                return false;
+            /* repeat the newest texture, unless it has been encoded and
+             * released in the meantime */
+            auto last = d_ptr->gpu_encoder_last_queued;
+            int count = last ? last->count.load() : 0;
+            while (count > 0 && !last->count.compare_exchange_weak(count, count + 1))
+                ;
+
+            if (count > 0) {
+                entry->tf = last;
+                entry->timestamp = info->timestamp;
+                entry->duplicate = true;
+                d_ptr->gpu_encoder_queue.push();
+                os_wakeup_signal(d_ptr->gpu_encode_wakeup);
+
+                info->timestamp += d_ptr->video->video_output_get_frame_time();
+                return --info->count;
+            }
 
-            auto tf = d_ptr->gpu_encoder_queue.front();
-            tf->count++;
-            os_sem_post(d_ptr->gpu_encode_semaphore);
-            return --info->count;
+            if (d_ptr->gpu_encoder_avail_queue.empty())
+                return false;
         }
 
-        auto tf = d_ptr->gpu_encoder_avail_queue.front();
-        d_ptr->gpu_encoder_avail_queue.pop_front();
+        lite_obs_tex_frame *tf{};
+        d_ptr->gpu_encoder_avail_queue.pop(tf);
 
         /* the vframe_info->count > 1 case causing a copy can only happen if by
          * some chance the very first frame has to be duplicated for whatever
@@ -1121,17 +1577,19 @@ void lite_obs_core_video::output_gpu_encoders()
         }
 
         tf->count = 1;
-        tf->timestamp = info->timestamp;
-        d_ptr->gpu_encoder_queue.push_back(tf);
+        entry->tf = tf;
+        entry->timestamp = info->timestamp;
+        entry->duplicate = false;
+        d_ptr->gpu_encoder_last_queued = tf;
+        d_ptr->gpu_encoder_queue.push();
 
-        os_sem_post(d_ptr->gpu_encode_semaphore);
+        os_wakeup_signal(d_ptr->gpu_encode_wakeup);
 
+        info->timestamp += d_ptr->video->video_output_get_frame_time();
         return --info->count;
 
     };
 
-    d_ptr->gpu_encoder_mutex.lock();
     while (queue_frame(&vframe_info))
         ;
-    d_ptr->gpu_encoder_mutex.unlock();
 }
@@ -3,22 +3,26 @@
 #include "lite-obs/lite_obs_core_video.h"
 #include "lite-obs/lite_obs_core_audio.h"
 #include "lite-obs/lite_obs_source.h"
+#include "lite-obs/lite_obs_source_graph.h"
 #include "lite-obs/lite_encoder.h"
+#include "lite-obs/media-io/video_output.h"
 #include "lite-obs/output/aoa_output.h"
 #include "lite-obs/output/file_output.h"
 #include "lite-obs/output/srt_stream_output.h"
 #include "lite-obs/output/rtmp_stream_output.h"
 #include "lite-obs/output/iOS_muxd_output.h"
 #include "lite-obs/util/threading.h"
+#include "lite-obs/util/log.h"
 #include "lite-obs/lite_obs_platform_config.h"
 
+#include <map>
 #include <set>
 
 
 struct lite_obs_media_source_private
 {
     std::shared_ptr<lite_obs_source> internal_source{};
-    uintptr_t core_ptr{};
+    std::shared_ptr<lite_obs_source_graph> graph{};
 };
 
 lite_obs_media_source_internal::lite_obs_media_source_internal()
@@ -57,6 +61,11 @@ void lite_obs_media_source_internal::output_video(const uint8_t *video_data[MAX_
     d_ptr->internal_source->lite_source_output_video(video_data, line_size, format, range, color_space, width, height);
 }
 
+void lite_obs_media_source_internal::output_video_borrowed(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES], video_format format, video_range_type range, video_colorspace color_space, uint32_t width, uint32_t height, void (*release_cb)(void *), void *opaque)
+{
+    d_ptr->internal_source->lite_source_output_video_borrowed(video_data, line_size, format, range, color_space, width, height, release_cb, opaque);
+}
+
 void lite_obs_media_source_internal::output_video(const uint8_t *img_data, uint32_t img_width, uint32_t img_height)
 {
     d_ptr->internal_source->lite_source_output_video(img_data, img_width, img_height);
@@ -89,45 +98,7 @@ void lite_obs_media_source_internal::set_render_box(int x, int y, int width, int
 
 void lite_obs_media_source_internal::set_order(order_movement movement)
 {
-    std::lock_guard<std::recursive_mutex> lock(lite_obs_source::sources_mutex);
-    auto &sources = lite_obs_source::sources[d_ptr->core_ptr];
-    auto iter = std::find(sources.begin(), sources.end(), d_ptr->internal_source);
-    if (iter == sources.end())
-        return;
-
-    switch (movement) {
-    case MOVE_UP:
-    {
-        auto target = std::next(iter);
-        if (target != sources.end())
-            std::iter_swap(iter, target);
-    }
-    break;
-    case MOVE_DOWN:
-    {
-        if (iter != sources.begin()) {
-            auto target = std::prev(iter);
-            std::iter_swap(iter, target);
-        }
-    }
-    break;
-    case MOVE_TOP:
-    {
-        auto target = std::prev(sources.end());
-        if (iter != target)
-            std::iter_swap(iter, target);
-    }
-    break;
-    case MOVE_BOTTOM:
-    {
-        auto target = sources.begin();
-        if (iter != target)
-            std::iter_swap(iter, target);
-    }
-    break;
-    default:
-        break;
-    }
+    d_ptr->graph->move(d_ptr->internal_source, movement);
 }
 
 void lite_obs_media_source_internal::set_flip(bool flip_h, bool flip_v)
@@ -140,26 +111,68 @@ void lite_obs_media_source_internal::reset_transform()
     d_ptr->internal_source->lite_source_reset_transform();
 }
 
+void lite_obs_media_source_internal::set_jitter_window(uint32_t ms)
+{
+    d_ptr->internal_source->lite_source_set_jitter_window(ms);
+}
+
+void lite_obs_media_source_internal::set_audio_mixers(uint32_t mixers)
+{
+    d_ptr->internal_source->lite_source_set_audio_mixers(mixers);
+}
+
 struct lite_obs_private
 {
     std::shared_ptr<lite_obs_core_video> video{};
     std::shared_ptr<lite_obs_core_audio> audio{};
+    std::shared_ptr<lite_obs_source_graph> graph{};
 
     std::shared_ptr<lite_obs_output> output{};
+    /* outputs started with lite_obs_start_output2, fed by the same encoders
+     * as output */
+    std::map<int, std::shared_ptr<lite_obs_output>> shared_outputs{};
+    /* scaled video encoders of outputs started with lite_obs_start_rendition
+     * and the core video renditions feeding them */
+    std::map<int, std::shared_ptr<lite_obs_encoder>> rendition_encoders{};
+    std::map<int, std::shared_ptr<video_output>> rendition_videos{};
+    int next_output_id = 1;
+
     std::shared_ptr<lite_obs_encoder> video_encoder{};
-    std::shared_ptr<lite_obs_encoder> audio_encoder{};
+    bool sw_encoder{};
+    video_codec codec = VIDEO_CODEC_H264;
+    std::shared_ptr<lite_obs_encoder> audio_encoders[MAX_AUDIO_MIXES]{};
+    uint32_t audio_tracks = 1;
+    audio_codec acodec = AUDIO_CODEC_AAC;
+    opus_encoder_settings opus{};
+    x264_encoder_settings x264{};
 
     std::set<lite_obs_media_source_internal *> sources;
 
+    std::shared_ptr<lite_obs_encoder> create_video_encoder(int vb);
+    bool start_output(const std::shared_ptr<lite_obs_output> &out, const std::shared_ptr<lite_obs_encoder> &venc, int ab);
+    template<typename F>
+    void for_each_video_encoder(F &&f) {
+        if (video_encoder)
+            f(video_encoder);
+        for (auto &iter : rendition_encoders)
+            f(iter.second);
+    }
+
+    int add_shared_output(output_type type, void *output_info, const lite_obs_output_callbak &callback,
+                          const std::shared_ptr<lite_obs_encoder> &venc, int vb, int ab);
+
     lite_obs_private() {
-        auto ptr = reinterpret_cast<uintptr_t>(this);
-        video = std::make_shared<lite_obs_core_video>(ptr);
-        audio = std::make_shared<lite_obs_core_audio>(ptr);
+        graph = std::make_shared<lite_obs_source_graph>();
+        video = std::make_shared<lite_obs_core_video>(graph);
+        audio = std::make_shared<lite_obs_core_audio>(graph);
     }
 
     ~lite_obs_private() {
+        rendition_encoders.clear();
+        rendition_videos.clear();
         video_encoder.reset();
-        audio_encoder.reset();
+        for (auto &encoder : audio_encoders)
+            encoder.reset();
 
         video.reset();
         audio.reset();
@@ -173,17 +186,17 @@ lite_obs_internal::lite_obs_internal()
 
 lite_obs_internal::~lite_obs_internal()
 {
-    {
-        std::lock_guard<std::recursive_mutex> lock(lite_obs_source::sources_mutex);
-        auto &sources = lite_obs_source::sources[reinterpret_cast<uintptr_t>(d_ptr)];
-        sources.clear();
-    }
+    d_ptr->graph->clear();
 
     for (auto iter : d_ptr->sources) {
         delete iter;
     }
     d_ptr->sources.clear();
 
+    for (auto &iter : d_ptr->shared_outputs)
+        iter.second->lite_obs_output_destroy();
+    d_ptr->shared_outputs.clear();
+
     if(d_ptr->output) {
         d_ptr->output->lite_obs_output_destroy();
         d_ptr->output.reset();
@@ -192,11 +205,6 @@ lite_obs_internal::~lite_obs_internal()
     d_ptr->video->lite_obs_stop_video();
     d_ptr->audio->lite_obs_stop_audio();
 
-    {
-        std::lock_guard<std::recursive_mutex> lock(lite_obs_source::sources_mutex);
-        lite_obs_source::sources.erase(reinterpret_cast<uintptr_t>(d_ptr));
-    }
-
     delete d_ptr;
 }
 
@@ -229,31 +237,163 @@ bool lite_obs_internal::obs_reset_audio(uint32_t sample_rate)
     return d_ptr->audio->lite_obs_start_audio(sample_rate);
 }
 
+void lite_obs_internal::obs_set_video_readback_depth(uint32_t depth)
+{
+    d_ptr->video->lite_obs_set_stage_depth(depth);
+}
+
+uint32_t lite_obs_internal::obs_get_video_readback_latency()
+{
+    return d_ptr->video->readback_latency();
+}
+
+void lite_obs_internal::obs_set_video_gpu_conversion(bool enabled)
+{
+    d_ptr->video->lite_obs_set_gpu_conversion(enabled);
+}
+
+void lite_obs_internal::obs_set_audio_tracks(uint32_t tracks)
+{
+    if (tracks < 1)
+        tracks = 1;
+    else if (tracks > MAX_AUDIO_MIXES)
+        tracks = MAX_AUDIO_MIXES;
+
+    d_ptr->audio_tracks = tracks;
+}
+
+static lite_obs_encoder::encoder_id audio_encoder_id(audio_codec codec)
+{
+    return codec == AUDIO_CODEC_OPUS ? lite_obs_encoder::encoder_id::OPUS : lite_obs_encoder::encoder_id::AAC;
+}
+
+void lite_obs_internal::obs_set_audio_codec(audio_codec codec, const lite_obs_opus_settings *opus)
+{
+    opus_encoder_settings settings{};
+    if (opus) {
+        if (opus->frame_ms > 0)
+            settings.frame_ms = opus->frame_ms;
+        if (opus->complexity > 0)
+            settings.complexity = opus->complexity > 10 ? 10 : opus->complexity;
+        settings.low_delay = opus->low_delay != 0;
+    }
+
+    d_ptr->acodec = codec;
+    d_ptr->opus = settings;
+
+    /* the frame size changes with the codec, so idle encoders are dropped
+     * and created again by the next output instead of being reset */
+    for (auto &encoder : d_ptr->audio_encoders) {
+        if (!encoder)
+            continue;
+
+        if (encoder->lite_obs_encoder_active()) {
+            blog(LOG_WARNING, "audio codec changed while an output is running, it keeps the old one");
+            continue;
+        }
+        encoder.reset();
+    }
+}
+
+uint32_t lite_obs_internal::obs_get_video_encoder_delay()
+{
+    if (!d_ptr->video_encoder)
+        return 0;
+
+    return d_ptr->video_encoder->lite_obs_encoder_get_delay_frames();
+}
+
+bool lite_obs_internal::obs_get_video_encoder_stats(lite_obs_video_encoder_stats *stats)
+{
+    if (!d_ptr->video_encoder || !stats)
+        return false;
+
+    video_input_stats input{};
+    if (!d_ptr->video_encoder->lite_obs_encoder_get_input_stats(&input))
+        return false;
+
+    stats->queue_depth = input.queue_depth;
+    stats->max_queue_depth = input.max_queue_depth;
+    stats->queue_limit = input.queue_limit;
+    stats->encoded_frames = input.delivered_frames;
+    stats->dropped_frames = input.dropped_frames;
+    stats->last_encode_ns = input.last_callback_ns;
+    stats->avg_encode_ns = input.avg_callback_ns;
+    stats->max_encode_ns = input.max_callback_ns;
+    return true;
+}
+
+static std::shared_ptr<lite_obs_output> create_output(output_type type)
+{
+    switch (type) {
+    case output_type::rtmp:
+        return std::make_shared<rtmp_stream_output>();
+    case output_type::srt:
+        return std::make_shared<mpeg_ts_output>();
+    case output_type::file:
+        return std::make_shared<lite_ffmpeg_mux>();
+    case output_type::android_aoa:
+        return std::make_shared<aoa_output>();
+    case output_type::iOS_usb:
+        return std::make_shared<iOS_muxd_output>();
+    default:
+        return nullptr;
+    }
+}
+
+static lite_obs_encoder::encoder_id video_encoder_id(bool sw, video_codec codec)
+{
+    if (codec == VIDEO_CODEC_HEVC)
+        return lite_obs_encoder::encoder_id::X265;
+    if (codec == VIDEO_CODEC_AV1)
+        return lite_obs_encoder::encoder_id::SVT_AV1;
+    if (sw)
+        return lite_obs_encoder::encoder_id::X264;
+
+#if TARGET_PLATFORM == PLATFORM_ANDROID
+    return lite_obs_encoder::encoder_id::MEDIACODEC;
+#elif TARGET_PLATFORM == PLATFORM_MAC || TARGET_PLATFORM == PLATFORM_IOS
+    return lite_obs_encoder::encoder_id::VIDEOTOOLBOX;
+#else
+    return lite_obs_encoder::encoder_id::FFMPEG_H264_HW;
+#endif
+}
+
+std::shared_ptr<lite_obs_encoder> lite_obs_private::create_video_encoder(int vb)
+{
+    auto encoder = std::make_shared<lite_obs_encoder>(video_encoder_id(sw_encoder, codec), vb, 0);
+    encoder->lite_obs_encoder_set_x264_settings(x264);
+    encoder->lite_obs_encoder_set_core_video(video);
+    return encoder;
+}
+
+/* outputs share the audio encoders and, unless they are renditions, the one
+ * video encoder. the first output to start creates them with its bitrates */
+bool lite_obs_private::start_output(const std::shared_ptr<lite_obs_output> &out, const std::shared_ptr<lite_obs_encoder> &venc, int ab)
+{
+    /* one audio encoder per track, each one reading its own mix */
+    bool multi_track = out->i_multi_track();
+    size_t slots = multi_track ? MAX_AUDIO_MIXES : 1;
+    size_t tracks = multi_track ? audio_tracks : 1;
+    for (size_t i = 0; i < tracks; i++) {
+        if (!audio_encoders[i]) {
+            audio_encoders[i] = std::make_shared<lite_obs_encoder>(audio_encoder_id(acodec), ab, i);
+            audio_encoders[i]->lite_obs_encoder_set_opus_settings(opus);
+            audio_encoders[i]->lite_obs_encoder_set_core_audio(audio);
+        }
+    }
+
+    out->lite_obs_output_set_video_encoder(venc);
+    for (size_t i = 0; i < slots; i++)
+        out->lite_obs_output_set_audio_encoder(i < tracks ? audio_encoders[i] : nullptr, i);
+    return out->lite_obs_output_start();
+}
+
 bool lite_obs_internal::lite_obs_start_output(output_type type, void *output_info, int vb, int ab, const lite_obs_output_callbak &callback)
 {
     if (!d_ptr->output)
     {
-        std::shared_ptr<lite_obs_output> output = nullptr;
-        switch (type) {
-        case output_type::rtmp:
-            output = std::make_shared<rtmp_stream_output>();
-            break;
-        case output_type::srt:
-            output = std::make_shared<mpeg_ts_output>();
-            break;
-        case output_type::file:
-            output = std::make_shared<lite_ffmpeg_mux>();
-            break;
-        case output_type::android_aoa:
-            output = std::make_shared<aoa_output>();
-            break;
-        case output_type::iOS_usb:
-            output = std::make_shared<iOS_muxd_output>();
-            break;
-        default:
-            break;
-        }
-
+        auto output = create_output(type);
         if (!output)
             return false;
 
@@ -263,22 +403,12 @@ bool lite_obs_internal::lite_obs_start_output(output_type type, void *output_inf
 
         d_ptr->output = output;
         d_ptr->output->set_output_signal_callback(callback);
-
-#if TARGET_PLATFORM == PLATFORM_ANDROID
-        d_ptr->video_encoder = std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::MEDIACODEC, vb, 0);
-#elif TARGET_PLATFORM == PLATFORM_MAC || TARGET_PLATFORM == PLATFORM_IOS
-        d_ptr->video_encoder = std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::VIDEOTOOLBOX, vb, 0);
-#else
-        d_ptr->video_encoder = std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::FFMPEG_H264_HW, vb, 0);
-#endif
-        d_ptr->video_encoder->lite_obs_encoder_set_core_video(d_ptr->video);
-        d_ptr->audio_encoder = std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::AAC, ab, 0);
-        d_ptr->audio_encoder->lite_obs_encoder_set_core_audio(d_ptr->audio);
     }
 
-    d_ptr->output->lite_obs_output_set_video_encoder(d_ptr->video_encoder);
-    d_ptr->output->lite_obs_output_set_audio_encoder(d_ptr->audio_encoder, 0);
-    return d_ptr->output->lite_obs_output_start();
+    if (!d_ptr->video_encoder)
+        d_ptr->video_encoder = d_ptr->create_video_encoder(vb);
+
+    return d_ptr->start_output(d_ptr->output, d_ptr->video_encoder, ab);
 }
 
 void lite_obs_internal::lite_obs_stop_output()
@@ -289,51 +419,156 @@ void lite_obs_internal::lite_obs_stop_output()
     d_ptr->output->lite_obs_output_stop();
 }
 
+int lite_obs_private::add_shared_output(output_type type, void *output_info, const lite_obs_output_callbak &callback,
+                                        const std::shared_ptr<lite_obs_encoder> &venc, int vb, int ab)
+{
+    auto out = create_output(type);
+    if (!out)
+        return -1;
+
+    out->i_set_output_info(output_info);
+    if (!out->lite_obs_output_create(video, audio))
+        return -1;
+
+    out->set_output_signal_callback(callback);
+
+    if (!video_encoder)
+        video_encoder = create_video_encoder(vb);
+
+    if (!start_output(out, venc ? venc : video_encoder, ab)) {
+        out->lite_obs_output_destroy();
+        return -1;
+    }
+
+    int id = next_output_id++;
+    shared_outputs.emplace(id, out);
+    if (venc)
+        rendition_encoders.emplace(id, venc);
+    return id;
+}
+
+int lite_obs_internal::lite_obs_start_output2(output_type type, void *output_info, int vb, int ab, const lite_obs_output_callbak &callback)
+{
+    return d_ptr->add_shared_output(type, output_info, callback, nullptr, vb, ab);
+}
+
+/* from here on every video encoder forces its keyframes onto the video
+ * clock. scene cuts, intra refresh and the periodic gop are turned off when
+ * an encoder is opened, so the running ones are recreated */
+int lite_obs_internal::lite_obs_start_rendition(output_type type, void *output_info, uint32_t width, uint32_t height, int vb, int ab, const lite_obs_output_callbak &callback)
+{
+    if (!width || !height)
+        return -1;
+
+    if (!d_ptr->x264.aligned_keyframes) {
+        d_ptr->x264.aligned_keyframes = true;
+        d_ptr->for_each_video_encoder([&](const std::shared_ptr<lite_obs_encoder> &encoder){
+            encoder->lite_obs_encoder_set_x264_settings(d_ptr->x264);
+            encoder->lite_obs_encoder_reset_encoder_impl(video_encoder_id(d_ptr->sw_encoder, d_ptr->codec), true);
+        });
+    }
+
+    auto video = d_ptr->video->lite_obs_add_rendition(width, height);
+    if (!video)
+        return -1;
+
+    auto encoder = d_ptr->create_video_encoder(vb);
+    encoder->lite_obs_encoder_set_video(video);
+    int id = d_ptr->add_shared_output(type, output_info, callback, encoder, vb, ab);
+    if (id < 0) {
+        d_ptr->video->lite_obs_remove_rendition(video);
+        return -1;
+    }
+
+    d_ptr->rendition_videos.emplace(id, video);
+    return id;
+}
+
+void lite_obs_internal::lite_obs_stop_output2(int output_id)
+{
+    auto iter = d_ptr->shared_outputs.find(output_id);
+    if (iter == d_ptr->shared_outputs.end())
+        return;
+
+    auto output = iter->second;
+    d_ptr->shared_outputs.erase(iter);
+
+    /* stops the output and waits for it to finish, the encoders keep
+     * running as long as another output uses them */
+    output->lite_obs_output_destroy();
+    d_ptr->rendition_encoders.erase(output_id);
+
+    auto video = d_ptr->rendition_videos.find(output_id);
+    if (video != d_ptr->rendition_videos.end()) {
+        d_ptr->video->lite_obs_remove_rendition(video->second);
+        d_ptr->rendition_videos.erase(video);
+    }
+}
+
 lite_obs_media_source_internal *lite_obs_internal::lite_obs_create_source(source_type type)
 {
     auto source = std::make_shared<lite_obs_source>(type, d_ptr->video, d_ptr->audio);
     auto source_wrapper = new lite_obs_media_source_internal;
     source_wrapper->d_ptr->internal_source = source;
-    source_wrapper->d_ptr->core_ptr = reinterpret_cast<uintptr_t>(d_ptr);
+    source_wrapper->d_ptr->graph = d_ptr->graph;
     d_ptr->sources.emplace(source_wrapper);
-
-    {
-        std::lock_guard<std::recursive_mutex> lock(lite_obs_source::sources_mutex);
-        auto &sources = lite_obs_source::sources[reinterpret_cast<uintptr_t>(d_ptr)];
-        sources.push_back(source);
-    }
+    d_ptr->graph->add(source);
 
     return source_wrapper;
 }
 
 void lite_obs_internal::lite_obs_destroy_source(lite_obs_media_source_internal *source)
 {
-    {
-        std::lock_guard<std::recursive_mutex> lock(lite_obs_source::sources_mutex);
-        auto &sources = lite_obs_source::sources[reinterpret_cast<uintptr_t>(d_ptr)];
-        sources.erase(std::find(sources.begin(), sources.end(), source->d_ptr->internal_source));
-    }
+    d_ptr->graph->remove(source->d_ptr->internal_source);
 
     d_ptr->sources.erase(source);
     delete source;
 }
 
 
-void lite_obs_internal::lite_obs_reset_encoder(bool sw)
+void lite_obs_internal::lite_obs_reset_encoder(bool sw, video_codec codec, const lite_obs_x264_settings *x264)
 {
-    if (d_ptr->video_encoder) {
-        if (sw)
-            d_ptr->video_encoder->lite_obs_encoder_reset_encoder_impl(lite_obs_encoder::encoder_id::X264);
-        else {
-#if TARGET_PLATFORM == PLATFORM_ANDROID
-            d_ptr->video_encoder->lite_obs_encoder_reset_encoder_impl(lite_obs_encoder::encoder_id::MEDIACODEC);
-#elif TARGET_PLATFORM == PLATFORM_MAC || TARGET_PLATFORM == PLATFORM_IOS
-            d_ptr->video_encoder->lite_obs_encoder_reset_encoder_impl(lite_obs_encoder::encoder_id::VIDEOTOOLBOX);
-#else
-            d_ptr->video_encoder->lite_obs_encoder_reset_encoder_impl(lite_obs_encoder::encoder_id::FFMPEG_H264_HW);
-#endif
-        }
+    x264_encoder_settings settings{};
+    if (x264) {
+        if (x264->preset && *x264->preset)
+            settings.preset = x264->preset;
+        if (x264->tune)
+            settings.tune = x264->tune;
+        settings.threads = x264->threads > 0 ? x264->threads : 0;
+        settings.lookahead = x264->lookahead > 0 ? x264->lookahead : 0;
+        settings.bframes = x264->bframes > 0 ? x264->bframes : 0;
+        if (x264->keyint_sec > 0)
+            settings.keyint_sec = x264->keyint_sec;
+        settings.crf = x264->crf > 0 ? x264->crf : 0;
+        settings.vbv_buffer_kbit = x264->vbv_buffer_kbit > 0 ? x264->vbv_buffer_kbit : 0;
+        settings.low_latency = x264->low_latency != 0;
+        if (x264->x264_opts)
+            settings.x264_opts = x264->x264_opts;
     }
+
+    settings.aligned_keyframes = d_ptr->x264.aligned_keyframes;
+    d_ptr->x264 = settings;
+    d_ptr->sw_encoder = sw;
+    d_ptr->codec = codec;
+    bool software = sw || codec != VIDEO_CODEC_H264;
+    d_ptr->for_each_video_encoder([&](const std::shared_ptr<lite_obs_encoder> &encoder){
+        encoder->lite_obs_encoder_set_x264_settings(settings);
+        /* recreate a running software encoder so the settings take effect */
+        encoder->lite_obs_encoder_reset_encoder_impl(video_encoder_id(sw, codec), software);
+    });
+}
+
+void lite_obs_internal::lite_obs_reset_encoder(bool sw, const lite_obs_x264_settings *x264)
+{
+    lite_obs_reset_encoder(sw, d_ptr->codec, x264);
+}
+
+void lite_obs_internal::lite_obs_reset_encoder(bool sw)
+{
+    d_ptr->sw_encoder = sw;
+    d_ptr->for_each_video_encoder([&](const std::shared_ptr<lite_obs_encoder> &encoder){
+        encoder->lite_obs_encoder_reset_encoder_impl(video_encoder_id(sw, d_ptr->codec));
+    });
 }
 
 
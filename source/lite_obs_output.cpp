@@ -10,6 +10,7 @@
 #include "lite-obs/media-io/video_output.h"
 #include "lite-obs/media-io/audio_output.h"
 
+#include <string.h>
 #include <atomic>
 #include <thread>
 #include <mutex>
@@ -24,7 +25,7 @@ struct lite_obs_output_private
     std::atomic_bool data_active{};
     int64_t video_offset{};
     int64_t audio_offsets[MAX_AUDIO_MIXES]{};
-    int64_t highest_audio_ts{};
+    int64_t highest_audio_ts[MAX_AUDIO_MIXES]{};
     int64_t highest_video_ts{};
     std::thread end_data_capture_thread;
     os_event_t *stopping_event{};
@@ -212,7 +213,7 @@ bool lite_obs_output::lite_obs_output_start()
     }
 
     if (lite_obs_output_actual_start()) {
-        if (d_ptr->signal_callback.start) {
+        if (d_ptr->signal_callback.starting) {
             d_ptr->signal_callback.starting(d_ptr->signal_callback.opaque);
         }
         return true;
@@ -292,15 +293,13 @@ void lite_obs_output::lite_obs_output_set_video_encoder(std::shared_ptr<lite_obs
 
 void lite_obs_output::lite_obs_output_set_audio_encoder(std::shared_ptr<lite_obs_encoder> encoder, size_t idx)
 {
-    if (!encoder)
-        return;
-
-    if (encoder->lite_obs_encoder_type() != obs_encoder_type::OBS_ENCODER_AUDIO) {
+    if (encoder && encoder->lite_obs_encoder_type() != obs_encoder_type::OBS_ENCODER_AUDIO) {
         blog(LOG_WARNING, "obs_output_set_audio_encoder: encoder passed is not a audio encoder");
         return;
     }
 
-    if (idx > 0) {
+    if (idx >= MAX_AUDIO_MIXES || (idx > 0 && !i_multi_track())) {
+        blog(LOG_WARNING, "obs_output_set_audio_encoder: idx %zu out of range for this output", idx);
         return;
     }
 
@@ -308,10 +307,16 @@ void lite_obs_output::lite_obs_output_set_audio_encoder(std::shared_ptr<lite_obs
     if (audio_encoder == encoder)
         return;
 
+    if (d_ptr->active) {
+        blog(LOG_WARNING, "obs_output_set_audio_encoder: cannot change audio encoders while the output is active");
+        return;
+    }
+
     if (audio_encoder)
         audio_encoder->obs_encoder_remove_output(shared_from_this());
 
-    encoder->obs_encoder_add_output(shared_from_this());
+    if (encoder)
+        encoder->obs_encoder_add_output(shared_from_this());
     d_ptr->audio_encoders[idx] = encoder;
 }
 
@@ -322,9 +327,25 @@ std::shared_ptr<lite_obs_encoder> lite_obs_output::lite_obs_output_get_video_enc
 
 std::shared_ptr<lite_obs_encoder> lite_obs_output::lite_obs_output_get_audio_encoder(size_t idx)
 {
+    if (idx >= MAX_AUDIO_MIXES)
+        return nullptr;
+
     return d_ptr->audio_encoders[idx].lock();
 }
 
+/* tracks are the audio encoder slots filled in from 0 up, a gap ends them */
+size_t lite_obs_output::lite_obs_output_audio_tracks()
+{
+    if (!i_multi_track())
+        return 1;
+
+    size_t tracks = 0;
+    while (tracks < MAX_AUDIO_MIXES && d_ptr->audio_encoders[tracks].lock())
+        tracks++;
+
+    return tracks ? tracks : 1;
+}
+
 uint64_t lite_obs_output::lite_obs_output_get_total_bytes()
 {
     return i_get_total_bytes();
@@ -479,12 +500,15 @@ bool lite_obs_output::lite_obs_output_initialize_encoders()
             return false;
     }
     if (i_has_audio()) {
-        auto ac = d_ptr->audio_encoders[0].lock();
-        if (!ac)
-            return false;
+        size_t tracks = lite_obs_output_audio_tracks();
+        for (size_t i = 0; i < tracks; i++) {
+            auto ac = d_ptr->audio_encoders[i].lock();
+            if (!ac)
+                return false;
 
-        if (!ac->obs_encoder_initialize())
-            return false;
+            if (!ac->obs_encoder_initialize())
+                return false;
+        }
     }
 
     return true;
@@ -544,12 +568,13 @@ void lite_obs_output::reset_packet_data()
 {
     d_ptr->received_audio = false;
     d_ptr->received_video = false;
-    d_ptr->highest_audio_ts = 0;
     d_ptr->highest_video_ts = 0;
     d_ptr->video_offset = 0;
 
-    for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
+    for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+        d_ptr->highest_audio_ts[i] = 0;
         d_ptr->audio_offsets[i] = 0;
+    }
 
     free_packets();
 }
@@ -682,11 +707,27 @@ void lite_obs_output::set_higher_ts(std::shared_ptr<encoder_packet> packet)
         if (d_ptr->highest_video_ts < packet->dts_usec)
             d_ptr->highest_video_ts = packet->dts_usec;
     } else {
-        if (d_ptr->highest_audio_ts < packet->dts_usec)
-            d_ptr->highest_audio_ts = packet->dts_usec;
+        if (d_ptr->highest_audio_ts[packet->track_idx] < packet->dts_usec)
+            d_ptr->highest_audio_ts[packet->track_idx] = packet->dts_usec;
     }
 }
 
+/* audio packets carry the encoder they came from, the track is whichever
+ * slot that encoder sits in on this output */
+size_t lite_obs_output::get_track_index(const std::shared_ptr<encoder_packet> &packet)
+{
+    auto encoder = packet->encoder.lock();
+    if (!encoder)
+        return 0;
+
+    for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+        if (d_ptr->audio_encoders[i].lock() == encoder)
+            return i;
+    }
+
+    return 0;
+}
+
 auto lite_obs_output::find_first_packet_type_idx(obs_encoder_type type, size_t audio_idx)
 {
     for (auto iter = d_ptr->interleaved_packets.begin(); iter != d_ptr->interleaved_packets.end(); iter++) {
@@ -748,7 +789,7 @@ auto lite_obs_output::prune_premature_packets()
     auto video = *video_idx;
     auto duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
 
-    size_t audio_mixes = 1;
+    size_t audio_mixes = lite_obs_output_audio_tracks();
     for (size_t i = 0; i < audio_mixes; i++) {
         auto audio_idx = find_first_packet_type_idx(obs_encoder_type::OBS_ENCODER_AUDIO, i);
         if (audio_idx == d_ptr->interleaved_packets.end()) {
@@ -815,16 +856,19 @@ bool lite_obs_output::prune_interleaved_packets()
     return true;
 }
 
-bool lite_obs_output::get_audio_and_video_packets(std::shared_ptr<encoder_packet> &video, std::shared_ptr<encoder_packet> &audio)
+bool lite_obs_output::get_audio_and_video_packets(std::shared_ptr<encoder_packet> &video, std::shared_ptr<encoder_packet> audio[MAX_AUDIO_MIXES])
 {
     video = find_first_packet_type(obs_encoder_type::OBS_ENCODER_VIDEO, 0);
     if (!video)
         d_ptr->received_video = false;
 
-    audio = find_first_packet_type(obs_encoder_type::OBS_ENCODER_AUDIO, 0);
-    if (!audio) {
-        d_ptr->received_audio = false;
-        return false;
+    size_t audio_mixes = lite_obs_output_audio_tracks();
+    for (size_t i = 0; i < audio_mixes; i++) {
+        audio[i] = find_first_packet_type(obs_encoder_type::OBS_ENCODER_AUDIO, i);
+        if (!audio[i]) {
+            d_ptr->received_audio = false;
+            return false;
+        }
     }
 
     if (!video) {
@@ -836,16 +880,18 @@ bool lite_obs_output::get_audio_and_video_packets(std::shared_ptr<encoder_packet
 
 bool lite_obs_output::initialize_interleaved_packets()
 {
-    std::shared_ptr<encoder_packet> video{}, audio{}, last_audio{};
+    std::shared_ptr<encoder_packet> video{}, audio[MAX_AUDIO_MIXES]{};
+    size_t audio_mixes = lite_obs_output_audio_tracks();
 
     if (!get_audio_and_video_packets(video, audio))
         return false;
 
-    last_audio = find_last_packet_type(obs_encoder_type::OBS_ENCODER_AUDIO, 0);
-
-    if (last_audio->dts_usec < video->dts_usec) {
-        d_ptr->received_audio = false;
-        return false;
+    for (size_t i = 0; i < audio_mixes; i++) {
+        auto last_audio = find_last_packet_type(obs_encoder_type::OBS_ENCODER_AUDIO, i);
+        if (last_audio->dts_usec < video->dts_usec) {
+            d_ptr->received_audio = false;
+            return false;
+        }
     }
 
     /* clear out excess starting audio if it hasn't been already */
@@ -858,10 +904,12 @@ bool lite_obs_output::initialize_interleaved_packets()
 
     /* get new offsets */
     d_ptr->video_offset = video->pts;
-    d_ptr->audio_offsets[0] = audio->dts;
+    for (size_t i = 0; i < audio_mixes; i++)
+        d_ptr->audio_offsets[i] = audio[i]->dts;
 
     /* subtract offsets from highest TS offset variables */
-    d_ptr->highest_audio_ts -= audio->dts_usec;
+    for (size_t i = 0; i < audio_mixes; i++)
+        d_ptr->highest_audio_ts[i] -= audio[i]->dts_usec;
     d_ptr->highest_video_ts -= video->dts_usec;
 
     /* apply new offsets to all existing packet DTS/PTS values */
@@ -882,12 +930,20 @@ void lite_obs_output::resort_interleaved_packets()
     old_array.clear();
 }
 
+/* video has to wait for every audio track, otherwise a track that runs a
+ * little behind the others could still produce packets older than it */
 bool lite_obs_output::has_higher_opposing_ts(std::shared_ptr<encoder_packet> packet)
 {
-    if (packet->type == obs_encoder_type::OBS_ENCODER_VIDEO)
-        return d_ptr->highest_audio_ts > packet->dts_usec;
-    else
+    if (packet->type == obs_encoder_type::OBS_ENCODER_VIDEO) {
+        size_t audio_mixes = lite_obs_output_audio_tracks();
+        for (size_t i = 0; i < audio_mixes; i++) {
+            if (d_ptr->highest_audio_ts[i] <= packet->dts_usec)
+                return false;
+        }
+        return true;
+    } else {
         return d_ptr->highest_video_ts > packet->dts_usec;
+    }
 }
 
 void lite_obs_output::send_interleaved()
@@ -914,9 +970,6 @@ void lite_obs_output::interleave_packets_internal(const std::shared_ptr<encoder_
     if (!d_ptr->active)
         return;
 
-    if (packet->type == obs_encoder_type::OBS_ENCODER_AUDIO)
-        packet->track_idx = 0;
-
     std::lock_guard<std::mutex> lock(d_ptr->interleaved_mutex);
 
     /* if first video frame is not a keyframe, discard until received */
@@ -926,11 +979,11 @@ void lite_obs_output::interleave_packets_internal(const std::shared_ptr<encoder_
     }
 
     auto was_started = d_ptr->received_audio && d_ptr->received_video;
-    auto out = std::make_shared<encoder_packet>();
-    *out = *packet;
-    out->data = std::make_shared<std::vector<uint8_t>>();
-    out->data->resize(packet->data->size());
-    memcpy(out->data->data(), packet->data->data(), packet->data->size());
+    /* the payload is never written once the packet is sent, only the
+     * fields this output adjusts need a copy */
+    auto out = encoder_packet_create(*packet);
+    if (out->type == obs_encoder_type::OBS_ENCODER_AUDIO)
+        out->track_idx = get_track_index(packet);
 
     if (was_started)
         apply_interleaved_packet_offset(out);
@@ -965,10 +1018,15 @@ void lite_obs_output::interleave_packets(void *data, const std::shared_ptr<encod
 void lite_obs_output::default_encoded_callback_internal(const std::shared_ptr<encoder_packet> &packet)
 {
     if (d_ptr->data_active) {
-        if (packet->type == obs_encoder_type::OBS_ENCODER_AUDIO)
-            packet->track_idx = 0;
-
-        i_encoded_packet(packet);
+        /* the packet may be shared with other outputs of the same encoder,
+         * tag a copy of it with this output's track */
+        if (packet->type == obs_encoder_type::OBS_ENCODER_AUDIO) {
+            auto out = encoder_packet_create(*packet);
+            out->track_idx = get_track_index(packet);
+            i_encoded_packet(out);
+        } else {
+            i_encoded_packet(packet);
+        }
 
         if (packet->type == obs_encoder_type::OBS_ENCODER_VIDEO)
             d_ptr->total_frames++;
@@ -1087,9 +1145,12 @@ void lite_obs_output::hook_data_capture(bool encoded, bool has_video, bool has_a
         encoded_callback = (has_video && has_audio) ? lite_obs_output::interleave_packets : lite_obs_output::default_encoded_callback;
 
         if (has_audio) {
-            auto ac = d_ptr->audio_encoders[0].lock();
-            if (ac)
-                ac->obs_encoder_start(encoded_callback, this);
+            size_t tracks = lite_obs_output_audio_tracks();
+            for (size_t i = 0; i < tracks; i++) {
+                auto ac = d_ptr->audio_encoders[i].lock();
+                if (ac)
+                    ac->obs_encoder_start(encoded_callback, this);
+            }
         }
         if (has_video) {
             auto vo = d_ptr->video.lock();
@@ -1186,6 +1247,8 @@ void lite_obs_output::log_frame_info()
         blog(LOG_INFO,
              "Output: Total drawn frames: %u (%u attempted)", drawn - lagged, drawn);
 
+    blog(LOG_INFO, "Output: Video readback latency: %u frames", core_video->readback_latency());
+
     if (drawn && lagged)
         blog(LOG_INFO, "Output: Number of lagged frames due to rendering lag/stalls: %u (%0.1f%%)", lagged, percentage_lagged);
     if (total && dropped)
@@ -1204,9 +1267,11 @@ void lite_obs_output::end_data_capture_thread_internal()
                 video_encoder->obs_encoder_stop(encoded_callback, this);
         }
         if (i_has_audio()) {
-            auto audio_encoder = d_ptr->audio_encoders[0].lock();
-            if (audio_encoder) {
-                audio_encoder->obs_encoder_stop(encoded_callback,this);
+            size_t tracks = lite_obs_output_audio_tracks();
+            for (size_t i = 0; i < tracks; i++) {
+                auto audio_encoder = d_ptr->audio_encoders[i].lock();
+                if (audio_encoder)
+                    audio_encoder->obs_encoder_stop(encoded_callback, this);
             }
         }
     } else {
@@ -1275,8 +1340,10 @@ void lite_obs_output::lite_obs_output_remove_encoder(std::shared_ptr<lite_obs_en
     if (d_ptr->video_encoder.lock() == encoder)
         d_ptr->video_encoder.reset();
     else {
-        if (d_ptr->audio_encoders[0].lock() == encoder)
-            d_ptr->audio_encoders[0].reset();
+        for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+            if (d_ptr->audio_encoders[i].lock() == encoder)
+                d_ptr->audio_encoders[i].reset();
+        }
     }
 }
 
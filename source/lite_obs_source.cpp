@@ -1,18 +1,26 @@
 #include "lite-obs/lite_obs_source.h"
-#include "lite-obs/util/circlebuf.h"
+#include "lite-obs/util/audio_ring.h"
 #include "lite-obs/util/log.h"
 #include "lite-obs/util/threading.h"
 #include "lite-obs/media-io/audio_resampler.h"
 #include "lite-obs/media-io/audio_output.h"
+#include "lite-obs/media-io/audio_math.h"
 #include "lite-obs/media-io/video_info.h"
 #include "lite-obs/media-io/video_matrices.h"
 #include "lite-obs/lite_obs_core_audio.h"
 #include "lite-obs/lite_obs_core_video.h"
+#include "lite-obs/lite_obs_source_transform.h"
 #include "lite-obs/graphics/gs_texture.h"
 #include "lite-obs/graphics/gs_subsystem.h"
 #include "lite-obs/graphics/gs_program.h"
+#include <string.h>
+#include <assert.h>
 #include <mutex>
 #include <list>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 #include <inttypes.h>
 
 /* maximum timestamp variance in nanoseconds */
@@ -247,6 +255,25 @@ struct async_frame {
     bool used{};
 };
 
+struct borrowed_frame_release {
+    void (*callback)(void *opaque){};
+    void *opaque{};
+    bool done{};
+};
+
+/* least squares line through recent async frame arrivals against their
+ * frame number, older ones weigh less. x is counted back from the newest
+ * frame and y from origin, so the sums stay small */
+struct async_pace_fit {
+    uint64_t origin{};
+    uint32_t points{};
+    double w{};
+    double x{};
+    double y{};
+    double xx{};
+    double xy{};
+};
+
 struct lite_source_private
 {
     std::weak_ptr<lite_obs_core_video> core_video{};
@@ -266,7 +293,12 @@ struct lite_source_private
     uint64_t next_audio_sys_ts_min{};
     uint64_t last_frame_ts{};
     uint64_t last_sys_timestamp{};
+    uint64_t sys_tick_interval{};
+    std::atomic_uint64_t async_jitter_ns{};
     bool async_rendered{};
+    uint64_t async_arrival_ts{};
+    async_pace_fit async_pacing{};
+    uint64_t async_shown_sys_ts{};
 
     /* audio */
     bool audio_failed{};
@@ -276,7 +308,7 @@ struct lite_source_private
     bool user_muted{};
     bool muted{};
     uint64_t audio_ts{};
-    circlebuf audio_input_buf[MAX_AUDIO_CHANNELS]{};
+    audio_ring audio_input_buf[MAX_AUDIO_CHANNELS]{};
     size_t last_audio_input_buf_size{};
     float *audio_output_buf[MAX_AUDIO_MIXES][MAX_AUDIO_CHANNELS]{};
     resample_info sample_info{};
@@ -286,12 +318,25 @@ struct lite_source_private
     std::list<audio_cb_info> audio_cb_list{};
     lite_obs_source::lite_obs_source_audio_frame audio_data{};
     size_t audio_storage_size{};
-    uint32_t audio_mixers{};
+    std::atomic_uint32_t audio_mixers{};
+    /* mixes audio_output_buf holds audio for after the last tick */
+    uint32_t audio_active_mixes{};
     float user_volume{};
     float volume{};
     int64_t sync_offset{};
     int64_t last_sync_offset{};
 
+    /* release callbacks of borrowed frames in the order the frames came in.
+     * a frame can finish early (dropped while an older one is still being
+     * uploaded), its callback then waits for the older ones. callbacks due
+     * wait in borrowed_ready and are called with no lock held, one thread at
+     * a time, so one may hand the next frame to this source */
+    std::mutex borrowed_mutex{};
+    std::deque<borrowed_frame_release> borrowed_releases{};
+    uint64_t borrowed_first_id{};
+    std::vector<borrowed_frame_release> borrowed_ready{};
+    bool borrowed_calling{};
+
     /* async video data */
     std::vector<std::shared_ptr<gs_texture>> async_textures{};
     std::shared_ptr<gs_texture> async_texure_out{};
@@ -310,6 +355,9 @@ struct lite_source_private
     std::list<std::shared_ptr<async_frame>> async_cache{};
     std::list<std::shared_ptr<lite_obs_source::lite_obs_source_video_frame>> async_frames{};
     std::mutex async_mutex{};
+    /* the thread holding async_mutex, frames it drops are released after it
+     * lets go */
+    std::atomic<std::thread::id> async_owner{};
     uint32_t async_width{};
     uint32_t async_height{};
     uint32_t async_cache_width{};
@@ -328,24 +376,7 @@ struct lite_source_private
     glm::mat4x4 draw_transform{1};
     glm::mat4x4 box_transform{1};
 
-    struct render_box_info {
-        int x{};
-        int y{};
-        int width{};
-        int height{};
-        source_aspect_ratio_mode mode{};
-    };
-
-    enum class transform_type {
-        pos,
-        scale,
-        flip,
-        rotate,
-        box,
-        reset,
-    };
-    std::mutex transform_setting_mutex{};
-    std::list<std::pair<transform_type, void*>> transform_setting_list{};
+    source_transform_queue transform_queue{};
     std::shared_ptr<gs_texture> crop_cache_texture{};
 
     lite_source_private(source_type t) {
@@ -375,7 +406,10 @@ struct lite_source_private
     }
 
     ~lite_source_private() {
-        graphics_subsystem::make_current(core_video.lock()->graphics());
+        /* a source without core video never created a texture */
+        auto c_v = core_video.lock();
+        if (c_v)
+            graphics_subsystem::make_current(c_v->graphics());
 
         if (async_texure_out)
             async_texure_out.reset();
@@ -390,7 +424,7 @@ struct lite_source_private
         for (int i = 0; i < MAX_AV_PLANES; i++)
             free((void *)audio_data.data[i]);
         for (int i = 0; i < MAX_AUDIO_CHANNELS; i++)
-            circlebuf_free(&audio_input_buf[i]);
+            audio_input_buf[i].free();
 
         resampler.reset();
         free(audio_output_buf[0][0]);
@@ -402,14 +436,69 @@ struct lite_source_private
         cur_async_frame.reset();
     }
 
+    uint64_t add_borrowed_release(void (*callback)(void *), void *opaque) {
+        std::lock_guard<std::mutex> locker(borrowed_mutex);
+        borrowed_releases.push_back({callback, opaque, false});
+        return borrowed_first_id + borrowed_releases.size() - 1;
+    }
+
+    void release_borrowed(uint64_t id) {
+        {
+            std::lock_guard<std::mutex> locker(borrowed_mutex);
+            borrowed_releases[id - borrowed_first_id].done = true;
+            while (!borrowed_releases.empty() && borrowed_releases.front().done) {
+                borrowed_ready.push_back(borrowed_releases.front());
+                borrowed_releases.pop_front();
+                borrowed_first_id++;
+            }
+        }
+
+        if (async_owner.load() != std::this_thread::get_id())
+            call_borrowed_releases();
+    }
+
+    void call_borrowed_releases() {
+        std::unique_lock<std::mutex> locker(borrowed_mutex);
+        if (borrowed_calling)
+            return;
+
+        borrowed_calling = true;
+        while (!borrowed_ready.empty()) {
+            std::vector<borrowed_frame_release> ready;
+            ready.swap(borrowed_ready);
+            locker.unlock();
+            for (auto &release : ready)
+                release.callback(release.opaque);
+            locker.lock();
+        }
+        borrowed_calling = false;
+    }
+
+    void lock_async() {
+        async_mutex.lock();
+        async_owner = std::this_thread::get_id();
+    }
+
+    void unlock_async() {
+        async_owner = std::thread::id();
+        async_mutex.unlock();
+        call_borrowed_releases();
+    }
+
     void reset_transform() {
         pos = glm::vec3{};
         scale = glm::vec3{1};
         rot = 0.f;
     }
 };
-std::recursive_mutex lite_obs_source::sources_mutex{};
-std::map<uintptr_t, std::list<std::shared_ptr<lite_obs_source>>> lite_obs_source::sources{};
+
+/* async_mutex held for a scope, see async_owner */
+struct async_locker {
+    explicit async_locker(lite_source_private *source) : d(source) { d->lock_async(); }
+    ~async_locker() { d->unlock_async(); }
+
+    lite_source_private *d;
+};
 
 lite_obs_source::lite_obs_source(source_type type, std::shared_ptr<lite_obs_core_video> c_v, std::shared_ptr<lite_obs_core_audio> c_a)
 {
@@ -529,7 +618,10 @@ bool lite_obs_source::process_audio(const lite_obs_source_audio_frame &audio)
     return ret;
 }
 
-/* maximum buffer size */
+/* each channel's input ring starts at two ticks, which is what a source
+ * normally holds, and grows up to the limit. audio that would not fit is
+ * dropped */
+#define MIN_BUF_SIZE (2 * AUDIO_OUTPUT_FRAMES * sizeof(float))
 #define MAX_BUF_SIZE (1000 * AUDIO_OUTPUT_FRAMES * sizeof(float))
 
 /* time threshold in nanoseconds to ensure audio timing is as seamless as
@@ -539,8 +631,7 @@ bool lite_obs_source::process_audio(const lite_obs_source_audio_frame &audio)
 void lite_obs_source::reset_audio_data(uint64_t os_time)
 {
     for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
-        if (d_ptr->audio_input_buf[i].size)
-            circlebuf_pop_front(&d_ptr->audio_input_buf[i], NULL, d_ptr->audio_input_buf[i].size);
+        d_ptr->audio_input_buf[i].clear();
     }
 
     d_ptr->last_audio_input_buf_size = 0;
@@ -609,6 +700,12 @@ void lite_obs_source::output_audio_data_internal(const audio_data *data)
 
     d_ptr->audio_buf_mutex.lock();
 
+    /* the rings are only allocated for the channels the output uses */
+    for (size_t i = 0; i < channels; i++) {
+        if (!d_ptr->audio_input_buf[i].capacity())
+            d_ptr->audio_input_buf[i].init(MIN_BUF_SIZE, MAX_BUF_SIZE);
+    }
+
     if (d_ptr->next_audio_sys_ts_min == in.timestamp) {
         push_back = true;
 
@@ -656,12 +753,11 @@ void lite_obs_source::output_audio_push_back(const struct audio_data *in, size_t
     size_t size = in->frames * sizeof(float);
 
     /* do not allow the circular buffers to become too big */
-    if ((d_ptr->audio_input_buf[0].size + size) > MAX_BUF_SIZE)
+    if (size > d_ptr->audio_input_buf[0].space())
         return;
 
     for (size_t i = 0; i < channels; i++)
-        circlebuf_push_back(&d_ptr->audio_input_buf[i], in->data[i],
-                            size);
+        d_ptr->audio_input_buf[i].push_back(in->data[i], size);
 
     /* reset audio input buffer size to ensure that audio doesn't get
      * perpetually cut */
@@ -678,12 +774,12 @@ void lite_obs_source::output_audio_place(const struct audio_data *in, size_t cha
     size_t buf_placement = get_buf_placement((uint32_t)sample_rate, in->timestamp - d_ptr->audio_ts) * sizeof(float);
 
     /* do not allow the circular buffers to become too big */
-    if ((buf_placement + size) > MAX_BUF_SIZE)
+    if ((buf_placement + size) > d_ptr->audio_input_buf[0].limit())
         return;
 
     for (size_t i = 0; i < channels; i++) {
-        circlebuf_place(&d_ptr->audio_input_buf[i], buf_placement, in->data[i], size);
-        circlebuf_pop_back(&d_ptr->audio_input_buf[i], NULL, d_ptr->audio_input_buf[i].size - (buf_placement + size));
+        d_ptr->audio_input_buf[i].place(buf_placement, in->data[i], size);
+        d_ptr->audio_input_buf[i].pop_back(d_ptr->audio_input_buf[i].size() - (buf_placement + size));
     }
 
     d_ptr->last_audio_input_buf_size = 0;
@@ -719,62 +815,55 @@ float lite_obs_source::get_source_volume()
 
 void lite_obs_source::multiply_output_audio(size_t mix, size_t channels, float vol)
 {
-    float *out = d_ptr->audio_output_buf[mix][0];
-    float *end = out + AUDIO_OUTPUT_FRAMES * channels;
-
-    while (out < end)
-        *(out++) *= vol;
+    audio_multiply_floats(d_ptr->audio_output_buf[mix][0], AUDIO_OUTPUT_FRAMES * channels, vol);
 }
 
-void lite_obs_source::apply_audio_volume(uint32_t mixers, size_t channels, size_t sample_rate)
+/* returns the mixes that are left with audio in them, a muted source has
+ * nothing to mix anywhere */
+uint32_t lite_obs_source::apply_audio_volume(uint32_t mixers, size_t channels, size_t sample_rate)
 {
     auto vol = get_source_volume();
     if (vol == 1.0f)
-        return;
+        return mixers;
 
-    if (vol == 0.0f || mixers == 0) {
-        memset(d_ptr->audio_output_buf[0][0], 0, AUDIO_OUTPUT_FRAMES * sizeof(float) * MAX_AUDIO_CHANNELS * MAX_AUDIO_MIXES);
-        return;
-    }
+    if (vol == 0.0f)
+        return 0;
 
     for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
-        uint32_t mix_and_val = (1 << mix);
-        if ((d_ptr->audio_mixers & mix_and_val) != 0 && (mixers & mix_and_val) != 0)
+        if ((mixers & (1 << mix)) != 0)
             multiply_output_audio(mix, channels, vol);
     }
+
+    return mixers;
 }
 
 void lite_obs_source::audio_source_tick(uint32_t mixers, size_t channels, size_t sample_rate, size_t size)
 {
     d_ptr->audio_buf_mutex.lock();
 
-    if (d_ptr->audio_input_buf[0].size < size) {
+    if (d_ptr->audio_input_buf[0].size() < size) {
         d_ptr->audio_pending = true;
         d_ptr->audio_buf_mutex.unlock();
         return;
     }
 
     for (size_t ch = 0; ch < channels; ch++)
-        circlebuf_peek_front(&d_ptr->audio_input_buf[ch], d_ptr->audio_output_buf[0][ch], size);
+        d_ptr->audio_input_buf[ch].peek_front(d_ptr->audio_output_buf[0][ch], size);
 
     d_ptr->audio_buf_mutex.unlock();
 
+    /* mixes that are not in use are left alone instead of being cleared,
+     * mix_audio skips them */
+    uint32_t active = d_ptr->audio_mixers & mixers;
     for (size_t mix = 1; mix < MAX_AUDIO_MIXES; mix++) {
-        uint32_t mix_and_val = (1 << mix);
-
-        if ((d_ptr->audio_mixers & mix_and_val) == 0 || (mixers & mix_and_val) == 0) {
-            memset(d_ptr->audio_output_buf[mix][0], 0, size * channels);
+        if ((active & (1 << mix)) == 0)
             continue;
-        }
 
         for (size_t ch = 0; ch < channels; ch++)
             memcpy(d_ptr->audio_output_buf[mix][ch], d_ptr->audio_output_buf[0][ch], size);
     }
 
-    if ((d_ptr->audio_mixers & 1) == 0 || (mixers & 1) == 0)
-        memset(d_ptr->audio_output_buf[0][0], 0, size * channels);
-
-    apply_audio_volume(mixers, channels, sample_rate);
+    d_ptr->audio_active_mixes = apply_audio_volume(active, channels, sample_rate);
     d_ptr->audio_pending = false;
 }
 
@@ -811,7 +900,7 @@ bool lite_obs_source::audio_buffer_insuffient(size_t sample_rate, uint64_t min_t
 
     auto size = total_floats * sizeof(float);
 
-    if (d_ptr->audio_input_buf[0].size < size) {
+    if (d_ptr->audio_input_buf[0].size() < size) {
         d_ptr->audio_pending = true;
         return true;
     }
@@ -821,37 +910,31 @@ bool lite_obs_source::audio_buffer_insuffient(size_t sample_rate, uint64_t min_t
 
 void lite_obs_source::mix_audio(struct audio_output_data *mixes, size_t channels, size_t sample_rate, struct ts_info *ts)
 {
-    d_ptr->audio_buf_mutex.lock();
-    if (d_ptr->audio_output_buf[0][0] && d_ptr->audio_ts) {
-        size_t total_floats = AUDIO_OUTPUT_FRAMES;
-        size_t start_point = 0;
+    std::lock_guard<std::mutex> locker(d_ptr->audio_buf_mutex);
+    if (!d_ptr->audio_output_buf[0][0] || !d_ptr->audio_ts)
+        return;
 
-        if (d_ptr->audio_ts < ts->start || ts->end <= d_ptr->audio_ts)
-            return;
+    size_t total_floats = AUDIO_OUTPUT_FRAMES;
+    size_t start_point = 0;
 
-        if (d_ptr->audio_ts != ts->start) {
-            start_point = conv_time_to_frames(sample_rate, d_ptr->audio_ts - ts->start);
-            if (start_point == AUDIO_OUTPUT_FRAMES)
-                return;
+    if (d_ptr->audio_ts < ts->start || ts->end <= d_ptr->audio_ts)
+        return;
 
-            total_floats -= start_point;
-        }
+    if (d_ptr->audio_ts != ts->start) {
+        start_point = conv_time_to_frames(sample_rate, d_ptr->audio_ts - ts->start);
+        if (start_point == AUDIO_OUTPUT_FRAMES)
+            return;
 
-        for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-            for (size_t ch = 0; ch < channels; ch++) {
-                float *mix = mixes[mix_idx].data[ch];
-                float *aud = d_ptr->audio_output_buf[mix_idx][ch];
-                float *end;
+        total_floats -= start_point;
+    }
 
-                mix += start_point;
-                end = aud + total_floats;
+    for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
+        if ((d_ptr->audio_active_mixes & (1 << mix_idx)) == 0)
+            continue;
 
-                while (aud < end)
-                    *(mix++) += *(aud++);
-            }
-        }
+        for (size_t ch = 0; ch < channels; ch++)
+            audio_mix_floats(mixes[mix_idx].data[ch] + start_point, d_ptr->audio_output_buf[mix_idx][ch], total_floats);
     }
-    d_ptr->audio_buf_mutex.unlock();
 }
 
 bool lite_obs_source::discard_if_stopped(size_t channels)
@@ -860,7 +943,7 @@ bool lite_obs_source::discard_if_stopped(size_t channels)
     size_t size;
 
     last_size = d_ptr->last_audio_input_buf_size;
-    size = d_ptr->audio_input_buf[0].size;
+    size = d_ptr->audio_input_buf[0].size();
 
     if (!size)
         return false;
@@ -874,7 +957,7 @@ bool lite_obs_source::discard_if_stopped(size_t channels)
         }
 
         for (size_t ch = 0; ch < channels; ch++)
-            circlebuf_pop_front(&d_ptr->audio_input_buf[ch], NULL, d_ptr->audio_input_buf[ch].size);
+            d_ptr->audio_input_buf[ch].clear();
 
         d_ptr->pending_stop = false;
         d_ptr->audio_ts = 0;
@@ -888,11 +971,11 @@ bool lite_obs_source::discard_if_stopped(size_t channels)
 
 void lite_obs_source::ignore_audio(size_t channels, size_t sample_rate)
 {
-    size_t num_floats = d_ptr->audio_input_buf[0].size / sizeof(float);
+    size_t num_floats = d_ptr->audio_input_buf[0].size() / sizeof(float);
 
     if (num_floats) {
         for (size_t ch = 0; ch < channels; ch++)
-            circlebuf_pop_front(&d_ptr->audio_input_buf[ch], NULL, d_ptr->audio_input_buf[ch].size);
+            d_ptr->audio_input_buf[ch].clear();
 
         d_ptr->last_audio_input_buf_size = 0;
         d_ptr->audio_ts += (uint64_t)num_floats * 1000000000ULL / (uint64_t)sample_rate;
@@ -908,7 +991,7 @@ void lite_obs_source::discard_audio(int total_buffering_ticks, size_t channels,
     }
 
     if (d_ptr->audio_ts < (ts->start - 1)) {
-        if (d_ptr->audio_pending && d_ptr->audio_input_buf[0].size < MAX_AUDIO_SIZE && discard_if_stopped(channels))
+        if (d_ptr->audio_pending && d_ptr->audio_input_buf[0].size() < MAX_AUDIO_SIZE && discard_if_stopped(channels))
             return;
 
         if (total_buffering_ticks == MAX_BUFFERING_TICKS)
@@ -928,7 +1011,7 @@ void lite_obs_source::discard_audio(int total_buffering_ticks, size_t channels,
 
     auto size = total_floats * sizeof(float);
 
-    if (d_ptr->audio_input_buf[0].size < size) {
+    if (d_ptr->audio_input_buf[0].size() < size) {
         if (discard_if_stopped(channels))
             return;
 
@@ -937,7 +1020,7 @@ void lite_obs_source::discard_audio(int total_buffering_ticks, size_t channels,
     }
 
     for (size_t ch = 0; ch < channels; ch++)
-        circlebuf_pop_front(&d_ptr->audio_input_buf[ch], NULL, size);
+        d_ptr->audio_input_buf[ch].pop_front(nullptr, size);
 
     d_ptr->last_audio_input_buf_size = 0;
 
@@ -965,9 +1048,9 @@ void lite_obs_source::clean_cache()
 
 void lite_obs_source::free_async_cache()
 {
-    d_ptr->async_cache.clear();
-    d_ptr->async_frames.clear();
     d_ptr->cur_async_frame.reset();
+    d_ptr->async_frames.clear();
+    d_ptr->async_cache.clear();
 }
 
 bool lite_obs_source::async_texture_changed(const lite_obs_source_video_frame *frame)
@@ -988,7 +1071,7 @@ void lite_obs_source::output_video_internal(const lite_obs_source_video_frame *f
         return;
     }
 
-    std::lock_guard<std::mutex> locker(d_ptr->async_mutex);
+    async_locker locker(d_ptr.get());
 
     if (d_ptr->async_frames.size() >= MAX_ASYNC_FRAMES) {
         free_async_cache();
@@ -1006,6 +1089,13 @@ void lite_obs_source::output_video_internal(const lite_obs_source_video_frame *f
     d_ptr->async_cache_format = format;
     d_ptr->async_cache_full_range = frame->full_range;
 
+    /* the newest queued frame will never be shown, hand its cache slot to
+     * this one instead of filling another */
+    if (async_frame_superseded(frame->timestamp)) {
+        remove_async_frame(d_ptr->async_frames.back());
+        d_ptr->async_frames.pop_back();
+    }
+
     std::shared_ptr<lite_obs_source_video_frame> new_frame{};
     for (auto iter = d_ptr->async_cache.begin(); iter != d_ptr->async_cache.end(); iter++) {
         auto &af = *iter;
@@ -1037,7 +1127,40 @@ void lite_obs_source::output_video_internal(const lite_obs_source_video_frame *f
     d_ptr->async_active = true;
 }
 
-void lite_obs_source::lite_source_output_video(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES], video_format format, video_range_type range, video_colorspace color_space, uint32_t width, uint32_t height)
+/* borrowed frames skip async_cache, they are queued as they are and free
+ * the caller's buffer when the last reference is dropped */
+void lite_obs_source::push_async_frame(const std::shared_ptr<lite_obs_source_video_frame> &frame)
+{
+    async_locker locker(d_ptr.get());
+
+    if (d_ptr->async_frames.size() >= MAX_ASYNC_FRAMES) {
+        free_async_cache();
+        d_ptr->last_frame_ts = 0;
+        return;
+    }
+
+    if (async_texture_changed(frame.get())) {
+        free_async_cache();
+        d_ptr->async_cache_width = frame->width;
+        d_ptr->async_cache_height = frame->height;
+    }
+
+    d_ptr->async_cache_format = frame->format;
+    d_ptr->async_cache_full_range = frame->full_range;
+
+    /* a superseded borrowed frame goes back to the caller right away */
+    if (async_frame_superseded(frame->timestamp)) {
+        remove_async_frame(d_ptr->async_frames.back());
+        d_ptr->async_frames.pop_back();
+    }
+
+    clean_cache();
+
+    d_ptr->async_frames.push_back(frame);
+    d_ptr->async_active = true;
+}
+
+bool lite_obs_source::prepare_video_frame(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES], video_format format, video_range_type range, video_colorspace color_space, uint32_t width, uint32_t height)
 {
     auto flip = line_size[0] < 0 && line_size[1] == 0;
     for (size_t i = 0; i < MAX_AV_PLANES; i++) {
@@ -1063,20 +1186,62 @@ void lite_obs_source::lite_source_output_video(const uint8_t *video_data[MAX_AV_
 
         if (!success) {
             d_ptr->video_frame->format = video_format::VIDEO_FORMAT_NONE;
-            return;
+            return false;
         }
     }
 
     if (d_ptr->video_frame->format == video_format::VIDEO_FORMAT_NONE)
-        return;
+        return false;
 
-    d_ptr->video_frame->timestamp = os_gettime_ns();
+    d_ptr->video_frame->timestamp = async_frame_timestamp(os_gettime_ns());
     d_ptr->video_frame->width = width;
     d_ptr->video_frame->height = height;
     d_ptr->video_frame->flip = flip;
 
     d_ptr->video_frame->full_range = format_is_yuv(d_ptr->video_frame->format) ? d_ptr->video_frame->full_range : true;
-    output_video_internal(d_ptr->video_frame.get());
+    return true;
+}
+
+void lite_obs_source::lite_source_output_video(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES], video_format format, video_range_type range, video_colorspace color_space, uint32_t width, uint32_t height)
+{
+    if (prepare_video_frame(video_data, line_size, format, range, color_space, width, height))
+        output_video_internal(d_ptr->video_frame.get());
+}
+
+void lite_obs_source::lite_source_output_video_borrowed(const uint8_t *video_data[MAX_AV_PLANES], const int line_size[MAX_AV_PLANES], video_format format, video_range_type range, video_colorspace color_space, uint32_t width, uint32_t height, void (*release_cb)(void *), void *opaque)
+{
+    /* nobody to tell when we are done with the planes, take a copy */
+    if (!release_cb) {
+        lite_source_output_video(video_data, line_size, format, range, color_space, width, height);
+        return;
+    }
+
+    /* from here on every way out drops the frame, which releases the
+     * buffer */
+    auto id = d_ptr->add_borrowed_release(release_cb, opaque);
+    auto frame = std::make_shared<lite_obs_source_video_frame>();
+    frame->release = [d = d_ptr.get(), id]() { d->release_borrowed(id); };
+
+    if (!prepare_video_frame(video_data, line_size, format, range, color_space, width, height))
+        return;
+
+    auto src = d_ptr->video_frame.get();
+    for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+        frame->data[i] = src->data[i];
+        frame->linesize[i] = src->linesize[i];
+    }
+    frame->width = src->width;
+    frame->height = src->height;
+    frame->timestamp = src->timestamp;
+    frame->format = src->format;
+    frame->full_range = src->full_range;
+    frame->flip = src->flip;
+    frame->flip_h = src->flip_h;
+    memcpy(frame->color_matrix, src->color_matrix, sizeof(frame->color_matrix));
+    memcpy(frame->color_range_min, src->color_range_min, sizeof(frame->color_range_min));
+    memcpy(frame->color_range_max, src->color_range_max, sizeof(frame->color_range_max));
+
+    push_async_frame(frame);
 }
 
 void lite_obs_source::lite_source_output_video(int texture_id, uint32_t texture_width, uint32_t texture_height)
@@ -1103,8 +1268,6 @@ void lite_obs_source::lite_source_output_video(int texture_id, uint32_t texture_
 
 void lite_obs_source::lite_source_output_video(const uint8_t *img_data, uint32_t img_width, uint32_t img_height)
 {
-    std::lock_guard<std::mutex> locker(d_ptr->sync_mutex);
-
     if (d_ptr->type & source_type::SOURCE_ASYNC) {
         return;
     }
@@ -1115,9 +1278,26 @@ void lite_obs_source::lite_source_output_video(const uint8_t *img_data, uint32_t
         return;
     }
 
-    graphics_subsystem::make_current(d_ptr->core_video.lock()->graphics());
-    d_ptr->sync_texture = gs_texture_create(img_width, img_height, gs_color_format::GS_RGBA, GS_DYNAMIC);
-    d_ptr->sync_texture->gs_texture_set_image(img_data, img_width * 4, false);
+    /* the graphics thread renders the sources with the context current,
+     * take the context before sync_mutex the same way */
+    graphics_subsystem::make_current(c_v->graphics());
+
+    {
+        std::lock_guard<std::mutex> locker(d_ptr->sync_mutex);
+
+        /* keep uploading into the same texture, it is only recreated when the
+         * size changes or it was replaced by an external texture */
+        auto &tex = d_ptr->sync_texture;
+        if (!tex || !tex->gs_texture_is_dynamic() ||
+                tex->gs_texture_get_width() != img_width ||
+                tex->gs_texture_get_height() != img_height ||
+                tex->gs_texture_get_color_format() != gs_color_format::GS_RGBA) {
+            tex = gs_texture_create(img_width, img_height, gs_color_format::GS_RGBA, GS_DYNAMIC);
+        }
+
+        if (tex)
+            tex->gs_texture_set_image(img_data, img_width * 4, false);
+    }
     graphics_subsystem::done_current();
 }
 
@@ -1142,16 +1322,132 @@ void lite_obs_source::remove_async_frame(const std::shared_ptr<lite_obs_source_v
     }
 }
 
+#define ASYNC_PACING_DECAY (1.0 - 1.0 / 256)
+#define ASYNC_PACING_MIN_POINTS 8
+
+/* frames are stamped when they arrive, which is as uneven as their
+ * delivery, and a window alone only delays that. with a window set, a frame
+ * arriving within it of where the recent arrivals put it gets that time
+ * instead, so frames keep the source's cadence and each is due at its own
+ * video tick. one arriving outside the window starts the fit over */
+uint64_t lite_obs_source::async_frame_timestamp(uint64_t arrival)
+{
+    auto &pace = d_ptr->async_pacing;
+    const uint64_t jitter = d_ptr->async_jitter_ns;
+    const uint64_t last_arrival = d_ptr->async_arrival_ts;
+    d_ptr->async_arrival_ts = arrival;
+
+    uint64_t paced = arrival;
+    bool fitted = false;
+    if (jitter && last_arrival && arrival > last_arrival && pace.points >= ASYNC_PACING_MIN_POINTS) {
+        const double det = pace.w * pace.xx - pace.x * pace.x;
+        if (det > 0) {
+            const double slope = (pace.w * pace.xy - pace.x * pace.y) / det;
+            const double offset = (pace.y - slope * pace.x) / pace.w;
+            const double predicted = (double)pace.origin + offset + slope;
+            if (predicted > 0) {
+                paced = (uint64_t)predicted;
+                fitted = uint64_diff(arrival, paced) <= jitter;
+            }
+        }
+    }
+
+    if (!jitter || !last_arrival || arrival <= last_arrival || (pace.points >= ASYNC_PACING_MIN_POINTS && !fitted)) {
+        pace = {};
+        pace.origin = arrival;
+        paced = arrival;
+    } else {
+        /* move the origin to this frame */
+        const double dy = (double)((int64_t)paced - (int64_t)pace.origin);
+        pace.xx += -2 * pace.x + pace.w;
+        pace.x -= pace.w;
+        pace.xy -= pace.y + pace.x * dy;
+        pace.y -= pace.w * dy;
+        pace.origin = paced;
+
+        pace.w *= ASYNC_PACING_DECAY;
+        pace.x *= ASYNC_PACING_DECAY;
+        pace.y *= ASYNC_PACING_DECAY;
+        pace.xx *= ASYNC_PACING_DECAY;
+        pace.xy *= ASYNC_PACING_DECAY;
+    }
+
+    const double y = (double)((int64_t)arrival - (int64_t)pace.origin);
+    pace.w += 1;
+    pace.y += y;
+    pace.points++;
+    return fitted ? paced : arrival;
+}
+
+/* a queued frame is due once its timestamp plus the jitter window has
+ * passed. with a window set, a frame also goes out at the video tick nearest
+ * to where the one before it went out plus their distance, as long as that
+ * holds it at least half a tick less than the window. a cadence sitting
+ * right on a tick boundary then keeps the ticks it started with instead of
+ * flipping between two ticks on the slightest noise */
+uint64_t lite_obs_source::async_frame_due(uint64_t timestamp)
+{
+    const uint64_t jitter = d_ptr->async_jitter_ns;
+    const uint64_t half_tick = d_ptr->sys_tick_interval / 2;
+    const uint64_t due = timestamp + jitter;
+    if (!jitter || !half_tick || !d_ptr->last_frame_ts || !d_ptr->async_shown_sys_ts || timestamp <= d_ptr->last_frame_ts)
+        return due;
+
+    const uint64_t earliest = due > half_tick ? due - half_tick : 0;
+    uint64_t locked = d_ptr->async_shown_sys_ts + (timestamp - d_ptr->last_frame_ts);
+    locked = locked > half_tick ? locked - half_tick : 0;
+    return std::max(earliest, std::min(due, locked));
+}
+
+/* when a new frame is due at the same video tick as the newest queued one,
+ * that one would be dropped at the tick anyway. ticks are predicted from the
+ * last two update_async_video calls, so this only kicks in once the video
+ * clock is running */
+bool lite_obs_source::async_frame_superseded(uint64_t timestamp)
+{
+    if (d_ptr->async_frames.empty() || !d_ptr->last_sys_timestamp || !d_ptr->sys_tick_interval)
+        return false;
+
+    const uint64_t interval = d_ptr->sys_tick_interval;
+    const uint64_t prev_due = async_frame_due(d_ptr->async_frames.back()->timestamp);
+
+    uint64_t tick = d_ptr->last_sys_timestamp + interval;
+    if (prev_due > tick)
+        tick += (prev_due - tick + interval - 1) / interval * interval;
+
+    return async_frame_due(timestamp) <= tick;
+}
+
 bool lite_obs_source::ready_async_frame(uint64_t sys_time)
 {
-    auto next_frame = d_ptr->async_frames.front();
-    while (d_ptr->async_frames.size() > 1) {
-        d_ptr->async_frames.pop_front();
-        remove_async_frame(next_frame);
-        next_frame = d_ptr->async_frames.front();
+    auto &frames = d_ptr->async_frames;
+    const uint64_t jitter = d_ptr->async_jitter_ns;
+    const uint64_t target = sys_time > jitter ? sys_time - jitter : 0;
+
+    /* timestamps jumped (clock reset, source restarted), pacing against
+     * them is meaningless so just show the newest frame */
+    if (uint64_diff(frames.back()->timestamp, target) > MAX_TS_VAR) {
+        while (frames.size() > 1) {
+            remove_async_frame(frames.front());
+            frames.pop_front();
+        }
+
+        d_ptr->last_frame_ts = frames.front()->timestamp;
+        d_ptr->async_shown_sys_ts = sys_time;
+        return true;
     }
 
-    d_ptr->last_frame_ts = next_frame->timestamp;
+    if (async_frame_due(frames.front()->timestamp) > sys_time)
+        return false;
+
+    /* show the newest frame that is due, the ones before it are late */
+    while (frames.size() > 1 && async_frame_due((*std::next(frames.begin()))->timestamp) <= sys_time) {
+        remove_async_frame(frames.front());
+        frames.pop_front();
+    }
+
+    d_ptr->last_frame_ts = frames.front()->timestamp;
+    d_ptr->async_shown_sys_ts = sys_time;
     return true;
 }
 
@@ -1164,8 +1460,10 @@ std::shared_ptr<lite_obs_source::lite_obs_source_video_frame> lite_obs_source::g
         auto frame = d_ptr->async_frames.front();
         d_ptr->async_frames.pop_front();
 
-        if (!d_ptr->last_frame_ts)
+        if (!d_ptr->last_frame_ts) {
             d_ptr->last_frame_ts = frame->timestamp;
+            d_ptr->async_shown_sys_ts = sys_time;
+        }
 
         return frame;
     }
@@ -1410,9 +1708,11 @@ bool lite_obs_source::set_async_texture_size(const std::shared_ptr<lite_obs_sour
     return d_ptr->async_textures[0] != NULL;
 }
 
-void lite_obs_source::async_tick(uint64_t sys_time)
+/* drops the frame of the last tick and picks the one for this tick, null
+ * when the last one stays on screen */
+std::shared_ptr<lite_obs_source::lite_obs_source_video_frame> lite_obs_source::select_async_frame(uint64_t sys_time)
 {
-    d_ptr->async_mutex.lock();
+    async_locker locker(d_ptr.get());
 
     if (d_ptr->cur_async_frame) {
         remove_async_frame(d_ptr->cur_async_frame);
@@ -1421,11 +1721,17 @@ void lite_obs_source::async_tick(uint64_t sys_time)
 
     d_ptr->cur_async_frame = get_closest_frame(sys_time);
 
+    if (d_ptr->last_sys_timestamp && sys_time > d_ptr->last_sys_timestamp)
+        d_ptr->sys_tick_interval = sys_time - d_ptr->last_sys_timestamp;
     d_ptr->last_sys_timestamp = sys_time;
-    d_ptr->async_mutex.unlock();
+    return d_ptr->cur_async_frame;
+}
 
-    if (d_ptr->cur_async_frame)
-        d_ptr->async_update_texture = set_async_texture_size(d_ptr->cur_async_frame);
+void lite_obs_source::async_tick(uint64_t sys_time)
+{
+    auto frame = select_async_frame(sys_time);
+    if (frame)
+        d_ptr->async_update_texture = set_async_texture_size(frame);
 
     d_ptr->async_rendered = false;
 }
@@ -1433,10 +1739,10 @@ void lite_obs_source::async_tick(uint64_t sys_time)
 std::shared_ptr<lite_obs_source::lite_obs_source_video_frame> lite_obs_source::get_frame()
 {
     std::shared_ptr<lite_obs_source::lite_obs_source_video_frame> frame = nullptr;
-    d_ptr->async_mutex.lock();
+    d_ptr->lock_async();
     frame = d_ptr->cur_async_frame;
     d_ptr->cur_async_frame = nullptr;
-    d_ptr->async_mutex.unlock();
+    d_ptr->unlock_async();
 
     return frame;
 }
@@ -1637,86 +1943,77 @@ void lite_obs_source::render_texture(std::shared_ptr<gs_texture> texture)
         return;
 
     // render box transform will override all the transform settings
-    auto update_transform = [=](lite_source_private::transform_type type, void *data){
-        if (type == lite_source_private::transform_type::box) {
-            d_ptr->reset_transform();
-
-            auto box = (lite_source_private::render_box_info *)data;
+    auto apply_render_box = [&](const source_render_box &box){
+        d_ptr->reset_transform();
+
+        // update crop texture
+        auto tex_width = texture->gs_texture_get_width();
+        auto tex_height = texture->gs_texture_get_height();
+        bool need_crop = box.mode == source_aspect_ratio_mode::KEEP_ASPECT_RATIO_BY_EXPANDING
+                         && ((int)tex_width != box.width || (int)tex_height != box.height);
+        if (need_crop) {
+            uint32_t cx = 0, cy = 0;
+            calc_size(tex_width, tex_height, box.width, box.height, cx, cy);
+            if (d_ptr->crop_cache_texture && (d_ptr->crop_cache_texture->gs_texture_get_width() != cx || d_ptr->crop_cache_texture->gs_texture_get_height() != cy))
+                d_ptr->crop_cache_texture.reset();
+
+            d_ptr->crop_cache_texture = gs_texture_create(cx, cy, gs_color_format::GS_RGBA, GS_RENDER_TARGET);
+        }
 
-            // update crop texture
-            auto tex_width = texture->gs_texture_get_width();
-            auto tex_height = texture->gs_texture_get_height();
-            bool need_crop = box->mode == source_aspect_ratio_mode::KEEP_ASPECT_RATIO_BY_EXPANDING
-                             && ((int)tex_width != box->width || (int)tex_height != box->height);
-            if (need_crop) {
+        if (!need_crop) {
+            if (box.mode == source_aspect_ratio_mode::KEEP_ASPECT_RATIO) {
                 uint32_t cx = 0, cy = 0;
-                calc_size(tex_width, tex_height, box->width, box->height, cx, cy);
-                if (d_ptr->crop_cache_texture && (d_ptr->crop_cache_texture->gs_texture_get_width() != cx || d_ptr->crop_cache_texture->gs_texture_get_height() != cy))
-                    d_ptr->crop_cache_texture.reset();
-
-                d_ptr->crop_cache_texture = gs_texture_create(cx, cy, gs_color_format::GS_RGBA, GS_RENDER_TARGET);
-            }
-
-            if (!need_crop) {
-                if (box->mode == source_aspect_ratio_mode::KEEP_ASPECT_RATIO) {
-                    uint32_t cx = 0, cy = 0;
-                    scaled_to(tex_width, tex_height, box->width, box->height, box->mode, cx, cy);
-                    d_ptr->pos = glm::vec3(box->x + (box->width - cx) / 2, box->y + (box->height -cy) / 2, 0.0f);
-                    d_ptr->scale = glm::vec3((float)cx / (float)tex_width, (float)cy / (float)tex_height, 1.0f);
-                } else {
-                    d_ptr->pos = glm::vec3(box->x, box->y, 0.0f);
-                    if (box->mode == source_aspect_ratio_mode::IGNORE_ASPECT_RATIO) {
-                        d_ptr->scale = glm::vec3((float)box->width / (float)tex_width, (float)box->height / (float)tex_height, 1.0f);
-                    }
-                }
+                scaled_to(tex_width, tex_height, box.width, box.height, box.mode, cx, cy);
+                d_ptr->pos = glm::vec3(box.x + (box.width - cx) / 2, box.y + (box.height -cy) / 2, 0.0f);
+                d_ptr->scale = glm::vec3((float)cx / (float)tex_width, (float)cy / (float)tex_height, 1.0f);
             } else {
-                d_ptr->pos = glm::vec3(box->x, box->y, 0.0f);
-                d_ptr->scale = glm::vec3((float)box->width / (float)d_ptr->crop_cache_texture->gs_texture_get_width(),
-                                         (float)box->height / (float)d_ptr->crop_cache_texture->gs_texture_get_height(),
-                                         1.0f);
+                d_ptr->pos = glm::vec3(box.x, box.y, 0.0f);
+                if (box.mode == source_aspect_ratio_mode::IGNORE_ASPECT_RATIO) {
+                    d_ptr->scale = glm::vec3((float)box.width / (float)tex_width, (float)box.height / (float)tex_height, 1.0f);
+                }
             }
+        } else {
+            d_ptr->pos = glm::vec3(box.x, box.y, 0.0f);
+            d_ptr->scale = glm::vec3((float)box.width / (float)d_ptr->crop_cache_texture->gs_texture_get_width(),
+                                     (float)box.height / (float)d_ptr->crop_cache_texture->gs_texture_get_height(),
+                                     1.0f);
+        }
+    };
 
-            delete box;
-        } if (type == lite_source_private::transform_type::reset) {
-            d_ptr->reset_transform();
+    auto pending = d_ptr->transform_queue.drain();
+    if (!pending.empty()) {
+        if (pending.reset_crop)
             d_ptr->crop_cache_texture.reset();
-        } else {
-            auto vec2 = (glm::vec2 *)data;
+
+        if (pending.has_box)
+            apply_render_box(pending.box);
+        else if (pending.reset)
+            d_ptr->reset_transform();
+        update_draw_transform(texture);
+
+        bool flip = pending.flip_x != 1.0f || pending.flip_y != 1.0f;
+        if (pending.has_scale || flip || pending.has_rotate) {
             auto tl = top_left();
-            if (type == lite_source_private::transform_type::pos) {
-                auto offset = (*vec2) - glm::vec2(tl.x, tl.y);
-                d_ptr->pos += offset;
-            } else if (type == lite_source_private::transform_type::scale) {
+            if (pending.has_scale) {
                 glm::vec2 v(d_ptr->scale.x < 0 ? -1.f : 1.f, d_ptr->scale.y < 0 ? -1.f : 1.f);
-                d_ptr->scale = *vec2 * v;
-            } else if (type == lite_source_private::transform_type::flip) {
-                d_ptr->scale = d_ptr->scale * (*vec2);
-            } else if (type == lite_source_private::transform_type::rotate) {
-                auto rot = d_ptr->rot + vec2->x;
-                if (rot >= 360.0f)
-                    rot -= 360.0f;
-                else if (rot <= -360.0f)
-                    rot += 360.0f;
-
-                d_ptr->rot = rot;
+                d_ptr->scale = glm::vec2(pending.scale_x, pending.scale_y) * v;
             }
-            if (type != lite_source_private::transform_type::pos) {
-                update_draw_transform(texture);
-                set_item_top_left(tl);
-            }
-            delete vec2;
+            if (flip)
+                d_ptr->scale = d_ptr->scale * glm::vec2(pending.flip_x, pending.flip_y);
+            if (pending.has_rotate)
+                d_ptr->rot = fmodf(d_ptr->rot + pending.rot, 360.0f);
+
+            update_draw_transform(texture);
+            set_item_top_left(tl);
         }
-    };
 
-    {
-        std::lock_guard<std::mutex> locker(d_ptr->transform_setting_mutex);
-        for (auto iter = d_ptr->transform_setting_list.begin(); iter != d_ptr->transform_setting_list.end(); iter++) {
-            const auto &pair = *iter;
-            update_transform(pair.first, pair.second);
+        if (pending.has_pos) {
+            update_draw_transform(texture);
+            auto tl = top_left();
+            d_ptr->pos += glm::vec2(pending.pos_x, pending.pos_y) - glm::vec2(tl.x, tl.y);
         }
-        d_ptr->transform_setting_list.clear();
-        update_draw_transform(texture);
     }
+    update_draw_transform(texture);
 
     if (render_crop_texture(texture))
         texture = d_ptr->crop_cache_texture;
@@ -1760,22 +2057,23 @@ void lite_obs_source::render()
 
 void lite_obs_source::lite_source_set_pos(float x, float y)
 {
-    std::lock_guard<std::mutex> locker(d_ptr->transform_setting_mutex);
-    auto pos = new glm::vec2(x, y);
-    d_ptr->transform_setting_list.emplace_back(lite_source_private::transform_type::pos, pos);
+    source_transform_command cmd{source_transform_type::pos, {}};
+    cmd.vec = {x, y};
+    d_ptr->transform_queue.push(cmd);
 }
 
 void lite_obs_source::lite_source_set_scale(float width_scale, float height_scale)
 {
-    std::lock_guard<std::mutex> locker(d_ptr->transform_setting_mutex);
-    auto pos = new glm::vec2(width_scale, height_scale);
-    d_ptr->transform_setting_list.emplace_back(lite_source_private::transform_type::scale, pos);
+    source_transform_command cmd{source_transform_type::scale, {}};
+    cmd.vec = {width_scale, height_scale};
+    d_ptr->transform_queue.push(cmd);
 }
 
 void lite_obs_source::lite_source_set_rotate(float rot)
 {
-    std::lock_guard<std::mutex> locker(d_ptr->transform_setting_mutex);
-    d_ptr->transform_setting_list.emplace_back(lite_source_private::transform_type::rotate, new glm::vec2(rot, 0.f));
+    source_transform_command cmd{source_transform_type::rotate, {}};
+    cmd.vec = {rot, 0.f};
+    d_ptr->transform_queue.push(cmd);
 }
 
 void lite_obs_source::lite_source_set_render_box(int x, int y, int width, int height, source_aspect_ratio_mode mode)
@@ -1785,18 +2083,29 @@ void lite_obs_source::lite_source_set_render_box(int x, int y, int width, int he
         return;
     }
 
-    auto box = new lite_source_private::render_box_info{x, y, width, height, mode};
-    d_ptr->transform_setting_list.emplace_back(lite_source_private::transform_type::box, box);
+    source_transform_command cmd{source_transform_type::box, {}};
+    cmd.box = {x, y, width, height, mode};
+    d_ptr->transform_queue.push(cmd);
 }
 
 void lite_obs_source::lite_source_set_flip(bool flip_h, bool flip_v)
 {
-    std::lock_guard<std::mutex> locker(d_ptr->transform_setting_mutex);
-    d_ptr->transform_setting_list.emplace_back(lite_source_private::transform_type::flip, new glm::vec2(flip_h ? -1.0f : 1.0f, flip_v ? -1.0f : 1.0f));
+    source_transform_command cmd{source_transform_type::flip, {}};
+    cmd.vec = {flip_h ? -1.0f : 1.0f, flip_v ? -1.0f : 1.0f};
+    d_ptr->transform_queue.push(cmd);
 }
 
 void lite_obs_source::lite_source_reset_transform()
 {
-    std::lock_guard<std::mutex> locker(d_ptr->transform_setting_mutex);
-    d_ptr->transform_setting_list.emplace_back(lite_source_private::transform_type::reset, nullptr);
+    d_ptr->transform_queue.push({source_transform_type::reset, {}});
+}
+
+void lite_obs_source::lite_source_set_jitter_window(uint32_t ms)
+{
+    d_ptr->async_jitter_ns = (uint64_t)ms * 1000000ULL;
+}
+
+void lite_obs_source::lite_source_set_audio_mixers(uint32_t mixers)
+{
+    d_ptr->audio_mixers = mixers & ((1 << MAX_AUDIO_MIXES) - 1);
 }
@@ -0,0 +1,87 @@
+#include "lite-obs/lite_obs_source_graph.h"
+
+#include <algorithm>
+#include <atomic>
+
+lite_obs_source_graph::lite_obs_source_graph()
+{
+    current = std::make_shared<const source_list>();
+}
+
+lite_obs_source_graph::~lite_obs_source_graph()
+{
+
+}
+
+std::shared_ptr<const lite_obs_source_graph::source_list> lite_obs_source_graph::snapshot() const
+{
+    return std::atomic_load_explicit(&current, std::memory_order_acquire);
+}
+
+void lite_obs_source_graph::publish(std::shared_ptr<const source_list> list)
+{
+    std::atomic_store_explicit(&current, std::move(list), std::memory_order_release);
+}
+
+void lite_obs_source_graph::add(const std::shared_ptr<lite_obs_source> &source)
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+    auto list = std::make_shared<source_list>(*current);
+    list->push_back(source);
+    publish(std::move(list));
+}
+
+void lite_obs_source_graph::remove(const std::shared_ptr<lite_obs_source> &source)
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+    auto iter = std::find(current->begin(), current->end(), source);
+    if (iter == current->end())
+        return;
+
+    auto list = std::make_shared<source_list>(*current);
+    list->erase(list->begin() + (iter - current->begin()));
+    publish(std::move(list));
+}
+
+void lite_obs_source_graph::move(const std::shared_ptr<lite_obs_source> &source, order_movement movement)
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+    auto iter = std::find(current->begin(), current->end(), source);
+    if (iter == current->end())
+        return;
+
+    size_t index = iter - current->begin();
+    size_t target = index;
+
+    switch (movement) {
+    case MOVE_UP:
+        if (index + 1 < current->size())
+            target = index + 1;
+        break;
+    case MOVE_DOWN:
+        if (index > 0)
+            target = index - 1;
+        break;
+    case MOVE_TOP:
+        target = current->size() - 1;
+        break;
+    case MOVE_BOTTOM:
+        target = 0;
+        break;
+    default:
+        break;
+    }
+
+    if (target == index)
+        return;
+
+    auto list = std::make_shared<source_list>(*current);
+    std::swap((*list)[index], (*list)[target]);
+    publish(std::move(list));
+}
+
+void lite_obs_source_graph::clear()
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+    publish(std::make_shared<const source_list>());
+}
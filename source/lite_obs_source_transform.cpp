@@ -0,0 +1,115 @@
+#include "lite-obs/lite_obs_source_transform.h"
+
+void source_transform_pending::merge(const source_transform_command &cmd)
+{
+    switch (cmd.type) {
+    case source_transform_type::reset:
+        *this = source_transform_pending{};
+        reset = true;
+        reset_crop = true;
+        break;
+    case source_transform_type::box:
+    {
+        bool crop = reset_crop;
+        *this = source_transform_pending{};
+        reset_crop = crop;
+        has_box = true;
+        box = cmd.box;
+    }
+    break;
+    case source_transform_type::pos:
+        has_pos = true;
+        pos_x = cmd.vec.x;
+        pos_y = cmd.vec.y;
+        break;
+    case source_transform_type::scale:
+        has_scale = true;
+        scale_x = cmd.vec.x;
+        scale_y = cmd.vec.y;
+        break;
+    case source_transform_type::flip:
+        flip_x *= cmd.vec.x;
+        flip_y *= cmd.vec.y;
+        break;
+    case source_transform_type::rotate:
+        has_rotate = true;
+        rot += cmd.vec.x;
+        break;
+    default:
+        break;
+    }
+}
+
+void source_transform_pending::merge(const source_transform_pending &other)
+{
+    if (other.reset || other.has_box) {
+        bool crop = reset_crop;
+        *this = other;
+        reset_crop |= crop;
+        return;
+    }
+
+    if (other.has_scale) {
+        has_scale = true;
+        scale_x = other.scale_x;
+        scale_y = other.scale_y;
+    }
+
+    flip_x *= other.flip_x;
+    flip_y *= other.flip_y;
+
+    if (other.has_rotate) {
+        has_rotate = true;
+        rot += other.rot;
+    }
+
+    if (other.has_pos) {
+        has_pos = true;
+        pos_x = other.pos_x;
+        pos_y = other.pos_y;
+    }
+}
+
+bool source_transform_pending::empty() const
+{
+    return !reset && !reset_crop && !has_box && !has_scale && !has_rotate && !has_pos && flip_x == 1.0f && flip_y == 1.0f;
+}
+
+source_transform_queue::source_transform_queue()
+{
+    ring.init(SOURCE_TRANSFORM_QUEUE_SIZE);
+}
+
+void source_transform_queue::push(const source_transform_command &cmd)
+{
+    if (!overflowed.load(std::memory_order_acquire) && ring.push(cmd))
+        return;
+
+    std::lock_guard<std::mutex> lock(overflow_mutex);
+    overflow.merge(cmd);
+    overflowed.store(true, std::memory_order_release);
+}
+
+source_transform_pending source_transform_queue::drain()
+{
+    source_transform_pending pending{};
+
+    source_transform_command cmd;
+    while (ring.pop(cmd))
+        pending.merge(cmd);
+
+    if (overflowed.load(std::memory_order_acquire)) {
+        /* a producer may have filled the ring again and moved on to the
+         * spare state since the ring looked empty. while the flag is set
+         * nobody starts a new run in the ring, so whatever is in it now is
+         * older than the spare state and goes first */
+        std::lock_guard<std::mutex> lock(overflow_mutex);
+        while (ring.pop(cmd))
+            pending.merge(cmd);
+        pending.merge(overflow);
+        overflow = source_transform_pending{};
+        overflowed.store(false, std::memory_order_release);
+    }
+
+    return pending;
+}
@@ -0,0 +1,212 @@
+#include "lite-obs/media-io/audio_math.h"
+#include "lite-obs/util/cpu_features.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AUDIO_MATH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AM_TARGET(isa)
+#else
+#define AM_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__) || defined(_M_ARM64)
+#define AUDIO_MATH_NEON
+#include <arm_neon.h>
+#endif
+
+/* the x86 clamp kernels put the limit first in min/max so that a nan
+ * sample comes out unchanged, the way the c++ version lets it through.
+ * neon min/max return nan for a nan input either way */
+
+#ifdef AUDIO_MATH_X86
+
+/* ------------------------------------------------------------------------- */
+/* sse */
+
+AM_TARGET("sse2")
+static void mix_floats_sse(float *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 a0 = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i));
+        __m128 a1 = _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_loadu_ps(src + i + 4));
+        _mm_storeu_ps(dst + i, a0);
+        _mm_storeu_ps(dst + i + 4, a1);
+    }
+
+    audio_mix_floats_c(dst + i, src + i, count - i);
+}
+
+AM_TARGET("sse2")
+static void multiply_floats_sse(float *data, size_t count, float vol)
+{
+    __m128 v = _mm_set1_ps(vol);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), v));
+        _mm_storeu_ps(data + i + 4, _mm_mul_ps(_mm_loadu_ps(data + i + 4), v));
+    }
+
+    audio_multiply_floats_c(data + i, count - i, vol);
+}
+
+AM_TARGET("sse2")
+static void clamp_floats_sse(float *data, size_t count)
+{
+    __m128 hi = _mm_set1_ps(1.0f);
+    __m128 lo = _mm_set1_ps(-1.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 a0 = _mm_max_ps(lo, _mm_min_ps(hi, _mm_loadu_ps(data + i)));
+        __m128 a1 = _mm_max_ps(lo, _mm_min_ps(hi, _mm_loadu_ps(data + i + 4)));
+        _mm_storeu_ps(data + i, a0);
+        _mm_storeu_ps(data + i + 4, a1);
+    }
+
+    audio_clamp_floats_c(data + i, count - i);
+}
+
+/* ------------------------------------------------------------------------- */
+/* avx2 */
+
+AM_TARGET("avx2")
+static void mix_floats_avx2(float *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 a0 = _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i));
+        __m256 a1 = _mm256_add_ps(_mm256_loadu_ps(dst + i + 8), _mm256_loadu_ps(src + i + 8));
+        _mm256_storeu_ps(dst + i, a0);
+        _mm256_storeu_ps(dst + i + 8, a1);
+    }
+
+    mix_floats_sse(dst + i, src + i, count - i);
+}
+
+AM_TARGET("avx2")
+static void multiply_floats_avx2(float *data, size_t count, float vol)
+{
+    __m256 v = _mm256_set1_ps(vol);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), v));
+        _mm256_storeu_ps(data + i + 8, _mm256_mul_ps(_mm256_loadu_ps(data + i + 8), v));
+    }
+
+    multiply_floats_sse(data + i, count - i, vol);
+}
+
+AM_TARGET("avx2")
+static void clamp_floats_avx2(float *data, size_t count)
+{
+    __m256 hi = _mm256_set1_ps(1.0f);
+    __m256 lo = _mm256_set1_ps(-1.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 a0 = _mm256_max_ps(lo, _mm256_min_ps(hi, _mm256_loadu_ps(data + i)));
+        __m256 a1 = _mm256_max_ps(lo, _mm256_min_ps(hi, _mm256_loadu_ps(data + i + 8)));
+        _mm256_storeu_ps(data + i, a0);
+        _mm256_storeu_ps(data + i + 8, a1);
+    }
+
+    clamp_floats_sse(data + i, count - i);
+}
+
+#endif
+
+#ifdef AUDIO_MATH_NEON
+
+/* ------------------------------------------------------------------------- */
+/* neon */
+
+static void mix_floats_neon(float *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a0 = vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i));
+        float32x4_t a1 = vaddq_f32(vld1q_f32(dst + i + 4), vld1q_f32(src + i + 4));
+        vst1q_f32(dst + i, a0);
+        vst1q_f32(dst + i + 4, a1);
+    }
+
+    audio_mix_floats_c(dst + i, src + i, count - i);
+}
+
+static void multiply_floats_neon(float *data, size_t count, float vol)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), vol));
+        vst1q_f32(data + i + 4, vmulq_n_f32(vld1q_f32(data + i + 4), vol));
+    }
+
+    audio_multiply_floats_c(data + i, count - i, vol);
+}
+
+static void clamp_floats_neon(float *data, size_t count)
+{
+    float32x4_t hi = vdupq_n_f32(1.0f);
+    float32x4_t lo = vdupq_n_f32(-1.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a0 = vmaxq_f32(lo, vminq_f32(hi, vld1q_f32(data + i)));
+        float32x4_t a1 = vmaxq_f32(lo, vminq_f32(hi, vld1q_f32(data + i + 4)));
+        vst1q_f32(data + i, a0);
+        vst1q_f32(data + i + 4, a1);
+    }
+
+    audio_clamp_floats_c(data + i, count - i);
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+struct audio_math_kernels {
+    const char *isa;
+    void (*mix)(float *dst, const float *src, size_t count);
+    void (*multiply)(float *data, size_t count, float vol);
+    void (*clamp)(float *data, size_t count);
+};
+
+static audio_math_kernels select_kernels()
+{
+    audio_math_kernels k = {"c", audio_mix_floats_c, audio_multiply_floats_c, audio_clamp_floats_c};
+
+#ifdef AUDIO_MATH_X86
+    if (cpu_has_sse2())
+        k = {"sse", mix_floats_sse, multiply_floats_sse, clamp_floats_sse};
+    if (cpu_has_sse2() && cpu_has_avx2())
+        k = {"avx2", mix_floats_avx2, multiply_floats_avx2, clamp_floats_avx2};
+#elif defined(AUDIO_MATH_NEON)
+    k = {"neon", mix_floats_neon, multiply_floats_neon, clamp_floats_neon};
+#endif
+
+    return k;
+}
+
+static const audio_math_kernels &kernels()
+{
+    static const audio_math_kernels k = select_kernels();
+    return k;
+}
+
+const char *audio_math_isa()
+{
+    return kernels().isa;
+}
+
+void audio_mix_floats(float *dst, const float *src, size_t count)
+{
+    kernels().mix(dst, src, count);
+}
+
+void audio_multiply_floats(float *data, size_t count, float vol)
+{
+    kernels().multiply(data, count, vol);
+}
+
+void audio_clamp_floats(float *data, size_t count)
+{
+    kernels().clamp(data, count);
+}
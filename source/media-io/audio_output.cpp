@@ -4,7 +4,9 @@
 #include "lite-obs/util/log.h"
 
 #include "lite-obs/media-io/audio_resampler.h"
+#include "lite-obs/media-io/audio_math.h"
 
+#include <string.h>
 #include <thread>
 #include <mutex>
 #include <vector>
@@ -54,6 +56,23 @@ struct audio_mix {
     float buffer[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES]{};
 };
 
+/* tick error histogram, 100us buckets up to 20ms, the last one takes
+ * everything later than that */
+#define AUDIO_TICK_BUCKET_NS 100000ULL
+#define AUDIO_TICK_BUCKETS 201
+
+/* further behind than this the thread restarts its schedule from now
+ * instead of mixing a burst of ticks to catch up */
+#define AUDIO_MAX_CATCHUP_NS 1000000000ULL
+
+struct audio_tick_histogram {
+    uint64_t buckets[AUDIO_TICK_BUCKETS]{};
+    uint64_t ticks{};
+    uint64_t total_error_ns{};
+    uint64_t max_error_ns{};
+    uint64_t resyncs{};
+};
+
 struct audio_output_private {
     audio_output_info info{};
     size_t block_size{};
@@ -69,6 +88,9 @@ struct audio_output_private {
     void *input_param{};
     std::recursive_mutex input_mutex;
     audio_mix mixes[MAX_AUDIO_MIXES]{};
+
+    std::mutex tick_stats_mutex;
+    audio_tick_histogram tick_stats{};
 };
 
 audio_output::audio_output()
@@ -87,7 +109,7 @@ static inline bool valid_audio_params(const audio_output_info *info)
             info->speakers != speaker_layout::SPEAKERS_UNKNOWN;
 }
 
-void audio_output::clamp_audio_output(size_t bytes)
+void audio_output::clamp_audio_output(size_t bytes, uint32_t active_mixes)
 {
     size_t float_size = bytes / sizeof(float);
 
@@ -95,20 +117,11 @@ void audio_output::clamp_audio_output(size_t bytes)
         audio_mix *mix = &d_ptr->mixes[mix_idx];
 
         /* do not process mixing if a specific mix is inactive */
-        if (!mix->inputs.size())
+        if ((active_mixes & (1 << mix_idx)) == 0)
             continue;
 
-        for (size_t plane = 0; plane < d_ptr->planes; plane++) {
-            float *mix_data = mix->buffer[plane];
-            float *mix_end = &mix_data[float_size];
-
-            while (mix_data < mix_end) {
-                float val = *mix_data;
-                val = (val > 1.0f) ? 1.0f : val;
-                val = (val < -1.0f) ? -1.0f : val;
-                *(mix_data++) = val;
-            }
-        }
+        for (size_t plane = 0; plane < d_ptr->planes; plane++)
+            audio_clamp_floats(mix->buffer[plane], float_size);
     }
 }
 
@@ -134,8 +147,13 @@ bool audio_output::resample_audio_output(std::shared_ptr<audio_input> input, aud
     return success;
 }
 
-void audio_output::do_audio_output(size_t mix_idx, uint64_t timestamp, uint32_t frames)
+void audio_output::do_audio_output(size_t mix_idx, uint32_t active_mixes, uint64_t timestamp, uint32_t frames)
 {
+    /* a mix that got its first input after the buffers were cleared still
+     * holds the audio of its last active tick */
+    if (!(active_mixes & (1 << mix_idx)))
+        return;
+
     audio_mix *mix = &d_ptr->mixes[mix_idx];
     audio_data data;
 
@@ -178,13 +196,12 @@ void audio_output::input_and_output(uint64_t audio_time, uint64_t prev_time)
     }
     d_ptr->input_mutex.unlock();
 
-    /* clear mix buffers */
+    /* clear mix buffers, the sources only mix into the active ones */
     for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
         audio_mix *mix = &d_ptr->mixes[mix_idx];
 
-        memset(mix->buffer[0], 0,
-                AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS *
-                sizeof(float));
+        if (active_mixes & (1 << mix_idx))
+            memset(mix->buffer[0], 0, AUDIO_OUTPUT_FRAMES * d_ptr->channels * sizeof(float));
 
         for (size_t i = 0; i < d_ptr->planes; i++)
             data[mix_idx].data[i] = mix->buffer[i];
@@ -199,35 +216,98 @@ void audio_output::input_and_output(uint64_t audio_time, uint64_t prev_time)
         return;
 
     /* clamps audio data to -1.0..1.0 */
-    clamp_audio_output(bytes);
+    clamp_audio_output(bytes, active_mixes);
 
     /* output */
     for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
-        do_audio_output(i, new_ts, AUDIO_OUTPUT_FRAMES);
+        do_audio_output(i, active_mixes, new_ts, AUDIO_OUTPUT_FRAMES);
+}
+
+void audio_output::record_tick_error(uint64_t error_ns)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->tick_stats_mutex);
+    auto &stats = d_ptr->tick_stats;
+
+    size_t bucket = (size_t)(error_ns / AUDIO_TICK_BUCKET_NS);
+    stats.buckets[bucket < AUDIO_TICK_BUCKETS ? bucket : AUDIO_TICK_BUCKETS - 1]++;
+    stats.ticks++;
+    stats.total_error_ns += error_ns;
+    if (error_ns > stats.max_error_ns)
+        stats.max_error_ns = error_ns;
+}
+
+void audio_output::audio_output_get_tick_stats(audio_tick_stats *stats)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->tick_stats_mutex);
+    auto &hist = d_ptr->tick_stats;
+
+    *stats = audio_tick_stats{};
+    stats->ticks = hist.ticks;
+    stats->max_error_ns = hist.max_error_ns;
+    stats->resyncs = hist.resyncs;
+    if (!hist.ticks)
+        return;
+
+    stats->avg_error_ns = hist.total_error_ns / hist.ticks;
+
+    uint64_t p99_count = hist.ticks - hist.ticks / 100;
+    uint64_t count = 0;
+    for (size_t i = 0; i < AUDIO_TICK_BUCKETS; i++) {
+        count += hist.buckets[i];
+        if (count >= p99_count) {
+            /* upper edge of the bucket, but never past the worst tick */
+            uint64_t edge = (i + 1) * AUDIO_TICK_BUCKET_NS;
+            stats->p99_error_ns = (i == AUDIO_TICK_BUCKETS - 1 || edge > hist.max_error_ns) ? hist.max_error_ns : edge;
+            break;
+        }
+    }
 }
 
+/* ticks are due every AUDIO_OUTPUT_FRAMES samples from start_time, on the
+ * same os_gettime_ns clock the video thread and the sources stamp their
+ * data with. the schedule is computed from the sample count rather than
+ * by adding up sleeps, so it doesn't drift, and the thread sleeps until
+ * the absolute time the next tick is due */
 void audio_output::audio_thread_internal()
 {
     size_t rate = d_ptr->info.samples_per_sec;
     uint64_t samples = 0;
     uint64_t start_time = os_gettime_ns();
     uint64_t prev_time = start_time;
-    uint64_t audio_time = prev_time;
-    uint32_t audio_wait_time = (uint32_t)(
-                audio_frames_to_ns(rate, AUDIO_OUTPUT_FRAMES) / 1000000);
-
+    uint64_t audio_time;
+    uint64_t interval = audio_frames_to_ns(rate, AUDIO_OUTPUT_FRAMES);
 
     while (os_event_try(d_ptr->stop_event) == EAGAIN) {
-        uint64_t cur_time;
+        uint64_t next_time = start_time + audio_frames_to_ns(rate, samples + AUDIO_OUTPUT_FRAMES);
+        uint64_t cur_time = os_gettime_ns();
+
+        /* the clock went backwards, or we are so far behind that catching
+         * up would flood the mixes. start over from now */
+        if (next_time > cur_time + interval * 2 || cur_time > next_time + AUDIO_MAX_CATCHUP_NS) {
+            blog(LOG_WARNING, "audio_thread: tick schedule off by %lld ms, restarting it",
+                 (long long)((int64_t)(cur_time - next_time) / 1000000));
+            {
+                std::lock_guard<std::mutex> lock(d_ptr->tick_stats_mutex);
+                d_ptr->tick_stats.resyncs++;
+            }
 
-        os_sleep_ms(audio_wait_time);
+            samples = 0;
+            start_time = prev_time = cur_time;
+            continue;
+        }
+
+        os_sleepto_ns(next_time);
 
+        /* a tick is due once all of its audio can have arrived, at the end
+         * of the time it covers */
         cur_time = os_gettime_ns();
-        while (audio_time <= cur_time) {
-            samples += AUDIO_OUTPUT_FRAMES;
-            audio_time =
-                    start_time + audio_frames_to_ns(rate, samples);
+        for (;;) {
+            audio_time = start_time + audio_frames_to_ns(rate, samples + AUDIO_OUTPUT_FRAMES);
+            if (audio_time > cur_time)
+                break;
 
+            samples += AUDIO_OUTPUT_FRAMES;
+            record_tick_error(cur_time - audio_time);
             input_and_output(audio_time, prev_time);
             prev_time = audio_time;
         }
@@ -237,6 +317,8 @@ void audio_output::audio_thread_internal()
 void audio_output::audio_thread(void *param)
 {
     audio_output *audio = (audio_output *)param;
+    if (!os_set_thread_time_critical())
+        blog(LOG_DEBUG, "audio_thread: could not raise the thread's priority, ticks may run late under load");
     audio->audio_thread_internal();
 }
 
@@ -261,6 +343,7 @@ int audio_output::audio_output_open(audio_output_info *info)
     if (os_event_init(&d_ptr->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
         goto fail;
 
+    blog(LOG_DEBUG, "audio_output_open: mixing with %s kernels", audio_math_isa());
     d_ptr->thread = std::thread(audio_output::audio_thread, this);
 
     d_ptr->initialized = true;
@@ -280,6 +363,13 @@ void audio_output::audio_output_close()
         os_event_signal(d_ptr->stop_event);
         if (d_ptr->thread.joinable())
             d_ptr->thread.join();
+
+        audio_tick_stats stats;
+        audio_output_get_tick_stats(&stats);
+        blog(LOG_INFO, "audio_output_close: %llu ticks, tick error avg %.2f ms, p99 %.2f ms, max %.2f ms, %llu restarts",
+             (unsigned long long)stats.ticks, (double)stats.avg_error_ns / 1000000.0,
+             (double)stats.p99_error_ns / 1000000.0, (double)stats.max_error_ns / 1000000.0,
+             (unsigned long long)stats.resyncs);
     }
 
     for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
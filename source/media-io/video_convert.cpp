@@ -0,0 +1,849 @@
+#include "lite-obs/media-io/video_convert.h"
+#include "lite-obs/util/threading.h"
+#include "lite-obs/util/log.h"
+#include "lite-obs/util/cpu_features.h"
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VIDEO_CONVERT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VC_TARGET(isa)
+#else
+#define VC_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__) || defined(_M_ARM64)
+#define VIDEO_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+/* ------------------------------------------------------------------------- */
+/* row kernels, plain c++ versions. the simd versions must produce exactly
+ * the same output and hand their leftover pixels to these. */
+
+static inline uint8_t clamp_u8(int32_t val)
+{
+    return (uint8_t)(val < 0 ? 0 : (val > 255 ? 255 : val));
+}
+
+static void deinterleave_uv_c(const uint8_t *uv, uint8_t *u, uint8_t *v, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        u[i] = uv[i * 2];
+        v[i] = uv[i * 2 + 1];
+    }
+}
+
+static void interleave_uv_c(const uint8_t *u, const uint8_t *v, uint8_t *uv, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uv[i * 2] = u[i];
+        uv[i * 2 + 1] = v[i];
+    }
+}
+
+static void rgb_to_y_c(const uint8_t *rgb, uint8_t *y, size_t count, const video_convert_coeffs *k)
+{
+    for (size_t i = 0; i < count; i++, rgb += 4) {
+        int32_t val = k->y[0] * rgb[0] + k->y[1] * rgb[1] + k->y[2] * rgb[2] + k->y_offset;
+        y[i] = clamp_u8(val >> 15);
+    }
+}
+
+static inline void rgb_store_uv_c(const int32_t c[3], uint8_t *u, uint8_t *v, const video_convert_coeffs *k)
+{
+    int32_t val_u = k->u[0] * c[0] + k->u[1] * c[1] + k->u[2] * c[2] + k->uv_offset;
+    int32_t val_v = k->v[0] * c[0] + k->v[1] * c[1] + k->v[2] * c[2] + k->uv_offset;
+    *u = clamp_u8(val_u >> 15);
+    *v = clamp_u8(val_v >> 15);
+}
+
+/* count is the number of chroma samples, u_step 1 for planar output and 2
+ * for nv12 (v then has to point at u + 1) */
+static void rgb_to_uv_c(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k)
+{
+    for (size_t i = 0; i < count; i++, rgb0 += 8, rgb1 += 8) {
+        int32_t c[3];
+        for (int ch = 0; ch < 3; ch++)
+            c[ch] = (rgb0[ch] + rgb0[ch + 4] + rgb1[ch] + rgb1[ch + 4] + 2) >> 2;
+        rgb_store_uv_c(c, u + i * step, v + i * step, k);
+    }
+}
+
+/* samples begin..count of a row, rgb0 and rgb1 point at its first pixel.
+ * the left pixel of each pair weighs 1/2, the right one and the one before
+ * the pair 1/4, the first pixel stands in for the one before the row */
+static void rgb_to_uv_left_range_c(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t begin, size_t count, const video_convert_coeffs *k)
+{
+    for (size_t i = begin; i < count; i++) {
+        size_t x = i * 8;
+        size_t prev = i ? x - 4 : x;
+        int32_t c[3];
+        for (int ch = 0; ch < 3; ch++) {
+            c[ch] = (rgb0[prev + ch] + rgb1[prev + ch] + 2 * (rgb0[x + ch] + rgb1[x + ch]) +
+                     rgb0[x + 4 + ch] + rgb1[x + 4 + ch] + 4) >> 3;
+        }
+        rgb_store_uv_c(c, u + i * step, v + i * step, k);
+    }
+}
+
+static void rgb_to_uv_left_c(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k)
+{
+    rgb_to_uv_left_range_c(rgb0, rgb1, u, v, step, 0, count, k);
+}
+
+/* pixel_size interleaved components, count output pixels */
+static void box_2x_c(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count, size_t pixel_size)
+{
+    for (size_t i = 0; i < count; i++) {
+        for (size_t c = 0; c < pixel_size; c++) {
+            size_t a = i * pixel_size * 2 + c;
+            size_t b = a + pixel_size;
+            dst[i * pixel_size + c] = (uint8_t)((row0[a] + row0[b] + row1[a] + row1[b] + 2) >> 2);
+        }
+    }
+}
+
+struct video_convert_kernels {
+    const char *isa;
+    void (*deinterleave_uv)(const uint8_t *uv, uint8_t *u, uint8_t *v, size_t count);
+    void (*interleave_uv)(const uint8_t *u, const uint8_t *v, uint8_t *uv, size_t count);
+    void (*rgb_to_y)(const uint8_t *rgb, uint8_t *y, size_t count, const video_convert_coeffs *k);
+    void (*rgb_to_uv)(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k);
+    void (*rgb_to_uv_left)(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k);
+    void (*box_2x_8)(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count);
+    void (*box_2x_16)(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count);
+    void (*box_2x_32)(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count);
+};
+
+static void box_2x_8_c(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count)
+{
+    box_2x_c(row0, row1, dst, count, 1);
+}
+
+static void box_2x_16_c(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count)
+{
+    box_2x_c(row0, row1, dst, count, 2);
+}
+
+static void box_2x_32_c(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count)
+{
+    box_2x_c(row0, row1, dst, count, 4);
+}
+
+#ifdef VIDEO_CONVERT_X86
+
+/* ------------------------------------------------------------------------- */
+/* sse4.1 */
+
+VC_TARGET("sse4.1")
+static void deinterleave_uv_sse41(const uint8_t *uv, uint8_t *u, uint8_t *v, size_t count)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(uv + i * 2)), shuffle);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(uv + i * 2 + 16)), shuffle);
+        _mm_storeu_si128((__m128i *)(u + i), _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128((__m128i *)(v + i), _mm_unpackhi_epi64(a, b));
+    }
+
+    deinterleave_uv_c(uv + i * 2, u + i, v + i, count - i);
+}
+
+VC_TARGET("sse4.1")
+static void interleave_uv_sse41(const uint8_t *u, const uint8_t *v, uint8_t *uv, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(u + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(v + i));
+        _mm_storeu_si128((__m128i *)(uv + i * 2), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128((__m128i *)(uv + i * 2 + 16), _mm_unpackhi_epi8(a, b));
+    }
+
+    interleave_uv_c(u + i, v + i, uv + i * 2, count - i);
+}
+
+/* weighted sum of four pixels, result in 32 bit lanes */
+VC_TARGET("sse4.1")
+static inline __m128i rgb_dot4_sse41(__m128i px, __m128i coeff, __m128i offset)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coeff);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coeff);
+    return _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(lo, hi), offset), 15);
+}
+
+VC_TARGET("sse4.1")
+static void rgb_to_y_sse41(const uint8_t *rgb, uint8_t *y, size_t count, const video_convert_coeffs *k)
+{
+    const __m128i coeff = _mm_setr_epi16(k->y[0], k->y[1], k->y[2], 0, k->y[0], k->y[1], k->y[2], 0);
+    const __m128i offset = _mm_set1_epi32(k->y_offset);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i *src = (const __m128i *)(rgb + i * 4);
+        __m128i y0 = rgb_dot4_sse41(_mm_loadu_si128(src), coeff, offset);
+        __m128i y1 = rgb_dot4_sse41(_mm_loadu_si128(src + 1), coeff, offset);
+        __m128i y2 = rgb_dot4_sse41(_mm_loadu_si128(src + 2), coeff, offset);
+        __m128i y3 = rgb_dot4_sse41(_mm_loadu_si128(src + 3), coeff, offset);
+        __m128i out = _mm_packus_epi16(_mm_packs_epi32(y0, y1), _mm_packs_epi32(y2, y3));
+        _mm_storeu_si128((__m128i *)(y + i), out);
+    }
+
+    rgb_to_y_c(rgb + i * 4, y + i, count - i, k);
+}
+
+/* 2x2 sums of eight pixels from each row, two chroma pixels per vector */
+VC_TARGET("sse4.1")
+static inline void rgb_sum_2x2_sse41(const uint8_t *rgb0, const uint8_t *rgb1, __m128i *sum01, __m128i *sum23)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a0 = _mm_loadu_si128((const __m128i *)rgb0);
+    __m128i a1 = _mm_loadu_si128((const __m128i *)(rgb0 + 16));
+    __m128i b0 = _mm_loadu_si128((const __m128i *)rgb1);
+    __m128i b1 = _mm_loadu_si128((const __m128i *)(rgb1 + 16));
+
+    /* px0 px1 | px2 px3 | px4 px5 | px6 px7, vertical sums */
+    __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+    __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+    __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+    __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+    /* horizontal neighbours */
+    s01 = _mm_add_epi16(s01, _mm_srli_si128(s01, 8));
+    s23 = _mm_add_epi16(s23, _mm_srli_si128(s23, 8));
+    s45 = _mm_add_epi16(s45, _mm_srli_si128(s45, 8));
+    s67 = _mm_add_epi16(s67, _mm_srli_si128(s67, 8));
+
+    *sum01 = _mm_unpacklo_epi64(s01, s23);
+    *sum23 = _mm_unpacklo_epi64(s45, s67);
+}
+
+/* eight chroma pixels from their averaged components, two per vector */
+VC_TARGET("sse4.1")
+static inline void rgb_store_uv_sse41(const __m128i avg[4], uint8_t *u, uint8_t *v, size_t step, const video_convert_coeffs *k)
+{
+    const __m128i coeff_u = _mm_setr_epi16(k->u[0], k->u[1], k->u[2], 0, k->u[0], k->u[1], k->u[2], 0);
+    const __m128i coeff_v = _mm_setr_epi16(k->v[0], k->v[1], k->v[2], 0, k->v[0], k->v[1], k->v[2], 0);
+    const __m128i offset = _mm_set1_epi32(k->uv_offset);
+
+    __m128i u0 = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(_mm_madd_epi16(avg[0], coeff_u), _mm_madd_epi16(avg[1], coeff_u)), offset), 15);
+    __m128i u1 = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(_mm_madd_epi16(avg[2], coeff_u), _mm_madd_epi16(avg[3], coeff_u)), offset), 15);
+    __m128i v0 = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(_mm_madd_epi16(avg[0], coeff_v), _mm_madd_epi16(avg[1], coeff_v)), offset), 15);
+    __m128i v1 = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(_mm_madd_epi16(avg[2], coeff_v), _mm_madd_epi16(avg[3], coeff_v)), offset), 15);
+
+    __m128i out_u = _mm_packus_epi16(_mm_packs_epi32(u0, u1), _mm_setzero_si128());
+    __m128i out_v = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_setzero_si128());
+
+    if (step == 2) {
+        _mm_storeu_si128((__m128i *)u, _mm_unpacklo_epi8(out_u, out_v));
+    } else {
+        _mm_storel_epi64((__m128i *)u, out_u);
+        _mm_storel_epi64((__m128i *)v, out_v);
+    }
+}
+
+VC_TARGET("sse4.1")
+static void rgb_to_uv_sse41(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k)
+{
+    const __m128i two = _mm_set1_epi16(2);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i avg[4];
+        rgb_sum_2x2_sse41(rgb0 + i * 8, rgb1 + i * 8, &avg[0], &avg[1]);
+        rgb_sum_2x2_sse41(rgb0 + i * 8 + 32, rgb1 + i * 8 + 32, &avg[2], &avg[3]);
+        for (auto &a : avg)
+            a = _mm_srli_epi16(_mm_add_epi16(a, two), 2);
+        rgb_store_uv_sse41(avg, u + i * step, v + i * step, step, k);
+    }
+
+    rgb_to_uv_c(rgb0 + i * 8, rgb1 + i * 8, u + i * step, v + i * step, step, count - i, k);
+}
+
+/* the pairs' 2x2 sums plus those of the pairs shifted left by a pixel. the
+ * first sample has no pixel before it and goes to the c version */
+VC_TARGET("sse4.1")
+static void rgb_to_uv_left_sse41(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k)
+{
+    const __m128i four = _mm_set1_epi16(4);
+    rgb_to_uv_left_range_c(rgb0, rgb1, u, v, step, 0, count < 1 ? count : 1, k);
+
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        __m128i avg[4], prev[4];
+        rgb_sum_2x2_sse41(rgb0 + i * 8, rgb1 + i * 8, &avg[0], &avg[1]);
+        rgb_sum_2x2_sse41(rgb0 + i * 8 + 32, rgb1 + i * 8 + 32, &avg[2], &avg[3]);
+        rgb_sum_2x2_sse41(rgb0 + i * 8 - 4, rgb1 + i * 8 - 4, &prev[0], &prev[1]);
+        rgb_sum_2x2_sse41(rgb0 + i * 8 + 28, rgb1 + i * 8 + 28, &prev[2], &prev[3]);
+        for (int j = 0; j < 4; j++)
+            avg[j] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(avg[j], prev[j]), four), 3);
+        rgb_store_uv_sse41(avg, u + i * step, v + i * step, step, k);
+    }
+
+    rgb_to_uv_left_range_c(rgb0, rgb1, u, v, step, i, count, k);
+}
+
+/* (a + b + c + d + 2) >> 2 of horizontal neighbour pairs, sums given per row
+ * as 16 bit lanes */
+VC_TARGET("sse4.1")
+static inline __m128i box_round_sse41(__m128i sum)
+{
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+VC_TARGET("sse4.1")
+static void box_2x_8_sse41(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count)
+{
+    const __m128i ones = _mm_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a0 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(row0 + i * 2)), ones);
+        __m128i a1 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(row0 + i * 2 + 16)), ones);
+        __m128i b0 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(row1 + i * 2)), ones);
+        __m128i b1 = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(row1 + i * 2 + 16)), ones);
+        __m128i lo = box_round_sse41(_mm_add_epi16(a0, b0));
+        __m128i hi = box_round_sse41(_mm_add_epi16(a1, b1));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+    box_2x_c(row0 + i * 2, row1 + i * 2, dst + i, count - i, 1);
+}
+
+VC_TARGET("sse4.1")
+static void box_2x_16_sse41(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count)
+{
+    /* u0 u1 v0 v1 ... so that maddubs adds the right neighbours */
+    const __m128i shuffle = _mm_setr_epi8(0, 2, 1, 3, 4, 6, 5, 7, 8, 10, 9, 11, 12, 14, 13, 15);
+    const __m128i ones = _mm_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a0 = _mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(row0 + i * 4)), shuffle), ones);
+        __m128i a1 = _mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(row0 + i * 4 + 16)), shuffle), ones);
+        __m128i b0 = _mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(row1 + i * 4)), shuffle), ones);
+        __m128i b1 = _mm_maddubs_epi16(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(row1 + i * 4 + 16)), shuffle), ones);
+        __m128i lo = box_round_sse41(_mm_add_epi16(a0, b0));
+        __m128i hi = box_round_sse41(_mm_add_epi16(a1, b1));
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_packus_epi16(lo, hi));
+    }
+
+    box_2x_c(row0 + i * 4, row1 + i * 4, dst + i * 2, count - i, 2);
+}
+
+VC_TARGET("sse4.1")
+static void box_2x_32_sse41(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i out[2];
+        for (int half = 0; half < 2; half++) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(row0 + i * 8 + half * 16));
+            __m128i b = _mm_loadu_si128((const __m128i *)(row1 + i * 8 + half * 16));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            out[half] = box_round_sse41(_mm_unpacklo_epi64(lo, hi));
+        }
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(out[0], out[1]));
+    }
+
+    box_2x_c(row0 + i * 8, row1 + i * 8, dst + i * 4, count - i, 4);
+}
+
+/* ------------------------------------------------------------------------- */
+/* avx2, 128 bit lanes are fixed up with a permute before storing */
+
+VC_TARGET("avx2")
+static void deinterleave_uv_avx2(const uint8_t *uv, uint8_t *u, uint8_t *v, size_t count)
+{
+    const __m256i shuffle = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                             0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        /* lane qwords: u0 v0 u1 v1 | u2 v2 u3 v3 */
+        __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(uv + i * 2)), shuffle);
+        __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(uv + i * 2 + 32)), shuffle);
+        a = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(u + i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i *)(v + i), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+
+    deinterleave_uv_sse41(uv + i * 2, u + i, v + i, count - i);
+}
+
+VC_TARGET("avx2")
+static void interleave_uv_avx2(const uint8_t *u, const uint8_t *v, uint8_t *uv, size_t count)
+{
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(u + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(v + i));
+        __m256i lo = _mm256_unpacklo_epi8(a, b);
+        __m256i hi = _mm256_unpackhi_epi8(a, b);
+        _mm256_storeu_si256((__m256i *)(uv + i * 2), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(uv + i * 2 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    interleave_uv_sse41(u + i, v + i, uv + i * 2, count - i);
+}
+
+VC_TARGET("avx2")
+static inline __m256i rgb_dot8_avx2(__m256i px, __m256i coeff, __m256i offset)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), coeff);
+    __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), coeff);
+    return _mm256_srai_epi32(_mm256_add_epi32(_mm256_hadd_epi32(lo, hi), offset), 15);
+}
+
+VC_TARGET("avx2")
+static void rgb_to_y_avx2(const uint8_t *rgb, uint8_t *y, size_t count, const video_convert_coeffs *k)
+{
+    const __m256i coeff = _mm256_setr_epi16(k->y[0], k->y[1], k->y[2], 0, k->y[0], k->y[1], k->y[2], 0,
+                                            k->y[0], k->y[1], k->y[2], 0, k->y[0], k->y[1], k->y[2], 0);
+    const __m256i offset = _mm256_set1_epi32(k->y_offset);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i *src = (const __m256i *)(rgb + i * 4);
+        __m256i y0 = rgb_dot8_avx2(_mm256_loadu_si256(src), coeff, offset);
+        __m256i y1 = rgb_dot8_avx2(_mm256_loadu_si256(src + 1), coeff, offset);
+        __m256i y2 = rgb_dot8_avx2(_mm256_loadu_si256(src + 2), coeff, offset);
+        __m256i y3 = rgb_dot8_avx2(_mm256_loadu_si256(src + 3), coeff, offset);
+        __m256i out = _mm256_packus_epi16(_mm256_packs_epi32(y0, y1), _mm256_packs_epi32(y2, y3));
+        _mm256_storeu_si256((__m256i *)(y + i), _mm256_permutevar8x32_epi32(out, order));
+    }
+
+    rgb_to_y_sse41(rgb + i * 4, y + i, count - i, k);
+}
+
+VC_TARGET("avx2")
+static void box_2x_8_avx2(const uint8_t *row0, const uint8_t *row1, uint8_t *dst, size_t count)
+{
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi16(2);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a0 = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(row0 + i * 2)), ones);
+        __m256i a1 = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(row0 + i * 2 + 32)), ones);
+        __m256i b0 = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(row1 + i * 2)), ones);
+        __m256i b1 = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(row1 + i * 2 + 32)), ones);
+        __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(a0, b0), two), 2);
+        __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(a1, b1), two), 2);
+        __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(dst + i), out);
+    }
+
+    box_2x_8_sse41(row0 + i * 2, row1 + i * 2, dst + i, count - i);
+}
+
+#endif
+
+#ifdef VIDEO_CONVERT_NEON
+
+/* ------------------------------------------------------------------------- */
+/* neon */
+
+static void deinterleave_uv_neon(const uint8_t *uv, uint8_t *u, uint8_t *v, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x2_t px = vld2q_u8(uv + i * 2);
+        vst1q_u8(u + i, px.val[0]);
+        vst1q_u8(v + i, px.val[1]);
+    }
+
+    deinterleave_uv_c(uv + i * 2, u + i, v + i, count - i);
+}
+
+static void interleave_uv_neon(const uint8_t *u, const uint8_t *v, uint8_t *uv, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x2_t px;
+        px.val[0] = vld1q_u8(u + i);
+        px.val[1] = vld1q_u8(v + i);
+        vst2q_u8(uv + i * 2, px);
+    }
+
+    interleave_uv_c(u + i, v + i, uv + i * 2, count - i);
+}
+
+/* eight 16 bit components per channel -> eight results */
+static inline uint8x8_t rgb_dot8_neon(int16x8_t c0, int16x8_t c1, int16x8_t c2, const int16_t *coeff, int32x4_t offset)
+{
+    int32x4_t lo = vmlal_n_s16(offset, vget_low_s16(c0), coeff[0]);
+    lo = vmlal_n_s16(lo, vget_low_s16(c1), coeff[1]);
+    lo = vmlal_n_s16(lo, vget_low_s16(c2), coeff[2]);
+    int32x4_t hi = vmlal_n_s16(offset, vget_high_s16(c0), coeff[0]);
+    hi = vmlal_n_s16(hi, vget_high_s16(c1), coeff[1]);
+    hi = vmlal_n_s16(hi, vget_high_s16(c2), coeff[2]);
+    return vqmovn_u16(vcombine_u16(vqshrun_n_s32(lo, 15), vqshrun_n_s32(hi, 15)));
+}
+
+static void rgb_to_y_neon(const uint8_t *rgb, uint8_t *y, size_t count, const video_convert_coeffs *k)
+{
+    const int32x4_t offset = vdupq_n_s32(k->y_offset);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t px = vld4q_u8(rgb + i * 4);
+        uint8x8_t lo = rgb_dot8_neon(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(px.val[0]))),
+                                     vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(px.val[1]))),
+                                     vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(px.val[2]))), k->y, offset);
+        uint8x8_t hi = rgb_dot8_neon(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(px.val[0]))),
+                                     vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(px.val[1]))),
+                                     vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(px.val[2]))), k->y, offset);
+        vst1q_u8(y + i, vcombine_u8(lo, hi));
+    }
+
+    rgb_to_y_c(rgb + i * 4, y + i, count - i, k);
+}
+
+static inline void rgb_store_uv_neon(const int16x8_t c[3], uint8_t *u, uint8_t *v, size_t step, const video_convert_coeffs *k)
+{
+    const int32x4_t offset = vdupq_n_s32(k->uv_offset);
+    uint8x8_t out_u = rgb_dot8_neon(c[0], c[1], c[2], k->u, offset);
+    uint8x8_t out_v = rgb_dot8_neon(c[0], c[1], c[2], k->v, offset);
+    if (step == 2) {
+        uint8x8x2_t out;
+        out.val[0] = out_u;
+        out.val[1] = out_v;
+        vst2_u8(u, out);
+    } else {
+        vst1_u8(u, out_u);
+        vst1_u8(v, out_v);
+    }
+}
+
+static void rgb_to_uv_neon(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x16x4_t a = vld4q_u8(rgb0 + i * 8);
+        uint8x16x4_t b = vld4q_u8(rgb1 + i * 8);
+        int16x8_t c[3];
+        for (int ch = 0; ch < 3; ch++) {
+            uint16x8_t sum = vaddq_u16(vpaddlq_u8(a.val[ch]), vpaddlq_u8(b.val[ch]));
+            c[ch] = vreinterpretq_s16_u16(vrshrq_n_u16(sum, 2));
+        }
+        rgb_store_uv_neon(c, u + i * step, v + i * step, step, k);
+    }
+
+    rgb_to_uv_c(rgb0 + i * 8, rgb1 + i * 8, u + i * step, v + i * step, step, count - i, k);
+}
+
+/* as the sse4.1 version, the pair sums plus those of the pairs shifted left
+ * by a pixel */
+static void rgb_to_uv_left_neon(const uint8_t *rgb0, const uint8_t *rgb1, uint8_t *u, uint8_t *v, size_t step, size_t count, const video_convert_coeffs *k)
+{
+    rgb_to_uv_left_range_c(rgb0, rgb1, u, v, step, 0, count < 1 ? count : 1, k);
+
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        uint8x16x4_t a = vld4q_u8(rgb0 + i * 8);
+        uint8x16x4_t b = vld4q_u8(rgb1 + i * 8);
+        uint8x16x4_t pa = vld4q_u8(rgb0 + i * 8 - 4);
+        uint8x16x4_t pb = vld4q_u8(rgb1 + i * 8 - 4);
+        int16x8_t c[3];
+        for (int ch = 0; ch < 3; ch++) {
+            uint16x8_t sum = vaddq_u16(vpaddlq_u8(a.val[ch]), vpaddlq_u8(b.val[ch]));
+            sum = vaddq_u16(sum, vaddq_u16(vpaddlq_u8(pa.val[ch]), vpaddlq_u8(pb.val[ch])));
+            c[ch] = vreinterpretq_s16_u16(vrshrq_n_u16(sum, 3));
+        }
+        rgb_store_uv_neon(c, u + i * step, v + i * step, step, k);
+    }
+
+    rgb_to_uv_left_range_c(rgb0, rgb1, u, v, step, i, count, k);
+}
+
+#endif
+
+static video_convert_kernels select_kernels()
+{
+    video_convert_kernels k = {"c", deinterleave_uv_c, interleave_uv_c, rgb_to_y_c, rgb_to_uv_c, rgb_to_uv_left_c, box_2x_8_c, box_2x_16_c, box_2x_32_c};
+
+#ifdef VIDEO_CONVERT_X86
+    if (cpu_has_sse41())
+        k = {"sse4.1", deinterleave_uv_sse41, interleave_uv_sse41, rgb_to_y_sse41, rgb_to_uv_sse41, rgb_to_uv_left_sse41, box_2x_8_sse41, box_2x_16_sse41, box_2x_32_sse41};
+    if (cpu_has_sse41() && cpu_has_avx2()) {
+        /* chroma and the wider box filters gain little from 256 bit
+         * vectors, they stay on sse4.1 */
+        k.isa = "avx2";
+        k.deinterleave_uv = deinterleave_uv_avx2;
+        k.interleave_uv = interleave_uv_avx2;
+        k.rgb_to_y = rgb_to_y_avx2;
+        k.box_2x_8 = box_2x_8_avx2;
+    }
+#elif defined(VIDEO_CONVERT_NEON)
+    k = {"neon", deinterleave_uv_neon, interleave_uv_neon, rgb_to_y_neon, rgb_to_uv_neon, rgb_to_uv_left_neon, box_2x_8_neon, box_2x_16_neon, box_2x_32_neon};
+#endif
+
+    return k;
+}
+
+static const video_convert_kernels &kernels()
+{
+    static const video_convert_kernels k = select_kernels();
+    return k;
+}
+
+const char *video_convert_isa()
+{
+    return kernels().isa;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void video_convert_coeffs_init(video_convert_coeffs *coeffs, video_format src_format, video_colorspace colorspace, video_range_type range)
+{
+    double kr = 0.299, kb = 0.114;
+    if (colorspace == video_colorspace::VIDEO_CS_709) {
+        kr = 0.2126;
+        kb = 0.0722;
+    }
+
+    bool full = range == video_range_type::VIDEO_RANGE_FULL;
+    double y_scale = full ? 1.0 : 219.0 / 255.0;
+    double c_scale = full ? 1.0 : 224.0 / 255.0;
+
+    auto q15 = [](double val) { return (int16_t)lround(val * 32768.0); };
+
+    /* r g b */
+    int16_t y[3] = {q15(kr * y_scale), 0, q15(kb * y_scale)};
+    int16_t u[3] = {q15(-kr / (2.0 * (1.0 - kb)) * c_scale), 0, q15(0.5 * c_scale)};
+    int16_t v[3] = {q15(0.5 * c_scale), 0, q15(-kb / (2.0 * (1.0 - kr)) * c_scale)};
+
+    /* green takes the rounding error, so white stays white and grey has no
+     * chroma */
+    y[1] = (int16_t)(lround(y_scale * 32768.0) - y[0] - y[2]);
+    u[1] = (int16_t)(-u[0] - u[2]);
+    v[1] = (int16_t)(-v[0] - v[2]);
+
+    bool bgr = src_format != video_format::VIDEO_FORMAT_RGBA;
+    for (int i = 0; i < 3; i++) {
+        int src = bgr ? 2 - i : i;
+        coeffs->y[i] = y[src];
+        coeffs->u[i] = u[src];
+        coeffs->v[i] = v[src];
+    }
+    coeffs->y[3] = coeffs->u[3] = coeffs->v[3] = 0;
+
+    coeffs->y_offset = ((full ? 0 : 16) << 15) + (1 << 14);
+    coeffs->uv_offset = (128 << 15) + (1 << 14);
+}
+
+void video_convert_nv12_to_i420(const uint8_t *const src[], const uint32_t src_linesize[], uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height)
+{
+    auto &k = kernels();
+
+    for (uint32_t y = 0; y < height; y++)
+        memcpy(dst[0] + y * dst_linesize[0], src[0] + y * src_linesize[0], width);
+
+    for (uint32_t y = 0; y < height / 2; y++)
+        k.deinterleave_uv(src[1] + y * src_linesize[1], dst[1] + y * dst_linesize[1], dst[2] + y * dst_linesize[2], width / 2);
+}
+
+void video_convert_i420_to_nv12(const uint8_t *const src[], const uint32_t src_linesize[], uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height)
+{
+    auto &k = kernels();
+
+    for (uint32_t y = 0; y < height; y++)
+        memcpy(dst[0] + y * dst_linesize[0], src[0] + y * src_linesize[0], width);
+
+    for (uint32_t y = 0; y < height / 2; y++)
+        k.interleave_uv(src[1] + y * src_linesize[1], src[2] + y * src_linesize[2], dst[1] + y * dst_linesize[1], width / 2);
+}
+
+void video_convert_rgb_to_nv12(const uint8_t *src, uint32_t src_linesize, uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height, const video_convert_coeffs *coeffs)
+{
+    auto &k = kernels();
+    auto rgb_to_uv = coeffs->chroma_left ? k.rgb_to_uv_left : k.rgb_to_uv;
+
+    for (uint32_t y = 0; y < height; y += 2) {
+        const uint8_t *row0 = src + y * src_linesize;
+        const uint8_t *row1 = row0 + src_linesize;
+        uint8_t *uv = dst[1] + (y / 2) * dst_linesize[1];
+
+        k.rgb_to_y(row0, dst[0] + y * dst_linesize[0], width, coeffs);
+        k.rgb_to_y(row1, dst[0] + (y + 1) * dst_linesize[0], width, coeffs);
+        rgb_to_uv(row0, row1, uv, uv + 1, 2, width / 2, coeffs);
+    }
+}
+
+void video_convert_rgb_to_i420(const uint8_t *src, uint32_t src_linesize, uint8_t *dst[], const uint32_t dst_linesize[], uint32_t width, uint32_t height, const video_convert_coeffs *coeffs)
+{
+    auto &k = kernels();
+    auto rgb_to_uv = coeffs->chroma_left ? k.rgb_to_uv_left : k.rgb_to_uv;
+
+    for (uint32_t y = 0; y < height; y += 2) {
+        const uint8_t *row0 = src + y * src_linesize;
+        const uint8_t *row1 = row0 + src_linesize;
+
+        k.rgb_to_y(row0, dst[0] + y * dst_linesize[0], width, coeffs);
+        k.rgb_to_y(row1, dst[0] + (y + 1) * dst_linesize[0], width, coeffs);
+        rgb_to_uv(row0, row1, dst[1] + (y / 2) * dst_linesize[1], dst[2] + (y / 2) * dst_linesize[2], 1, width / 2, coeffs);
+    }
+}
+
+bool video_convert_downscale_supported(video_format format)
+{
+    switch (format) {
+    case video_format::VIDEO_FORMAT_I420:
+    case video_format::VIDEO_FORMAT_NV12:
+    case video_format::VIDEO_FORMAT_Y800:
+    case video_format::VIDEO_FORMAT_RGBA:
+    case video_format::VIDEO_FORMAT_BGRA:
+    case video_format::VIDEO_FORMAT_BGRX:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void downscale_plane(void (*box)(const uint8_t *, const uint8_t *, uint8_t *, size_t), const uint8_t *src, uint32_t src_linesize, uint8_t *dst, uint32_t dst_linesize, uint32_t dst_width, uint32_t dst_height)
+{
+    for (uint32_t y = 0; y < dst_height; y++) {
+        const uint8_t *row0 = src + y * 2 * src_linesize;
+        box(row0, row0 + src_linesize, dst + y * dst_linesize, dst_width);
+    }
+}
+
+void video_convert_downscale_2x(video_format format, const uint8_t *const src[], const uint32_t src_linesize[], uint8_t *dst[], const uint32_t dst_linesize[], uint32_t src_width, uint32_t src_height)
+{
+    auto &k = kernels();
+    uint32_t width = src_width / 2;
+    uint32_t height = src_height / 2;
+
+    switch (format) {
+    case video_format::VIDEO_FORMAT_I420:
+        downscale_plane(k.box_2x_8, src[0], src_linesize[0], dst[0], dst_linesize[0], width, height);
+        downscale_plane(k.box_2x_8, src[1], src_linesize[1], dst[1], dst_linesize[1], width / 2, height / 2);
+        downscale_plane(k.box_2x_8, src[2], src_linesize[2], dst[2], dst_linesize[2], width / 2, height / 2);
+        break;
+    case video_format::VIDEO_FORMAT_NV12:
+        downscale_plane(k.box_2x_8, src[0], src_linesize[0], dst[0], dst_linesize[0], width, height);
+        downscale_plane(k.box_2x_16, src[1], src_linesize[1], dst[1], dst_linesize[1], width / 2, height / 2);
+        break;
+    case video_format::VIDEO_FORMAT_Y800:
+        downscale_plane(k.box_2x_8, src[0], src_linesize[0], dst[0], dst_linesize[0], width, height);
+        break;
+    case video_format::VIDEO_FORMAT_RGBA:
+    case video_format::VIDEO_FORMAT_BGRA:
+    case video_format::VIDEO_FORMAT_BGRX:
+        downscale_plane(k.box_2x_32, src[0], src_linesize[0], dst[0], dst_linesize[0], width, height);
+        break;
+    default:
+        break;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct video_convert_worker {
+    std::thread thread{};
+    os_wakeup_t *wakeup{};
+};
+
+struct video_convert_pool_private {
+    std::vector<video_convert_worker> workers{};
+    os_sem_t *done{};
+    std::atomic_bool stop{};
+
+    void (*job)(void *param, size_t band, size_t band_count){};
+    void *param{};
+};
+
+video_convert_pool::video_convert_pool()
+{
+    d_ptr = std::make_unique<video_convert_pool_private>();
+}
+
+video_convert_pool::~video_convert_pool()
+{
+    stop();
+}
+
+bool video_convert_pool::start(size_t threads)
+{
+    stop();
+
+    if (os_sem_init(&d_ptr->done, 0) != 0)
+        return false;
+
+    d_ptr->stop = false;
+    d_ptr->workers.resize(threads);
+    for (size_t i = 0; i < threads; i++) {
+        if (os_wakeup_init(&d_ptr->workers[i].wakeup) != 0) {
+            d_ptr->workers.resize(i);
+            stop();
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < threads; i++)
+        d_ptr->workers[i].thread = std::thread(&video_convert_pool::worker_thread, this, i + 1);
+
+    blog(LOG_DEBUG, "video_convert_pool: started %d worker threads", (int)threads);
+    return true;
+}
+
+void video_convert_pool::stop()
+{
+    d_ptr->stop = true;
+    for (auto &worker : d_ptr->workers) {
+        if (worker.thread.joinable()) {
+            os_wakeup_signal(worker.wakeup);
+            worker.thread.join();
+        }
+        os_wakeup_destroy(worker.wakeup);
+    }
+    d_ptr->workers.clear();
+
+    if (d_ptr->done) {
+        os_sem_destroy(d_ptr->done);
+        d_ptr->done = nullptr;
+    }
+}
+
+size_t video_convert_pool::band_count()
+{
+    return d_ptr->workers.size() + 1;
+}
+
+void video_convert_pool::run(void (*job)(void *, size_t, size_t), void *param)
+{
+    size_t count = band_count();
+
+    /* the wakeup/semaphore pair orders these stores against the workers */
+    d_ptr->job = job;
+    d_ptr->param = param;
+    for (auto &worker : d_ptr->workers)
+        os_wakeup_signal(worker.wakeup);
+
+    job(param, 0, count);
+
+    for (size_t i = 1; i < count; i++)
+        os_sem_wait(d_ptr->done);
+}
+
+void video_convert_pool::worker_thread(size_t band)
+{
+    auto &worker = d_ptr->workers[band - 1];
+    size_t count = band_count();
+
+    while (true) {
+        os_wakeup_wait(worker.wakeup);
+        if (d_ptr->stop)
+            break;
+
+        d_ptr->job(d_ptr->param, band, count);
+        os_sem_post(d_ptr->done);
+    }
+}
@@ -1,4 +1,5 @@
 #include "lite-obs/media-io/video_frame.h"
+#include <string.h>
 
 #define ALIGN_SIZE(size, align) size = (((size) + (align - 1)) & (~(align - 1)))
 
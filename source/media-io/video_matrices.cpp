@@ -1,4 +1,5 @@
 #include "lite-obs/media-io/video_matrices.h"
+#include <string.h>
 #include <memory>
 
 static struct {
@@ -2,29 +2,76 @@
 #include "lite-obs/media-io/video_scaler.h"
 #include "lite-obs/media-io/video_frame.h"
 #include "lite-obs/util/threading.h"
+#include "lite-obs/util/spsc_ring.h"
 #include "lite-obs/util/log.h"
+#include <string.h>
 #include <thread>
 #include <mutex>
 #include <vector>
 
 #define MAX_CONVERT_BUFFERS 3
 #define MAX_CACHE_SIZE 16
+#define MIN_INPUT_QUEUE 1
 
+/* count and skipped are raised by the graphics thread when the cache is full
+ * while the video thread is working through the frame. refs holds one
+ * reference for the video thread until every repeat has been handed out and
+ * one for each input job still using the frame, the slot is recycled once it
+ * drops to zero. */
 struct cached_frame_info {
     struct video_data frame{};
-    int skipped{};
-    int count{};
+    std::atomic_int skipped{};
+    std::atomic_int count{};
+    std::atomic_int refs{};
 };
 
+/* cfi is claimed by exchanging it for null, either by the input thread when
+ * it starts on the job or by the video thread when it drops the job */
+struct video_input_job {
+    std::atomic<cached_frame_info *> cfi{};
+    uint64_t timestamp{};
+    bool keyframe{};
+};
+
+/* every input scales and delivers frames on its own thread so a slow output
+ * can't hold back the others. pending counts the jobs it has not started on,
+ * once max_queue of them are waiting the video thread drops the oldest, so a
+ * slow encoder catches up on recent frames and hands its cache slots back
+ * instead of stalling the video thread. dropped jobs stay in the ring until
+ * the input thread pops them, the ring only fills if a single callback runs
+ * for longer than MAX_CACHE_SIZE frames, then new frames are dropped too.
+ * frames starting a gop on the input's keyframe grid are never the ones
+ * dropped as oldest, an encoder forcing its keyframes on them would
+ * otherwise put them a frame later than its peers. */
 struct video_input
 {
     struct video_scale_info conversion{};
     std::unique_ptr<video_scaler> scaler{};
     video_frame frame[MAX_CONVERT_BUFFERS]{};
     int cur_frame{};
+    /* unscaled frames are copied here while the input is slow */
+    video_frame copy{};
+    bool copy_allocated{};
 
     void (*callback)(void *param, struct video_data *frame){};
     void *param{};
+
+    std::thread thread{};
+    spsc_ring<video_input_job> jobs{};
+    os_wakeup_t *wakeup{};
+    std::atomic_bool stop{};
+    std::atomic_uint32_t pending{};
+    size_t max_queue{};
+
+    std::atomic_uint64_t keyframe_interval_ns{};
+    uint64_t last_gop = VIDEO_GOP_NONE;
+
+    std::atomic_long dropped_frames{};
+    std::atomic_uint32_t max_depth{};
+    std::atomic_uint64_t delivered_frames{};
+    std::atomic_uint64_t callback_ns{};
+    std::atomic_uint64_t last_callback_ns{};
+    std::atomic_uint64_t max_callback_ns{};
 };
 
 struct video_output_private
@@ -32,10 +79,9 @@ struct video_output_private
     video_output_info info{};
 
     std::thread thread;
-    std::recursive_mutex data_mutex;
-    bool stop{};
+    std::atomic_bool stop{};
 
-    os_sem_t *update_semaphore{};
+    os_wakeup_t *update_wakeup{};
     uint64_t frame_time{};
     volatile std::atomic_long skipped_frames{};
     volatile std::atomic_long total_frames{};
@@ -45,10 +91,8 @@ struct video_output_private
     std::recursive_mutex input_mutex;
     std::vector<std::shared_ptr<video_input>> inputs{};
 
-    size_t available_frames{};
-    size_t first_added{};
-    size_t last_added{};
-    cached_frame_info cache[MAX_CACHE_SIZE]{};
+    spsc_ring<cached_frame_info> cache{};
+    size_t dispatch_seq{};
 
     volatile std::atomic_bool raw_active{};
     volatile std::atomic_long gpu_refs{};
@@ -84,12 +128,12 @@ int video_output::video_output_open(video_output_info *info)
     d_ptr->frame_time = (uint64_t)(1000000000.0 * (double)info->fps_den / (double)info->fps_num);
     d_ptr->initialized = false;
 
-    os_sem_init(&d_ptr->update_semaphore, 0);
-
-    d_ptr->thread = std::thread(video_output::video_thread, this);
+    os_wakeup_init(&d_ptr->update_wakeup);
 
     init_cache();
 
+    d_ptr->thread = std::thread(video_output::video_thread, this);
+
     d_ptr->initialized = true;
     return VIDEO_OUTPUT_SUCCESS;
 }
@@ -98,14 +142,22 @@ void video_output::video_output_close()
 {
     video_output_stop();
 
+    d_ptr->input_mutex.lock();
+    auto inputs = std::move(d_ptr->inputs);
     d_ptr->inputs.clear();
+    d_ptr->input_mutex.unlock();
+
+    for (auto &input : inputs)
+        video_input_stop(input.get());
+    inputs.clear();
 
-    for (size_t i = 0; i < d_ptr->info.cache_size; i++) {
-        auto frame = &d_ptr->cache[i].frame;
+    for (size_t i = 0; i < d_ptr->cache.capacity(); i++) {
+        auto frame = &d_ptr->cache.slot(i).frame;
         frame->frame.frame_free();
     }
 
-    os_sem_destroy(d_ptr->update_semaphore);
+    os_wakeup_destroy(d_ptr->update_wakeup);
+    d_ptr->update_wakeup = nullptr;
 }
 
 uint32_t video_output::video_output_get_width()
@@ -158,6 +210,8 @@ bool video_output::video_output_connect(const video_scale_info *conversion, void
 
         success = video_input_init(input);
         if (success) {
+            input->thread = std::thread(&video_output::video_input_thread, this, input.get());
+
             if (d_ptr->inputs.size() == 0) {
                 if (!d_ptr->gpu_refs) {
                     reset_frames();
@@ -176,10 +230,13 @@ void video_output::video_output_disconnect(void (*callback)(void *, video_data *
     if (!callback)
         return;
 
-    std::lock_guard<std::recursive_mutex> lock(d_ptr->input_mutex);
+    std::shared_ptr<video_input> input{};
+
+    d_ptr->input_mutex.lock();
 
     auto idx = video_get_input_idx(callback, param);
     if (idx != -1) {
+        input = d_ptr->inputs[idx];
         d_ptr->inputs.erase(d_ptr->inputs.begin() + idx);
 
         if (d_ptr->inputs.size() == 0) {
@@ -189,6 +246,13 @@ void video_output::video_output_disconnect(void (*callback)(void *, video_data *
             }
         }
     }
+
+    d_ptr->input_mutex.unlock();
+
+    /* the video thread no longer sees the input, wait for the frame it
+     * may be delivering right now */
+    if (input)
+        video_input_stop(input.get());
 }
 
 void video_output::video_output_stop()
@@ -196,7 +260,7 @@ void video_output::video_output_stop()
     if (d_ptr->initialized) {
         d_ptr->initialized = false;
         d_ptr->stop = true;
-        os_sem_post(d_ptr->update_semaphore);
+        os_wakeup_signal(d_ptr->update_wakeup);
         if (d_ptr->thread.joinable())
             d_ptr->thread.join();
     }
@@ -207,42 +271,43 @@ bool video_output::video_output_stopped()
     return d_ptr->stop;
 }
 
+/* only ever called from the graphics thread, which is the single producer of
+ * the frame cache */
 bool video_output::video_output_lock_frame(video_frame *frame, int count, uint64_t timestamp)
 {
-    bool locked = false;
-
-    std::lock_guard<std::recursive_mutex> lock(d_ptr->data_mutex);
-
-    if (d_ptr->available_frames == 0) {
-        d_ptr->cache[d_ptr->last_added].count += count;
-        d_ptr->cache[d_ptr->last_added].skipped += count;
-        locked = false;
-
-    } else {
-        if (d_ptr->available_frames != d_ptr->info.cache_size) {
-            if (++d_ptr->last_added == d_ptr->info.cache_size)
-                d_ptr->last_added = 0;
-        }
-
-        auto cfi = &d_ptr->cache[d_ptr->last_added];
+    auto cfi = d_ptr->cache.write_slot();
+    if (cfi) {
         cfi->frame.timestamp = timestamp;
         cfi->count = count;
         cfi->skipped = 0;
+        cfi->refs = 1;
 
         *frame = cfi->frame.frame;
+        return true;
+    }
+
+    /* the cache is full, repeat the newest frame instead. once all of its
+     * repeats have been handed out the inputs are still busy with it, so
+     * there is nothing left to do but drop the frame */
+    auto last = d_ptr->cache.last_pushed();
+    int cur = last->count.load();
+    while (cur > 0 && !last->count.compare_exchange_weak(cur, cur + count))
+        ;
 
-        locked = true;
+    if (cur > 0) {
+        last->skipped += count;
+    } else {
+        d_ptr->total_frames += count;
+        d_ptr->skipped_frames += count;
     }
 
-    return locked;
+    return false;
 }
 
 void video_output::video_output_unlock_frame()
 {
-    std::lock_guard<std::recursive_mutex> lock(d_ptr->data_mutex);
-
-    d_ptr->available_frames--;
-    os_sem_post(d_ptr->update_semaphore);
+    d_ptr->cache.push();
+    os_wakeup_signal(d_ptr->update_wakeup);
 }
 
 uint64_t video_output::video_output_get_frame_time()
@@ -257,69 +322,230 @@ uint32_t video_output::video_output_get_total_frames()
 
 void video_output::video_thread_internal()
 {
-    while (os_sem_wait(d_ptr->update_semaphore) == 0) {
+    while (os_wakeup_wait(d_ptr->update_wakeup) == 0) {
         if (d_ptr->stop)
             break;
 
-        while (!d_ptr->stop && !video_output_cur_frame()) {
+        recycle_cached_frames();
+
+        while (!d_ptr->stop && video_output_cur_frame()) {
             d_ptr->total_frames++;
         }
-
-        d_ptr->total_frames++;
     }
 }
 
 bool video_output::video_output_cur_frame()
 {
-    bool complete;
-    bool skipped;
+    auto frame_info = d_ptr->cache.read_slot(d_ptr->dispatch_seq);
+    if (!frame_info)
+        return false;
 
     /* -------------------------------- */
 
-    d_ptr->data_mutex.lock();
+    d_ptr->input_mutex.lock();
 
-    auto frame_info = &d_ptr->cache[d_ptr->first_added];
+    for (size_t i = 0; i < d_ptr->inputs.size(); i++) {
+        auto &input = d_ptr->inputs[i];
+        uint64_t interval = input->keyframe_interval_ns;
+        uint64_t gop = input->last_gop;
+        bool keyframe = interval && video_keyframe_due(frame_info->frame.timestamp, interval, &gop);
+
+        /* a gop whose first frame is dropped here starts with the next */
+        auto job = input->jobs.write_slot();
+        if (!job) {
+            input->dropped_frames++;
+            continue;
+        }
+        input->last_gop = gop;
 
-    d_ptr->data_mutex.unlock();
+        if (input->pending >= input->max_queue)
+            video_input_drop_oldest(input.get());
+
+        frame_info->refs++;
+        job->timestamp = frame_info->frame.timestamp;
+        job->keyframe = keyframe;
+        job->cfi.store(frame_info, std::memory_order_relaxed);
+        uint32_t depth = ++input->pending;
+        input->jobs.push();
+        os_wakeup_signal(input->wakeup);
+
+        if (depth > input->max_depth)
+            input->max_depth = depth;
+    }
+
+    d_ptr->input_mutex.unlock();
 
     /* -------------------------------- */
 
-    d_ptr->input_mutex.lock();
+    frame_info->frame.timestamp += d_ptr->frame_time;
 
-    for (size_t i = 0; i < d_ptr->inputs.size(); i++) {
-        auto input = d_ptr->inputs[i];
-        auto frame = frame_info->frame;
+    if (frame_info->count.fetch_sub(1) == 1) {
+        d_ptr->dispatch_seq++;
+        frame_info->refs--;
+        recycle_cached_frames();
+    } else {
+        int skipped = frame_info->skipped.load();
+        while (skipped > 0 && !frame_info->skipped.compare_exchange_weak(skipped, skipped - 1))
+            ;
 
-        if (scale_video_output(input, &frame))
-            input->callback(input->param, &frame);
+        if (skipped > 0)
+            d_ptr->skipped_frames++;
     }
 
-    d_ptr->input_mutex.unlock();
-
     /* -------------------------------- */
 
-    d_ptr->data_mutex.lock();
+    return true;
+}
 
-    frame_info->frame.timestamp += d_ptr->frame_time;
-    complete = --frame_info->count == 0;
-    skipped = frame_info->skipped > 0;
-
-    if (complete) {
-        if (++d_ptr->first_added == d_ptr->info.cache_size)
-            d_ptr->first_added = 0;
-
-        if (++d_ptr->available_frames == d_ptr->info.cache_size)
-            d_ptr->last_added = d_ptr->first_added;
-    } else if (skipped) {
-        --frame_info->skipped;
-        d_ptr->skipped_frames++;
+void video_output::video_input_thread(video_input *input)
+{
+    while (os_wakeup_wait(input->wakeup) == 0) {
+        if (input->stop)
+            break;
+
+        video_input_job *job;
+        while (!input->stop && (job = input->jobs.front())) {
+            /* null if the video thread dropped the job while it was queued */
+            auto cfi = job->cfi.exchange(nullptr, std::memory_order_acq_rel);
+            if (cfi) {
+                input->pending--;
+
+                /* the video thread advances cfi->frame.timestamp for
+                 * repeats, only the planes are safe to read here */
+                video_data frame;
+                frame.frame = cfi->frame.frame;
+                frame.timestamp = job->timestamp;
+                frame.keyframe = job->keyframe;
+
+                uint64_t start = os_gettime_ns();
+                bool scaled = scale_video_output(input, &frame);
+
+                /* cache slots are recycled in order, so one held through a
+                 * long callback stalls the graphics thread for every input.
+                 * a scaled frame is the input's own already. an input gets a
+                 * copy of its first frame, before it is known how long it
+                 * takes, and of every frame while its last callback took
+                 * longer than a frame */
+                if (!input->scaler && (!input->delivered_frames || input->last_callback_ns > d_ptr->frame_time))
+                    copy_video_input_frame(input, &frame);
+                if (frame.frame.data[0] != cfi->frame.frame.data[0]) {
+                    release_cached_frame(cfi);
+                    cfi = nullptr;
+                }
+
+                if (scaled)
+                    input->callback(input->param, &frame);
+                uint64_t elapsed = os_gettime_ns() - start;
+
+                input->delivered_frames++;
+                input->callback_ns += elapsed;
+                input->last_callback_ns = elapsed;
+                if (elapsed > input->max_callback_ns)
+                    input->max_callback_ns = elapsed;
+
+                if (cfi)
+                    release_cached_frame(cfi);
+            }
+            input->jobs.pop();
+        }
     }
+}
 
-    d_ptr->data_mutex.unlock();
+void video_output::video_input_stop(video_input *input)
+{
+    input->stop = true;
+    os_wakeup_signal(input->wakeup);
+    if (input->thread.joinable())
+        input->thread.join();
 
-    /* -------------------------------- */
+    /* give back the frames that were queued but never delivered */
+    video_input_job *job;
+    while ((job = input->jobs.front())) {
+        auto cfi = job->cfi.exchange(nullptr);
+        if (cfi)
+            release_cached_frame(cfi);
+        input->jobs.pop();
+    }
+
+    os_wakeup_destroy(input->wakeup);
+    input->wakeup = nullptr;
+
+    if (input->copy_allocated) {
+        input->copy.frame_free();
+        input->copy_allocated = false;
+    }
 
-    return complete;
+    if (input->dropped_frames)
+        blog(LOG_INFO, "video-io: input dropped %ld frames because it could not keep up", (long)input->dropped_frames);
+}
+
+/* video thread only, it is the producer of the job queue and so the only one
+ * that can race the input thread for a queued job */
+bool video_output::video_input_drop_oldest(video_input *input)
+{
+    size_t end = input->jobs.write_index();
+    for (size_t seq = input->jobs.read_index(); seq < end; seq++) {
+        auto &job = input->jobs.slot(seq % input->jobs.capacity());
+        if (job.keyframe)
+            continue;
+
+        auto cfi = job.cfi.exchange(nullptr, std::memory_order_acq_rel);
+        if (cfi) {
+            input->pending--;
+            release_cached_frame(cfi);
+            input->dropped_frames++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool video_output::video_output_get_input_stats(void (*callback)(void *, video_data *), void *param, video_input_stats *stats)
+{
+    if (!callback || !stats)
+        return false;
+
+    std::lock_guard<std::recursive_mutex> lock(d_ptr->input_mutex);
+
+    auto idx = video_get_input_idx(callback, param);
+    if (idx == -1)
+        return false;
+
+    auto &input = d_ptr->inputs[idx];
+    stats->queue_depth = input->pending;
+    stats->max_queue_depth = input->max_depth;
+    stats->queue_limit = (uint32_t)input->max_queue;
+    stats->delivered_frames = input->delivered_frames;
+    stats->dropped_frames = (uint64_t)input->dropped_frames;
+    stats->last_callback_ns = input->last_callback_ns;
+    stats->max_callback_ns = input->max_callback_ns;
+    stats->avg_callback_ns = stats->delivered_frames ? input->callback_ns / stats->delivered_frames : 0;
+    return true;
+}
+
+void video_output::video_output_set_keyframe_interval(void (*callback)(void *, video_data *), void *param, uint64_t interval_ns)
+{
+    std::lock_guard<std::recursive_mutex> lock(d_ptr->input_mutex);
+
+    auto idx = video_get_input_idx(callback, param);
+    if (idx != -1)
+        d_ptr->inputs[idx]->keyframe_interval_ns = interval_ns;
+}
+
+/* called by whichever thread is done with the frame, only the video thread
+ * recycles slots so they are released in order */
+void video_output::release_cached_frame(cached_frame_info *cfi)
+{
+    if (cfi->refs.fetch_sub(1) == 1)
+        os_wakeup_signal(d_ptr->update_wakeup);
+}
+
+void video_output::recycle_cached_frames()
+{
+    cached_frame_info *cfi;
+    while ((cfi = d_ptr->cache.front()) && cfi->refs == 0)
+        d_ptr->cache.pop();
 }
 
 void video_output::init_cache()
@@ -327,12 +553,12 @@ void video_output::init_cache()
     if (d_ptr->info.cache_size > MAX_CACHE_SIZE)
         d_ptr->info.cache_size = MAX_CACHE_SIZE;
 
-    for (size_t i = 0; i < d_ptr->info.cache_size; i++) {
-        auto frame = &d_ptr->cache[i].frame;
+    d_ptr->cache.init(d_ptr->info.cache_size);
+    d_ptr->dispatch_seq = 0;
+    for (size_t i = 0; i < d_ptr->cache.capacity(); i++) {
+        auto frame = &d_ptr->cache.slot(i).frame;
         frame->frame.frame_init(d_ptr->info.format, d_ptr->info.width, d_ptr->info.height);
     }
-
-    d_ptr->available_frames = d_ptr->info.cache_size;
 }
 
 int video_output::video_get_input_idx(void (*callback)(void *, video_data *), void *param)
@@ -375,6 +601,14 @@ bool video_output::video_input_init(std::shared_ptr<video_input> input)
             input->frame[i].frame_init(input->conversion.format, input->conversion.width, input->conversion.height);
     }
 
+    if (!input->jobs.init(MAX_CACHE_SIZE) || os_wakeup_init(&input->wakeup) != 0)
+        return false;
+
+    /* the waiting jobs plus the one being delivered hold at most half of
+     * the frame cache, the rest is left to the other inputs */
+    size_t half = d_ptr->info.cache_size / 2;
+    input->max_queue = half > MIN_INPUT_QUEUE ? half - 1 : MIN_INPUT_QUEUE;
+
     return true;
 }
 
@@ -401,7 +635,7 @@ void video_output::log_skipped()
              percentage_skipped);
 }
 
-bool video_output::scale_video_output(std::shared_ptr<video_input> input, video_data *data)
+bool video_output::scale_video_output(video_input *input, video_data *data)
 {
     bool success = true;
 
@@ -428,6 +662,20 @@ bool video_output::scale_video_output(std::shared_ptr<video_input> input, video_
     return success;
 }
 
+void video_output::copy_video_input_frame(video_input *input, video_data *data)
+{
+    if (!input->copy_allocated) {
+        input->copy.frame_init(d_ptr->info.format, d_ptr->info.width, d_ptr->info.height);
+        input->copy_allocated = true;
+    }
+
+    video_frame::video_frame_copy(&input->copy, &data->frame, d_ptr->info.format, d_ptr->info.height);
+    for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+        data->frame.data[i] = input->copy.data[i];
+        data->frame.linesize[i] = input->copy.linesize[i];
+    }
+}
+
 void video_output::video_output_inc_texture_encoders()
 {
     d_ptr->gpu_refs++;
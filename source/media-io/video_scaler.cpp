@@ -1,14 +1,30 @@
 #include "lite-obs/media-io/video_scaler.h"
+#include "lite-obs/media-io/video_convert.h"
 #include "lite-obs/util/log.h"
 
 extern "C" {
 #include <libswscale/swscale.h>
 }
 
+enum class video_scaler_fast_path {
+    none,
+    nv12_to_i420,
+    i420_to_nv12,
+    rgb_to_nv12,
+    rgb_to_i420,
+    downscale_2x,
+};
+
 struct video_scaler_private {
     struct SwsContext *swscale{};
     int src_height{};
 
+    video_scaler_fast_path fast_path = video_scaler_fast_path::none;
+    video_format format = video_format::VIDEO_FORMAT_NONE;
+    uint32_t width{};
+    uint32_t height{};
+    video_convert_coeffs coeffs{};
+
     ~video_scaler_private() {
         if (swscale)
             sws_freeContext(swscale);
@@ -103,6 +119,54 @@ static inline int get_ffmpeg_range_type(video_range_type type)
     return 0;
 }
 
+static inline bool is_rgb_format(video_format format)
+{
+    return format == video_format::VIDEO_FORMAT_RGBA ||
+            format == video_format::VIDEO_FORMAT_BGRA ||
+            format == video_format::VIDEO_FORMAT_BGRX;
+}
+
+static inline bool is_partial_range(video_range_type type)
+{
+    return type != video_range_type::VIDEO_RANGE_FULL;
+}
+
+/* conversions video_convert handles itself, swscale is only set up for
+ * everything else */
+static video_scaler_fast_path get_fast_path(const video_scale_info *dst, const video_scale_info *src, video_scale_type type)
+{
+    bool same_size = dst->width == src->width && dst->height == src->height;
+    bool same_range = is_partial_range(dst->range) == is_partial_range(src->range);
+    bool even = !(src->width & 1) && !(src->height & 1);
+
+    if (same_size && even && same_range) {
+        if (src->format == video_format::VIDEO_FORMAT_NV12 && dst->format == video_format::VIDEO_FORMAT_I420)
+            return video_scaler_fast_path::nv12_to_i420;
+        if (src->format == video_format::VIDEO_FORMAT_I420 && dst->format == video_format::VIDEO_FORMAT_NV12)
+            return video_scaler_fast_path::i420_to_nv12;
+    }
+
+    if (same_size && even && is_rgb_format(src->format)) {
+        if (dst->format == video_format::VIDEO_FORMAT_NV12)
+            return video_scaler_fast_path::rgb_to_nv12;
+        if (dst->format == video_format::VIDEO_FORMAT_I420)
+            return video_scaler_fast_path::rgb_to_i420;
+    }
+
+    /* the box filter is as good as bilinear at exactly half size, but not
+     * what someone asking for point or bicubic sampling expects */
+    bool filter_ok = type != video_scale_type::VIDEO_SCALE_POINT && type != video_scale_type::VIDEO_SCALE_BICUBIC;
+    bool half_size = dst->width * 2 == src->width && dst->height * 2 == src->height;
+    bool planar_420 = src->format == video_format::VIDEO_FORMAT_I420 || src->format == video_format::VIDEO_FORMAT_NV12;
+    bool aligned = planar_420 ? !(src->width & 3) && !(src->height & 3) : even;
+
+    if (filter_ok && half_size && aligned && same_range && dst->format == src->format &&
+            video_convert_downscale_supported(src->format))
+        return video_scaler_fast_path::downscale_2x;
+
+    return video_scaler_fast_path::none;
+}
+
 #define FIXED_1_0 (1 << 16)
 
 video_scaler::video_scaler()
@@ -128,6 +192,17 @@ int video_scaler::create(const video_scale_info *dst, const video_scale_info *sr
     if (format_src == AV_PIX_FMT_NONE || format_dst == AV_PIX_FMT_NONE)
         return VIDEO_SCALER_BAD_CONVERSION;
 
+    d_ptr->fast_path = get_fast_path(dst, src, type);
+    if (d_ptr->fast_path != video_scaler_fast_path::none) {
+        d_ptr->format = src->format;
+        d_ptr->width = src->width;
+        d_ptr->height = src->height;
+        video_convert_coeffs_init(&d_ptr->coeffs, src->format, dst->colorspace, dst->range);
+        blog(LOG_DEBUG, "video_scaler_create: using %s conversion for %ux%u -> %ux%u",
+             video_convert_isa(), src->width, src->height, dst->width, dst->height);
+        return VIDEO_SCALER_SUCCESS;
+    }
+
     d_ptr->src_height = src->height;
     d_ptr->swscale = sws_getCachedContext(NULL, src->width, src->height,
                                           format_src, dst->width,
@@ -152,6 +227,26 @@ int video_scaler::create(const video_scale_info *dst, const video_scale_info *sr
 
 bool video_scaler::video_scaler_scale(uint8_t *output[], uint32_t out_linesize[], const uint8_t * const input[], const uint32_t in_linesize[])
 {
+    switch (d_ptr->fast_path) {
+    case video_scaler_fast_path::nv12_to_i420:
+        video_convert_nv12_to_i420(input, in_linesize, output, out_linesize, d_ptr->width, d_ptr->height);
+        return true;
+    case video_scaler_fast_path::i420_to_nv12:
+        video_convert_i420_to_nv12(input, in_linesize, output, out_linesize, d_ptr->width, d_ptr->height);
+        return true;
+    case video_scaler_fast_path::rgb_to_nv12:
+        video_convert_rgb_to_nv12(input[0], in_linesize[0], output, out_linesize, d_ptr->width, d_ptr->height, &d_ptr->coeffs);
+        return true;
+    case video_scaler_fast_path::rgb_to_i420:
+        video_convert_rgb_to_i420(input[0], in_linesize[0], output, out_linesize, d_ptr->width, d_ptr->height, &d_ptr->coeffs);
+        return true;
+    case video_scaler_fast_path::downscale_2x:
+        video_convert_downscale_2x(d_ptr->format, input, in_linesize, output, out_linesize, d_ptr->width, d_ptr->height);
+        return true;
+    case video_scaler_fast_path::none:
+        break;
+    }
+
     if (!d_ptr->swscale)
         return false;
 
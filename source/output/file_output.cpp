@@ -3,6 +3,7 @@
 #include <atomic>
 #include <list>
 #include <thread>
+#include <string.h>
 #include "lite-obs/lite_encoder.h"
 #include "lite-obs/media-io/ffmpeg_formats.h"
 #include "lite-obs/media-io/video_output.h"
@@ -60,9 +61,9 @@ struct lite_ffmpeg_mux_private
     AVStream *video_stream{};
     AVCodecContext *video_ctx{};
     AVPacket *packet{};
-    audio_info audio_infos{};
+    audio_info audio_infos[MAX_AUDIO_MIXES]{};
     main_params params{};
-    audio_params audio{};
+    audio_params audio[MAX_AUDIO_MIXES]{};
     int num_audio_streams{};
     char error[4096]{};
 
@@ -107,6 +108,11 @@ bool lite_ffmpeg_mux::i_encoded()
     return true;
 }
 
+bool lite_ffmpeg_mux::i_multi_track()
+{
+    return true;
+}
+
 bool lite_ffmpeg_mux::i_create()
 {
     d_ptr->initilized = true;
@@ -190,10 +196,12 @@ void lite_ffmpeg_mux::i_encoded_packet(std::shared_ptr<struct encoder_packet> pa
 
     int idx = -1;
     auto is_audio = packet->type == obs_encoder_type::OBS_ENCODER_AUDIO;
-    if (is_audio)
-        idx = d_ptr->audio_infos.stream->id;
-    else
+    if (is_audio) {
+        if (packet->track_idx < (size_t)d_ptr->num_audio_streams)
+            idx = d_ptr->audio_infos[packet->track_idx].stream->id;
+    } else {
         idx = d_ptr->video_stream->id;
+    }
 
     if (idx == -1) {
         return;
@@ -206,7 +214,7 @@ void lite_ffmpeg_mux::i_encoded_packet(std::shared_ptr<struct encoder_packet> pa
         return av_rescale_q_rnd(val / codec_time_base.num, codec_time_base, stream->time_base, (enum AVRounding)(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX));
     };
 
-    const AVRational codec_time_base = is_audio ? d_ptr->audio_infos.ctx->time_base : d_ptr->video_ctx->time_base;
+    const AVRational codec_time_base = is_audio ? d_ptr->audio_infos[packet->track_idx].ctx->time_base : d_ptr->video_ctx->time_base;
 
     d_ptr->packet->data = packet->data->data();
     d_ptr->packet->size = (int)packet->data->size();
@@ -235,12 +243,16 @@ int lite_ffmpeg_mux::i_get_dropped_frames()
 void lite_ffmpeg_mux::init_params()
 {
     auto video_encoder = lite_obs_output_get_video_encoder();
-    auto audio_encoder = lite_obs_output_get_audio_encoder(0);
 
     auto output_info = lite_obs_output_video()->video_output_get_info();
 
     d_ptr->params.has_video = video_encoder != nullptr;
-    d_ptr->params.tracks = 1;
+    d_ptr->params.vcodec = video_encoder->lite_obs_encoder_codec();
+    /* every track comes from the same kind of encoder */
+    auto first_audio = lite_obs_output_get_audio_encoder(0);
+    if (first_audio && strcmp(first_audio->lite_obs_encoder_codec(), "opus") == 0)
+        d_ptr->params.acodec = "opus";
+    d_ptr->params.tracks = (int)lite_obs_output_audio_tracks();
     d_ptr->params.vbitrate = video_encoder->lite_obs_encoder_bitrate();
     d_ptr->params.width = lite_obs_output_get_width();
     d_ptr->params.height = lite_obs_output_get_height();
@@ -273,10 +285,16 @@ void lite_ffmpeg_mux::init_params()
     d_ptr->params.color_range = range;
     d_ptr->params.chroma_sample_location = determine_chroma_location(lite_obs_to_ffmpeg_video_format(output_info->format), spc);
 
-    d_ptr->audio.abitrate = audio_encoder->lite_obs_encoder_bitrate();
-    d_ptr->audio.sample_rate = audio_encoder->lite_obs_encoder_get_sample_rate();
-    d_ptr->audio.channels = (int)lite_obs_output_audio()->audio_output_get_channels();
-    d_ptr->audio.frame_size = (int)audio_encoder->lite_obs_encoder_get_frame_size();
+    for (int i = 0; i < d_ptr->params.tracks; i++) {
+        auto audio_encoder = lite_obs_output_get_audio_encoder(i);
+        if (!audio_encoder)
+            continue;
+
+        d_ptr->audio[i].abitrate = audio_encoder->lite_obs_encoder_bitrate();
+        d_ptr->audio[i].sample_rate = audio_encoder->lite_obs_encoder_get_sample_rate();
+        d_ptr->audio[i].channels = (int)lite_obs_output_audio()->audio_output_get_channels();
+        d_ptr->audio[i].frame_size = (int)audio_encoder->lite_obs_encoder_get_frame_size();
+    }
 }
 
 bool lite_ffmpeg_mux::new_stream(AVStream **stream, const char *name)
@@ -351,12 +369,14 @@ void lite_ffmpeg_mux::create_video_stream()
     d_ptr->video_ctx = context;
 }
 
-void lite_ffmpeg_mux::create_audio_stream()
+void lite_ffmpeg_mux::create_audio_stream(size_t idx)
 {
-    auto audio_encoder = lite_obs_output_get_audio_encoder(0);
+    auto audio_encoder = lite_obs_output_get_audio_encoder(idx);
     if (!audio_encoder)
         return;
 
+    auto &audio = d_ptr->audio[idx];
+
     const char *name = d_ptr->params.acodec;
     const AVCodecDescriptor *codec = avcodec_descriptor_get_by_name(name);
     if (!codec) {
@@ -368,7 +388,7 @@ void lite_ffmpeg_mux::create_audio_stream()
     if (!new_stream(&stream, name))
         return;
 
-    stream->time_base = {1, d_ptr->audio.sample_rate};
+    stream->time_base = {1, audio.sample_rate};
 
     void *extradata = NULL;
     uint8_t *extra_data = nullptr;
@@ -381,13 +401,13 @@ void lite_ffmpeg_mux::create_audio_stream()
     auto context = avcodec_alloc_context3(NULL);
     context->codec_type = codec->type;
     context->codec_id = codec->id;
-    context->bit_rate = (int64_t)d_ptr->audio.abitrate * 1000;
-    auto channels = d_ptr->audio.channels;
+    context->bit_rate = (int64_t)audio.abitrate * 1000;
+    auto channels = audio.channels;
 #if LIBAVUTIL_VERSION_INT < AV_VERSION_INT(57, 24, 100)
     context->channels = channels;
 #endif
-    context->sample_rate = d_ptr->audio.sample_rate;
-    context->frame_size = d_ptr->audio.frame_size;
+    context->sample_rate = audio.sample_rate;
+    context->frame_size = audio.frame_size;
     context->sample_fmt = AV_SAMPLE_FMT_S16;
     context->time_base = stream->time_base;
     context->extradata = (uint8_t *)extradata;
@@ -408,15 +428,28 @@ void lite_ffmpeg_mux::create_audio_stream()
 
     avcodec_parameters_from_context(stream->codecpar, context);
 
-    d_ptr->audio_infos.stream = stream;
-    d_ptr->audio_infos.ctx = context;
+    if (d_ptr->params.tracks > 1) {
+        char title[16];
+        snprintf(title, sizeof(title), "Track %d", (int)idx + 1);
+        av_dict_set(&stream->metadata, "title", title, 0);
+    }
+
+    d_ptr->audio_infos[idx].stream = stream;
+    d_ptr->audio_infos[idx].ctx = context;
     d_ptr->num_audio_streams++;
 }
 
 bool lite_ffmpeg_mux::init_streams()
 {
     create_video_stream();
-    create_audio_stream();
+
+    /* packets are routed to streams by track, so a track without an
+     * encoder ends the list rather than shifting the ones after it */
+    for (int i = 0; i < d_ptr->params.tracks; i++) {
+        create_audio_stream(i);
+        if (d_ptr->num_audio_streams != i + 1)
+            break;
+    }
 
     if (!d_ptr->video_stream && !d_ptr->num_audio_streams)
         return false;
@@ -436,9 +469,11 @@ void lite_ffmpeg_mux::free_avformat()
         d_ptr->output = nullptr;
     }
 
-    avcodec_free_context(&d_ptr->audio_infos.ctx);
+    for (auto &info : d_ptr->audio_infos) {
+        avcodec_free_context(&info.ctx);
+        info = {};
+    }
 
-    d_ptr->audio_infos.ctx = nullptr;
     d_ptr->video_stream = nullptr;
     d_ptr->num_audio_streams = 0;
 }
@@ -15,6 +15,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 ******************************************************************************/
 
+#include <string.h>
 #include <stdio.h>
 #include "lite-obs/output/flv_mux.h"
 #include "librtmp/rtmp_helpers.h"
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "rtmp.h"
+#include <string.h>
 
 static inline AVal *flv_str(AVal *out, const char *str)
 {
@@ -0,0 +1,195 @@
+#include "lite-obs/output/rtmp_dbr.h"
+#include "lite-obs/util/log.h"
+
+#define DBR_MSEC_TO_NSEC 1000000ULL
+
+/* queue delay that counts as congestion, and the one under which it is clear */
+#define DBR_TRIGGER_USEC 200000LL
+#define DBR_CLEAR_USEC 50000LL
+
+/* wait between two cuts so the last one shows in the queue first */
+#define DBR_DEC_HOLD_NS (1000ULL * DBR_MSEC_TO_NSEC)
+#define DBR_INC_INTERVAL_NS (1000ULL * DBR_MSEC_TO_NSEC)
+#define DBR_PROBE_INTERVAL_NS (3000ULL * DBR_MSEC_TO_NSEC)
+#define DBR_PROBE_NS (2000ULL * DBR_MSEC_TO_NSEC)
+
+#define DBR_SAMPLE_INTERVAL_NS (10ULL * DBR_MSEC_TO_NSEC)
+#define DBR_MIN_ESTIMATE_NS (500ULL * DBR_MSEC_TO_NSEC)
+#define DBR_MAX_ESTIMATE_NS (1000ULL * DBR_MSEC_TO_NSEC)
+
+#define DBR_MIN_BITRATE 50
+
+void rtmp_dbr::reset(long video_bitrate, long audio_bitrate, uint64_t time_ns)
+{
+    first = 0;
+    count = 0;
+    unacked = 0;
+
+    orig = video_bitrate;
+    audio = audio_bitrate;
+    cur_bitrate = video_bitrate;
+    prev_bitrate = 0;
+    est_bitrate = 0;
+    total_est = 0;
+    step = video_bitrate / 20 > DBR_MIN_BITRATE ? video_bitrate / 20 : DBR_MIN_BITRATE;
+
+    last_change_ns = time_ns;
+    last_dec_ns = time_ns;
+    dec_delay_usec = 0;
+    clear_since_ns = 0;
+    probe_until_ns = 0;
+}
+
+void rtmp_dbr::add_sample(uint64_t time_ns, uint64_t acked_bytes, uint64_t unacked_bytes)
+{
+    unacked = unacked_bytes;
+
+    if (count) {
+        auto &last = samples[(first + count - 1) % DBR_MAX_SAMPLES];
+        if (time_ns - last.time_ns < DBR_SAMPLE_INTERVAL_NS) {
+            last.acked = acked_bytes;
+            update_estimate();
+            return;
+        }
+    }
+
+    if (count == DBR_MAX_SAMPLES) {
+        first = (first + 1) % DBR_MAX_SAMPLES;
+        count--;
+    }
+    samples[(first + count) % DBR_MAX_SAMPLES] = {time_ns, acked_bytes};
+    count++;
+
+    while (count > 1 && time_ns - samples[(first + 1) % DBR_MAX_SAMPLES].time_ns >= DBR_MAX_ESTIMATE_NS) {
+        first = (first + 1) % DBR_MAX_SAMPLES;
+        count--;
+    }
+
+    update_estimate();
+}
+
+void rtmp_dbr::update_estimate()
+{
+    auto &oldest = samples[first];
+    auto &newest = samples[(first + count - 1) % DBR_MAX_SAMPLES];
+    uint64_t dur = newest.time_ns - oldest.time_ns;
+
+    if (count < 2 || dur < DBR_MIN_ESTIMATE_NS) {
+        est_bitrate = 0;
+        total_est = 0;
+        return;
+    }
+
+    /* bytes per nanosecond times 8e6 is kbps */
+    total_est = (long)((newest.acked - oldest.acked) * 8000000ULL / dur);
+    est_bitrate = total_est - audio;
+    if (est_bitrate < DBR_MIN_BITRATE)
+        est_bitrate = DBR_MIN_BITRATE;
+}
+
+int64_t rtmp_dbr::delay_usec(int64_t queue_usec) const
+{
+    /* the socket backlog drains at the acked rate, kbps is bits per msec */
+    int64_t socket_usec = total_est > 0 ? (int64_t)(unacked * 8000 / (uint64_t)total_est) : 0;
+    return queue_usec + socket_usec;
+}
+
+long rtmp_dbr::set_bitrate(long bitrate, uint64_t time_ns)
+{
+    long floor = orig / 10 > DBR_MIN_BITRATE ? orig / 10 : DBR_MIN_BITRATE;
+    if (bitrate < floor)
+        bitrate = floor;
+    if (bitrate > orig)
+        bitrate = orig;
+    if (bitrate == cur_bitrate)
+        return 0;
+
+    cur_bitrate = bitrate;
+    last_change_ns = time_ns;
+    return bitrate;
+}
+
+long rtmp_dbr::update(uint64_t time_ns, int64_t queue_usec)
+{
+    if (!orig)
+        return 0;
+
+    int64_t delay = delay_usec(queue_usec);
+
+    if (delay >= DBR_TRIGGER_USEC) {
+        clear_since_ns = 0;
+
+        if (probe_until_ns && prev_bitrate) {
+            long bitrate = prev_bitrate;
+            prev_bitrate = 0;
+            probe_until_ns = 0;
+            last_dec_ns = time_ns;
+            blog(LOG_INFO, "bitrate probe failed, going back to: %ld", bitrate);
+            return set_bitrate(bitrate, time_ns);
+        }
+
+        if (time_ns - last_dec_ns < DBR_DEC_HOLD_NS)
+            return 0;
+
+        /* already under the link and draining, leave it be */
+        if (est_bitrate && cur_bitrate < est_bitrate && delay < dec_delay_usec) {
+            dec_delay_usec = delay;
+            return 0;
+        }
+
+        /* under what got through once there is an estimate, less what it
+         * takes to drain the backlog in two seconds, so one step is enough
+         * after a sudden drop. a fixed cut without an estimate */
+        long bitrate = cur_bitrate * 7 / 10;
+        if (est_bitrate) {
+            long backlog = (long)((delay - DBR_TRIGGER_USEC) * total_est / 1000000);
+            bitrate = est_bitrate * 9 / 10 - backlog / 2;
+        }
+        if (bitrate > cur_bitrate * 9 / 10)
+            bitrate = cur_bitrate * 9 / 10;
+
+        last_dec_ns = time_ns;
+        dec_delay_usec = delay;
+        long changed = set_bitrate(bitrate, time_ns);
+        if (changed)
+            blog(LOG_INFO, "bitrate decreased to: %ld, delay: %lld ms, estimate: %ld",
+                 changed, (long long)(delay / 1000), est_bitrate);
+        return changed;
+    }
+
+    if (probe_until_ns && time_ns >= probe_until_ns) {
+        probe_until_ns = 0;
+        prev_bitrate = 0;
+        blog(LOG_INFO, "bitrate probe held at: %ld", cur_bitrate);
+    }
+
+    if (delay >= DBR_CLEAR_USEC) {
+        clear_since_ns = 0;
+        return 0;
+    }
+
+    if (!clear_since_ns)
+        clear_since_ns = time_ns;
+    if (cur_bitrate >= orig)
+        return 0;
+
+    if (!probe_until_ns && time_ns - last_dec_ns >= DBR_PROBE_INTERVAL_NS && time_ns - clear_since_ns >= DBR_INC_INTERVAL_NS) {
+        long bitrate = cur_bitrate * 3 / 2;
+        prev_bitrate = cur_bitrate;
+        probe_until_ns = time_ns + DBR_PROBE_NS;
+        last_dec_ns = time_ns;
+        long changed = set_bitrate(bitrate, time_ns);
+        if (changed)
+            blog(LOG_INFO, "bitrate probing: %ld", changed);
+        return changed;
+    }
+
+    if (time_ns - clear_since_ns >= DBR_INC_INTERVAL_NS && time_ns - last_change_ns >= DBR_INC_INTERVAL_NS) {
+        long changed = set_bitrate(cur_bitrate + step, time_ns);
+        if (changed)
+            blog(LOG_INFO, "bitrate increased to: %ld%s", changed, changed >= orig ? ", done" : "");
+        return changed;
+    }
+
+    return 0;
+}
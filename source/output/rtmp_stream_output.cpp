@@ -6,13 +6,16 @@
 #include "lite-obs/media-io/audio_output.h"
 #include "lite-obs/media-io/video_output.h"
 #include "lite-obs/lite_obs_avc.h"
+#include "lite-obs/lite_obs_platform_config.h"
 
+#include <string.h>
 #include <mutex>
 #include <atomic>
 #include <list>
 #include <thread>
 
 #include "lite-obs/output/flv_mux.h"
+#include "lite-obs/output/rtmp_dbr.h"
 
 extern "C"
 {
@@ -20,30 +23,6 @@ extern "C"
 #include "librtmp/log.h"
 }
 
-#ifndef SEC_TO_NSEC
-#define SEC_TO_NSEC 1000000000ULL
-#endif
-
-#ifndef MSEC_TO_USEC
-#define MSEC_TO_USEC 1000ULL
-#endif
-
-#ifndef MSEC_TO_NSEC
-#define MSEC_TO_NSEC 1000000ULL
-#endif
-
-/* dynamic bitrate coefficients */
-#define DBR_INC_TIMER (30ULL * SEC_TO_NSEC)
-#define DBR_TRIGGER_USEC (200ULL * MSEC_TO_USEC)
-#define MIN_ESTIMATE_DURATION_MS 1000
-#define MAX_ESTIMATE_DURATION_MS 2000
-
-struct dbr_frame {
-    uint64_t send_beg{};
-    uint64_t send_end{};
-    size_t size{};
-};
-
 struct rtmp_stream_output_private
 {
     std::string stream_url;
@@ -90,16 +69,8 @@ struct rtmp_stream_output_private
     int dropped_frames{};
 
     std::mutex dbr_mutex;
-    std::list<std::shared_ptr<dbr_frame>> dbr_frames;
-    size_t dbr_data_size{};
-    uint64_t dbr_inc_timeout{};
-    long audio_bitrate{};
-    long dbr_est_bitrate{};
-    long dbr_orig_bitrate{};
-    long dbr_prev_bitrate{};
-    long dbr_cur_bitrate{};
-    long dbr_inc_bitrate{};
-    bool dbr_enabled{};
+    rtmp_dbr dbr;
+    std::atomic_bool dbr_enabled{};
 
     RTMP rtmp{};
 
@@ -123,6 +94,11 @@ static void log_rtmp(int level, const char *format, va_list args)
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#endif
+
+#if TARGET_PLATFORM == PLATFORM_LINUX || TARGET_PLATFORM == PLATFORM_ANDROID
+#include <linux/sockios.h>
 #endif
 
 bool netif_str_to_addr(struct sockaddr_storage *out, int *addr_len,
@@ -236,8 +212,6 @@ void rtmp_stream_output::i_destroy()
     free_packets();
     os_event_destroy(d_ptr->stop_event);
     os_sem_destroy(d_ptr->send_sem);
-
-    d_ptr->dbr_frames.clear();
 }
 
 void rtmp_stream_output::connect_thread(void *param)
@@ -270,18 +244,17 @@ bool rtmp_stream_output::init_connect()
     auto venc = lite_obs_output_get_video_encoder();
     auto aenc = lite_obs_output_get_audio_encoder(0);
 
-    d_ptr->dbr_frames.clear();
-    d_ptr->audio_bitrate = aenc ? aenc->lite_obs_encoder_bitrate() : 0;
-    d_ptr->dbr_data_size = 0;
-    d_ptr->dbr_orig_bitrate = venc ? venc->lite_obs_encoder_bitrate() : 0;
-    d_ptr->dbr_cur_bitrate = d_ptr->dbr_orig_bitrate;
-    d_ptr->dbr_est_bitrate = 0;
-    d_ptr->dbr_inc_bitrate = d_ptr->dbr_orig_bitrate / 10;
-    d_ptr->dbr_inc_timeout = 0;
-    d_ptr->dbr_enabled = false;
+    long video_bitrate = venc ? venc->lite_obs_encoder_bitrate() : 0;
+    long audio_bitrate = aenc ? aenc->lite_obs_encoder_bitrate() : 0;
+    d_ptr->dbr.reset(video_bitrate, audio_bitrate, os_gettime_ns());
+    /* the bitrate of a shared encoder is the recording's as well, the
+     * stream must not lower it for a congested link */
+    d_ptr->dbr_enabled = video_bitrate > 0 && venc->obs_encoder_output_count() <= 1;
 
     if (d_ptr->dbr_enabled) {
-        blog(LOG_INFO, "Dynamic bitrate enabled.  Dropped frames begone!");
+        blog(LOG_INFO, "Dynamic bitrate enabled, starting at %ld kbps", video_bitrate);
+    } else if (video_bitrate > 0) {
+        blog(LOG_INFO, "Dynamic bitrate disabled, the video encoder feeds other outputs");
     }
 
     if (drop_p < (drop_b + 200))
@@ -486,16 +459,14 @@ bool rtmp_stream_output::send_audio_header()
     if (!aencoder)
         return false;
 
-    auto packet = std::make_shared<encoder_packet>();
+    auto packet = encoder_packet_create();
     packet->type = obs_encoder_type::OBS_ENCODER_AUDIO;
     packet->timebase_den = 1;
 
     uint8_t *header = nullptr;
     size_t size = 0;
     aencoder->lite_obs_encoder_get_extra_data(&header, &size);
-    packet->data = std::make_shared<std::vector<uint8_t>>();
-    packet->data->resize(size);
-    memcpy(packet->data->data(), header, size);
+    packet->data = packet_pool_copy(header, size);
     return send_packet(packet, true) >= 0;
 }
 
@@ -505,7 +476,7 @@ bool rtmp_stream_output::send_video_header()
     if (!vencoder)
         return false;
 
-    auto packet = std::make_shared<encoder_packet>();
+    auto packet = encoder_packet_create();
     packet->type = obs_encoder_type::OBS_ENCODER_VIDEO;
     packet->timebase_den = 1;
     packet->keyframe = true;
@@ -514,8 +485,9 @@ bool rtmp_stream_output::send_video_header()
     size_t size = 0;
     vencoder->lite_obs_encoder_get_extra_data(&header, &size);
 
-    packet->data = std::make_shared<std::vector<uint8_t>>();
-    obs_parse_avc_header(*packet->data, header, size);
+    std::vector<uint8_t> avc_header;
+    obs_parse_avc_header(avc_header, header, size);
+    packet->data = packet_pool_copy(avc_header.data(), avc_header.size());
     return send_packet(packet, true) >= 0;
 }
 
@@ -600,38 +572,81 @@ int rtmp_stream_output::send_packet(const std::shared_ptr<encoder_packet> &packe
     return ret;
 }
 
-void rtmp_stream_output::dbr_add_frame(std::shared_ptr<dbr_frame> back)
+/* bytes written to the socket the peer has not acknowledged yet. returning
+ * 0 where the platform cannot tell makes the estimate the write rate, which
+ * is what the kernel accepts and only trails the link once the send buffer
+ * is full */
+uint64_t rtmp_stream_output::socket_unacked_bytes()
 {
-    d_ptr->dbr_frames.push_back(back);
-    auto front = d_ptr->dbr_frames.front();
+    int unacked = 0;
+    auto sock = d_ptr->rtmp.m_sb.sb_socket;
+
+#if TARGET_PLATFORM == PLATFORM_LINUX || TARGET_PLATFORM == PLATFORM_ANDROID
+    /* unsent plus unacknowledged, unlike FIONREAD which is the receive side */
+    if (ioctl(sock, SIOCOUTQ, &unacked) < 0)
+        unacked = 0;
+#elif TARGET_PLATFORM == PLATFORM_MAC || TARGET_PLATFORM == PLATFORM_IOS
+    socklen_t len = sizeof(unacked);
+    if (getsockopt(sock, SOL_SOCKET, SO_NWRITE, &unacked, &len) < 0)
+        unacked = 0;
+#else
+    (void)sock;
+#endif
 
-    d_ptr->dbr_data_size += back->size;
+    return unacked > 0 ? (uint64_t)unacked : 0;
+}
 
-    auto dur = (back->send_end - front->send_beg) / 1000000;
+void rtmp_stream_output::dbr_add_sample()
+{
+    uint64_t unacked = socket_unacked_bytes();
+    uint64_t sent = d_ptr->total_bytes_sent;
+    uint64_t acked = sent > unacked ? sent - unacked : 0;
 
-    if (dur >= MAX_ESTIMATE_DURATION_MS) {
-        d_ptr->dbr_data_size -= front->size;
-        d_ptr->dbr_frames.pop_front();
-    }
+    std::lock_guard<std::mutex> lock(d_ptr->dbr_mutex);
+    d_ptr->dbr.add_sample(os_gettime_ns(), acked, unacked);
+}
 
-    d_ptr->dbr_est_bitrate = (dur >= MIN_ESTIMATE_DURATION_MS) ? (long)(d_ptr->dbr_data_size * 1000 / dur) : 0;
-    d_ptr->dbr_est_bitrate *= 8;
-    d_ptr->dbr_est_bitrate /= 1000;
+void rtmp_stream_output::dbr_update(int64_t buffer_duration_usec)
+{
+    /* another output joined the encoder, hand it back its bitrate */
+    auto vencoder = lite_obs_output_get_video_encoder();
+    if (vencoder && vencoder->obs_encoder_output_count() > 1) {
+        blog(LOG_INFO, "Dynamic bitrate disabled, the video encoder feeds other outputs");
+        d_ptr->dbr_enabled = false;
+        dbr_restore_bitrate();
+        return;
+    }
 
-    if (d_ptr->dbr_est_bitrate) {
-        d_ptr->dbr_est_bitrate -= d_ptr->audio_bitrate;
-        if (d_ptr->dbr_est_bitrate < 50)
-            d_ptr->dbr_est_bitrate = 50;
+    long bitrate;
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->dbr_mutex);
+        bitrate = d_ptr->dbr.update(os_gettime_ns(), buffer_duration_usec);
     }
+
+    if (bitrate)
+        dbr_set_bitrate(bitrate);
 }
 
-void rtmp_stream_output::dbr_set_bitrate()
+void rtmp_stream_output::dbr_set_bitrate(long bitrate)
 {
     auto vencoder = lite_obs_output_get_video_encoder();
     if (!vencoder)
         return;
 
-    vencoder->lite_obs_encoder_update_bitrate((int)d_ptr->dbr_cur_bitrate);
+    vencoder->lite_obs_encoder_update_bitrate((int)bitrate);
+}
+
+void rtmp_stream_output::dbr_restore_bitrate()
+{
+    long bitrate = 0;
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->dbr_mutex);
+        if (d_ptr->dbr.bitrate() != d_ptr->dbr.orig_bitrate())
+            bitrate = d_ptr->dbr.orig_bitrate();
+    }
+
+    if (bitrate)
+        dbr_set_bitrate(bitrate);
 }
 
 void rtmp_stream_output::send_thread_internal()
@@ -659,23 +674,13 @@ void rtmp_stream_output::send_thread_internal()
             }
         }
 
-        auto frame = std::make_shared<dbr_frame>();
-        if (d_ptr->dbr_enabled) {
-            frame->send_beg = os_gettime_ns();
-            frame->size = packet->data->size();
-        }
-
         if (send_packet(packet, false) < 0) {
             d_ptr->disconnected = true;
             break;
         }
 
-        if (d_ptr->dbr_enabled) {
-            frame->send_end = os_gettime_ns();
-
-            std::lock_guard<std::mutex> lock(d_ptr->dbr_mutex);
-            dbr_add_frame(frame);
-        }
+        if (d_ptr->dbr_enabled)
+            dbr_add_sample();
     }
 
     bool encode_error = d_ptr->encode_error;
@@ -707,12 +712,8 @@ void rtmp_stream_output::send_thread_internal()
     d_ptr->sent_first_media_packet = false;
 
     /* reset bitrate on stop */
-    if (d_ptr->dbr_enabled) {
-        if (d_ptr->dbr_cur_bitrate != d_ptr->dbr_orig_bitrate) {
-            d_ptr->dbr_cur_bitrate = d_ptr->dbr_orig_bitrate;
-            dbr_set_bitrate();
-        }
-    }
+    if (d_ptr->dbr_enabled)
+        dbr_restore_bitrate();
 }
 
 void rtmp_stream_output::send_thread(void *param)
@@ -846,6 +847,18 @@ void rtmp_stream_output::connect_thread_internal()
 
 bool rtmp_stream_output::i_start()
 {
+    /* flv carries h264 and aac only */
+    auto vencoder = lite_obs_output_get_video_encoder();
+    if (vencoder && strcmp(vencoder->lite_obs_encoder_codec(), "h264") != 0) {
+        blog(LOG_WARNING, "rtmp stream: %s video is not supported, use h264", vencoder->lite_obs_encoder_codec());
+        return false;
+    }
+    auto aencoder = lite_obs_output_get_audio_encoder(0);
+    if (aencoder && strcmp(aencoder->lite_obs_encoder_codec(), "AAC") != 0) {
+        blog(LOG_WARNING, "rtmp stream: %s audio is not supported, use aac", aencoder->lite_obs_encoder_codec());
+        return false;
+    }
+
     if (!lite_obs_output_can_begin_data_capture())
         return false;
     if (!lite_obs_output_initialize_encoders())
@@ -895,58 +908,6 @@ bool rtmp_stream_output::add_packet(const std::shared_ptr<encoder_packet> &packe
     return true;
 }
 
-void rtmp_stream_output::dbr_inc_bitrate()
-{
-    d_ptr->dbr_prev_bitrate = d_ptr->dbr_cur_bitrate;
-    d_ptr->dbr_cur_bitrate += d_ptr->dbr_inc_bitrate;
-
-    if (d_ptr->dbr_cur_bitrate >= d_ptr->dbr_orig_bitrate) {
-        d_ptr->dbr_cur_bitrate = d_ptr->dbr_orig_bitrate;
-        blog(LOG_INFO, "bitrate increased to: %ld, done", d_ptr->dbr_cur_bitrate);
-    } else if (d_ptr->dbr_cur_bitrate < d_ptr->dbr_orig_bitrate) {
-        d_ptr->dbr_inc_timeout = os_gettime_ns() + DBR_INC_TIMER;
-        blog(LOG_INFO, "bitrate increased to: %ld, waiting", d_ptr->dbr_cur_bitrate);
-    }
-}
-
-bool rtmp_stream_output::dbr_bitrate_lowered()
-{
-    long prev_bitrate = d_ptr->dbr_prev_bitrate;
-    long est_bitrate = 0;
-    long new_bitrate;
-
-    if (d_ptr->dbr_est_bitrate &&
-        d_ptr->dbr_est_bitrate < d_ptr->dbr_cur_bitrate) {
-        d_ptr->dbr_data_size = 0;
-        d_ptr->dbr_frames.pop_front();
-        est_bitrate = d_ptr->dbr_est_bitrate / 100 * 100;
-        if (est_bitrate < 50) {
-            est_bitrate = 50;
-        }
-    }
-
-    if (est_bitrate) {
-        new_bitrate = est_bitrate;
-
-    } else if (prev_bitrate) {
-        new_bitrate = prev_bitrate;
-        blog(LOG_INFO, "going back to prev bitrate");
-
-    } else {
-        return false;
-    }
-
-    if (new_bitrate == d_ptr->dbr_cur_bitrate) {
-        return false;
-    }
-
-    d_ptr->dbr_prev_bitrate = 0;
-    d_ptr->dbr_cur_bitrate = new_bitrate;
-    d_ptr->dbr_inc_timeout = os_gettime_ns() + DBR_INC_TIMER;
-    blog(LOG_INFO, "bitrate decreased to: %ld", d_ptr->dbr_cur_bitrate);
-    return true;
-}
-
 std::shared_ptr<encoder_packet> rtmp_stream_output::find_first_video_packet()
 {
     for (auto iter = d_ptr->packets.begin(); iter != d_ptr->packets.end(); iter++) {
@@ -1004,17 +965,11 @@ void rtmp_stream_output::check_to_drop_frames(bool pframes)
     int64_t drop_threshold = pframes ? d_ptr->pframe_drop_threshold_usec
                                      : d_ptr->drop_threshold_usec;
 
-    if (!pframes && d_ptr->dbr_enabled) {
-        if (d_ptr->dbr_inc_timeout) {
-            uint64_t t = os_gettime_ns();
+    auto first = num_packets < 5 ? nullptr : find_first_video_packet();
 
-            if (t >= d_ptr->dbr_inc_timeout) {
-                d_ptr->dbr_inc_timeout = 0;
-                dbr_inc_bitrate();
-                dbr_set_bitrate();
-            }
-        }
-    }
+    /* the controller also needs the clear queue to raise the bitrate */
+    if (!pframes && d_ptr->dbr_enabled)
+        dbr_update(first ? d_ptr->last_dts_usec - first->dts_usec : 0);
 
     if (num_packets < 5) {
         if (!pframes)
@@ -1022,7 +977,6 @@ void rtmp_stream_output::check_to_drop_frames(bool pframes)
         return;
     }
 
-    auto first = find_first_video_packet();
     if (!first)
         return;
 
@@ -1035,28 +989,10 @@ void rtmp_stream_output::check_to_drop_frames(bool pframes)
             (float)buffer_duration_usec / (float)drop_threshold;
     }
 
-    /* alternatively, drop only pframes:
-     * (!pframes && stream->dbr_enabled)
-     * but let's test without dropping frames
-     * at all first */
-    if (d_ptr->dbr_enabled) {
-        bool bitrate_changed = false;
-
-        if (pframes) {
-            return;
-        }
-
-        if ((uint64_t)buffer_duration_usec >= DBR_TRIGGER_USEC) {
-            std::lock_guard<std::mutex> lock(d_ptr->dbr_mutex);
-            bitrate_changed = dbr_bitrate_lowered();
-        }
-
-        if (bitrate_changed) {
-            blog(LOG_DEBUG, "buffer_duration_msec: %lld", buffer_duration_usec / 1000);
-            dbr_set_bitrate();
-        }
+    /* with dynamic bitrate only drop p-frames, the last resort when the
+     * link falls faster than the bitrate can follow */
+    if (!pframes && d_ptr->dbr_enabled)
         return;
-    }
 
     if (buffer_duration_usec > drop_threshold) {
         blog(LOG_DEBUG, "buffer_duration_usec: %lld", buffer_duration_usec);
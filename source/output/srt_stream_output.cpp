@@ -1,4 +1,5 @@
 #include "lite-obs/output/srt_stream_output.h"
+#include <string.h>
 #include <thread>
 #include <mutex>
 #include <list>
@@ -337,13 +338,16 @@ bool mpeg_ts_output::create_audio_stream(ffmpeg_data *data, int idx)
         return false;
 
     auto aoi = audio->audio_output_get_info();
+    /* opus resamples to 48 kHz, packets are timed at the encoder's rate */
+    auto aencoder = lite_obs_output_get_audio_encoder(idx);
+    int sample_rate = aencoder ? (int)aencoder->lite_obs_encoder_get_sample_rate() : (int)aoi->samples_per_sec;
     context = avcodec_alloc_context3(NULL);
     context->codec_type = codec->type;
     context->codec_id = codec->id;
     context->bit_rate = (int64_t)data->config.audio_bitrate * 1000;
-    context->time_base = {1, (int)aoi->samples_per_sec};
+    context->time_base = {1, sample_rate};
     context->channels = get_audio_channels(aoi->speakers);
-    context->sample_rate = aoi->samples_per_sec;
+    context->sample_rate = sample_rate;
     context->channel_layout = av_get_default_channel_layout(context->channels);
 
     //avutil default channel layout for 5 channels is 5.0 ; fix for 4.1
@@ -355,7 +359,7 @@ bool mpeg_ts_output::create_audio_stream(ffmpeg_data *data, int idx)
 
     avstream->time_base = context->time_base;
 
-    data->audio_samplerate = aoi->samples_per_sec;
+    data->audio_samplerate = sample_rate;
     data->audio_format = convert_ffmpeg_sample_format(context->sample_fmt);
     data->audio_planes = get_audio_planes(data->audio_format, aoi->speakers);
     data->audio_size = get_audio_size(data->audio_format, aoi->speakers, 1);
@@ -709,6 +713,8 @@ bool mpeg_ts_output::set_config()
     config.video_encoder = vencoder->lite_obs_encoder_codec();
     if (strcmp(config.video_encoder, "h264") == 0)
         config.video_encoder_id = AV_CODEC_ID_H264;
+    else if (strcmp(config.video_encoder, "hevc") == 0)
+        config.video_encoder_id = AV_CODEC_ID_HEVC;
     else
         config.video_encoder_id = AV_CODEC_ID_AV1;
 
@@ -718,10 +724,15 @@ bool mpeg_ts_output::set_config()
     config.gop_size = keyint_sec ? keyint_sec * video_info->fps_num / video_info->fps_den : 250;
 
     /* 3. Audio settings */
-    // 3.a) set audio encoder and id to aac
+    // 3.a) set audio encoder and id to aac or opus
     auto aencoder = lite_obs_output_get_audio_encoder(0);
-    config.audio_encoder = "aac";
-    config.audio_encoder_id = AV_CODEC_ID_AAC;
+    if (strcmp(aencoder->lite_obs_encoder_codec(), "opus") == 0) {
+        config.audio_encoder = "opus";
+        config.audio_encoder_id = AV_CODEC_ID_OPUS;
+    } else {
+        config.audio_encoder = "aac";
+        config.audio_encoder_id = AV_CODEC_ID_AAC;
+    }
 
     // 3.b) get audio bitrate from the audio encoder.
     config.audio_bitrate = aencoder->lite_obs_encoder_bitrate();
@@ -0,0 +1,101 @@
+#include "lite-obs/util/audio_frame_pool.h"
+#include "lite-obs/util/audio_ring.h"
+#include "lite-obs/lite_obs_platform_config.h"
+
+#include <stdlib.h>
+
+#if TARGET_PLATFORM == PLATFORM_WIN32
+#include <malloc.h>
+#endif
+
+/* the frames are allocated once and reused for the lifetime of the encoder,
+ * a whole number of pages */
+static void *alloc_pages(size_t size)
+{
+    size_t page = os_page_size();
+    size = (size + page - 1) / page * page;
+
+#if TARGET_PLATFORM == PLATFORM_WIN32
+    return _aligned_malloc(size, page);
+#else
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, page, size) != 0)
+        return nullptr;
+    return ptr;
+#endif
+}
+
+static void free_pages(void *ptr)
+{
+#if TARGET_PLATFORM == PLATFORM_WIN32
+    _aligned_free(ptr);
+#else
+    ::free(ptr);
+#endif
+}
+
+audio_frame_pool::~audio_frame_pool()
+{
+    free();
+}
+
+bool audio_frame_pool::init(size_t planes, size_t plane_bytes, size_t count)
+{
+    free();
+
+    if (!planes || planes > MAX_AV_PLANES || !plane_bytes || !count)
+        return false;
+
+    size_t page = os_page_size();
+    size_t stride = (planes * plane_bytes + page - 1) / page * page;
+
+    block = (uint8_t *)alloc_pages(stride * count);
+    if (!block)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    frames.resize(count);
+    free_frames.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        auto &frame = frames[i];
+        frame.planes = planes;
+        frame.plane_bytes = plane_bytes;
+        for (size_t j = 0; j < planes; j++)
+            frame.data[j] = block + i * stride + j * plane_bytes;
+
+        free_frames.push_back(&frame);
+    }
+
+    return true;
+}
+
+void audio_frame_pool::free()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    free_frames.clear();
+    frames.clear();
+
+    if (block)
+        free_pages(block);
+    block = nullptr;
+}
+
+audio_frame_buffer *audio_frame_pool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (free_frames.empty())
+        return nullptr;
+
+    auto frame = free_frames.back();
+    free_frames.pop_back();
+    return frame;
+}
+
+void audio_frame_pool::release(audio_frame_buffer *frame)
+{
+    if (!frame)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    free_frames.push_back(frame);
+}
@@ -0,0 +1,142 @@
+#include "lite-obs/util/audio_ring.h"
+#include "lite-obs/lite_obs_platform_config.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#if TARGET_PLATFORM == PLATFORM_WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static size_t query_page_size()
+{
+#if TARGET_PLATFORM == PLATFORM_WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+#else
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+#endif
+}
+
+size_t os_page_size()
+{
+    static const size_t page_size = query_page_size();
+    return page_size;
+}
+
+audio_ring::~audio_ring()
+{
+    free();
+}
+
+static size_t round_to_pages(size_t size)
+{
+    size_t page = os_page_size();
+    return (size + page - 1) / page * page;
+}
+
+bool audio_ring::init(size_t capacity, size_t limit)
+{
+    capacity = round_to_pages(capacity);
+    limit = limit ? round_to_pages(limit) : capacity;
+    if (limit < capacity)
+        limit = capacity;
+
+    clear();
+    if (capacity && capacity <= cap) {
+        max = limit > cap ? limit : cap;
+        return true;
+    }
+
+    free();
+    if (!capacity)
+        return false;
+
+    buf = (uint8_t *)malloc(capacity);
+    if (!buf)
+        return false;
+
+    cap = capacity;
+    max = limit;
+    return true;
+}
+
+/* doubles until needed fits, at most to the limit, and moves the contents
+ * to the front of the new storage */
+bool audio_ring::grow(size_t needed)
+{
+    if (needed > max)
+        return false;
+
+    size_t capacity = cap ? cap : os_page_size();
+    while (capacity < needed)
+        capacity *= 2;
+    capacity = round_to_pages(capacity);
+    if (capacity > max)
+        capacity = max;
+
+    auto data = (uint8_t *)malloc(capacity);
+    if (!data)
+        return false;
+
+    if (count)
+        peek_front(data, count);
+    if (buf)
+        ::free(buf);
+
+    buf = data;
+    cap = capacity;
+    start = 0;
+    return true;
+}
+
+void audio_ring::free()
+{
+    if (buf)
+        ::free(buf);
+
+    buf = nullptr;
+    cap = 0;
+    max = 0;
+    start = 0;
+    count = 0;
+}
+
+bool audio_ring::push_back_zero(size_t bytes)
+{
+    return push_back(nullptr, bytes);
+}
+
+bool audio_ring::place(size_t position, const void *data, size_t bytes)
+{
+    if (position + bytes > cap && !grow(position + bytes))
+        return false;
+
+    if (position > count)
+        write_at(count, nullptr, position - count);
+
+    write_at(position, data, bytes);
+    if (position + bytes > count)
+        count = position + bytes;
+    return true;
+}
+
+void audio_ring::pop_back(size_t bytes)
+{
+    assert(bytes <= count);
+
+    count -= bytes;
+    if (!count)
+        start = 0;
+}
+
+void audio_ring::clear()
+{
+    start = 0;
+    count = 0;
+}
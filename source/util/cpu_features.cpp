@@ -0,0 +1,65 @@
+#include "lite-obs/util/cpu_features.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+
+bool cpu_has_sse2()
+{
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+}
+
+bool cpu_has_sse41()
+{
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+}
+
+bool cpu_has_avx2()
+{
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+#else
+bool cpu_has_sse2()
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+bool cpu_has_sse41()
+{
+    return __builtin_cpu_supports("sse4.1");
+}
+
+bool cpu_has_avx2()
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+#else
+bool cpu_has_sse2()
+{
+    return false;
+}
+
+bool cpu_has_sse41()
+{
+    return false;
+}
+
+bool cpu_has_avx2()
+{
+    return false;
+}
+#endif
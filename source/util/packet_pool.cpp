@@ -0,0 +1,201 @@
+#include "lite-obs/util/packet_pool.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <mutex>
+
+/* 256 bytes up to 4 MB in steps of 4, bigger payloads get a block of their
+ * own that is freed instead of cached */
+#define PACKET_POOL_MIN_SHIFT 8
+#define PACKET_POOL_CLASSES 8
+#define PACKET_POOL_OVERSIZE PACKET_POOL_CLASSES
+
+/* free blocks kept per class, about 8 MB of each class but at least 4 and at
+ * most 256 blocks */
+#define PACKET_POOL_CACHE_BYTES (8 * 1024 * 1024)
+#define PACKET_POOL_CACHE_MIN 4
+#define PACKET_POOL_CACHE_MAX 256
+
+static inline size_t class_size(uint32_t size_class)
+{
+    return (size_t)1 << (PACKET_POOL_MIN_SHIFT + size_class * 2);
+}
+
+static inline uint32_t size_to_class(size_t size)
+{
+    for (uint32_t i = 0; i < PACKET_POOL_CLASSES; i++) {
+        if (size <= class_size(i))
+            return i;
+    }
+    return PACKET_POOL_OVERSIZE;
+}
+
+class packet_pool
+{
+public:
+    packet_pool() {
+        for (uint32_t i = 0; i < PACKET_POOL_CLASSES; i++) {
+            size_t count = PACKET_POOL_CACHE_BYTES / class_size(i);
+            if (count < PACKET_POOL_CACHE_MIN)
+                count = PACKET_POOL_CACHE_MIN;
+            else if (count > PACKET_POOL_CACHE_MAX)
+                count = PACKET_POOL_CACHE_MAX;
+            classes[i].max_free = count;
+        }
+    }
+
+    static packet_pool *instance() {
+        /* never destroyed, packets can still be released by other static
+         * objects while the process exits */
+        static packet_pool *pool = new packet_pool;
+        return pool;
+    }
+
+    packet_buffer *acquire(size_t size) {
+        uint32_t size_class = size_to_class(size);
+        packet_buffer *buf = nullptr;
+
+        if (size_class != PACKET_POOL_OVERSIZE) {
+            auto &c = classes[size_class];
+            std::lock_guard<std::mutex> lock(c.mutex);
+            buf = c.free;
+            if (buf) {
+                c.free = buf->next;
+                c.free_count--;
+            }
+        }
+
+        if (!buf) {
+            size_t cap = size_class == PACKET_POOL_OVERSIZE ? size : class_size(size_class);
+            void *block = malloc(sizeof(packet_buffer) + cap);
+            if (!block)
+                return nullptr;
+
+            buf = new (block) packet_buffer;
+            buf->size_class = size_class;
+            buf->cap = cap;
+        }
+
+        buf->next = nullptr;
+        buf->bytes = size;
+        buf->refs.store(1, std::memory_order_relaxed);
+
+        blocks_in_use.fetch_add(1, std::memory_order_relaxed);
+        bytes_in_use.fetch_add(buf->cap, std::memory_order_relaxed);
+        return buf;
+    }
+
+    void release(packet_buffer *buf) {
+        blocks_in_use.fetch_sub(1, std::memory_order_relaxed);
+        bytes_in_use.fetch_sub(buf->cap, std::memory_order_relaxed);
+
+        if (buf->size_class != PACKET_POOL_OVERSIZE) {
+            auto &c = classes[buf->size_class];
+            std::lock_guard<std::mutex> lock(c.mutex);
+            if (c.free_count < c.max_free) {
+                buf->next = c.free;
+                c.free = buf;
+                c.free_count++;
+                return;
+            }
+        }
+
+        buf->~packet_buffer();
+        free(buf);
+    }
+
+    static packet_data wrap(packet_buffer *buf) { return packet_data(buf); }
+
+    std::atomic_size_t blocks_in_use{};
+    std::atomic_size_t bytes_in_use{};
+
+private:
+    struct size_class_list {
+        std::mutex mutex;
+        packet_buffer *free{};
+        size_t free_count{};
+        size_t max_free{};
+    };
+
+    size_class_list classes[PACKET_POOL_CLASSES];
+};
+
+void packet_data::reset()
+{
+    if (!buf)
+        return;
+
+    if (buf->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        packet_pool::instance()->release(buf);
+    buf = nullptr;
+}
+
+bool packet_data::resize(size_t size)
+{
+    if (!buf) {
+        *this = packet_pool_alloc(size);
+        return buf != nullptr;
+    }
+
+    if (size <= buf->cap) {
+        buf->bytes = size;
+        return true;
+    }
+
+    packet_data bigger = packet_pool_alloc(size);
+    if (!bigger)
+        return false;
+
+    memcpy(bigger->data(), buf->data(), buf->bytes);
+    swap(bigger);
+    return true;
+}
+
+bool packet_data::append(const void *data, size_t size)
+{
+    size_t old_size = buf ? buf->bytes : 0;
+    if (!resize(old_size + size))
+        return false;
+
+    memcpy(buf->data() + old_size, data, size);
+    return true;
+}
+
+packet_data packet_pool_alloc(size_t size)
+{
+    auto pool = packet_pool::instance();
+    return packet_pool::wrap(pool->acquire(size));
+}
+
+packet_data packet_pool_copy(const void *data, size_t size)
+{
+    auto out = packet_pool_alloc(size);
+    if (out && size)
+        memcpy(out->data(), data, size);
+    return out;
+}
+
+void *packet_pool_alloc_raw(size_t size)
+{
+    auto buf = packet_pool::instance()->acquire(size);
+    return buf ? buf->data() : nullptr;
+}
+
+void packet_pool_free_raw(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    auto buf = (packet_buffer *)ptr - 1;
+    packet_pool::instance()->release(buf);
+}
+
+size_t packet_pool_blocks_in_use()
+{
+    return packet_pool::instance()->blocks_in_use.load(std::memory_order_relaxed);
+}
+
+size_t packet_pool_bytes_in_use()
+{
+    return packet_pool::instance()->bytes_in_use.load(std::memory_order_relaxed);
+}
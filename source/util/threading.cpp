@@ -1,5 +1,7 @@
 #include "lite-obs/util/threading.h"
 #include "lite-obs/lite_obs_platform_config.h"
+#include <string.h>
+#include <atomic>
 #include <chrono>
 #include <thread>
 #include <mutex>
@@ -204,6 +206,100 @@ int os_sem_wait(os_sem_t *sem)
 }
 #endif
 
+#if TARGET_PLATFORM == PLATFORM_LINUX || TARGET_PLATFORM == PLATFORM_ANDROID
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+struct os_wakeup_data {
+    std::atomic_uint32_t signalled{};
+    std::atomic_uint32_t waiters{};
+};
+
+static_assert(sizeof(std::atomic_uint32_t) == sizeof(uint32_t), "futex word must be 32 bits");
+
+static inline long os_futex(std::atomic_uint32_t *addr, int op, uint32_t val)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), op, val, nullptr, nullptr, 0);
+}
+
+int os_wakeup_init(os_wakeup_t **wakeup)
+{
+    *wakeup = new os_wakeup_data;
+    return 0;
+}
+
+void os_wakeup_destroy(os_wakeup_t *wakeup)
+{
+    if (wakeup)
+        delete wakeup;
+}
+
+int os_wakeup_signal(os_wakeup_t *wakeup)
+{
+    if (!wakeup)
+        return -1;
+
+    if (wakeup->signalled.exchange(1) == 0 && wakeup->waiters.load())
+        os_futex(&wakeup->signalled, FUTEX_WAKE_PRIVATE, 1);
+
+    return 0;
+}
+
+int os_wakeup_wait(os_wakeup_t *wakeup)
+{
+    if (!wakeup)
+        return -1;
+
+    while (wakeup->signalled.exchange(0) == 0) {
+        wakeup->waiters++;
+        os_futex(&wakeup->signalled, FUTEX_WAIT_PRIVATE, 0);
+        wakeup->waiters--;
+    }
+
+    return 0;
+}
+#else
+struct os_wakeup_data {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool signalled = false;
+};
+
+int os_wakeup_init(os_wakeup_t **wakeup)
+{
+    *wakeup = new os_wakeup_data;
+    return 0;
+}
+
+void os_wakeup_destroy(os_wakeup_t *wakeup)
+{
+    if (wakeup)
+        delete wakeup;
+}
+
+int os_wakeup_signal(os_wakeup_t *wakeup)
+{
+    if (!wakeup)
+        return -1;
+
+    std::lock_guard<std::mutex> lock(wakeup->mutex);
+    wakeup->signalled = true;
+    wakeup->cond.notify_one();
+    return 0;
+}
+
+int os_wakeup_wait(os_wakeup_t *wakeup)
+{
+    if (!wakeup)
+        return -1;
+
+    std::unique_lock<std::mutex> lock(wakeup->mutex);
+    wakeup->cond.wait(lock, [wakeup] { return wakeup->signalled; });
+    wakeup->signalled = false;
+    return 0;
+}
+#endif
+
 int64_t os_gettime_ns()
 {
     std::chrono::time_point<std::chrono::system_clock> now = std::chrono::system_clock::now();
@@ -253,6 +349,27 @@ bool os_sleepto_ns(uint64_t time_target)
 #endif
     }
 }
+#elif TARGET_PLATFORM == PLATFORM_LINUX || TARGET_PLATFORM == PLATFORM_ANDROID
+#include <time.h>
+#include <errno.h>
+/* sleep on the absolute deadline so that being preempted between reading
+ * the clock and going to sleep doesn't push the wakeup back.
+ * os_gettime_ns is the system clock, so CLOCK_REALTIME it is */
+bool os_sleepto_ns(uint64_t time_target)
+{
+    uint64_t current = os_gettime_ns();
+    if (time_target < current)
+        return false;
+
+    struct timespec req;
+    req.tv_sec = time_target / 1000000000;
+    req.tv_nsec = time_target % 1000000000;
+
+    while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &req, nullptr) == EINTR)
+        ;
+
+    return true;
+}
 #else
 bool os_sleepto_ns(uint64_t time_target)
 {
@@ -277,6 +394,71 @@ bool os_sleepto_ns(uint64_t time_target)
 }
 #endif
 
+/* ticks that have to go out on time, like the audio thread's, should not
+ * wait for a busy thread to use up its time slice first */
+#if TARGET_PLATFORM == PLATFORM_WIN32
+bool os_set_thread_time_critical()
+{
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+}
+#elif TARGET_PLATFORM == PLATFORM_IOS || TARGET_PLATFORM == PLATFORM_MAC
+#include <pthread.h>
+bool os_set_thread_time_critical()
+{
+    return pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0) == 0;
+}
+#elif TARGET_PLATFORM == PLATFORM_LINUX || TARGET_PLATFORM == PLATFORM_ANDROID
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+/* the first version of the kernel's struct sched_attr */
+struct os_sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+#define OS_TIME_CRITICAL_SLICE_NS 100000
+
+/* a short time slice makes the fair scheduler (eevdf, linux 6.12 and up)
+ * run the thread as soon as it wakes instead of at the end of the running
+ * thread's slice, and needs no privileges. older kernels take the request
+ * and ignore the slice, so it is read back: only a kernel that keeps it
+ * reports it. otherwise a real time policy is tried, which works where the
+ * user may use one */
+bool os_set_thread_time_critical()
+{
+#if defined(SYS_sched_setattr) && defined(SYS_sched_getattr)
+    os_sched_attr attr{};
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_OTHER;
+    attr.sched_nice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+    attr.sched_runtime = OS_TIME_CRITICAL_SLICE_NS;
+    if (syscall(SYS_sched_setattr, 0, &attr, 0) == 0) {
+        os_sched_attr set{};
+        if (syscall(SYS_sched_getattr, 0, &set, sizeof(set), 0) == 0 && set.sched_policy == SCHED_OTHER &&
+            set.sched_runtime == OS_TIME_CRITICAL_SLICE_NS)
+            return true;
+    }
+#endif
+
+    struct sched_param param{};
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+#else
+bool os_set_thread_time_critical()
+{
+    return false;
+}
+#endif
+
 void os_breakpoint()
 {
 #ifdef __WIN32
@@ -0,0 +1,105 @@
+#include "test_common.h"
+#include "lite-obs/media-io/audio_math.h"
+
+#include <limits>
+#include <random>
+#include <string.h>
+#include <vector>
+
+/* long enough for the widest kernel's unrolled loop, then every tail the
+ * narrower kernels and the scalar loop pick up */
+#define MATH_MAX_COUNT 67
+#define MATH_MAX_OFFSET 3
+
+/* samples in range, clipping ones, the edges of the clamp, signed zeros,
+ * denormals, infinities and nan */
+static std::vector<float> test_samples(std::mt19937 &rng, size_t count)
+{
+    static const float specials[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 1.0000001f, -1.0000001f, 0.99999994f, -0.99999994f,
+        std::numeric_limits<float>::denorm_min(), -std::numeric_limits<float>::denorm_min(),
+        std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN(), 3.5f, -7.25f, 1e30f,
+    };
+
+    std::uniform_real_distribution<float> in_range(-1.5f, 1.5f);
+    std::uniform_int_distribution<size_t> pick(0, sizeof(specials) / sizeof(specials[0]) * 4);
+
+    std::vector<float> samples(count);
+    for (auto &sample : samples) {
+        size_t i = pick(rng);
+        sample = i < sizeof(specials) / sizeof(specials[0]) ? specials[i] : in_range(rng);
+    }
+    return samples;
+}
+
+/* nan only on one side of a sum, which nan two nans give is up to the
+ * instruction order */
+static void strip_nan(std::vector<float> &samples, const std::vector<float> &other)
+{
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (samples[i] != samples[i] && other[i] != other[i])
+            samples[i] = 0.5f;
+    }
+}
+
+static bool same_bits(const float *a, const float *b, size_t count)
+{
+    return memcmp(a, b, count * sizeof(float)) == 0;
+}
+
+/* every count up to a few times the widest vector, at every alignment, has
+ * to give exactly the bits the reference kernels give. what runs is picked
+ * for this cpu, on avx2 the sse kernels run on the tails */
+int main()
+{
+    fprintf(stderr, "audio math: %s\n", audio_math_isa());
+
+    std::mt19937 rng(1);
+    const float volumes[] = {0.0f, 0.8f, 1.0f, -1.0f, 1.7f, 1e-30f};
+
+    for (size_t offset = 0; offset <= MATH_MAX_OFFSET; offset++) {
+        for (size_t count = 0; count <= MATH_MAX_COUNT; count++) {
+            /* a guard sample after the end catches a kernel running over */
+            auto dst = test_samples(rng, offset + count + 1);
+            auto src = test_samples(rng, offset + count + 1);
+            strip_nan(src, dst);
+
+            auto ref = dst;
+            audio_mix_floats_c(ref.data() + offset, src.data() + offset, count);
+            audio_mix_floats(dst.data() + offset, src.data() + offset, count);
+            CHECK(same_bits(dst.data(), ref.data(), dst.size()));
+
+            for (float vol : volumes) {
+                auto data = test_samples(rng, offset + count + 1);
+                auto expected = data;
+                audio_multiply_floats_c(expected.data() + offset, count, vol);
+                audio_multiply_floats(data.data() + offset, count, vol);
+                CHECK(same_bits(data.data(), expected.data(), data.size()));
+            }
+
+            auto data = test_samples(rng, offset + count + 1);
+            auto expected = data;
+            audio_clamp_floats_c(expected.data() + offset, count);
+            audio_clamp_floats(data.data() + offset, count);
+            CHECK(same_bits(data.data(), expected.data(), data.size()));
+        }
+    }
+
+    /* a whole tick of the mix, as the sources and the output run it */
+    std::vector<float> mix(1024 * 2), mix_ref(1024 * 2);
+    for (int source = 0; source < 32; source++) {
+        auto input = test_samples(rng, mix.size());
+        strip_nan(input, mix);
+        auto input_ref = input;
+
+        audio_multiply_floats(input.data(), input.size(), 0.8f);
+        audio_multiply_floats_c(input_ref.data(), input_ref.size(), 0.8f);
+        audio_mix_floats(mix.data(), input.data(), mix.size());
+        audio_mix_floats_c(mix_ref.data(), input_ref.data(), mix_ref.size());
+    }
+    audio_clamp_floats(mix.data(), mix.size());
+    audio_clamp_floats_c(mix_ref.data(), mix_ref.size());
+    CHECK(same_bits(mix.data(), mix_ref.data(), mix.size()));
+    return 0;
+}
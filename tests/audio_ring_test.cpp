@@ -0,0 +1,186 @@
+#include "test_common.h"
+#include "lite-obs/util/audio_ring.h"
+#include "lite-obs/util/audio_frame_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <set>
+#include <vector>
+
+#define RING_OPS 200000
+#define RING_MAX_BYTES 5000
+#define POOL_FRAMES 4
+#define POOL_PLANES 2
+#define POOL_PLANE_BYTES 4100
+
+static bool same_front(const audio_ring &ring, const std::deque<uint8_t> &model)
+{
+    if (ring.size() != model.size())
+        return false;
+
+    std::vector<uint8_t> data(model.size());
+    ring.peek_front(data.data(), data.size());
+    return std::equal(data.begin(), data.end(), model.begin());
+}
+
+/* random pushes, zero fills, placements and pops against a deque doing the
+ * same, from one page that has to grow, with pushes past the limit refused
+ * and the contents left as they were */
+static void test_ring_model()
+{
+    const size_t page = os_page_size();
+    const size_t limit = 4 * page;
+
+    audio_ring ring;
+    CHECK(ring.init(1, limit));
+    CHECK_EQ(ring.capacity(), page);
+    CHECK_EQ(ring.limit(), limit);
+
+    std::mt19937 rng(1);
+    std::deque<uint8_t> model;
+    std::vector<uint8_t> data(RING_MAX_BYTES);
+    uint8_t next = 0;
+    size_t refused = 0;
+
+    for (int op = 0; op < RING_OPS; op++) {
+        size_t bytes = std::uniform_int_distribution<size_t>(0, RING_MAX_BYTES)(rng);
+        for (size_t i = 0; i < bytes; i++)
+            data[i] = next++;
+
+        size_t before = ring.capacity();
+        switch (rng() % 6) {
+        case 0:
+        case 1:
+            if (ring.push_back(data.data(), bytes)) {
+                model.insert(model.end(), data.begin(), data.begin() + bytes);
+            } else {
+                CHECK(model.size() + bytes > limit);
+                refused++;
+            }
+            break;
+        case 2:
+            if (ring.push_back_zero(bytes))
+                model.insert(model.end(), bytes, 0);
+            else
+                CHECK(model.size() + bytes > limit);
+            break;
+        case 3: {
+            size_t position = std::uniform_int_distribution<size_t>(0, model.size() + 2000)(rng);
+            if (ring.place(position, data.data(), bytes)) {
+                if (position + bytes > model.size())
+                    model.resize(position + bytes, 0);
+                std::copy(data.begin(), data.begin() + bytes, model.begin() + position);
+            } else {
+                CHECK(position + bytes > limit);
+            }
+            break;
+        }
+        case 4: {
+            size_t pop = std::min(bytes, model.size());
+            std::vector<uint8_t> out(pop);
+            ring.pop_front(out.data(), pop);
+            CHECK(std::equal(out.begin(), out.end(), model.begin()));
+            model.erase(model.begin(), model.begin() + pop);
+            break;
+        }
+        case 5: {
+            size_t pop = std::min(bytes / 4, model.size());
+            ring.pop_back(pop);
+            model.resize(model.size() - pop);
+            break;
+        }
+        }
+
+        CHECK(ring.capacity() >= before);
+        CHECK(ring.capacity() <= limit);
+        CHECK_EQ(ring.space(), limit - model.size());
+        CHECK(same_front(ring, model));
+    }
+
+    CHECK_EQ(ring.capacity(), limit);
+    CHECK(refused > 0);
+}
+
+/* a source that pushes a little more than it pops keeps the storage it
+ * started with, wrapping around inside it rather than growing */
+static void test_ring_steady()
+{
+    const size_t page = os_page_size();
+    audio_ring ring;
+    CHECK(ring.init(2 * page, 64 * page));
+
+    std::vector<uint8_t> in(page), out(page);
+    uint8_t next = 0;
+    uint8_t expect = 0;
+    for (int tick = 0; tick < 10000; tick++) {
+        size_t bytes = page * 3 / 4 + (tick % 3) * page / 8;
+        for (size_t i = 0; i < bytes; i++)
+            in[i] = next++;
+        CHECK(ring.push_back(in.data(), bytes));
+
+        while (ring.size() >= page) {
+            ring.pop_front(out.data(), page);
+            for (size_t i = 0; i < page; i++)
+                CHECK_EQ(out[i], expect++);
+        }
+    }
+    CHECK_EQ(ring.capacity(), 2 * page);
+
+    /* init again keeps the allocation but empties it */
+    CHECK(ring.init(page, 64 * page));
+    CHECK_EQ(ring.size(), 0);
+    CHECK_EQ(ring.capacity(), 2 * page);
+}
+
+/* every frame is handed out once, with its planes back to back, and the
+ * pool runs dry instead of allocating */
+static void test_frame_pool()
+{
+    audio_frame_pool pool;
+    CHECK(pool.init(POOL_PLANES, POOL_PLANE_BYTES, POOL_FRAMES));
+    CHECK_EQ(pool.frame_count(), POOL_FRAMES);
+
+    std::vector<audio_frame_buffer *> frames;
+    std::set<audio_frame_buffer *> unique;
+    for (int i = 0; i < POOL_FRAMES; i++) {
+        auto frame = pool.acquire();
+        CHECK(frame);
+        CHECK_EQ(frame->planes, POOL_PLANES);
+        CHECK_EQ(frame->plane_bytes, POOL_PLANE_BYTES);
+        for (size_t plane = 0; plane < POOL_PLANES; plane++) {
+            CHECK(frame->data[plane] == frame->data[0] + plane * POOL_PLANE_BYTES);
+            memset(frame->data[plane], i * POOL_PLANES + (int)plane + 1, POOL_PLANE_BYTES);
+        }
+        frames.push_back(frame);
+        unique.insert(frame);
+    }
+    CHECK_EQ(unique.size(), POOL_FRAMES);
+    CHECK(pool.acquire() == nullptr);
+
+    /* no frame overlaps another */
+    for (int i = 0; i < POOL_FRAMES; i++) {
+        for (size_t plane = 0; plane < POOL_PLANES; plane++) {
+            for (size_t b = 0; b < POOL_PLANE_BYTES; b++)
+                CHECK_EQ(frames[i]->data[plane][b], i * POOL_PLANES + (int)plane + 1);
+        }
+    }
+
+    pool.release(frames[2]);
+    CHECK(pool.acquire() == frames[2]);
+    CHECK(pool.acquire() == nullptr);
+
+    for (auto frame : frames)
+        pool.release(frame);
+    for (int i = 0; i < POOL_FRAMES; i++)
+        CHECK(pool.acquire());
+    CHECK(pool.acquire() == nullptr);
+}
+
+int main()
+{
+    test_ring_model();
+    test_ring_steady();
+    test_frame_pool();
+    return 0;
+}
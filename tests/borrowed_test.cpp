@@ -0,0 +1,181 @@
+#include "test_video.h"
+#include "lite-obs/util/threading.h"
+
+#define BORROWED_WIDTH 64
+#define BORROWED_HEIGHT 64
+#define BORROWED_FPS 30
+#define BORROWED_FRAMES 200
+
+/* what the caller's planes get overwritten with once they are released,
+ * brighter than any frame so a late read shows in the output */
+#define BORROWED_POISON 255
+
+/* frames handed over one at a time, each from the release of the one before */
+#define BORROWED_RELAY_FRAMES 60
+
+struct borrowed_buffer {
+    std::vector<uint8_t> planes[3];
+    int releases{};
+};
+
+struct borrowed_state {
+    std::mutex mutex;
+    std::vector<borrowed_buffer> buffers{BORROWED_FRAMES};
+    std::vector<size_t> order;
+};
+
+struct borrowed_opaque {
+    borrowed_state *state;
+    size_t index;
+};
+
+static borrowed_opaque opaques[BORROWED_FRAMES];
+
+static void release_frame(void *opaque)
+{
+    auto frame = (borrowed_opaque *)opaque;
+    auto state = frame->state;
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto &buffer = state->buffers[frame->index];
+    buffer.releases++;
+    memset(buffer.planes[0].data(), BORROWED_POISON, buffer.planes[0].size());
+    state->order.push_back(frame->index);
+}
+
+static void submit_frame(lite_obs_source *source, borrowed_buffer &buffer, borrowed_opaque *opaque,
+                         void (*release_cb)(void *))
+{
+    const uint8_t *data[MAX_AV_PLANES] = {buffer.planes[0].data(), buffer.planes[1].data(), buffer.planes[2].data()};
+    const int linesize[MAX_AV_PLANES] = {BORROWED_WIDTH, BORROWED_WIDTH / 2, BORROWED_WIDTH / 2};
+    source->lite_source_output_video_borrowed(data, linesize, video_format::VIDEO_FORMAT_I420,
+                                              video_range_type::VIDEO_RANGE_FULL, video_colorspace::VIDEO_CS_709,
+                                              BORROWED_WIDTH, BORROWED_HEIGHT, release_cb, opaque);
+}
+
+static void fill_buffer(borrowed_buffer &buffer, size_t i)
+{
+    buffer.planes[0].assign(BORROWED_WIDTH * BORROWED_HEIGHT, (uint8_t)(40 + (i % 8) * 20));
+    buffer.planes[1].assign(BORROWED_WIDTH * BORROWED_HEIGHT / 4, 128);
+    buffer.planes[2].assign(BORROWED_WIDTH * BORROWED_HEIGHT / 4, 128);
+}
+
+static lite_obs_source *relay_source;
+static borrowed_opaque relay_opaques[BORROWED_RELAY_FRAMES];
+
+static void relay_frame(void *opaque)
+{
+    auto frame = (borrowed_opaque *)opaque;
+    auto state = frame->state;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->buffers[frame->index].releases++;
+        state->order.push_back(frame->index);
+    }
+
+    auto next = frame->index + 1;
+    if (next < BORROWED_RELAY_FRAMES)
+        submit_frame(relay_source, state->buffers[next], &relay_opaques[next], relay_frame);
+}
+
+/* a caller that only has one frame out at a time and hands over the next
+ * one from the release callback, whichever thread that comes in on. the
+ * callback may not run under the source's locks or the chain deadlocks */
+static void test_relay(test_video &video)
+{
+    borrowed_state state;
+    state.buffers.resize(BORROWED_RELAY_FRAMES);
+    for (size_t i = 0; i < BORROWED_RELAY_FRAMES; i++) {
+        fill_buffer(state.buffers[i], i);
+        relay_opaques[i] = {&state, i};
+    }
+
+    auto source = video.add_source(source_type::SOURCE_ASYNCVIDEO);
+    relay_source = source.get();
+    submit_frame(relay_source, state.buffers[0], &relay_opaques[0], relay_frame);
+
+    for (int i = 0; i < 100; i++) {
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.order.size() == BORROWED_RELAY_FRAMES)
+                break;
+        }
+        os_sleep_ms(50);
+    }
+
+    video.graph->remove(source);
+    video.sources.clear();
+    source.reset();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CHECK_EQ(state.order.size(), BORROWED_RELAY_FRAMES);
+    for (size_t i = 0; i < BORROWED_RELAY_FRAMES; i++) {
+        CHECK_EQ(state.buffers[i].releases, 1);
+        CHECK_EQ(state.order[i], i);
+    }
+}
+
+/* pushes borrowed i420 frames into an async source, first faster than the
+ * canvas renders so most are superseded, then in a burst that overflows the
+ * queue, then destroys the source with frames still queued. every buffer
+ * has to come back exactly once, in the order it was handed over, and none
+ * may be read after it came back */
+int main()
+{
+    test_video video;
+    video.start(BORROWED_WIDTH, BORROWED_HEIGHT, BORROWED_FPS);
+
+    test_video_capture capture;
+    video.connect(&capture);
+
+    borrowed_state state;
+    auto source = video.add_source(source_type::SOURCE_ASYNCVIDEO);
+
+    for (size_t i = 0; i < BORROWED_FRAMES; i++) {
+        fill_buffer(state.buffers[i], i);
+        opaques[i] = {&state, i};
+        submit_frame(source.get(), state.buffers[i], &opaques[i], release_frame);
+
+        if (i < BORROWED_FRAMES * 3 / 4)
+            os_sleep_ms(5);
+    }
+
+    size_t frames = 0;
+    {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        frames = capture.timestamps.size();
+    }
+    CHECK(capture.wait_frames(frames + 5));
+
+    /* the source goes away with frames still queued or cached, the render
+     * thread may hold the last reference until its next pass */
+    video.graph->remove(source);
+    video.sources.clear();
+    source.reset();
+    for (int i = 0; i < 100; i++) {
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.order.size() == BORROWED_FRAMES)
+                break;
+        }
+        os_sleep_ms(50);
+    }
+
+    test_relay(video);
+    video.disconnect();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    CHECK_EQ(state.order.size(), BORROWED_FRAMES);
+    for (size_t i = 0; i < BORROWED_FRAMES; i++) {
+        CHECK_EQ(state.buffers[i].releases, 1);
+        CHECK_EQ(state.order[i], i);
+    }
+
+    std::lock_guard<std::mutex> capture_lock(capture.mutex);
+    uint8_t max_y = 0;
+    for (auto y : capture.centre_y)
+        max_y = y > max_y ? y : max_y;
+    CHECK(max_y > 0);
+    CHECK(max_y < BORROWED_POISON - 10);
+    return 0;
+}
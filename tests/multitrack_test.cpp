@@ -0,0 +1,69 @@
+#include "test_output.h"
+#include "test_mp4.h"
+
+#define MULTITRACK_WIDTH 320
+#define MULTITRACK_HEIGHT 180
+#define MULTITRACK_FPS 30
+#define MULTITRACK_TRACKS 3
+#define MULTITRACK_RECORD_MS 2000
+
+/* records three audio tracks with a tone routed into the first and the
+ * third only, then reads the file back. it has to hold one video and three
+ * audio tracks titled in order, each about as long as the video, with the
+ * silent middle track far smaller than the two carrying a tone */
+int main()
+{
+    test_temp_file file("lite_obs_multitrack_test.mp4");
+
+    {
+        test_obs obs;
+        obs.start(MULTITRACK_WIDTH, MULTITRACK_HEIGHT, MULTITRACK_FPS);
+        obs.add_image(MULTITRACK_WIDTH, MULTITRACK_HEIGHT, 200, 80, 40);
+        obs.add_tone(440, 0.5f, 1 << 0);
+        obs.add_tone(1000, 0.5f, 1 << 2);
+        obs.api->lite_obs_set_audio_tracks(obs.api, MULTITRACK_TRACKS);
+
+        test_output_events events;
+        CHECK(obs.api->lite_obs_start_output(obs.api, output_type::file, (void *)file.path.c_str(), 1000, 128, events.callback()));
+        CHECK(events.wait_first_packet());
+        os_sleep_ms(MULTITRACK_RECORD_MS);
+
+        obs.api->lite_obs_stop_output(obs.api);
+        CHECK(events.wait_stopped());
+        CHECK_EQ(events.stop_code, LITE_OBS_OUTPUT_SUCCESS);
+    }
+
+    mp4_reader mp4;
+    CHECK(mp4.open(file.path));
+    CHECK_EQ(mp4.tracks.size(), MULTITRACK_TRACKS + 1);
+    CHECK_EQ(mp4.count("vide"), 1);
+    CHECK_EQ(mp4.count("soun"), MULTITRACK_TRACKS);
+
+    const mp4_track *video = nullptr;
+    std::vector<const mp4_track *> audio;
+    for (auto &track : mp4.tracks) {
+        fprintf(stderr, "%s '%s': %zu samples, %llu bytes, %.3f s\n", track.handler.c_str(), track.name.c_str(),
+                track.sample_sizes.size(), (unsigned long long)track.bytes(),
+                track.timescale ? (double)track.duration / track.timescale : 0.0);
+        if (track.handler == "vide")
+            video = &track;
+        else
+            audio.push_back(&track);
+    }
+
+    CHECK(video->timescale > 0);
+    const double video_sec = (double)video->duration / video->timescale;
+    CHECK(video_sec > MULTITRACK_RECORD_MS / 1000.0 * 0.8);
+
+    for (size_t i = 0; i < audio.size(); i++) {
+        char title[16];
+        snprintf(title, sizeof(title), "Track %d", (int)i + 1);
+        CHECK(audio[i]->name == title);
+        CHECK(audio[i]->timescale > 0);
+        CHECK_NEAR((double)audio[i]->duration / audio[i]->timescale, video_sec, 0.25);
+    }
+
+    CHECK(audio[0]->bytes() > audio[1]->bytes() * 4);
+    CHECK(audio[2]->bytes() > audio[1]->bytes() * 4);
+    return 0;
+}
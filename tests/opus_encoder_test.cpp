@@ -0,0 +1,142 @@
+#include "test_common.h"
+#include "lite-obs/encoder/opus_encoder.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+#define OPUS_TEST_CHANNELS 2
+#define OPUS_TEST_BITRATE 96
+/* a second of audio per run */
+#define OPUS_TEST_SAMPLES OPUS_SAMPLE_RATE
+/* the lookahead libopus primes the stream with: 6.5 ms, or 2.5 ms in the
+ * lowdelay application that leaves out the silk lookahead */
+#define OPUS_TEST_PRIMING 312
+#define OPUS_TEST_PRIMING_LOW_DELAY 120
+
+struct opus_run {
+    int frame_size{};
+    int priming{};
+    int pre_skip = -1;
+    int64_t first_pts = INT64_MIN;
+    int64_t packets{};
+    int64_t uneven{};
+    int64_t samples_out{};
+};
+
+/* encodes a second of a stereo tone through a context opus_apply_settings
+ * set up, the way lite_opus_encoder does, and records what came out */
+static opus_run opus_encode(const AVCodec *codec, const opus_encoder_settings &settings)
+{
+    opus_run run;
+
+    AVCodecContext *context = avcodec_alloc_context3(codec);
+    CHECK(context);
+    context->bit_rate = OPUS_TEST_BITRATE * 1000;
+    context->channels = OPUS_TEST_CHANNELS;
+    context->channel_layout = AV_CH_LAYOUT_STEREO;
+    context->sample_fmt = AV_SAMPLE_FMT_FLT;
+    context->flags = AV_CODEC_FLAG_GLOBAL_HEADER;
+    opus_apply_settings(context, settings);
+    CHECK(avcodec_open2(context, codec, nullptr) >= 0);
+
+    run.frame_size = context->frame_size;
+    run.priming = context->initial_padding;
+
+    /* OpusHead: magic, version, channels, then the pre-skip, little endian */
+    if (context->extradata_size >= 12 && !memcmp(context->extradata, "OpusHead", 8))
+        run.pre_skip = context->extradata[10] | (context->extradata[11] << 8);
+
+    AVFrame *aframe = av_frame_alloc();
+    AVPacket *avpacket = av_packet_alloc();
+    CHECK(aframe && avpacket);
+    aframe->format = context->sample_fmt;
+    aframe->channels = context->channels;
+    aframe->channel_layout = context->channel_layout;
+    aframe->sample_rate = context->sample_rate;
+    aframe->nb_samples = run.frame_size;
+
+    auto receive = [&](bool flushing) {
+        while (avcodec_receive_packet(context, avpacket) == 0) {
+            if (run.first_pts == INT64_MIN)
+                run.first_pts = avpacket->pts;
+            /* the last packet of a flush only covers what is left */
+            if (avpacket->duration != run.frame_size && !flushing)
+                run.uneven++;
+            run.samples_out += avpacket->duration;
+            run.packets++;
+            av_packet_unref(avpacket);
+        }
+    };
+
+    std::vector<float> samples((size_t)run.frame_size * OPUS_TEST_CHANNELS);
+    int64_t pts = 0;
+    for (; pts + run.frame_size <= OPUS_TEST_SAMPLES; pts += run.frame_size) {
+        for (int i = 0; i < run.frame_size; i++) {
+            float v = (float)(0.3 * sin(2 * M_PI * 440 * (double)(pts + i) / OPUS_SAMPLE_RATE));
+            samples[i * OPUS_TEST_CHANNELS] = v;
+            samples[i * OPUS_TEST_CHANNELS + 1] = -v;
+        }
+
+        CHECK(avcodec_fill_audio_frame(aframe, context->channels, context->sample_fmt, (const uint8_t *)samples.data(),
+                                       (int)(samples.size() * sizeof(float)), 1) >= 0);
+        aframe->pts = pts;
+        CHECK(avcodec_send_frame(context, aframe) >= 0);
+        receive(false);
+    }
+
+    CHECK(avcodec_send_frame(context, nullptr) >= 0);
+    receive(true);
+
+    av_packet_free(&avpacket);
+    av_frame_free(&aframe);
+    avcodec_free_context(&context);
+    return run;
+}
+
+/* every supported frame duration in both applications: the encoder has to
+ * use the requested frame size, every packet has to last exactly one frame,
+ * the first one has to start the priming delay before zero and the OpusHead
+ * has to carry that delay as its pre-skip, so a player cuts exactly it. the
+ * delay the encoder adds, priming plus one frame, has to stay within the
+ * libopus lookahead of the application */
+int main()
+{
+    const AVCodec *codec = avcodec_find_encoder_by_name("libopus");
+    TEST_SKIP_IF(!codec, "ffmpeg built without libopus");
+
+    const int frame_ms[] = {5, 10, 20, 40, 60};
+    for (bool low_delay : {false, true}) {
+        for (int ms : frame_ms) {
+            opus_encoder_settings settings;
+            settings.frame_ms = ms;
+            settings.low_delay = low_delay;
+
+            auto run = opus_encode(codec, settings);
+            const int priming_limit = low_delay ? OPUS_TEST_PRIMING_LOW_DELAY : OPUS_TEST_PRIMING;
+            fprintf(stderr, "%2d ms%s: frame %d, priming %d, pre-skip %d, first pts %lld, %lld packets, delay %.1f ms\n",
+                    ms, low_delay ? " low delay" : "", run.frame_size, run.priming, run.pre_skip,
+                    (long long)run.first_pts, (long long)run.packets,
+                    (run.priming + run.frame_size) * 1000.0 / OPUS_SAMPLE_RATE);
+
+            CHECK_EQ(run.frame_size, ms * OPUS_SAMPLE_RATE / 1000);
+            CHECK_EQ(run.uneven, 0);
+            CHECK_EQ(run.first_pts, -run.priming);
+            CHECK_EQ(run.pre_skip, run.priming);
+            CHECK(run.priming > 0 && run.priming <= priming_limit);
+            /* the flush hands back the priming samples as well */
+            CHECK_EQ(run.samples_out, OPUS_TEST_SAMPLES / run.frame_size * run.frame_size + run.priming);
+        }
+    }
+
+    /* a duration libopus can't do falls back to 20 ms */
+    opus_encoder_settings odd;
+    odd.frame_ms = 15;
+    CHECK_EQ(opus_encode(codec, odd).frame_size, 20 * OPUS_SAMPLE_RATE / 1000);
+    return 0;
+}
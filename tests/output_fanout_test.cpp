@@ -0,0 +1,286 @@
+#include "test_output.h"
+#include "test_h264.h"
+#include "test_mp4.h"
+#include "test_mpegts.h"
+#include "test_rtmp.h"
+
+#include <srt/srt.h>
+
+#define FANOUT_WIDTH 320
+#define FANOUT_HEIGHT 180
+#define FANOUT_FPS 30
+#define FANOUT_RECORD_MS 3000
+/* outputs that join a running encoder start with its next keyframe */
+#define FANOUT_KEYINT_SEC 1
+#define FANOUT_MIN_COMMON_FRAMES (FANOUT_FPS * (FANOUT_RECORD_MS / 1000 - FANOUT_KEYINT_SEC) * 3 / 4)
+#define FANOUT_OUTPUTS 3
+
+/* an srt listener on 127.0.0.1 taking the mpeg-ts one caller sends */
+struct srt_sink {
+    int port{};
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::string data;
+    bool closed{};
+
+    ~srt_sink() { stop(); }
+
+    std::string url() const { return "srt://127.0.0.1:" + std::to_string(port); }
+
+    bool start() {
+        if (srt_startup() < 0)
+            return false;
+        started = true;
+
+        listener = srt_create_socket();
+        if (listener == SRT_INVALID_SOCK)
+            return false;
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int len = sizeof(addr);
+        if (srt_bind(listener, (sockaddr *)&addr, sizeof(addr)) == SRT_ERROR || srt_listen(listener, 1) == SRT_ERROR ||
+            srt_getsockname(listener, (sockaddr *)&addr, &len) == SRT_ERROR)
+            return false;
+
+        port = ntohs(addr.sin_port);
+        thread = std::thread([this] { receive(); });
+        return true;
+    }
+
+    /* closing the listener ends a pending accept */
+    void stop() {
+        quit = true;
+        if (listener != SRT_INVALID_SOCK)
+            srt_close(listener);
+        if (thread.joinable())
+            thread.join();
+        if (peer != SRT_INVALID_SOCK)
+            srt_close(peer);
+        listener = peer = SRT_INVALID_SOCK;
+        if (started)
+            srt_cleanup();
+        started = false;
+    }
+
+    bool wait_closed() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(TEST_OUTPUT_TIMEOUT_SEC), [&] { return closed; });
+    }
+
+private:
+    SRTSOCKET listener = SRT_INVALID_SOCK;
+    SRTSOCKET peer = SRT_INVALID_SOCK;
+    std::thread thread;
+    std::atomic_bool quit{};
+    bool started{};
+
+    void receive() {
+        peer = srt_accept(listener, nullptr, nullptr);
+        if (peer != SRT_INVALID_SOCK) {
+            int timeout_ms = 100;
+            srt_setsockopt(peer, 0, SRTO_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+
+            char buf[1500];
+            while (!quit) {
+                int got = srt_recvmsg(peer, buf, sizeof(buf));
+                if (got > 0) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    data.append(buf, got);
+                } else if (srt_getlasterror(nullptr) != SRT_EASYNCRCV) {
+                    break;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        cond.notify_all();
+    }
+};
+
+/* what one output carried, the packets in the order they were sent */
+struct fanout_stream {
+    const char *name{};
+    std::vector<h264_picture> video;
+    std::vector<std::string> audio;
+};
+
+/* the packets two outputs have in common. a later one joins at a keyframe
+ * the other already has, from there on every packet has to be the same
+ * until one of them ends */
+template<typename T, typename Eq>
+static size_t common_packets(const std::vector<T> &a, const std::vector<T> &b, Eq eq)
+{
+    if (a.empty() || b.empty())
+        return 0;
+
+    size_t ia = 0, ib = 0;
+    while (ia < a.size() && !eq(a[ia], b[0]))
+        ia++;
+    if (ia == a.size()) {
+        ia = 0;
+        while (ib < b.size() && !eq(a[0], b[ib]))
+            ib++;
+        if (ib == b.size())
+            return 0;
+    }
+
+    size_t n = 0;
+    while (ia + n < a.size() && ib + n < b.size()) {
+        if (!eq(a[ia + n], b[ib + n])) {
+            fprintf(stderr, "packet %zu after the first common one differs\n", n);
+            return 0;
+        }
+        n++;
+    }
+    return n;
+}
+
+static bool same_picture(const h264_picture &a, const h264_picture &b)
+{
+    return a.idr == b.idr && a.slices == b.slices;
+}
+
+static bool same_packet(const std::string &a, const std::string &b)
+{
+    return a == b;
+}
+
+static fanout_stream read_file(const std::string &path)
+{
+    fanout_stream stream;
+    stream.name = "file";
+
+    mp4_reader mp4;
+    CHECK(mp4.open(path));
+    for (auto &track : mp4.tracks) {
+        for (size_t i = 0; i < track.sample_sizes.size(); i++) {
+            auto data = mp4.sample(track, i);
+            if (track.handler == "vide")
+                stream.video.push_back(h264_from_avcc(data, track.sample_sizes[i]));
+            else if (track.handler == "soun")
+                stream.audio.emplace_back((const char *)data, track.sample_sizes[i]);
+        }
+    }
+    return stream;
+}
+
+/* flv tags: avc nalus behind a five byte header, aac frames behind two.
+ * the sequence headers are left out */
+static fanout_stream read_rtmp(rtmp_sink &sink)
+{
+    fanout_stream stream;
+    stream.name = "rtmp";
+
+    std::lock_guard<std::mutex> lock(sink.mutex);
+    for (auto &message : sink.media) {
+        auto p = (const uint8_t *)message.data.data();
+        size_t size = message.data.size();
+        if (message.type == RTMP_MSG_VIDEO && size > 5 && (p[0] & 0x0f) == 7 && p[1] == 1)
+            stream.video.push_back(h264_from_avcc(p + 5, size - 5));
+        else if (message.type == RTMP_MSG_AUDIO && size > 2 && (p[0] >> 4) == 10 && p[1] == 1)
+            stream.audio.emplace_back(message.data, 2);
+    }
+    return stream;
+}
+
+static fanout_stream read_srt(srt_sink &sink)
+{
+    fanout_stream stream;
+    stream.name = "srt";
+
+    ts_reader ts;
+    {
+        std::lock_guard<std::mutex> lock(sink.mutex);
+        ts.parse((const uint8_t *)sink.data.data(), sink.data.size());
+    }
+    CHECK_EQ(ts.lost_sync, 0);
+    CHECK(ts.video_pid >= 0);
+
+    /* the last pes has no end marker, it may have been cut off when the
+     * connection closed */
+    if (!ts.video.empty())
+        ts.video.pop_back();
+    for (auto &pes : ts.video)
+        stream.video.push_back(h264_from_annexb((const uint8_t *)pes.data.data(), pes.data.size()));
+    return stream;
+}
+
+/* a file, an rtmp and an srt output started with lite_obs_start_output2
+ * run from the one x264 encoder and the one aac encoder. each has to start
+ * on a keyframe, and from where they overlap every video packet has to be
+ * the same in all three and every audio packet the same in the file and the
+ * rtmp stream, none of them dropped or sent twice */
+int main()
+{
+    test_temp_file file("lite_obs_fanout_test.mp4");
+    rtmp_sink rtmp;
+    CHECK(rtmp.start());
+    srt_sink srt;
+    CHECK(srt.start());
+
+    const std::string rtmp_url = rtmp.url();
+    const std::string srt_url = srt.url();
+
+    {
+        test_obs obs;
+        obs.start(FANOUT_WIDTH, FANOUT_HEIGHT, FANOUT_FPS);
+        obs.add_moving_square(FANOUT_WIDTH, FANOUT_HEIGHT, FANOUT_FPS);
+        obs.add_tone(440, 0.5f, 1 << 0);
+
+        lite_obs_x264_settings x264{};
+        x264.keyint_sec = FANOUT_KEYINT_SEC;
+        obs.api->lite_obs_reset_encoder2(obs.api, true, &x264);
+
+        struct {
+            output_type type;
+            const char *info;
+        } outputs[FANOUT_OUTPUTS] = {
+            {output_type::file, file.path.c_str()},
+            {output_type::rtmp, rtmp_url.c_str()},
+            {output_type::srt, srt_url.c_str()},
+        };
+
+        test_output_events events[FANOUT_OUTPUTS];
+        int ids[FANOUT_OUTPUTS];
+        for (int i = 0; i < FANOUT_OUTPUTS; i++) {
+            ids[i] = obs.api->lite_obs_start_output2(obs.api, outputs[i].type, (void *)outputs[i].info, 1000, 128, events[i].callback());
+            CHECK(ids[i] > 0);
+        }
+        CHECK(rtmp.wait_publishing());
+        for (auto &event : events)
+            CHECK(event.wait_first_packet());
+
+        os_sleep_ms(FANOUT_RECORD_MS);
+
+        for (int i = 0; i < FANOUT_OUTPUTS; i++) {
+            obs.api->lite_obs_stop_output2(obs.api, ids[i]);
+            CHECK(events[i].wait_stopped());
+            CHECK_EQ(events[i].stop_code, LITE_OBS_OUTPUT_SUCCESS);
+        }
+    }
+
+    CHECK(rtmp.wait_closed());
+    CHECK(srt.wait_closed());
+
+    fanout_stream streams[FANOUT_OUTPUTS] = {read_file(file.path), read_rtmp(rtmp), read_srt(srt)};
+    for (auto &stream : streams) {
+        fprintf(stderr, "%-4s: %zu video, %zu audio packets\n", stream.name, stream.video.size(), stream.audio.size());
+        CHECK(!stream.video.empty());
+        CHECK(stream.video.front().idr);
+    }
+
+    for (int i = 1; i < FANOUT_OUTPUTS; i++) {
+        size_t common = common_packets(streams[0].video, streams[i].video, same_picture);
+        fprintf(stderr, "%s and %s: %zu video packets in common\n", streams[0].name, streams[i].name, common);
+        CHECK(common >= FANOUT_MIN_COMMON_FRAMES);
+    }
+
+    size_t common_audio = common_packets(streams[0].audio, streams[1].audio, same_packet);
+    fprintf(stderr, "file and rtmp: %zu audio packets in common\n", common_audio);
+    CHECK(common_audio >= (size_t)TEST_OUTPUT_SAMPLE_RATE / 1024 * (FANOUT_RECORD_MS / 1000 - FANOUT_KEYINT_SEC));
+    return 0;
+}
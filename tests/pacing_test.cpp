@@ -0,0 +1,127 @@
+#include "test_common.h"
+#include "lite-obs/lite_obs_source.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#define PACING_WIDTH 64
+#define PACING_HEIGHT 64
+#define PACING_FPS 30
+#define PACING_TICKS 90
+#define PACING_WINDOW_MS 25
+/* where the canvas ticks sit against the source's frame slots */
+#define PACING_TICK_PHASE_MS 6
+
+#define PACING_MS 1000000ULL
+/* an arbitrary start of the clock, far from zero */
+#define PACING_START_NS 1000000000ULL
+
+typedef std::shared_ptr<lite_obs_source::lite_obs_source_video_frame> pacing_frame;
+
+/* reaches into the source the way the core video does, stamping and
+ * queueing frames as output_video does and picking one per video tick as
+ * update_async_video does, without a graphics thread to upload them */
+class lite_obs_source_test
+{
+public:
+    static uint64_t stamp(lite_obs_source &source, uint64_t arrival) { return source.async_frame_timestamp(arrival); }
+    static void queue(lite_obs_source &source, const pacing_frame &frame) { source.push_async_frame(frame); }
+    static pacing_frame tick(lite_obs_source &source, uint64_t sys_time) { return source.select_async_frame(sys_time); }
+};
+
+/* how late each frame arrives against its slot, in ms, repeating. always
+ * under the window and half of them after the tick that follows the slot */
+static const uint64_t pacing_delays_ms[] = {0, 11, 3, 12, 7, 1, 10, 5, 9, 2, 12, 6, 0, 8, 4, 11};
+#define PACING_DELAYS (sizeof(pacing_delays_ms) / sizeof(pacing_delays_ms[0]))
+
+static const uint64_t pacing_interval = 1000000000ULL / PACING_FPS;
+
+static uint64_t arrival(size_t frame)
+{
+    return PACING_START_NS + frame * pacing_interval + pacing_delays_ms[frame % PACING_DELAYS] * PACING_MS;
+}
+
+static uint64_t tick_time(size_t tick)
+{
+    return PACING_START_NS + tick * pacing_interval + PACING_TICK_PHASE_MS * PACING_MS;
+}
+
+/* a camera delivering one frame per canvas tick with the delays above into
+ * an async source with the given jitter window. returns the frame each tick
+ * picked, -1 where the last one stayed on screen */
+static std::vector<int> run_pacing(uint32_t window_ms)
+{
+    lite_obs_source source(source_type::SOURCE_ASYNCVIDEO, nullptr, nullptr);
+    source.lite_source_set_jitter_window(window_ms);
+
+    std::vector<pacing_frame> frames;
+    std::vector<int> shown;
+    for (size_t tick = 0; tick < PACING_TICKS; tick++) {
+        while (arrival(frames.size()) <= tick_time(tick)) {
+            auto frame = std::make_shared<lite_obs_source::lite_obs_source_video_frame>();
+            frame->width = PACING_WIDTH;
+            frame->height = PACING_HEIGHT;
+            frame->format = video_format::VIDEO_FORMAT_I420;
+            frame->full_range = true;
+            frame->timestamp = lite_obs_source_test::stamp(source, arrival(frames.size()));
+            frames.push_back(frame);
+            lite_obs_source_test::queue(source, frame);
+        }
+
+        auto picked = lite_obs_source_test::tick(source, tick_time(tick));
+        int index = -1;
+        for (size_t i = 0; picked && i < frames.size(); i++) {
+            if (frames[i] == picked)
+                index = (int)i;
+        }
+        CHECK(!picked || index >= 0);
+        shown.push_back(index);
+    }
+    return shown;
+}
+
+/* repeats are ticks that kept the last frame, skips frames never shown */
+static void print_cadence(uint32_t window_ms, const std::vector<int> &shown)
+{
+    int repeats = 0, skips = 0, prev = -1;
+    for (int index : shown) {
+        if (index < 0) {
+            repeats++;
+            continue;
+        }
+        skips += index - prev - 1;
+        prev = index;
+    }
+    fprintf(stderr, "window %u ms: %d repeated, %d skipped\n", window_ms, repeats, skips);
+}
+
+/* without a window each tick shows the newest frame that has arrived, so a
+ * frame landing after the tick that follows its slot comes up together with
+ * the next one: the tick before repeats and the late frame is skipped.
+ * with a window wider than the delays every frame is held to the tick after
+ * its slot and the source keeps its cadence: the first frame goes up as it
+ * arrives, the next tick repeats it and from then on tick n shows frame n-1 */
+int main()
+{
+    auto unpaced = run_pacing(0);
+    print_cadence(0, unpaced);
+    for (size_t tick = 0; tick < PACING_TICKS; tick++) {
+        int newest = -1;
+        while (arrival(newest + 1) <= tick_time(tick))
+            newest++;
+
+        int last = -1;
+        for (size_t i = 0; i < tick; i++)
+            last = std::max(last, unpaced[i]);
+        CHECK_EQ(unpaced[tick], newest > last ? newest : -1);
+    }
+
+    auto paced = run_pacing(PACING_WINDOW_MS);
+    print_cadence(PACING_WINDOW_MS, paced);
+    CHECK_EQ(paced[0], 0);
+    CHECK_EQ(paced[1], -1);
+    for (size_t tick = 2; tick < PACING_TICKS; tick++)
+        CHECK_EQ(paced[tick], (int)tick - 1);
+    return 0;
+}
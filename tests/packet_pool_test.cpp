@@ -0,0 +1,165 @@
+#include "test_common.h"
+#include "lite-obs/lite_encoder_info.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define POOL_OUTPUTS 3
+#define POOL_PACKETS 20000
+/* packets an output may hold before the encoder waits for it */
+#define POOL_MAX_QUEUED 64
+
+static uint8_t pattern(int64_t pts, size_t i)
+{
+    return (uint8_t)(pts * 31 + i * 7 + (i >> 8));
+}
+
+/* the frame number is written over the whole payload, any byte another
+ * packet wrote shows up */
+static bool intact(const encoder_packet &packet)
+{
+    const uint8_t *data = packet.data->data();
+    for (size_t i = 0; i < packet.data->size(); i++) {
+        if (data[i] != pattern(packet.pts, i))
+            return false;
+    }
+    return true;
+}
+
+struct test_output_queue {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::shared_ptr<encoder_packet>> packets;
+    bool done{};
+    size_t checked{};
+};
+
+/* an encoder thread writes every packet into a fresh pooled buffer and
+ * hands a reference to each of three outputs, which hold on to them for
+ * different lengths of time before sending. a buffer reused while an output
+ * still holds it shows up as a payload that no longer matches its stamp */
+static void test_fanout()
+{
+    const size_t blocks_before = packet_pool_blocks_in_use();
+    test_output_queue outputs[POOL_OUTPUTS];
+    std::atomic_bool corrupted = false;
+
+    std::vector<std::thread> threads;
+    for (int o = 0; o < POOL_OUTPUTS; o++) {
+        threads.emplace_back([&, o] {
+            auto &output = outputs[o];
+            std::mt19937 rng(o + 1);
+            /* each output sends in bursts of a different size */
+            std::uniform_int_distribution<size_t> burst(1, 4 << (o * 2));
+            while (true) {
+                std::deque<std::shared_ptr<encoder_packet>> sending;
+                {
+                    std::unique_lock<std::mutex> lock(output.mutex);
+                    size_t want = burst(rng);
+                    output.cond.wait(lock, [&] { return output.packets.size() >= want || output.done; });
+                    if (output.packets.empty() && output.done)
+                        break;
+                    while (!output.packets.empty() && sending.size() < want) {
+                        sending.push_back(std::move(output.packets.front()));
+                        output.packets.pop_front();
+                    }
+                }
+                output.cond.notify_all();
+
+                for (auto &packet : sending) {
+                    if (!intact(*packet))
+                        corrupted = true;
+                }
+                output.checked += sending.size();
+            }
+        });
+    }
+
+    std::mt19937 rng(0);
+    /* mostly small packets with the occasional keyframe sized one, so
+     * several size classes get reused */
+    std::uniform_int_distribution<size_t> small(16, 6000);
+    std::uniform_int_distribution<size_t> large(60000, 300000);
+    for (int64_t pts = 0; pts < POOL_PACKETS; pts++) {
+        size_t size = pts % 30 == 0 ? large(rng) : small(rng);
+        auto packet = encoder_packet_create();
+        packet->data = packet_pool_alloc(size);
+        CHECK(packet->data);
+        CHECK(packet->data->capacity() >= size);
+        for (size_t i = 0; i < size; i++)
+            packet->data->data()[i] = pattern(pts, i);
+        packet->pts = pts;
+
+        for (auto &output : outputs) {
+            std::unique_lock<std::mutex> lock(output.mutex);
+            output.cond.wait(lock, [&] { return output.packets.size() < POOL_MAX_QUEUED; });
+            output.packets.push_back(encoder_packet_create(*packet));
+            output.cond.notify_all();
+        }
+    }
+
+    for (auto &output : outputs) {
+        std::lock_guard<std::mutex> lock(output.mutex);
+        output.done = true;
+        output.cond.notify_all();
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    CHECK(!corrupted);
+    for (auto &output : outputs)
+        CHECK_EQ(output.checked, POOL_PACKETS);
+    CHECK_EQ(packet_pool_blocks_in_use(), blocks_before);
+}
+
+/* a buffer goes back to its class only when its last reference goes, and
+ * is then what the next allocation of that class gets */
+static void test_reuse()
+{
+    const size_t blocks_before = packet_pool_blocks_in_use();
+
+    auto first = packet_pool_alloc(1000);
+    const packet_buffer *block = first.get();
+    packet_data second = first;
+    packet_data third = second;
+    CHECK_EQ(first.use_count(), 3);
+    CHECK_EQ(packet_pool_blocks_in_use(), blocks_before + 1);
+
+    first.reset();
+    second.reset();
+    auto other = packet_pool_alloc(1000);
+    CHECK(other.get() != block);
+    CHECK_EQ(third.use_count(), 1);
+
+    third.reset();
+    auto reused = packet_pool_alloc(900);
+    CHECK(reused.get() == block);
+    CHECK_EQ(reused->size(), 900);
+
+    /* growing past the class moves the contents to a bigger block */
+    memset(reused->data(), 0x5a, 900);
+    CHECK(reused.append("tail", 4));
+    CHECK_EQ(reused->size(), 904);
+    CHECK(reused->capacity() >= 904);
+    CHECK(reused->data()[899] == 0x5a);
+    CHECK(memcmp(reused->data() + 900, "tail", 4) == 0);
+    CHECK(reused.resize(8 << 20));
+    CHECK(reused->data()[0] == 0x5a);
+
+    other.reset();
+    reused.reset();
+    CHECK_EQ(packet_pool_blocks_in_use(), blocks_before);
+}
+
+int main()
+{
+    test_reuse();
+    test_fanout();
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include "test_video.h"
+
+#define RENDER_WIDTH 64
+#define RENDER_HEIGHT 64
+#define RENDER_FPS 30
+
+/* not saturated in any channel so a swapped or clamped one shows */
+#define RENDER_R 200
+#define RENDER_G 80
+#define RENDER_B 40
+
+/* renders a solid colour image source on a headless context, reads the
+ * converted frame back through the raw video output and checks it against
+ * the full range bt.709 value of the colour */
+int main()
+{
+    test_video video;
+    video.start(RENDER_WIDTH, RENDER_HEIGHT, RENDER_FPS);
+
+    auto image = test_rgba_image(RENDER_WIDTH, RENDER_HEIGHT, RENDER_R, RENDER_G, RENDER_B);
+    auto source = video.add_source(source_type::SOURCE_VIDEO);
+    source->lite_source_output_video(image.data(), RENDER_WIDTH, RENDER_HEIGHT);
+
+    /* the first frames can be from before the source was drawn */
+    test_video_capture capture;
+    video.connect(&capture);
+    CHECK(capture.wait_frames(3));
+    video.disconnect();
+
+    double y, u, v;
+    test_rgb_to_yuv(RENDER_R, RENDER_G, RENDER_B, &y, &u, &v);
+    CHECK_NEAR(capture.y, y, 2);
+    CHECK_NEAR(capture.u, u, 2);
+    CHECK_NEAR(capture.v, v, 2);
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "test_video.h"
+#include "test_h264.h"
+#include "lite-obs/lite_encoder.h"
+#include "lite-obs/util/threading.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+
+#define RENDITION_WIDTH 640
+#define RENDITION_HEIGHT 360
+#define RENDITION_FPS 30
+#define RENDITION_BITRATE 800
+#define RENDITION_RECORD_MS 4000
+#define RENDITION_COUNT 3
+/* the slow encoder takes this many frame times for every packet */
+#define RENDITION_SLOW_FRAMES 3
+
+static const uint32_t rendition_sizes[RENDITION_COUNT][2] = {
+    {RENDITION_WIDTH, RENDITION_HEIGHT}, {480, 270}, {320, 180},
+};
+
+/* what one encoder put out: the frame index on the video clock of every
+ * packet and of the keyframes among them */
+struct rendition_packets {
+    std::mutex mutex;
+    std::vector<int64_t> frames;
+    std::set<int64_t> keyframes;
+    uint64_t frame_time{};
+    uint64_t sleep_ns{};
+
+    static void callback(void *param, const std::shared_ptr<encoder_packet> &packet) {
+        auto self = (rendition_packets *)param;
+        int64_t frame = (int64_t)((packet->dts_usec * 1000 + self->frame_time / 2) / self->frame_time);
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->frames.push_back(frame);
+            if (packet->keyframe)
+                self->keyframes.insert(frame);
+        }
+
+        if (self->sleep_ns)
+            os_sleepto_ns(os_gettime_ns() + self->sleep_ns);
+    }
+};
+
+/* the main output and two renditions scaled on the gpu, each into an x264
+ * encoder with aligned keyframes. the last rendition blocks its input
+ * thread for three frame times per packet, so video_output drops most of
+ * its frames. every encoder has to encode at its own size, and past the
+ * first packet of each, where an encoder starts with a keyframe of its own,
+ * all of them have to put their keyframes on the same frames, one every
+ * keyint_sec, the slow one included */
+int main()
+{
+    test_video video;
+    video.start(RENDITION_WIDTH, RENDITION_HEIGHT, RENDITION_FPS);
+
+    auto source = video.add_source(source_type::SOURCE_VIDEO);
+    std::atomic_bool stop_feeding{};
+    std::thread feeder([&] {
+        uint8_t shade = 0;
+        while (!stop_feeding) {
+            auto image = test_rgba_image(RENDITION_WIDTH, RENDITION_HEIGHT, shade, (uint8_t)(255 - shade), 80);
+            source->lite_source_output_video(image.data(), RENDITION_WIDTH, RENDITION_HEIGHT);
+            shade += 7;
+            os_sleep_ms(1000 / RENDITION_FPS);
+        }
+    });
+
+    x264_encoder_settings settings;
+    settings.preset = "ultrafast";
+    settings.low_latency = true;
+    settings.keyint_sec = 1;
+    settings.aligned_keyframes = true;
+
+    const uint64_t frame_time = video.video->core_video()->video_output_get_frame_time();
+
+    std::shared_ptr<video_output> outputs[RENDITION_COUNT];
+    std::shared_ptr<lite_obs_encoder> encoders[RENDITION_COUNT];
+    rendition_packets packets[RENDITION_COUNT];
+    for (int i = 0; i < RENDITION_COUNT; i++) {
+        outputs[i] = i ? video.video->lite_obs_add_rendition(rendition_sizes[i][0], rendition_sizes[i][1]) : video.video->core_video();
+        CHECK(outputs[i]);
+        CHECK_EQ(outputs[i]->video_output_get_width(), rendition_sizes[i][0]);
+        CHECK_EQ(outputs[i]->video_output_get_height(), rendition_sizes[i][1]);
+
+        encoders[i] = std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::X264, RENDITION_BITRATE, 0);
+        encoders[i]->lite_obs_encoder_set_x264_settings(settings);
+        encoders[i]->lite_obs_encoder_set_core_video(video.video);
+        if (i)
+            encoders[i]->lite_obs_encoder_set_video(outputs[i]);
+        CHECK(encoders[i]->obs_encoder_initialize());
+
+        packets[i].frame_time = frame_time;
+    }
+    packets[RENDITION_COUNT - 1].sleep_ns = frame_time * RENDITION_SLOW_FRAMES;
+
+    for (int i = 0; i < RENDITION_COUNT; i++)
+        encoders[i]->obs_encoder_start(rendition_packets::callback, &packets[i]);
+
+    os_sleep_ms(RENDITION_RECORD_MS);
+
+    /* the encoder is shut down once its last callback is gone, ask for the
+     * headers before that */
+    for (int i = 0; i < RENDITION_COUNT; i++) {
+        uint8_t *extra = nullptr;
+        size_t extra_size = 0;
+        uint32_t width = 0, height = 0;
+        CHECK(encoders[i]->lite_obs_encoder_get_extra_data(&extra, &extra_size));
+        CHECK(h264_sps_size(extra, extra_size, &width, &height));
+        fprintf(stderr, "encoder %d: %ux%u\n", i, width, height);
+        CHECK_EQ(width, rendition_sizes[i][0]);
+        CHECK_EQ(height, rendition_sizes[i][1]);
+
+        encoders[i]->obs_encoder_stop(rendition_packets::callback, &packets[i]);
+        encoders[i]->obs_encoder_shutdown();
+        encoders[i]->obs_encoder_destroy();
+        if (i)
+            video.video->lite_obs_remove_rendition(outputs[i]);
+    }
+
+    stop_feeding = true;
+    feeder.join();
+
+    /* the frames every encoder saw the whole of */
+    int64_t first = INT64_MIN, last = INT64_MAX;
+    for (auto &p : packets) {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        CHECK(p.frames.size() > 1);
+        first = std::max(first, p.frames[1]);
+        last = std::min(last, p.frames.back());
+    }
+    CHECK(last - first >= RENDITION_FPS * 2);
+
+    std::set<int64_t> expected;
+    for (auto frame : packets[0].keyframes) {
+        if (frame >= first && frame <= last)
+            expected.insert(frame);
+    }
+
+    for (int i = 0; i < RENDITION_COUNT; i++) {
+        auto &p = packets[i];
+        std::set<int64_t> keyframes;
+        for (auto frame : p.keyframes) {
+            if (frame >= first && frame <= last)
+                keyframes.insert(frame);
+        }
+        fprintf(stderr, "encoder %d: %zu packets, %zu keyframes in frames %lld to %lld\n", i, p.frames.size(),
+                keyframes.size(), (long long)first, (long long)last);
+        CHECK(keyframes == expected);
+    }
+
+    /* one keyframe every keyint_sec, none in between */
+    CHECK(expected.size() >= 2);
+    for (auto iter = std::next(expected.begin()); iter != expected.end(); ++iter)
+        CHECK_NEAR(*iter - *std::prev(iter), RENDITION_FPS, 1);
+
+    /* the slow encoder lost frames, the others none */
+    CHECK(packets[RENDITION_COUNT - 1].frames.size() < packets[0].frames.size() / 2);
+    for (int i = 0; i < RENDITION_COUNT - 1; i++)
+        CHECK_EQ((int64_t)packets[i].frames.size(), packets[i].frames.back() - packets[i].frames.front() + 1);
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "test_video.h"
+
+#define RGBX_FPS 30
+/* what the cpu conversion is split into, more than the one band a frame
+ * under 1080 rows gets */
+#define RGBX_BANDS 4
+
+static void pattern_pixel(uint32_t x, uint32_t y, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    *r = (uint8_t)(x * 5 + y * 3);
+    *g = (uint8_t)(x * y + y * 17);
+    *b = (uint8_t)(255 - x * 3 + y * 7);
+}
+
+struct rgbx_frame {
+    std::vector<uint8_t> luma;
+    std::vector<uint8_t> chroma;
+};
+
+/* renders the pattern and reads back one nv12 frame, converted by the
+ * Convert_NV12_Y and Convert_NV12_UV shaders or by copy_rgbx_frame in the
+ * given number of bands */
+static rgbx_frame render_pattern(uint32_t width, uint32_t height, bool gpu_conversion, uint32_t bands)
+{
+    test_video video;
+    video.video->lite_obs_set_gpu_conversion(gpu_conversion);
+    video.video->lite_obs_set_rgbx_convert_bands(bands);
+    video.start(width, height, RGBX_FPS);
+
+    std::vector<uint8_t> image(width * height * 4);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t *pixel = &image[(y * width + x) * 4];
+            pattern_pixel(x, y, &pixel[0], &pixel[1], &pixel[2]);
+            pixel[3] = 255;
+        }
+    }
+
+    auto source = video.add_source(source_type::SOURCE_VIDEO);
+    source->lite_source_output_video(image.data(), width, height);
+
+    test_video_capture capture;
+    video.connect(&capture);
+    CHECK(capture.wait_frames(3));
+    video.disconnect();
+
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    return {capture.luma, capture.chroma};
+}
+
+/* the cpu conversion split into RGBX_BANDS bands of chroma rows has to give
+ * what the gpu conversion gives for every pixel, a band seam off by a row or
+ * a swapped channel shows against the pattern. 54 rows leave 27 chroma rows,
+ * which don't split into even bands */
+static void run_copy(uint32_t width, uint32_t height)
+{
+    fprintf(stderr, "%ux%u\n", width, height);
+
+    auto reference = render_pattern(width, height, true, 0);
+    auto copied = render_pattern(width, height, false, RGBX_BANDS);
+    CHECK_EQ(reference.luma.size(), (size_t)width * height);
+    CHECK_EQ(copied.luma.size(), reference.luma.size());
+    CHECK_EQ(copied.chroma.size(), reference.chroma.size());
+
+    int max_diff = 0;
+    for (size_t i = 0; i < reference.luma.size(); i++)
+        max_diff = std::max(max_diff, abs(copied.luma[i] - reference.luma[i]));
+    for (size_t i = 0; i < reference.chroma.size(); i++)
+        max_diff = std::max(max_diff, abs(copied.chroma[i] - reference.chroma[i]));
+    fprintf(stderr, "largest difference to the gpu conversion: %d\n", max_diff);
+
+    for (size_t i = 0; i < reference.luma.size(); i++)
+        CHECK_NEAR(copied.luma[i], reference.luma[i], 1);
+    for (size_t i = 0; i < reference.chroma.size(); i++)
+        CHECK_NEAR(copied.chroma[i], reference.chroma[i], 1);
+}
+
+int main()
+{
+    run_copy(320, 180);
+    run_copy(96, 54);
+    return 0;
+}
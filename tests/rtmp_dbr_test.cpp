@@ -0,0 +1,205 @@
+#include "test_output.h"
+#include "test_rtmp.h"
+
+#define DBR_WIDTH 640
+#define DBR_HEIGHT 360
+#define DBR_FPS 30
+#define DBR_VIDEO_BITRATE 2500
+#define DBR_AUDIO_BITRATE 64
+/* what the throttled sink reads, well under what the encoder starts at */
+#define DBR_LINK_KBPS 1000
+/* a few kilobytes of window, the backlog stays in the sender's socket */
+#define DBR_RECEIVE_BUFFER (16 * 1024)
+
+#define DBR_UNTHROTTLED_MS 3000
+/* the bitrate has to settle within this long after the link drops */
+#define DBR_CONVERGE_MS 10000
+#define DBR_STEADY_MS 4000
+/* below the 900 ms at which the output starts dropping p-frames */
+#define DBR_MAX_LATENCY_MS 800
+
+#define DBR_SHARED_THROTTLED_MS 6000
+/* the stream with the slow link gets this long to cut the bitrate, were it
+ * allowed to */
+#define DBR_SHARED_SETTLE_MS 2000
+
+typedef std::chrono::steady_clock dbr_clock;
+
+/* what a sink got in a span of arrival times */
+struct dbr_window {
+    int64_t frames{};
+    int64_t missing{};
+    double kbps{};
+    int64_t max_latency_ms{};
+};
+
+static int64_t dbr_offset_ms(const rtmp_message &message)
+{
+    auto received = std::chrono::duration_cast<std::chrono::milliseconds>(message.received.time_since_epoch());
+    return received.count() - message.timestamp;
+}
+
+/* the video frames that arrived in [begin, end) and those missing between
+ * them on the frame clock, the bitrate of all media over their timestamps,
+ * and the longest a message took, against the quickest of the stream */
+static dbr_window read_window(rtmp_sink &sink, dbr_clock::time_point begin, dbr_clock::time_point end)
+{
+    dbr_window window;
+    std::lock_guard<std::mutex> lock(sink.mutex);
+
+    int64_t base = INT64_MAX;
+    for (auto &message : sink.media)
+        base = std::min(base, dbr_offset_ms(message));
+
+    const double frame_ms = 1000.0 / DBR_FPS;
+    int64_t bytes = 0, first_ts = -1, last_ts = -1, last_video = -1;
+    for (auto &message : sink.media) {
+        if (message.received < begin || message.received >= end)
+            continue;
+
+        bytes += (int64_t)message.data.size();
+        if (first_ts < 0)
+            first_ts = message.timestamp;
+        last_ts = message.timestamp;
+        window.max_latency_ms = std::max(window.max_latency_ms, dbr_offset_ms(message) - base);
+
+        /* flv avc nalus, the sequence header left out */
+        auto p = (const uint8_t *)message.data.data();
+        if (message.type != RTMP_MSG_VIDEO || message.data.size() <= 5 || p[1] != 1)
+            continue;
+        if (last_video >= 0)
+            window.missing += std::max<int64_t>(0, llround((message.timestamp - last_video) / frame_ms) - 1);
+        last_video = message.timestamp;
+        window.frames++;
+    }
+
+    if (last_ts > first_ts)
+        window.kbps = bytes * 8.0 / (double)(last_ts - first_ts);
+    return window;
+}
+
+static void print_window(const char *name, const dbr_window &window)
+{
+    fprintf(stderr, "%s: %lld frames, %lld missing, %.0f kbps, latency %lld ms\n", name, (long long)window.frames,
+            (long long)window.missing, window.kbps, (long long)window.max_latency_ms);
+}
+
+/* an rtmp output started with lite_obs_start_output2 into a sink that
+ * reads at DBR_LINK_KBPS once the stream runs. dynamic bitrate has to bring
+ * the encoder under the link within DBR_CONVERGE_MS: from there on the
+ * frames have to arrive without drops, the queue latency has to stay under
+ * DBR_MAX_LATENCY_MS and the stream has to make use of the link */
+static void test_sole_stream(test_obs &obs)
+{
+    rtmp_sink sink;
+    sink.receive_buffer = DBR_RECEIVE_BUFFER;
+    CHECK(sink.start());
+    const std::string url = sink.url();
+
+    test_output_events events;
+    int id = obs.api->lite_obs_start_output2(obs.api, output_type::rtmp, (void *)url.c_str(), DBR_VIDEO_BITRATE,
+                                             DBR_AUDIO_BITRATE, events.callback());
+    CHECK(id > 0);
+    CHECK(sink.wait_publishing());
+    CHECK(events.wait_first_packet());
+
+    auto started = dbr_clock::now();
+    os_sleep_ms(DBR_UNTHROTTLED_MS);
+    auto throttled = dbr_clock::now();
+    sink.read_rate = DBR_LINK_KBPS * 1000 / 8;
+    os_sleep_ms(DBR_CONVERGE_MS + DBR_STEADY_MS);
+    auto end = dbr_clock::now();
+
+    /* the rest of the queue goes out at full speed */
+    sink.read_rate = 0;
+    obs.api->lite_obs_stop_output2(obs.api, id);
+    CHECK(events.wait_stopped());
+    CHECK_EQ(events.stop_code, LITE_OBS_OUTPUT_SUCCESS);
+    CHECK(sink.wait_closed());
+
+    auto before = read_window(sink, started, throttled);
+    print_window("unthrottled", before);
+    for (int sec = 0; sec * 1000 < DBR_CONVERGE_MS + DBR_STEADY_MS; sec++) {
+        char name[32];
+        snprintf(name, sizeof(name), "second %2d", sec);
+        auto from = throttled + std::chrono::seconds(sec);
+        print_window(name, read_window(sink, from, from + std::chrono::seconds(1)));
+    }
+    auto steady = read_window(sink, throttled + std::chrono::milliseconds(DBR_CONVERGE_MS), end);
+    print_window("steady", steady);
+
+    /* the link has to be the bottleneck to begin with */
+    CHECK(before.kbps > DBR_LINK_KBPS * 1.5);
+
+    CHECK(steady.frames >= DBR_FPS * DBR_STEADY_MS / 1000 * 9 / 10);
+    CHECK_EQ(steady.missing, 0);
+    CHECK(steady.max_latency_ms < DBR_MAX_LATENCY_MS);
+    CHECK(steady.kbps > DBR_LINK_KBPS / 2);
+    CHECK(steady.kbps < DBR_LINK_KBPS * 1.1);
+}
+
+/* two rtmp outputs on the one video encoder, one of them behind the slow
+ * link. its congestion must not lower the bitrate the other one gets, that
+ * one keeps what it had before the link dropped */
+static void test_shared_encoder(test_obs &obs)
+{
+    rtmp_sink slow, fast;
+    slow.receive_buffer = DBR_RECEIVE_BUFFER;
+    CHECK(slow.start());
+    CHECK(fast.start());
+    const std::string slow_url = slow.url();
+    const std::string fast_url = fast.url();
+
+    test_output_events events[2];
+    int ids[2] = {
+        obs.api->lite_obs_start_output2(obs.api, output_type::rtmp, (void *)slow_url.c_str(), DBR_VIDEO_BITRATE,
+                                        DBR_AUDIO_BITRATE, events[0].callback()),
+        obs.api->lite_obs_start_output2(obs.api, output_type::rtmp, (void *)fast_url.c_str(), DBR_VIDEO_BITRATE,
+                                        DBR_AUDIO_BITRATE, events[1].callback()),
+    };
+    CHECK(ids[0] > 0 && ids[1] > 0);
+    CHECK(slow.wait_publishing() && fast.wait_publishing());
+    for (auto &event : events)
+        CHECK(event.wait_first_packet());
+
+    auto started = dbr_clock::now();
+    os_sleep_ms(DBR_UNTHROTTLED_MS);
+    auto throttled = dbr_clock::now();
+    slow.read_rate = DBR_LINK_KBPS * 1000 / 8;
+    os_sleep_ms(DBR_SHARED_THROTTLED_MS);
+    auto end = dbr_clock::now();
+
+    slow.read_rate = 0;
+    for (int i = 0; i < 2; i++) {
+        obs.api->lite_obs_stop_output2(obs.api, ids[i]);
+        CHECK(events[i].wait_stopped());
+    }
+    CHECK(slow.wait_closed() && fast.wait_closed());
+
+    auto before = read_window(fast, started, throttled);
+    auto after = read_window(fast, throttled + std::chrono::milliseconds(DBR_SHARED_SETTLE_MS), end);
+    print_window("shared, before", before);
+    print_window("shared, after", after);
+    print_window("shared, slow link", read_window(slow, throttled, end));
+
+    CHECK(before.kbps > DBR_LINK_KBPS * 1.5);
+    CHECK(after.kbps > before.kbps * 0.8);
+    CHECK_EQ(after.missing, 0);
+}
+
+int main()
+{
+    test_obs obs;
+    obs.start(DBR_WIDTH, DBR_HEIGHT, DBR_FPS);
+    obs.add_moving_square(DBR_WIDTH, DBR_HEIGHT, DBR_FPS);
+    obs.add_tone(440, 0.5f, 1 << 0);
+
+    lite_obs_x264_settings x264{};
+    x264.preset = "ultrafast";
+    x264.keyint_sec = 2;
+    obs.api->lite_obs_reset_encoder2(obs.api, true, &x264);
+
+    test_sole_stream(obs);
+    test_shared_encoder(obs);
+    return 0;
+}
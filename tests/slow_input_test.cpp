@@ -0,0 +1,133 @@
+#include "test_common.h"
+#include "lite-obs/media-io/video_output.h"
+#include "lite-obs/util/threading.h"
+
+#include <atomic>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define SLOW_WIDTH 160
+#define SLOW_HEIGHT 90
+#define SLOW_FPS 30
+#define SLOW_FRAMES 120
+/* what lite_obs_core_video opens its output with */
+#define SLOW_CACHE_SIZE 6
+/* the mock encoder takes this many frame times for every frame */
+#define SLOW_ENCODE_FRAMES 8
+
+/* one connected input: what it was handed, and whether the frame it was
+ * handed still held what the graphics thread wrote for that timestamp */
+struct slow_input {
+    uint64_t start_ts{};
+    uint64_t frame_time{};
+    uint64_t encode_ns{};
+    std::mutex mutex;
+    std::vector<uint64_t> indices;
+    std::atomic_uint64_t overwritten{};
+
+    uint64_t index(uint64_t timestamp) const { return (timestamp - start_ts + frame_time / 2) / frame_time; }
+
+    static void callback(void *param, video_data *frame) {
+        auto self = (slow_input *)param;
+        uint64_t expected = self->index(frame->timestamp);
+        uint64_t marker;
+        memcpy(&marker, frame->frame.data[0], sizeof(marker));
+        if (marker != expected)
+            self->overwritten++;
+
+        if (self->encode_ns) {
+            os_sleepto_ns(os_gettime_ns() + self->encode_ns);
+            memcpy(&marker, frame->frame.data[0], sizeof(marker));
+            if (marker != expected)
+                self->overwritten++;
+        }
+
+        std::lock_guard<std::mutex> lock(self->mutex);
+        self->indices.push_back(expected);
+    }
+};
+
+/* a video output feeding two inputs that keep up and a mock encoder that
+ * takes eight frame times per frame. the fast inputs must get every frame,
+ * in order and none dropped, and the graphics thread must always find a
+ * free cache slot. the slow one drops its oldest frames, stays within its
+ * queue limit and keeps up with recent frames. no input may see a frame
+ * whose slot was reused while it held it */
+int main()
+{
+    video_output_info info{};
+    info.name = "test";
+    info.format = video_format::VIDEO_FORMAT_NV12;
+    info.width = SLOW_WIDTH;
+    info.height = SLOW_HEIGHT;
+    info.fps_num = SLOW_FPS;
+    info.fps_den = 1;
+    info.cache_size = SLOW_CACHE_SIZE;
+
+    video_output output;
+    CHECK_EQ(output.video_output_open(&info), VIDEO_OUTPUT_SUCCESS);
+
+    const uint64_t frame_time = output.video_output_get_frame_time();
+    const uint64_t start_ts = os_gettime_ns() + frame_time;
+
+    slow_input inputs[3];
+    for (auto &input : inputs) {
+        input.start_ts = start_ts;
+        input.frame_time = frame_time;
+    }
+    slow_input &slow = inputs[2];
+    slow.encode_ns = frame_time * SLOW_ENCODE_FRAMES;
+
+    for (auto &input : inputs)
+        CHECK(output.video_output_connect(nullptr, slow_input::callback, &input));
+
+    /* the graphics thread: one frame per interval, stamped with its index */
+    uint64_t lock_failures = 0;
+    for (uint64_t i = 0; i < SLOW_FRAMES; i++) {
+        uint64_t timestamp = start_ts + i * frame_time;
+        os_sleepto_ns(timestamp);
+
+        video_frame frame;
+        if (!output.video_output_lock_frame(&frame, 1, timestamp)) {
+            lock_failures++;
+            continue;
+        }
+        memcpy(frame.data[0], &i, sizeof(i));
+        output.video_output_unlock_frame();
+    }
+
+    /* let the fast inputs take the last frame */
+    os_sleep_ms(200);
+
+    video_input_stats stats[3];
+    for (int i = 0; i < 3; i++)
+        CHECK(output.video_output_get_input_stats(slow_input::callback, &inputs[i], &stats[i]));
+    output.video_output_close();
+
+    for (int i = 0; i < 3; i++) {
+        fprintf(stderr, "input %d: %llu delivered, %llu dropped, max queue %u of %u, avg %.2f ms\n", i,
+                (unsigned long long)stats[i].delivered_frames, (unsigned long long)stats[i].dropped_frames,
+                stats[i].max_queue_depth, stats[i].queue_limit, stats[i].avg_callback_ns / 1000000.0);
+        CHECK_EQ(inputs[i].overwritten, 0);
+    }
+    fprintf(stderr, "graphics thread: %llu of %d frames found the cache full\n", (unsigned long long)lock_failures, SLOW_FRAMES);
+    CHECK_EQ(lock_failures, 0);
+
+    for (int i = 0; i < 2; i++) {
+        CHECK_EQ(stats[i].dropped_frames, 0);
+        CHECK_EQ(inputs[i].indices.size(), SLOW_FRAMES);
+        for (size_t f = 0; f < inputs[i].indices.size(); f++)
+            CHECK_EQ(inputs[i].indices[f], f);
+    }
+
+    CHECK(stats[2].dropped_frames > 0);
+    CHECK(stats[2].max_queue_depth <= stats[2].queue_limit);
+    CHECK(slow.indices.size() >= SLOW_FRAMES / SLOW_ENCODE_FRAMES / 2);
+    for (size_t f = 1; f < slow.indices.size(); f++)
+        CHECK(slow.indices[f] > slow.indices[f - 1]);
+    /* it ends on recent frames rather than a backlog from the start */
+    CHECK(slow.indices.back() + stats[2].queue_limit + SLOW_ENCODE_FRAMES >= SLOW_FRAMES - 1);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "test_video.h"
+
+#define STAGING_WIDTH 64
+#define STAGING_HEIGHT 64
+#define STAGING_FPS 60
+#define STAGING_FRAMES 30
+
+#define STAGING_R 30
+#define STAGING_G 160
+#define STAGING_B 220
+
+/* reads STAGING_FRAMES frames back through a ring of the given depth. the
+ * frames have to come out in staging order, every timestamp a whole number
+ * of frame intervals after the last, with the right pixels, and none may
+ * sit in the ring for longer than it is deep */
+static void run_staging(uint32_t depth, bool gpu_conversion)
+{
+    fprintf(stderr, "depth %u, gpu conversion %d\n", depth, gpu_conversion);
+
+    test_video video;
+    video.video->lite_obs_set_stage_depth(depth);
+    video.video->lite_obs_set_gpu_conversion(gpu_conversion);
+    video.start(STAGING_WIDTH, STAGING_HEIGHT, STAGING_FPS);
+
+    auto image = test_rgba_image(STAGING_WIDTH, STAGING_HEIGHT, STAGING_R, STAGING_G, STAGING_B);
+    auto source = video.add_source(source_type::SOURCE_VIDEO);
+    source->lite_source_output_video(image.data(), STAGING_WIDTH, STAGING_HEIGHT);
+
+    test_video_capture capture;
+    video.connect(&capture);
+    CHECK(capture.wait_frames(STAGING_FRAMES));
+    video.disconnect();
+
+    uint64_t interval = video.video->core_video()->video_output_get_frame_time();
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    for (size_t i = 1; i < capture.timestamps.size(); i++) {
+        uint64_t delta = capture.timestamps[i] - capture.timestamps[i - 1];
+        CHECK(capture.timestamps[i] > capture.timestamps[i - 1]);
+        CHECK_EQ(delta % interval, 0);
+    }
+    CHECK(video.video->readback_latency() < depth);
+
+    double y, u, v;
+    test_rgb_to_yuv(STAGING_R, STAGING_G, STAGING_B, &y, &u, &v);
+    CHECK_NEAR(capture.y, y, 2);
+    CHECK_NEAR(capture.u, u, 2);
+    CHECK_NEAR(capture.v, v, 2);
+}
+
+int main()
+{
+    for (uint32_t depth : {2, 4, 8}) {
+        run_staging(depth, false);
+        run_staging(depth, true);
+    }
+    return 0;
+}
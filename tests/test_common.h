@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ctest reports a test that exits with this as skipped, for the ones that
+ * need a gpu or a codec the machine does not have */
+#define TEST_SKIP 77
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(EXIT_FAILURE);                                                  \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                           \
+    do {                                                                         \
+        long long check_a = (long long)(a);                                      \
+        long long check_b = (long long)(b);                                      \
+        if (check_a != check_b) {                                                \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n",    \
+                    __FILE__, __LINE__, #a, #b, check_a, check_b);               \
+            exit(EXIT_FAILURE);                                                  \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                              \
+    do {                                                                         \
+        double check_a = (double)(a);                                            \
+        double check_b = (double)(b);                                            \
+        if (check_a - check_b > (tolerance) || check_b - check_a > (tolerance)) { \
+            fprintf(stderr, "%s:%d: check failed: %s ~ %s (%g vs %g)\n",         \
+                    __FILE__, __LINE__, #a, #b, check_a, check_b);               \
+            exit(EXIT_FAILURE);                                                  \
+        }                                                                        \
+    } while (0)
+
+#define TEST_SKIP_IF(cond, reason)                                               \
+    do {                                                                         \
+        if (cond) {                                                              \
+            fprintf(stderr, "skipped: %s\n", reason);                            \
+            exit(TEST_SKIP);                                                     \
+        }                                                                        \
+    } while (0)
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/* the picture data of an h264 access unit, whatever container it came out
+ * of: the slice nal units only, each behind a 00 00 01 start code. sps, pps,
+ * sei and access unit delimiters are left out, muxers add or drop those on
+ * their own */
+struct h264_picture {
+    std::string slices;
+    bool idr{};
+};
+
+static inline void h264_add_nal(h264_picture &picture, const uint8_t *nal, size_t size)
+{
+    if (!size)
+        return;
+
+    int type = nal[0] & 0x1f;
+    if (type != 1 && type != 5)
+        return;
+
+    picture.idr |= type == 5;
+    picture.slices.append("\0\0\1", 3);
+    picture.slices.append((const char *)nal, size);
+}
+
+/* nal units behind 00 00 01 or 00 00 00 01, as in mpeg-ts and raw x264
+ * output. the zero byte before a four byte start code belongs to it, not to
+ * the nal before */
+static inline h264_picture h264_from_annexb(const uint8_t *data, size_t size)
+{
+    h264_picture picture;
+    size_t nal = SIZE_MAX;
+    size_t i = 0;
+    while (i + 3 <= size) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            if (nal != SIZE_MAX) {
+                size_t end = i;
+                while (end > nal && data[end - 1] == 0)
+                    end--;
+                h264_add_nal(picture, data + nal, end - nal);
+            }
+            i += 3;
+            nal = i;
+        } else {
+            i++;
+        }
+    }
+    if (nal != SIZE_MAX)
+        h264_add_nal(picture, data + nal, size - nal);
+    return picture;
+}
+
+/* nal units behind a four byte big endian length, as in mp4 and flv */
+static inline h264_picture h264_from_avcc(const uint8_t *data, size_t size)
+{
+    h264_picture picture;
+    size_t pos = 0;
+    while (pos + 4 <= size) {
+        size_t len = ((size_t)data[pos] << 24) | ((size_t)data[pos + 1] << 16) | ((size_t)data[pos + 2] << 8) | data[pos + 3];
+        pos += 4;
+        if (len > size - pos)
+            break;
+        h264_add_nal(picture, data + pos, len);
+        pos += len;
+    }
+    return picture;
+}
+
+/* exp-golomb reader over an sps with the emulation prevention bytes taken
+ * out */
+struct h264_bits {
+    std::string rbsp;
+    size_t pos{};
+
+    h264_bits(const uint8_t *nal, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            if (i >= 2 && nal[i] == 3 && nal[i - 1] == 0 && nal[i - 2] == 0)
+                continue;
+            rbsp.push_back((char)nal[i]);
+        }
+    }
+
+    uint32_t bit() {
+        if (pos >= rbsp.size() * 8)
+            return 0;
+        uint32_t b = ((uint8_t)rbsp[pos / 8] >> (7 - pos % 8)) & 1;
+        pos++;
+        return b;
+    }
+
+    uint32_t bits(int n) {
+        uint32_t v = 0;
+        while (n--)
+            v = (v << 1) | bit();
+        return v;
+    }
+
+    uint32_t ue() {
+        int zeros = 0;
+        while (!bit() && zeros < 32)
+            zeros++;
+        return (1u << zeros) - 1 + bits(zeros);
+    }
+};
+
+/* the picture size of the first sps in annex b data, false without one.
+ * 4:2:0 only, scaling matrices are not skipped */
+static inline bool h264_sps_size(const uint8_t *data, size_t size, uint32_t *width, uint32_t *height)
+{
+    for (size_t i = 0; i + 4 < size; i++) {
+        if (data[i] || data[i + 1] || data[i + 2] != 1 || (data[i + 3] & 0x1f) != 7)
+            continue;
+
+        h264_bits bits(data + i + 4, size - i - 4);
+        uint32_t profile = bits.bits(8);
+        bits.bits(16); /* constraint flags, level */
+        bits.ue(); /* sps id */
+        if (profile == 100 || profile == 110 || profile == 122 || profile == 244 || profile == 44 ||
+            profile == 83 || profile == 86 || profile == 118 || profile == 128) {
+            if (bits.ue() != 1)
+                return false;
+            bits.ue(); /* bit depths */
+            bits.ue();
+            bits.bit();
+            if (bits.bit())
+                return false;
+        }
+
+        bits.ue(); /* log2 max frame num */
+        uint32_t poc_type = bits.ue();
+        if (poc_type == 0) {
+            bits.ue();
+        } else if (poc_type == 1) {
+            bits.bit();
+            bits.ue();
+            bits.ue();
+            uint32_t cycle = bits.ue();
+            while (cycle--)
+                bits.ue();
+        }
+        bits.ue(); /* max ref frames */
+        bits.bit();
+
+        uint32_t mbs_w = bits.ue() + 1;
+        uint32_t map_units_h = bits.ue() + 1;
+        uint32_t frame_mbs_only = bits.bit();
+        if (!frame_mbs_only)
+            bits.bit();
+        bits.bit(); /* direct 8x8 inference */
+
+        uint32_t crop[4]{};
+        if (bits.bit()) {
+            for (auto &c : crop)
+                c = bits.ue();
+        }
+
+        *width = mbs_w * 16 - 2 * (crop[0] + crop[1]);
+        *height = map_units_h * 16 * (2 - frame_mbs_only) - 2 * (2 - frame_mbs_only) * (crop[2] + crop[3]);
+        return true;
+    }
+    return false;
+}
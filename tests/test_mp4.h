@@ -0,0 +1,192 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* just enough of an iso bmff (mp4 / mov) reader to check what a recording
+ * holds without ffprobe: the tracks in moov with their handler, timescale,
+ * duration, sample sizes and offsets and the name in their udta */
+
+struct mp4_track {
+    std::string handler; /* "vide", "soun" */
+    std::string name;
+    uint32_t timescale{};
+    uint64_t duration{};
+    std::vector<uint32_t> sample_sizes;
+    std::vector<uint64_t> sample_offsets;
+
+    /* stco / co64 and stsc, turned into sample_offsets once moov is read */
+    std::vector<uint64_t> chunk_offsets;
+    std::vector<std::pair<uint32_t, uint32_t>> chunk_runs; /* first chunk (1 based), samples per chunk */
+
+    uint64_t bytes() const {
+        uint64_t total = 0;
+        for (auto size : sample_sizes)
+            total += size;
+        return total;
+    }
+};
+
+struct mp4_reader {
+    std::vector<uint8_t> data;
+    std::vector<mp4_track> tracks;
+
+    bool open(const std::string &path) {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        uint8_t buf[65536];
+        size_t got;
+        while ((got = fread(buf, 1, sizeof(buf), file)) > 0)
+            data.insert(data.end(), buf, buf + got);
+        fclose(file);
+
+        if (!parse_boxes(0, data.size(), nullptr))
+            return false;
+
+        for (auto &track : tracks) {
+            if (!locate_samples(track))
+                return false;
+        }
+        return true;
+    }
+
+    /* the bytes of sample i, sample_sizes[i] of them */
+    const uint8_t *sample(const mp4_track &track, size_t i) const {
+        return &data[(size_t)track.sample_offsets[i]];
+    }
+
+    size_t count(const char *handler) const {
+        size_t n = 0;
+        for (auto &track : tracks)
+            n += track.handler == handler;
+        return n;
+    }
+
+    static uint32_t be32(const uint8_t *p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    static uint64_t be64(const uint8_t *p) {
+        return ((uint64_t)be32(p) << 32) | be32(p + 4);
+    }
+
+private:
+    /* samples follow each other within a chunk, the runs say how many each
+     * chunk holds from the chunk they start at up to the next run */
+    bool locate_samples(mp4_track &track) {
+        size_t sample = 0;
+        for (size_t run = 0; run < track.chunk_runs.size(); run++) {
+            if (!track.chunk_runs[run].first)
+                return false;
+            size_t first = track.chunk_runs[run].first - 1;
+            size_t last = run + 1 < track.chunk_runs.size() ? track.chunk_runs[run + 1].first - 1 : track.chunk_offsets.size();
+            for (size_t chunk = first; chunk < last && chunk < track.chunk_offsets.size(); chunk++) {
+                uint64_t offset = track.chunk_offsets[chunk];
+                for (uint32_t i = 0; i < track.chunk_runs[run].second && sample < track.sample_sizes.size(); i++) {
+                    if (offset + track.sample_sizes[sample] > data.size())
+                        return false;
+                    track.sample_offsets.push_back(offset);
+                    offset += track.sample_sizes[sample++];
+                }
+            }
+        }
+        return track.sample_offsets.size() == track.sample_sizes.size();
+    }
+
+    bool parse_boxes(size_t pos, size_t end, mp4_track *track) {
+        while (pos + 8 <= end) {
+            uint64_t size = be32(&data[pos]);
+            char type[5] = {};
+            memcpy(type, &data[pos + 4], 4);
+
+            size_t header = 8;
+            if (size == 1) {
+                if (pos + 16 > end)
+                    return false;
+                size = be64(&data[pos + 8]);
+                header = 16;
+            } else if (size == 0) {
+                size = end - pos;
+            }
+
+            if (size < header || size > end - pos)
+                return false;
+
+            if (!parse_box(type, pos + header, pos + (size_t)size, track))
+                return false;
+            pos += (size_t)size;
+        }
+        return pos == end;
+    }
+
+    bool parse_box(const char *type, size_t pos, size_t end, mp4_track *track) {
+        const uint8_t *p = &data[pos];
+        size_t len = end - pos;
+
+        if (!strcmp(type, "moov") || !strcmp(type, "mdia") || !strcmp(type, "minf") || !strcmp(type, "stbl"))
+            return parse_boxes(pos, end, track);
+
+        if (!strcmp(type, "trak")) {
+            tracks.emplace_back();
+            return parse_boxes(pos, end, &tracks.back());
+        }
+
+        if (!track)
+            return true;
+
+        if (!strcmp(type, "udta")) {
+            return parse_boxes(pos, end, track);
+        } else if (!strcmp(type, "name")) {
+            track->name.assign((const char *)p, strnlen((const char *)p, len));
+        } else if (!strcmp(type, "hdlr")) {
+            if (len < 12)
+                return false;
+            track->handler.assign((const char *)p + 8, 4);
+        } else if (!strcmp(type, "mdhd")) {
+            if (len < 24)
+                return false;
+            if (p[0] == 1) {
+                if (len < 36)
+                    return false;
+                track->timescale = be32(p + 20);
+                track->duration = be64(p + 24);
+            } else {
+                track->timescale = be32(p + 12);
+                track->duration = be32(p + 16);
+            }
+        } else if (!strcmp(type, "stsz")) {
+            if (len < 12)
+                return false;
+            uint32_t sample_size = be32(p + 4);
+            uint32_t samples = be32(p + 8);
+            if (!sample_size && len < 12 + (size_t)samples * 4)
+                return false;
+            for (uint32_t i = 0; i < samples; i++)
+                track->sample_sizes.push_back(sample_size ? sample_size : be32(p + 12 + i * 4));
+        } else if (!strcmp(type, "stco") || !strcmp(type, "co64")) {
+            if (len < 8)
+                return false;
+            bool wide = type[0] == 'c';
+            uint32_t chunks = be32(p + 4);
+            if (len < 8 + (size_t)chunks * (wide ? 8 : 4))
+                return false;
+            for (uint32_t i = 0; i < chunks; i++)
+                track->chunk_offsets.push_back(wide ? be64(p + 8 + i * 8) : be32(p + 8 + i * 4));
+        } else if (!strcmp(type, "stsc")) {
+            if (len < 8)
+                return false;
+            uint32_t runs = be32(p + 4);
+            if (len < 8 + (size_t)runs * 12)
+                return false;
+            for (uint32_t i = 0; i < runs; i++)
+                track->chunk_runs.emplace_back(be32(p + 8 + i * 12), be32(p + 12 + i * 12));
+        }
+        return true;
+    }
+};
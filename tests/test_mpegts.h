@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define TS_PACKET_SIZE 188
+
+/* just enough of an mpeg-ts demuxer to check what an srt output sent: the
+ * pat and pmt to find the h264 stream, then its pes packets with their
+ * timestamps. one program, no scrambling, no crc checks */
+
+struct ts_pes {
+    int64_t pts = -1; /* 90 kHz */
+    int64_t dts = -1;
+    std::string data;
+};
+
+struct ts_reader {
+    int pmt_pid = -1;
+    int video_pid = -1;
+    std::vector<ts_pes> video;
+    size_t packets{};
+    size_t lost_sync{};
+
+    /* the whole stream at once, partial packets at the end are ignored */
+    void parse(const uint8_t *data, size_t size) {
+        size_t pos = 0;
+        while (pos + TS_PACKET_SIZE <= size) {
+            if (data[pos] != 0x47) {
+                lost_sync++;
+                pos++;
+                continue;
+            }
+            parse_packet(data + pos);
+            pos += TS_PACKET_SIZE;
+        }
+        finish_pes();
+    }
+
+private:
+    std::string pes;
+    bool in_pes{};
+
+    void parse_packet(const uint8_t *p) {
+        packets++;
+        bool unit_start = p[1] & 0x40;
+        int pid = ((p[1] & 0x1f) << 8) | p[2];
+        int adaptation = (p[3] >> 4) & 3;
+
+        size_t offset = 4;
+        if (adaptation & 2)
+            offset += 1 + p[4];
+        if (!(adaptation & 1) || offset >= TS_PACKET_SIZE)
+            return;
+
+        const uint8_t *payload = p + offset;
+        size_t len = TS_PACKET_SIZE - offset;
+
+        if (pid == 0 || pid == pmt_pid) {
+            if (!unit_start || len < 1 || (size_t)payload[0] + 1 >= len)
+                return;
+            size_t pointer = payload[0] + 1;
+            parse_section(pid, payload + pointer, len - pointer);
+        } else if (pid == video_pid) {
+            if (unit_start) {
+                finish_pes();
+                in_pes = true;
+            }
+            if (in_pes)
+                pes.append((const char *)payload, len);
+        }
+    }
+
+    void parse_section(int pid, const uint8_t *s, size_t len) {
+        if (len < 3)
+            return;
+        size_t section_length = ((s[1] & 0x0f) << 8) | s[2];
+        size_t end = 3 + section_length;
+        if (end > len || section_length < 9)
+            return;
+        end -= 4; /* crc */
+
+        if (pid == 0 && s[0] == 0x00) {
+            for (size_t i = 8; i + 4 <= end; i += 4) {
+                int program = (s[i] << 8) | s[i + 1];
+                if (program)
+                    pmt_pid = ((s[i + 2] & 0x1f) << 8) | s[i + 3];
+            }
+        } else if (s[0] == 0x02 && end >= 12) {
+            size_t i = 12 + (((s[10] & 0x0f) << 8) | s[11]);
+            while (i + 5 <= end) {
+                int stream_type = s[i];
+                int es_pid = ((s[i + 1] & 0x1f) << 8) | s[i + 2];
+                size_t info = ((s[i + 3] & 0x0f) << 8) | s[i + 4];
+                if (stream_type == 0x1b && video_pid < 0)
+                    video_pid = es_pid;
+                i += 5 + info;
+            }
+        }
+    }
+
+    static int64_t timestamp(const uint8_t *p) {
+        return ((int64_t)(p[0] & 0x0e) << 29) | ((int64_t)p[1] << 22) | ((int64_t)(p[2] & 0xfe) << 14) |
+               ((int64_t)p[3] << 7) | (p[4] >> 1);
+    }
+
+    void finish_pes() {
+        if (!in_pes)
+            return;
+        in_pes = false;
+
+        auto p = (const uint8_t *)pes.data();
+        if (pes.size() < 9 || p[0] || p[1] || p[2] != 1) {
+            pes.clear();
+            return;
+        }
+
+        ts_pes packet;
+        size_t header = 9 + p[8];
+        int flags = p[7] >> 6;
+        if ((flags & 2) && pes.size() >= 14)
+            packet.pts = timestamp(p + 9);
+        packet.dts = (flags == 3 && pes.size() >= 19) ? timestamp(p + 14) : packet.pts;
+        if (header < pes.size())
+            packet.data = pes.substr(header);
+        video.push_back(std::move(packet));
+        pes.clear();
+    }
+};
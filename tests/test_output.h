@@ -0,0 +1,189 @@
+#pragma once
+
+#include "test_common.h"
+#include "lite-obs/lite_obs.h"
+#include "lite-obs/lite_obs_core_video.h"
+#include "lite-obs/lite_obs_output.h"
+#include "lite-obs/util/threading.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <math.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_OUTPUT_SAMPLE_RATE 48000
+#define TEST_OUTPUT_TIMEOUT_SEC 10
+
+/* 10 ms of audio per push, the way a capture device delivers it */
+#define TEST_TONE_FRAMES (TEST_OUTPUT_SAMPLE_RATE / 100)
+
+/* what an output reported through its callbacks */
+struct test_output_events {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool started{};
+    bool stopped{};
+    bool first_packet{};
+    int stop_code{};
+    std::string stop_message;
+
+    lite_obs_output_callbak callback() {
+        lite_obs_output_callbak cb{};
+        cb.start = [](void *param) {
+            auto self = (test_output_events *)param;
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->started = true;
+            self->cond.notify_all();
+        };
+        cb.stop = [](int code, const char *msg, void *param) {
+            auto self = (test_output_events *)param;
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->stopped = true;
+            self->stop_code = code;
+            self->stop_message = msg ? msg : "";
+            self->cond.notify_all();
+        };
+        cb.first_media_packet = [](void *param) {
+            auto self = (test_output_events *)param;
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->first_packet = true;
+            self->cond.notify_all();
+        };
+        cb.opaque = this;
+        return cb;
+    }
+
+    bool wait_first_packet() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(TEST_OUTPUT_TIMEOUT_SEC), [&] { return first_packet || stopped; }) && first_packet;
+    }
+
+    bool wait_stopped() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(TEST_OUTPUT_TIMEOUT_SEC), [&] { return stopped; });
+    }
+};
+
+/* a whole lite_obs through its c api, with sources fed from threads of
+ * their own, for tests that encode and write or send the result */
+struct test_obs {
+    lite_obs_api *api = lite_obs_api_new();
+    std::vector<lite_obs_media_source_api *> sources;
+    std::vector<std::thread> feeders;
+    std::atomic_bool stop_feeding{};
+
+    ~test_obs() {
+        stop_feeders();
+        for (auto &source : sources)
+            lite_obs_media_source_delete(api, &source);
+        lite_obs_api_delete(&api);
+    }
+
+    /* skips the test on machines without a graphics device */
+    void start(uint32_t width, uint32_t height, uint32_t fps) {
+        TEST_SKIP_IF(api->lite_obs_reset_video(api, width, height, fps) != LITE_OBS_VIDEO_SUCCESS, "no graphics device");
+        CHECK(api->lite_obs_reset_audio(api, TEST_OUTPUT_SAMPLE_RATE));
+    }
+
+    void stop_feeders() {
+        stop_feeding = true;
+        for (auto &feeder : feeders)
+            feeder.join();
+        feeders.clear();
+    }
+
+    /* a still image covering the canvas */
+    lite_obs_media_source_api *add_image(uint32_t width, uint32_t height, uint8_t r, uint8_t g, uint8_t b) {
+        std::vector<uint8_t> image(width * height * 4);
+        for (size_t i = 0; i < image.size(); i += 4) {
+            image[i] = r;
+            image[i + 1] = g;
+            image[i + 2] = b;
+            image[i + 3] = 255;
+        }
+
+        auto source = lite_obs_media_source_new(api, source_type::SOURCE_VIDEO);
+        source->output_video3(source, image.data(), width, height);
+        sources.push_back(source);
+        return source;
+    }
+
+    /* a square moving over a gradient, a new image every frame, so no two
+     * encoded pictures are alike */
+    lite_obs_media_source_api *add_moving_square(uint32_t width, uint32_t height, uint32_t fps) {
+        auto source = lite_obs_media_source_new(api, source_type::SOURCE_VIDEO);
+        sources.push_back(source);
+
+        feeders.emplace_back([this, source, width, height, fps] {
+            std::vector<uint8_t> image(width * height * 4);
+            const uint64_t interval = 1000000000ULL / fps;
+            uint64_t next = os_gettime_ns();
+            uint32_t frame = 0;
+
+            while (!stop_feeding) {
+                for (uint32_t y = 0; y < height; y++) {
+                    for (uint32_t x = 0; x < width; x++) {
+                        uint8_t *pixel = &image[(y * width + x) * 4];
+                        bool square = (x + width - frame * 5 % width) % width < height / 3 && (y + frame * 3) % height < height / 3;
+                        pixel[0] = square ? 240 : (uint8_t)(x * 255 / width);
+                        pixel[1] = square ? 240 : (uint8_t)(y * 255 / height);
+                        pixel[2] = square ? 40 : 128;
+                        pixel[3] = 255;
+                    }
+                }
+                source->output_video3(source, image.data(), width, height);
+                frame++;
+                next += interval;
+                os_sleepto_ns(next);
+            }
+        });
+        return source;
+    }
+
+    /* a stereo sine mixed into the tracks set in mixers, amplitude 0 feeds
+     * silence */
+    lite_obs_media_source_api *add_tone(double freq, float amplitude, uint32_t mixers) {
+        auto source = lite_obs_media_source_new(api, source_type::SOURCE_AUDIO);
+        source->set_audio_mixers(source, mixers);
+        sources.push_back(source);
+
+        feeders.emplace_back([this, source, freq, amplitude] {
+            std::vector<float> samples(TEST_TONE_FRAMES);
+            const uint8_t *planes[MAX_AV_PLANES] = {(const uint8_t *)samples.data(), (const uint8_t *)samples.data()};
+            const uint64_t interval = 1000000000ULL * TEST_TONE_FRAMES / TEST_OUTPUT_SAMPLE_RATE;
+            uint64_t next = os_gettime_ns();
+            uint64_t frame = 0;
+
+            while (!stop_feeding) {
+                for (auto &sample : samples)
+                    sample = amplitude * (float)sin(2 * M_PI * freq * (double)frame++ / TEST_OUTPUT_SAMPLE_RATE);
+
+                source->output_audio(source, planes, TEST_TONE_FRAMES, audio_format::AUDIO_FORMAT_FLOAT_PLANAR,
+                                     speaker_layout::SPEAKERS_STEREO, TEST_OUTPUT_SAMPLE_RATE);
+                next += interval;
+                os_sleepto_ns(next);
+            }
+        });
+        return source;
+    }
+};
+
+/* a file in the temp directory, removed when the test is done with it */
+struct test_temp_file {
+    std::string path;
+
+    explicit test_temp_file(const char *name) {
+        path = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove(path);
+    }
+
+    ~test_temp_file() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+};
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET test_socket_t;
+#define TEST_INVALID_SOCKET INVALID_SOCKET
+#define test_close_socket closesocket
+#define test_poll WSAPoll
+#define TEST_SEND_FLAGS 0
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int test_socket_t;
+#define TEST_INVALID_SOCKET (-1)
+#define test_close_socket close
+#define test_poll poll
+#define TEST_SEND_FLAGS MSG_NOSIGNAL
+#endif
+
+#define RTMP_SINK_SIG_SIZE 1536
+#define RTMP_SINK_CHUNK_SIZE 128
+#define RTMP_SINK_TIMEOUT_SEC 10
+/* what a throttled sink may read in one go after a pause */
+#define RTMP_SINK_BURST_MS 20
+
+#define RTMP_MSG_SET_CHUNK_SIZE 1
+#define RTMP_MSG_AUDIO 8
+#define RTMP_MSG_VIDEO 9
+#define RTMP_MSG_COMMAND 20
+
+/* a message the client sent, the timestamp in ms, received when its last
+ * byte was read */
+struct rtmp_message {
+    uint8_t type{};
+    uint32_t timestamp{};
+    std::chrono::steady_clock::time_point received;
+    std::string data;
+};
+
+/* just enough of an rtmp server on 127.0.0.1 for a librtmp publisher: the
+ * plain handshake, the chunk stream and answers to connect, createStream
+ * and publish. it takes one connection and keeps the audio and video
+ * messages it gets, for the test to compare with what the encoder made.
+ * with a read rate set it reads through a token bucket, and with a small
+ * receive buffer the client's socket backs up like behind a slow link */
+struct rtmp_sink {
+    int port{};
+    /* bytes per second, 0 reads as fast as the client sends. may change
+     * while the client is sending */
+    std::atomic<uint64_t> read_rate{};
+    /* SO_RCVBUF of the connection, set before start, 0 keeps the default */
+    int receive_buffer{};
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<rtmp_message> media;
+    bool publishing{};
+    bool closed{};
+
+    ~rtmp_sink() { stop(); }
+
+    /* rtmp://127.0.0.1:port/live/test once start returned true */
+    std::string url() const { return "rtmp://127.0.0.1:" + std::to_string(port) + "/live/test"; }
+
+    bool start() {
+#ifdef _WIN32
+        WSADATA wsa;
+        WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+        listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_socket == TEST_INVALID_SOCKET)
+            return false;
+
+        /* an accepted socket takes the buffer of the listening one, the
+         * window is settled during the handshake */
+        if (receive_buffer &&
+            setsockopt(listen_socket, SOL_SOCKET, SO_RCVBUF, (const char *)&receive_buffer, sizeof(receive_buffer)))
+            return false;
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listen_socket, (sockaddr *)&addr, sizeof(addr)) || listen(listen_socket, 1) ||
+            getsockname(listen_socket, (sockaddr *)&addr, &len))
+            return false;
+
+        port = ntohs(addr.sin_port);
+        thread = std::thread([this] { serve(); });
+        return true;
+    }
+
+    void stop() {
+        quit = true;
+        if (thread.joinable())
+            thread.join();
+        if (client != TEST_INVALID_SOCKET)
+            test_close_socket(client);
+        if (listen_socket != TEST_INVALID_SOCKET)
+            test_close_socket(listen_socket);
+        client = listen_socket = TEST_INVALID_SOCKET;
+    }
+
+    bool wait_publishing() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(RTMP_SINK_TIMEOUT_SEC), [&] { return publishing || closed; }) && publishing;
+    }
+
+    bool wait_closed() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(RTMP_SINK_TIMEOUT_SEC), [&] { return closed; });
+    }
+
+private:
+    struct chunk_stream {
+        uint32_t timestamp{};
+        uint32_t delta{};
+        uint32_t length{};
+        uint8_t type{};
+        uint32_t stream_id{};
+        bool extended{};
+        std::string payload;
+    };
+
+    test_socket_t listen_socket = TEST_INVALID_SOCKET;
+    test_socket_t client = TEST_INVALID_SOCKET;
+    std::thread thread;
+    std::atomic_bool quit{};
+    std::map<uint32_t, chunk_stream> streams;
+    uint32_t in_chunk_size = RTMP_SINK_CHUNK_SIZE;
+    double tokens{};
+    std::chrono::steady_clock::time_point refill = std::chrono::steady_clock::now();
+
+    /* waits for data in slices so stop() never hangs on a silent client */
+    bool wait_readable(test_socket_t s) {
+        while (!quit) {
+            pollfd fd{};
+            fd.fd = s;
+            fd.events = POLLIN;
+            int ret = test_poll(&fd, 1, 100);
+            if (ret > 0)
+                return true;
+            if (ret < 0)
+                return false;
+        }
+        return false;
+    }
+
+    /* how much of want the token bucket lets through now, waits for the
+     * first byte when it is empty */
+    size_t throttle(size_t want) {
+        while (!quit) {
+            auto now = std::chrono::steady_clock::now();
+            uint64_t rate = read_rate;
+            if (!rate) {
+                refill = now;
+                return want;
+            }
+
+            tokens += std::chrono::duration<double>(now - refill).count() * (double)rate;
+            tokens = std::min(tokens, (double)rate * RTMP_SINK_BURST_MS / 1000);
+            refill = now;
+            if (tokens >= 1)
+                return std::min(want, (size_t)tokens);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 0;
+    }
+
+    bool read_exact(void *buf, size_t size) {
+        auto p = (char *)buf;
+        while (size) {
+            size_t allowed = throttle(size);
+            if (!allowed || !wait_readable(client))
+                return false;
+            int got = (int)recv(client, p, (int)allowed, 0);
+            if (got <= 0)
+                return false;
+            if (read_rate)
+                tokens -= got;
+            p += got;
+            size -= got;
+        }
+        return true;
+    }
+
+    bool write_all(const void *buf, size_t size) {
+        auto p = (const char *)buf;
+        while (size) {
+            int sent = (int)send(client, p, (int)size, TEST_SEND_FLAGS);
+            if (sent <= 0)
+                return false;
+            p += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    void serve() {
+        if (wait_readable(listen_socket)) {
+            client = accept(listen_socket, nullptr, nullptr);
+            if (client != TEST_INVALID_SOCKET && handshake()) {
+                while (read_chunk()) {
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        cond.notify_all();
+    }
+
+    /* c0 c1 in, s0 s1 s2 out with s2 echoing c1, then c2 in */
+    bool handshake() {
+        std::vector<uint8_t> c1(1 + RTMP_SINK_SIG_SIZE);
+        if (!read_exact(c1.data(), c1.size()) || c1[0] != 3)
+            return false;
+
+        std::vector<uint8_t> reply(1 + 2 * RTMP_SINK_SIG_SIZE, 0);
+        reply[0] = 3;
+        for (size_t i = 9; i < 1 + RTMP_SINK_SIG_SIZE; i++)
+            reply[i] = (uint8_t)(i * 7);
+        memcpy(reply.data() + 1 + RTMP_SINK_SIG_SIZE, c1.data() + 1, RTMP_SINK_SIG_SIZE);
+        if (!write_all(reply.data(), reply.size()))
+            return false;
+
+        std::vector<uint8_t> c2(RTMP_SINK_SIG_SIZE);
+        return read_exact(c2.data(), c2.size());
+    }
+
+    static uint32_t be24(const uint8_t *p) { return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]; }
+    static uint32_t be32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | be24(p + 1); }
+
+    bool read_chunk() {
+        uint8_t b[3];
+        if (!read_exact(b, 1))
+            return false;
+        int fmt = b[0] >> 6;
+        uint32_t csid = b[0] & 0x3f;
+        if (csid == 0) {
+            if (!read_exact(b + 1, 1))
+                return false;
+            csid = 64 + b[1];
+        } else if (csid == 1) {
+            if (!read_exact(b + 1, 2))
+                return false;
+            csid = 64 + b[1] + b[2] * 256;
+        }
+
+        auto &cs = streams[csid];
+        static const size_t header_sizes[] = {11, 7, 3, 0};
+        uint8_t h[11];
+        if (!read_exact(h, header_sizes[fmt]))
+            return false;
+
+        bool starts = cs.payload.empty();
+        uint32_t ts = fmt < 3 ? be24(h) : 0;
+        if (fmt < 3)
+            cs.extended = ts == 0xffffff;
+        if (cs.extended) {
+            uint8_t ext[4];
+            if (!read_exact(ext, 4))
+                return false;
+            ts = be32(ext);
+        }
+
+        if (fmt <= 1) {
+            cs.length = be24(h + 3);
+            cs.type = h[6];
+        }
+        if (fmt == 0) {
+            cs.stream_id = h[7] | (h[8] << 8) | (h[9] << 16) | ((uint32_t)h[10] << 24);
+            cs.timestamp = ts;
+            cs.delta = 0;
+        } else if (fmt <= 2) {
+            cs.delta = ts;
+            cs.timestamp += ts;
+        } else if (starts) {
+            cs.timestamp += cs.delta;
+        }
+
+        size_t want = std::min<size_t>(cs.length - cs.payload.size(), in_chunk_size);
+        size_t have = cs.payload.size();
+        cs.payload.resize(have + want);
+        if (want && !read_exact(&cs.payload[have], want))
+            return false;
+
+        if (cs.payload.size() < cs.length)
+            return true;
+
+        rtmp_message message;
+        message.type = cs.type;
+        message.timestamp = cs.timestamp;
+        message.received = std::chrono::steady_clock::now();
+        message.data.swap(cs.payload);
+        return handle(message);
+    }
+
+    bool handle(rtmp_message &message) {
+        auto p = (const uint8_t *)message.data.data();
+        switch (message.type) {
+        case RTMP_MSG_SET_CHUNK_SIZE:
+            if (message.data.size() >= 4)
+                in_chunk_size = be32(p) & 0x7fffffff;
+            return in_chunk_size > 0;
+        case RTMP_MSG_AUDIO:
+        case RTMP_MSG_VIDEO: {
+            std::lock_guard<std::mutex> lock(mutex);
+            media.push_back(std::move(message));
+            return true;
+        }
+        case RTMP_MSG_COMMAND:
+            return command(message.data);
+        default:
+            return true;
+        }
+    }
+
+    /* amf0: the command name and transaction id lead every command */
+    bool command(const std::string &data) {
+        auto p = (const uint8_t *)data.data();
+        if (data.size() < 3 || p[0] != 0x02)
+            return true;
+        size_t len = (p[1] << 8) | p[2];
+        if (data.size() < 3 + len + 9 || p[3 + len] != 0x00)
+            return true;
+        std::string name(data, 3, len);
+        double txn;
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits = (bits << 8) | p[4 + len + i];
+        memcpy(&txn, &bits, sizeof(txn));
+
+        std::string reply;
+        if (name == "connect") {
+            amf_string(reply, "_result");
+            amf_number(reply, txn);
+            amf_null(reply);
+            amf_status(reply, "status", "NetConnection.Connect.Success");
+        } else if (name == "createStream") {
+            amf_string(reply, "_result");
+            amf_number(reply, txn);
+            amf_null(reply);
+            amf_number(reply, 1);
+        } else if (name == "publish") {
+            amf_string(reply, "onStatus");
+            amf_number(reply, 0);
+            amf_null(reply);
+            amf_status(reply, "status", "NetStream.Publish.Start");
+            if (!send_message(RTMP_MSG_COMMAND, 1, reply))
+                return false;
+            std::lock_guard<std::mutex> lock(mutex);
+            publishing = true;
+            cond.notify_all();
+            return true;
+        } else if (txn > 0) {
+            amf_string(reply, "_result");
+            amf_number(reply, txn);
+            amf_null(reply);
+            amf_null(reply);
+        } else {
+            return true;
+        }
+        return send_message(RTMP_MSG_COMMAND, 0, reply);
+    }
+
+    static void amf_string(std::string &out, const char *str) {
+        size_t len = strlen(str);
+        out += (char)0x02;
+        out += (char)(len >> 8);
+        out += (char)len;
+        out += str;
+    }
+
+    static void amf_number(std::string &out, double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        out += (char)0x00;
+        for (int i = 7; i >= 0; i--)
+            out += (char)(bits >> (i * 8));
+    }
+
+    static void amf_null(std::string &out) { out += (char)0x05; }
+
+    static void amf_status(std::string &out, const char *level, const char *code) {
+        out += (char)0x03;
+        for (auto key : {"level", "code"}) {
+            size_t len = strlen(key);
+            out += (char)(len >> 8);
+            out += (char)len;
+            out += key;
+            amf_string(out, key[0] == 'l' ? level : code);
+        }
+        out.append("\0\0\x09", 3);
+    }
+
+    /* on chunk stream 3 in chunks of the default size */
+    bool send_message(uint8_t type, uint32_t stream_id, const std::string &payload) {
+        std::string out;
+        for (size_t pos = 0; pos < payload.size() || pos == 0; pos += RTMP_SINK_CHUNK_SIZE) {
+            if (pos == 0) {
+                uint8_t h[12] = {0x03, 0, 0, 0, (uint8_t)(payload.size() >> 16), (uint8_t)(payload.size() >> 8),
+                                 (uint8_t)payload.size(), type, (uint8_t)stream_id, (uint8_t)(stream_id >> 8),
+                                 (uint8_t)(stream_id >> 16), (uint8_t)(stream_id >> 24)};
+                out.append((const char *)h, sizeof(h));
+            } else {
+                out += (char)0xc3;
+            }
+            out.append(payload, pos, RTMP_SINK_CHUNK_SIZE);
+            if (payload.empty())
+                break;
+        }
+        return write_all(out.data(), out.size());
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "test_common.h"
+#include "lite-obs/lite_obs_core_video.h"
+#include "lite-obs/lite_obs_core_audio.h"
+#include "lite-obs/lite_obs_source.h"
+#include "lite-obs/lite_obs_source_graph.h"
+#include "lite-obs/media-io/video_output.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+#define TEST_VIDEO_TIMEOUT_SEC 10
+
+/* what the raw video output delivered: the timestamp and centre luma of
+ * every frame, the planes of the newest one without padding and the nv12
+ * value of its centre pixel */
+struct test_video_capture {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<uint64_t> timestamps;
+    std::vector<uint8_t> centre_y;
+    std::vector<uint8_t> luma;
+    std::vector<uint8_t> chroma;
+    uint8_t y{};
+    uint8_t u{};
+    uint8_t v{};
+
+    bool wait_frames(size_t frames) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(TEST_VIDEO_TIMEOUT_SEC),
+                             [&] { return timestamps.size() >= frames; });
+    }
+};
+
+/* the graph and cores a lite_obs_internal sets up, without the encoders and
+ * outputs, so a test can render sources and read the frames back */
+struct test_video {
+    std::shared_ptr<lite_obs_source_graph> graph = std::make_shared<lite_obs_source_graph>();
+    std::shared_ptr<lite_obs_core_video> video = std::make_shared<lite_obs_core_video>(graph);
+    std::shared_ptr<lite_obs_core_audio> audio = std::make_shared<lite_obs_core_audio>(graph);
+    std::vector<std::shared_ptr<lite_obs_source>> sources;
+    test_video_capture *capture{};
+    uint32_t width{};
+    uint32_t height{};
+
+    ~test_video() {
+        stop();
+        for (auto &source : sources)
+            graph->remove(source);
+        sources.clear();
+    }
+
+    /* skips the test on machines without a graphics device */
+    void start(uint32_t cx, uint32_t cy, uint32_t fps) {
+        width = cx;
+        height = cy;
+        TEST_SKIP_IF(video->lite_obs_start_video(cx, cy, fps) != LITE_OBS_VIDEO_SUCCESS, "no graphics device");
+    }
+
+    void stop() {
+        disconnect();
+        video->lite_obs_stop_video();
+    }
+
+    std::shared_ptr<lite_obs_source> add_source(source_type type) {
+        auto source = std::make_shared<lite_obs_source>(type, video, audio);
+        graph->add(source);
+        sources.push_back(source);
+        return source;
+    }
+
+    void connect(test_video_capture *c) {
+        capture = c;
+        video->lite_obs_core_video_change_raw_active(true);
+        CHECK(video->core_video()->video_output_connect(nullptr, receive_video, this));
+    }
+
+    void disconnect() {
+        if (!capture)
+            return;
+        video->core_video()->video_output_disconnect(receive_video, this);
+        video->lite_obs_core_video_change_raw_active(false);
+        capture = nullptr;
+    }
+
+    /* the raw output is nv12 */
+    static void receive_video(void *param, video_data *frame) {
+        auto self = (test_video *)param;
+        uint32_t x = self->width / 2;
+        uint32_t y = self->height / 2;
+        const uint8_t *uv = frame->frame.data[1] + (y / 2) * frame->frame.linesize[1] + (x / 2) * 2;
+
+        auto capture = self->capture;
+        std::lock_guard<std::mutex> lock(capture->mutex);
+        capture->luma.resize(self->width * self->height);
+        capture->chroma.resize(self->width * self->height / 2);
+        for (uint32_t row = 0; row < self->height; row++)
+            memcpy(&capture->luma[row * self->width], frame->frame.data[0] + row * frame->frame.linesize[0], self->width);
+        for (uint32_t row = 0; row < self->height / 2; row++)
+            memcpy(&capture->chroma[row * self->width], frame->frame.data[1] + row * frame->frame.linesize[1], self->width);
+        capture->y = frame->frame.data[0][y * frame->frame.linesize[0] + x];
+        capture->u = uv[0];
+        capture->v = uv[1];
+        capture->centre_y.push_back(capture->y);
+        capture->timestamps.push_back(frame->timestamp);
+        capture->cond.notify_all();
+    }
+};
+
+static inline std::vector<uint8_t> test_rgba_image(uint32_t width, uint32_t height, uint8_t r, uint8_t g, uint8_t b)
+{
+    std::vector<uint8_t> image(width * height * 4);
+    for (size_t i = 0; i < image.size(); i += 4) {
+        image[i] = r;
+        image[i + 1] = g;
+        image[i + 2] = b;
+        image[i + 3] = 255;
+    }
+    return image;
+}
+
+/* full range bt.709, what the core video converts to */
+static inline void test_rgb_to_yuv(double r, double g, double b, double *y, double *u, double *v)
+{
+    *y = 0.2126 * r + 0.7152 * g + 0.0722 * b;
+    *u = (b - *y) / 1.8556 + 128;
+    *v = (r - *y) / 1.5748 + 128;
+}
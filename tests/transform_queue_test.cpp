@@ -0,0 +1,148 @@
+#include "test_common.h"
+#include "lite-obs/lite_obs_source_transform.h"
+#include "lite-obs/util/mpsc_ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define MPSC_PRODUCERS 4
+#define MPSC_VALUES 250000
+#define MPSC_CAPACITY 16
+
+#define TRANSFORM_ROTATORS 3
+#define TRANSFORM_COMMANDS 100000
+
+/* four producers push their own increasing sequence through a ring of
+ * sixteen, retrying when it is full, while one consumer pops. every value
+ * has to come out exactly once and each producer's values in the order
+ * they were pushed */
+static void run_ring()
+{
+    mpsc_ring<uint64_t> ring;
+    CHECK(ring.init(MPSC_CAPACITY));
+
+    std::vector<std::thread> producers;
+    for (uint64_t p = 0; p < MPSC_PRODUCERS; p++) {
+        producers.emplace_back([&ring, p] {
+            for (uint64_t seq = 0; seq < MPSC_VALUES;) {
+                if (ring.push((p << 32) | seq))
+                    seq++;
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    uint64_t next[MPSC_PRODUCERS]{};
+    uint64_t received = 0;
+    uint64_t bad = 0;
+    while (received < MPSC_PRODUCERS * MPSC_VALUES) {
+        uint64_t value;
+        if (!ring.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint64_t p = value >> 32;
+        if (p >= MPSC_PRODUCERS || (value & 0xffffffff) != next[p])
+            bad++;
+        else
+            next[p]++;
+        received++;
+    }
+
+    for (auto &producer : producers)
+        producer.join();
+
+    uint64_t value;
+    CHECK(!ring.pop(value));
+    CHECK_EQ(bad, 0);
+    for (uint64_t p = 0; p < MPSC_PRODUCERS; p++)
+        CHECK_EQ(next[p], MPSC_VALUES);
+}
+
+/* one thread moves the source through increasing positions while others
+ * rotate and flip it, and the render side drains now and then, slowly
+ * enough that the ring overflows into the spare state. positions must only
+ * ever move forward and end on the last one set, every rotation and flip
+ * must be counted once */
+static void run_transform_queue()
+{
+    source_transform_queue queue;
+    std::atomic_int running{TRANSFORM_ROTATORS + 1};
+
+    std::vector<std::thread> producers;
+    producers.emplace_back([&] {
+        for (int i = 1; i <= TRANSFORM_COMMANDS; i++) {
+            source_transform_command cmd{};
+            cmd.type = source_transform_type::pos;
+            cmd.vec.x = (float)i;
+            cmd.vec.y = (float)-i;
+            queue.push(cmd);
+        }
+        running--;
+    });
+
+    for (int r = 0; r < TRANSFORM_ROTATORS; r++) {
+        producers.emplace_back([&] {
+            for (int i = 0; i < TRANSFORM_COMMANDS; i++) {
+                source_transform_command cmd{};
+                cmd.type = i % 2 ? source_transform_type::flip : source_transform_type::rotate;
+                cmd.vec.x = i % 2 ? -1.0f : 1.0f;
+                cmd.vec.y = 1.0f;
+                queue.push(cmd);
+            }
+            running--;
+        });
+    }
+
+    float pos_x = 0;
+    float pos_y = 0;
+    double rot = 0;
+    float flip_x = 1.0f;
+    uint64_t backwards = 0;
+    uint64_t drains = 0;
+
+    auto apply = [&](const source_transform_pending &pending) {
+        CHECK(!pending.reset && !pending.has_box && !pending.has_scale);
+        if (pending.has_pos) {
+            if (pending.pos_x < pos_x)
+                backwards++;
+            CHECK_EQ(pending.pos_y, -pending.pos_x);
+            pos_x = pending.pos_x;
+            pos_y = pending.pos_y;
+        }
+        if (pending.has_rotate)
+            rot += pending.rot;
+        flip_x *= pending.flip_x;
+        CHECK_EQ(pending.flip_y, 1.0f);
+        drains++;
+    };
+
+    while (running) {
+        apply(queue.drain());
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    for (auto &producer : producers)
+        producer.join();
+    apply(queue.drain());
+    CHECK(queue.drain().empty());
+
+    fprintf(stderr, "%llu drains\n", (unsigned long long)drains);
+    CHECK_EQ(backwards, 0);
+    CHECK_EQ(pos_x, TRANSFORM_COMMANDS);
+    CHECK_EQ(pos_y, -TRANSFORM_COMMANDS);
+    CHECK_EQ(rot, TRANSFORM_ROTATORS * TRANSFORM_COMMANDS / 2);
+    /* an odd number of flips in total flips it */
+    CHECK_EQ(flip_x, (TRANSFORM_ROTATORS * TRANSFORM_COMMANDS / 2) % 2 ? -1.0f : 1.0f);
+}
+
+int main()
+{
+    run_ring();
+    run_transform_queue();
+    return 0;
+}
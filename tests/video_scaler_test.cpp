@@ -0,0 +1,172 @@
+#include "test_common.h"
+#include "lite-obs/media-io/video_scaler.h"
+
+#include <math.h>
+#include <vector>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+#define SCALER_WIDTH 128
+#define SCALER_HEIGHT 72
+
+struct scaler_plane {
+    uint32_t linesize;
+    uint32_t height;
+};
+
+static std::vector<scaler_plane> frame_planes(video_format format, uint32_t width, uint32_t height)
+{
+    switch (format) {
+    case video_format::VIDEO_FORMAT_I420:
+        return {{width, height}, {width / 2, height / 2}, {width / 2, height / 2}};
+    case video_format::VIDEO_FORMAT_NV12:
+        return {{width, height}, {width, height / 2}};
+    case video_format::VIDEO_FORMAT_Y800:
+        return {{width, height}};
+    default:
+        return {{width * 4, height}};
+    }
+}
+
+static AVPixelFormat ffmpeg_format(video_format format)
+{
+    switch (format) {
+    case video_format::VIDEO_FORMAT_I420:
+        return AV_PIX_FMT_YUV420P;
+    case video_format::VIDEO_FORMAT_NV12:
+        return AV_PIX_FMT_NV12;
+    case video_format::VIDEO_FORMAT_Y800:
+        return AV_PIX_FMT_GRAY8;
+    case video_format::VIDEO_FORMAT_RGBA:
+        return AV_PIX_FMT_RGBA;
+    case video_format::VIDEO_FORMAT_BGRA:
+    case video_format::VIDEO_FORMAT_BGRX:
+        return AV_PIX_FMT_BGRA;
+    default:
+        return AV_PIX_FMT_NONE;
+    }
+}
+
+struct scaler_frame {
+    std::vector<std::vector<uint8_t>> planes;
+    uint8_t *data[MAX_AV_PLANES]{};
+    uint32_t linesize[MAX_AV_PLANES]{};
+
+    scaler_frame(video_format format, uint32_t width, uint32_t height) {
+        auto layout = frame_planes(format, width, height);
+        planes.resize(layout.size());
+        for (size_t i = 0; i < layout.size(); i++) {
+            planes[i].resize(layout[i].linesize * layout[i].height);
+            data[i] = planes[i].data();
+            linesize[i] = layout[i].linesize;
+        }
+    }
+};
+
+/* smooth gradients with a little texture on top, what camera frames look
+ * like at this scale. every byte is set, alpha included */
+static void fill_source(scaler_frame &frame, video_format format, uint32_t width, uint32_t height)
+{
+    auto layout = frame_planes(format, width, height);
+    for (size_t p = 0; p < layout.size(); p++) {
+        for (uint32_t y = 0; y < layout[p].height; y++) {
+            for (uint32_t x = 0; x < layout[p].linesize; x++) {
+                double value = 128 + 90 * sin((x + 3.0 * p) / 11.0) * cos((y + 5.0 * (x % 4)) / 9.0) + ((x * 7 + y * 13) % 5);
+                frame.planes[p][y * layout[p].linesize + x] = (uint8_t)value;
+            }
+        }
+    }
+}
+
+/* swscale's default rgb to yuv path is off by up to 4 at full range, the
+ * accurate one is exact to rounding like the fast paths. area averaging is
+ * the box filter the 2x downscale uses */
+static int swscale_flags(bool downscale)
+{
+    return (downscale ? SWS_AREA : SWS_BILINEAR) | SWS_ACCURATE_RND | SWS_BITEXACT;
+}
+
+/* scales the same frame with video_scaler and with swscale set up the way
+ * video_scaler sets it up for conversions without a fast path, and returns
+ * the largest difference of any output byte */
+static int compare(video_format src_format, video_format dst_format, uint32_t dst_width, uint32_t dst_height,
+                   video_colorspace colorspace, video_range_type range, video_scale_type type)
+{
+    video_scale_info src{src_format, SCALER_WIDTH, SCALER_HEIGHT, video_range_type::VIDEO_RANGE_FULL, colorspace};
+    video_scale_info dst{dst_format, dst_width, dst_height, range, colorspace};
+    if (src_format == dst_format)
+        src.range = range;
+
+    scaler_frame input(src_format, SCALER_WIDTH, SCALER_HEIGHT);
+    fill_source(input, src_format, SCALER_WIDTH, SCALER_HEIGHT);
+    scaler_frame fast(dst_format, dst_width, dst_height);
+    scaler_frame reference(dst_format, dst_width, dst_height);
+
+    video_scaler scaler;
+    CHECK_EQ(scaler.create(&dst, &src, type), VIDEO_SCALER_SUCCESS);
+    CHECK(scaler.video_scaler_scale(fast.data, fast.linesize, input.data, input.linesize));
+
+    int cs = colorspace == video_colorspace::VIDEO_CS_709 ? SWS_CS_ITU709 : SWS_CS_ITU601;
+    int src_full = src.range == video_range_type::VIDEO_RANGE_FULL;
+    int dst_full = range == video_range_type::VIDEO_RANGE_FULL;
+    auto sws = sws_getCachedContext(NULL, SCALER_WIDTH, SCALER_HEIGHT, ffmpeg_format(src_format),
+                                    dst_width, dst_height, ffmpeg_format(dst_format),
+                                    swscale_flags(dst_width != SCALER_WIDTH), NULL, NULL, NULL);
+    CHECK(sws != nullptr);
+    sws_setColorspaceDetails(sws, sws_getCoefficients(cs), src_full, sws_getCoefficients(cs), dst_full, 0, 1 << 16, 1 << 16);
+    CHECK(sws_scale(sws, input.data, (const int *)input.linesize, 0, SCALER_HEIGHT,
+                    reference.data, (const int *)reference.linesize) > 0);
+    sws_freeContext(sws);
+
+    /* bgrx has no alpha to compare */
+    bool skip_alpha = dst_format == video_format::VIDEO_FORMAT_BGRX;
+
+    int max_diff = 0;
+    for (size_t p = 0; p < fast.planes.size(); p++) {
+        for (size_t i = 0; i < fast.planes[p].size(); i++) {
+            if (skip_alpha && i % 4 == 3)
+                continue;
+            int diff = abs((int)fast.planes[p][i] - (int)reference.planes[p][i]);
+            if (diff > max_diff)
+                max_diff = diff;
+        }
+    }
+
+    fprintf(stderr, "format %d -> %d, %ux%u, colorspace %d, range %d: max diff %d\n",
+            (int)src_format, (int)dst_format, dst_width, dst_height, (int)colorspace, (int)range, max_diff);
+    return max_diff;
+}
+
+#define CHECK_LSB(expr) CHECK((expr) <= 1)
+
+/* every video_scaler fast path against swscale, to one lsb */
+int main()
+{
+    const auto cs601 = video_colorspace::VIDEO_CS_601;
+    const auto cs709 = video_colorspace::VIDEO_CS_709;
+    const auto partial = video_range_type::VIDEO_RANGE_PARTIAL;
+    const auto full = video_range_type::VIDEO_RANGE_FULL;
+    const auto def = video_scale_type::VIDEO_SCALE_DEFAULT;
+    const auto bilinear = video_scale_type::VIDEO_SCALE_BILINEAR;
+
+    CHECK_LSB(compare(video_format::VIDEO_FORMAT_NV12, video_format::VIDEO_FORMAT_I420, SCALER_WIDTH, SCALER_HEIGHT, cs709, partial, def));
+    CHECK_LSB(compare(video_format::VIDEO_FORMAT_I420, video_format::VIDEO_FORMAT_NV12, SCALER_WIDTH, SCALER_HEIGHT, cs709, partial, def));
+
+    for (auto src : {video_format::VIDEO_FORMAT_RGBA, video_format::VIDEO_FORMAT_BGRA, video_format::VIDEO_FORMAT_BGRX}) {
+        for (auto dst : {video_format::VIDEO_FORMAT_NV12, video_format::VIDEO_FORMAT_I420}) {
+            CHECK_LSB(compare(src, dst, SCALER_WIDTH, SCALER_HEIGHT, cs601, partial, def));
+            CHECK_LSB(compare(src, dst, SCALER_WIDTH, SCALER_HEIGHT, cs601, full, def));
+            CHECK_LSB(compare(src, dst, SCALER_WIDTH, SCALER_HEIGHT, cs709, partial, def));
+            CHECK_LSB(compare(src, dst, SCALER_WIDTH, SCALER_HEIGHT, cs709, full, def));
+        }
+    }
+
+    for (auto format : {video_format::VIDEO_FORMAT_I420, video_format::VIDEO_FORMAT_NV12, video_format::VIDEO_FORMAT_Y800,
+                        video_format::VIDEO_FORMAT_RGBA, video_format::VIDEO_FORMAT_BGRA}) {
+        CHECK_LSB(compare(format, format, SCALER_WIDTH / 2, SCALER_HEIGHT / 2, cs709, partial, bilinear));
+    }
+
+    return 0;
+}
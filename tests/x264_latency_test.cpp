@@ -0,0 +1,183 @@
+#include "test_video.h"
+#include "lite-obs/lite_encoder.h"
+#include "lite-obs/encoder/x264_encoder.h"
+
+#include <atomic>
+
+#define LATENCY_WIDTH 640
+#define LATENCY_HEIGHT 360
+#define LATENCY_FPS 30
+#define LATENCY_BITRATE 1500
+#define LATENCY_FRAMES 90
+#define LATENCY_PACKETS 60
+
+static const char *const latency_presets[] = {"ultrafast", "superfast", "veryfast", "faster", "fast", "medium"};
+
+/* a square moving over a gradient, so motion search and b-frame decisions
+ * have something to work with */
+static void latency_frame(std::vector<uint8_t> &frame, int index)
+{
+    frame.resize(LATENCY_WIDTH * LATENCY_HEIGHT * 3 / 2);
+    for (int y = 0; y < LATENCY_HEIGHT; y++) {
+        for (int x = 0; x < LATENCY_WIDTH; x++) {
+            bool square = (x - index * 7) % LATENCY_WIDTH < 96 && (y + index * 3) % LATENCY_HEIGHT < 96;
+            frame[y * LATENCY_WIDTH + x] = square ? 235 : (uint8_t)(16 + (x + y) / 6);
+        }
+    }
+    memset(frame.data() + LATENCY_WIDTH * LATENCY_HEIGHT, 128, LATENCY_WIDTH * LATENCY_HEIGHT / 2);
+}
+
+struct latency_result {
+    bool opened{};
+    bool in_order{true};
+    int max_delay{};
+    int frames_out{};
+};
+
+/* encodes the clip with the params x264_encoder builds from settings and
+ * tracks whether each picture comes out of the call it went into */
+static latency_result latency_encode(const x264_encoder_settings &settings)
+{
+    latency_result result;
+
+    x264_param_t params;
+    memset(&params, 0, sizeof(params));
+    CHECK(x264_apply_settings(&params, settings, LATENCY_BITRATE, LATENCY_FPS, 1, false));
+    params.b_vfr_input = false;
+    params.i_width = LATENCY_WIDTH;
+    params.i_height = LATENCY_HEIGHT;
+    params.i_fps_num = LATENCY_FPS;
+    params.i_fps_den = 1;
+    params.i_csp = X264_CSP_NV12;
+    params.b_repeat_headers = false;
+    params.i_log_level = X264_LOG_NONE;
+
+    x264_t *context = x264_encoder_open(&params);
+    if (!context)
+        return result;
+    result.opened = true;
+
+    std::vector<uint8_t> frame;
+    x264_picture_t pic, pic_out;
+    x264_nal_t *nals = nullptr;
+    int nal_count = 0;
+
+    for (int i = 0; i < LATENCY_FRAMES; i++) {
+        latency_frame(frame, i);
+        x264_picture_init(&pic);
+        pic.i_pts = i;
+        pic.img.i_csp = X264_CSP_NV12;
+        pic.img.i_plane = 2;
+        pic.img.i_stride[0] = LATENCY_WIDTH;
+        pic.img.i_stride[1] = LATENCY_WIDTH;
+        pic.img.plane[0] = frame.data();
+        pic.img.plane[1] = frame.data() + LATENCY_WIDTH * LATENCY_HEIGHT;
+
+        int size = x264_encoder_encode(context, &nals, &nal_count, &pic, &pic_out);
+        CHECK(size >= 0);
+        if (size > 0) {
+            result.frames_out++;
+            if (pic_out.i_pts != i || pic_out.i_dts != pic_out.i_pts)
+                result.in_order = false;
+        } else {
+            result.in_order = false;
+        }
+
+        int delay = x264_encoder_delayed_frames(context);
+        if (delay > result.max_delay)
+            result.max_delay = delay;
+    }
+
+    x264_encoder_close(context);
+    return result;
+}
+
+struct latency_packets {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<std::shared_ptr<encoder_packet>> packets;
+    std::atomic_uint32_t max_delay{};
+    lite_obs_encoder *encoder{};
+
+    static void callback(void *param, const std::shared_ptr<encoder_packet> &packet) {
+        auto self = (latency_packets *)param;
+        uint32_t delay = self->encoder->lite_obs_encoder_get_delay_frames();
+        if (delay > self->max_delay)
+            self->max_delay = delay;
+
+        std::lock_guard<std::mutex> lock(self->mutex);
+        self->packets.push_back(packet);
+        self->cond.notify_all();
+    }
+
+    bool wait(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::seconds(TEST_VIDEO_TIMEOUT_SEC), [&] { return packets.size() >= count; });
+    }
+};
+
+/* in low latency mode every preset has to hand each picture back from the
+ * call it went into, with its own pts and dts equal to it. the default mode
+ * of the slower presets holds frames back and reorders them, which shows
+ * the check can fail. then the same through a running x264 encoder fed by
+ * the core video */
+int main()
+{
+    for (auto preset : latency_presets) {
+        x264_encoder_settings settings;
+        settings.preset = preset;
+        settings.low_latency = true;
+
+        auto low = latency_encode(settings);
+        CHECK(low.opened);
+        fprintf(stderr, "%-10s low latency: %d of %d frames out in order, max delay %d\n",
+                preset, low.frames_out, LATENCY_FRAMES, low.max_delay);
+        CHECK(low.in_order);
+        CHECK_EQ(low.frames_out, LATENCY_FRAMES);
+        CHECK_EQ(low.max_delay, 0);
+    }
+
+    x264_encoder_settings reordering;
+    reordering.preset = "medium";
+    reordering.bframes = 3;
+    auto control = latency_encode(reordering);
+    CHECK(control.opened);
+    fprintf(stderr, "medium with b-frames: max delay %d\n", control.max_delay);
+    CHECK(!control.in_order);
+    CHECK(control.max_delay > 0);
+
+    test_video video;
+    video.start(LATENCY_WIDTH, LATENCY_HEIGHT, LATENCY_FPS);
+
+    auto source = video.add_source(source_type::SOURCE_VIDEO);
+    auto image = test_rgba_image(LATENCY_WIDTH, LATENCY_HEIGHT, 200, 80, 40);
+    source->lite_source_output_video(image.data(), LATENCY_WIDTH, LATENCY_HEIGHT);
+
+    x264_encoder_settings settings;
+    settings.preset = "veryfast";
+    settings.low_latency = true;
+
+    auto encoder = std::make_shared<lite_obs_encoder>(lite_obs_encoder::encoder_id::X264, LATENCY_BITRATE, 0);
+    encoder->lite_obs_encoder_set_x264_settings(settings);
+    encoder->lite_obs_encoder_set_core_video(video.video);
+    CHECK(encoder->obs_encoder_initialize());
+
+    latency_packets packets;
+    packets.encoder = encoder.get();
+    encoder->obs_encoder_start(latency_packets::callback, &packets);
+    CHECK(packets.wait(LATENCY_PACKETS));
+    encoder->obs_encoder_stop(latency_packets::callback, &packets);
+    encoder->obs_encoder_shutdown();
+    encoder->obs_encoder_destroy();
+
+    std::lock_guard<std::mutex> lock(packets.mutex);
+    CHECK(packets.packets.front()->keyframe);
+    for (size_t i = 0; i < packets.packets.size(); i++) {
+        auto &packet = packets.packets[i];
+        CHECK_EQ(packet->dts, packet->pts);
+        if (i)
+            CHECK(packet->pts > packets.packets[i - 1]->pts);
+    }
+    CHECK_EQ(packets.max_delay, 0);
+    return 0;
+}